@@ -4,6 +4,7 @@
 layout(location = 0) in vec2 vUV;
 layout(location = 1) flat in uint vFrame;
 layout(location = 2) flat in uint vCover;
+layout(location = 3) flat in vec4 vRect; // {offset, scale} in UVs
 
 layout(location = 0) out vec4 outColor;
 
@@ -13,13 +14,14 @@ layout(set = 1, binding = 0) uniform sampler2D uTex[];
 layout(push_constant) uniform ViewPx {
     uvec4 fb; // {fbw, fbh, _, _}  (framebuffer)
     uvec4 vp; // {x, y, vw, vh}    (viewport)
+    float time; // seconds (read by the vertex stage)
 } pc;
 
 void main() {
     // ----- COVER PATH: icon/button etc. -----
     if (vCover != 0u) {
-        // Optional: clamp or discard outside [0,1]
-        if (vUV.x < 0.0 || vUV.y < 0.0 || vUV.x > 1.0 || vUV.y > 1.0) {
+        // Optional: clamp or discard outside the frame's rectangle
+        if (any(lessThan(vUV, vRect.xy)) || any(greaterThan(vUV, vRect.xy + vRect.zw))) {
             outColor = vec4(0.0);
             return;
         }
@@ -44,7 +46,10 @@ void main() {
     vec2 fragFBf = fragInVp * scale;
     ivec2 fragFB = ivec2(floor(fragFBf + 0.5));
 
-    ivec2 texSz = textureSize(uTex[nonuniformEXT(vFrame)], 0);
+    // the frame's texels inside the sampled texture (an atlas cell or all of it)
+    vec2 pageSz = vec2(textureSize(uTex[nonuniformEXT(vFrame)], 0));
+    ivec2 texBase = ivec2(round(vRect.xy * pageSz));
+    ivec2 texSz = ivec2(round(vRect.zw * pageSz));
 
     // Window to sample = min(framebuffer, texture) in framebuffer pixels
     ivec2 winFB = min(ivec2(pc.fb.xy), texSz);
@@ -59,6 +64,6 @@ void main() {
         return;
     }
 
-    ivec2 tc = texOrg + (fragFB - screenOrgFB);
+    ivec2 tc = texBase + texOrg + (fragFB - screenOrgFB);
     outColor = texelFetch(uTex[nonuniformEXT(vFrame)], tc, 0);
 }
@@ -9,6 +9,11 @@ layout(location = 6) in uint iFrame; // R32_UINT
 layout(location = 7) in uint iCover; // R32_UINT
 layout(location = 8) in vec2 iUVScale; // R32G32_SFLOAT
 layout(location = 9) in vec2 iUVOff; // R32G32_SFLOAT
+layout(location = 10) in uint iFrameBase; // playing: first frame-table entry
+layout(location = 11) in uint iFrameCount; // playing: frames; 0 shows iFrame
+layout(location = 12) in float iFps;
+layout(location = 13) in float iStartTime; // seconds, same clock as pc.time
+layout(location = 14) in uint iPlayback; // 0 loop, 1 once, 2 ping-pong
 
 // View/Proj (set = 0, binding = 0)
 layout(set = 0, binding = 0) uniform VP {
@@ -17,19 +22,58 @@ layout(set = 0, binding = 0) uniform VP {
     uint billboard;
 } cam;
 
+// Frames of the frame lists being played (set = 0, binding = 2)
+struct FrameRef {
+    vec2 uvScale;
+    vec2 uvOffset;
+    uint heapIndex;
+    uint _pad0, _pad1, _pad2;
+};
+layout(std430, set = 0, binding = 2) readonly buffer FrameTable {
+    FrameRef frames[];
+} table;
+
+// Push constants (shared with the fragment stage)
+layout(push_constant) uniform ViewPx {
+    uvec4 fb;
+    uvec4 vp;
+    float time; // seconds
+} pc;
+
 layout(location = 0) out vec2 vUV;
 layout(location = 1) flat out uint vFrame;
 layout(location = 2) flat out uint vCover;
+layout(location = 3) flat out vec4 vRect; // frame's sub-rectangle of the texture: {offset, scale}
 
 void main() {
-    // Switch based on iCover
-    if (iCover == 0u) {
-        vUV = inUV * iUVScale + iUVOff;
-    } else {
-        vUV = inUV;
+    uint frame = iFrame;
+    vec2 uvScale = iUVScale;
+    vec2 uvOff = iUVOff;
+
+    // Playing: pick the frame from the clock
+    if (iFrameCount > 0u) {
+        uint n = uint(max(pc.time - iStartTime, 0.0) * iFps);
+        uint local;
+        if (iPlayback == 1u) {
+            local = min(n, iFrameCount - 1u);
+        } else if (iPlayback == 2u && iFrameCount > 1u) {
+            uint period = 2u * iFrameCount - 2u;
+            uint k = n % period;
+            local = k < iFrameCount ? k : period - k;
+        } else {
+            local = n % iFrameCount;
+        }
+        FrameRef f = table.frames[iFrameBase + local];
+        frame = f.heapIndex;
+        uvScale = f.uvScale;
+        uvOff = f.uvOffset;
     }
 
-    vFrame = iFrame;
+    // uvScale/uvOff select the frame inside its texture (a TextureAtlas page, or the whole image)
+    vUV = inUV * uvScale + uvOff;
+    vRect = vec4(uvOff, uvScale);
+
+    vFrame = frame;
     vCover = iCover;
 
     if (cam.billboard != 0u) {
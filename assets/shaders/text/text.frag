@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : enable
 
 layout(location = 0) in vec2 vUV;
 layout(location = 1) in vec4 vColor;
@@ -6,7 +7,8 @@ layout(location = 2) in float vSdfPx;
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 2) uniform sampler2D uAtlas;
+// engine-wide bindless texture table (TextureHeap); the font atlas is uTex[pc.atlasIndex]
+layout(set = 1, binding = 0) uniform sampler2D uTex[];
 
 layout(push_constant) uniform PC {
     mat4 uModel;
@@ -15,6 +17,7 @@ layout(push_constant) uniform PC {
     float textOriginY;
     float textExtentX;
     float textExtentY;
+    uint atlasIndex;
 } pc;
 
 void main() {
@@ -39,7 +42,7 @@ void main() {
     }
 
     // SDF text path
-    float s = texture(uAtlas, vUV).r; // 0..1, 0.5 at edge
+    float s = texture(uTex[pc.atlasIndex], vUV).r; // 0..1, 0.5 at edge
     float aa = 0.5 * fwidth(s);
     float alpha = smoothstep(0.5 - aa, 0.5 + aa, s);
     if (alpha <= 1e-4) discard;
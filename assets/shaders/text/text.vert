@@ -23,6 +23,7 @@ layout(push_constant) uniform PC {
     float textOriginY;
     float textExtentX;
     float textExtentY;
+    uint atlasIndex;
 } pc;
 
 void main() {
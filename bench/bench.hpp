@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// engine_bench:
+// Headless micro-benchmarks for the CPU hot paths (no window, no Vulkan device).
+// Every case runs its body repeatedly for at least --min-time seconds and reports ns/iter, throughput
+// (items and bytes per second when the case declares them) and heap allocations per iteration, counted
+// by the global operator new replacement in bench_main.cpp.
+namespace Bench {
+
+// counted by the operator new replacement (all threads)
+inline std::atomic<uint64_t> allocCount{0};
+inline std::atomic<uint64_t> allocBytes{0};
+
+struct Case {
+	std::string name;
+	double itemsPerIter = 0.0; // e.g. triangles, glyphs, dispatches (0 = don't report)
+	double bytesPerIter = 0.0; // input bytes consumed per iteration (0 = don't report)
+	std::function<void()> setup; // optional, runs once before warmup (not timed, not counted)
+	std::function<void()> fn;	 // one iteration
+};
+
+struct Result {
+	std::string name;
+	uint64_t iterations = 0;
+	double nsPerIter = 0.0;
+	double itemsPerSec = 0.0;
+	double mbPerSec = 0.0;
+	double allocsPerIter = 0.0;
+	double allocBytesPerIter = 0.0;
+};
+
+// keeps the optimizer from dropping a result (address escapes through a volatile, portable to MSVC)
+inline const void *volatile sink = nullptr;
+template <typename T> inline void doNotOptimize(const T &v) { sink = &v; }
+
+} // namespace Bench
+
+// defined in cases.cpp; only goes through the engine's public API
+struct EngineBench {
+	static void registerAll(std::vector<Bench::Case> &cases, const std::vector<std::string> &ptyStreams);
+	// correctness checks on the same paths; prints each failure, returns false if any failed
+	static bool checkAll();
+};
@@ -0,0 +1,188 @@
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Allocation counting (replaces the global allocator for the whole binary)
+// -----------------------------------------------------------------------------
+
+// Every replaceable form: the aligned and nothrow ones too, or containers of over-aligned types (and anything
+// built with std::nothrow) would allocate without being counted.
+static void *tryCountedAlloc(std::size_t n, std::size_t align = 0) noexcept {
+	Bench::allocCount.fetch_add(1, std::memory_order_relaxed);
+	Bench::allocBytes.fetch_add(n, std::memory_order_relaxed);
+	if (n == 0)
+		n = 1;
+	if (align <= alignof(std::max_align_t))
+		return std::malloc(n);
+	return std::aligned_alloc(align, (n + align - 1) / align * align); // size must be a multiple of align
+}
+
+static void *countedAlloc(std::size_t n, std::size_t align = 0) {
+	if (void *p = tryCountedAlloc(n, align))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n) { return countedAlloc(n); }
+void *operator new[](std::size_t n) { return countedAlloc(n); }
+void *operator new(std::size_t n, std::align_val_t a) { return countedAlloc(n, std::size_t(a)); }
+void *operator new[](std::size_t n, std::align_val_t a) { return countedAlloc(n, std::size_t(a)); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return tryCountedAlloc(n); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return tryCountedAlloc(n); }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { return tryCountedAlloc(n, std::size_t(a)); }
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { return tryCountedAlloc(n, std::size_t(a)); }
+
+// malloc and aligned_alloc memory both go back through free()
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+// -----------------------------------------------------------------------------
+// Runner
+// -----------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+static Bench::Result runCase(const Bench::Case &c, double minSeconds) {
+	if (c.setup)
+		c.setup();
+
+	// warmup: first-touch allocations (reserve, map growth) shouldn't show up as per-iteration cost
+	for (int i = 0; i < 3; ++i)
+		c.fn();
+
+	// grow the batch until one batch alone takes ~1/10 of the budget, then keep running batches
+	uint64_t batch = 1;
+	uint64_t iterations = 0;
+	double elapsed = 0.0;
+	const uint64_t allocs0 = Bench::allocCount.load(std::memory_order_relaxed);
+	const uint64_t bytes0 = Bench::allocBytes.load(std::memory_order_relaxed);
+	while (elapsed < minSeconds) {
+		auto t0 = Clock::now();
+		for (uint64_t i = 0; i < batch; ++i)
+			c.fn();
+		double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+		elapsed += dt;
+		iterations += batch;
+		if (dt < minSeconds * 0.1 && batch < (1ull << 30))
+			batch *= 2;
+	}
+	const uint64_t allocs = Bench::allocCount.load(std::memory_order_relaxed) - allocs0;
+	const uint64_t bytes = Bench::allocBytes.load(std::memory_order_relaxed) - bytes0;
+
+	Bench::Result r;
+	r.name = c.name;
+	r.iterations = iterations;
+	r.nsPerIter = elapsed * 1e9 / double(iterations);
+	r.itemsPerSec = c.itemsPerIter > 0.0 ? c.itemsPerIter * double(iterations) / elapsed : 0.0;
+	r.mbPerSec = c.bytesPerIter > 0.0 ? c.bytesPerIter * double(iterations) / elapsed / (1024.0 * 1024.0) : 0.0;
+	r.allocsPerIter = double(allocs) / double(iterations);
+	r.allocBytesPerIter = double(bytes) / double(iterations);
+	return r;
+}
+
+static void printResult(const Bench::Result &r) {
+	char items[32] = "-", mb[32] = "-";
+	if (r.itemsPerSec > 0.0)
+		std::snprintf(items, sizeof(items), "%.3gM", r.itemsPerSec / 1e6);
+	if (r.mbPerSec > 0.0)
+		std::snprintf(mb, sizeof(mb), "%.1f", r.mbPerSec);
+	std::printf("%-40s %12.1f %10s %10s %10.2f %12.0f %10llu\n", r.name.c_str(), r.nsPerIter, items, mb, r.allocsPerIter, r.allocBytesPerIter, (unsigned long long)r.iterations);
+	std::fflush(stdout);
+}
+
+static bool writeJson(const std::string &path, const std::vector<Bench::Result> &results) {
+	FILE *f = std::fopen(path.c_str(), "wb");
+	if (!f)
+		return false;
+	std::fprintf(f, "{\"benchmarks\":[\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto &r = results[i];
+		std::fprintf(f, "  {\"name\":\"%s\",\"iterations\":%llu,\"ns_per_iter\":%.3f,\"items_per_sec\":%.3f,\"mb_per_sec\":%.3f,\"allocs_per_iter\":%.3f,\"alloc_bytes_per_iter\":%.3f}%s\n", r.name.c_str(), (unsigned long long)r.iterations, r.nsPerIter, r.itemsPerSec, r.mbPerSec, r.allocsPerIter,
+					 r.allocBytesPerIter, i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(f, "]}\n");
+	std::fclose(f);
+	return true;
+}
+
+// Usage:
+//   engine_bench [--filter substr] [--min-time 0.5] [--pty recorded.raw]... [--json out.json] [--list] [--check]
+// --check runs only the correctness checks (they also run before every benchmark run).
+// --pty takes raw PTY output (e.g. `script -q -c cmd out.raw`); without it the filter runs on a synthetic stream.
+int main(int argc, char *argv[]) {
+	std::string filter, json;
+	double minSeconds = 0.5;
+	bool list = false, checkOnly = false;
+	std::vector<std::string> ptyStreams;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			minSeconds = std::strtod(argv[++i], nullptr);
+		} else if (std::strcmp(argv[i], "--pty") == 0 && i + 1 < argc) {
+			std::ifstream in(argv[++i], std::ios::binary);
+			if (!in) {
+				std::fprintf(stderr, "[Bench] cannot open %s\n", argv[i]);
+				return 1;
+			}
+			ptyStreams.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		} else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			json = argv[++i];
+		} else if (std::strcmp(argv[i], "--list") == 0) {
+			list = true;
+		} else if (std::strcmp(argv[i], "--check") == 0) {
+			checkOnly = true;
+		}
+	}
+
+	// numbers from a broken path are meaningless: the checks gate every run
+	if (!EngineBench::checkAll())
+		return 1;
+	if (checkOnly)
+		return 0;
+
+	std::vector<Bench::Case> cases;
+	EngineBench::registerAll(cases, ptyStreams);
+
+	if (list) {
+		for (auto &c : cases)
+			std::printf("%s\n", c.name.c_str());
+		return 0;
+	}
+
+	std::printf("%-40s %12s %10s %10s %10s %12s %10s\n", "case", "ns/iter", "items/s", "MB/s", "allocs/it", "bytes/it", "iters");
+	std::vector<Bench::Result> results;
+	for (auto &c : cases) {
+		if (!filter.empty() && c.name.find(filter) == std::string::npos)
+			continue;
+		results.push_back(runCase(c, minSeconds));
+		printResult(results.back());
+	}
+
+	if (!json.empty() && !writeJson(json, results)) {
+		std::fprintf(stderr, "[Bench] cannot write %s\n", json.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,445 @@
+#include "bench.hpp"
+
+#include "bytering.hpp"
+#include "drawpool.hpp"
+#include "events.hpp"
+#include "model.hpp"
+#include "polygon.hpp"
+#include "raypicking.hpp"
+#include "scrollbackindex.hpp"
+#include "terminalprocess.hpp"
+#include "text.hpp"
+#include "textureheap.hpp"
+#include "vtscreen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Synthetic inputs (deterministic so runs are comparable across commits)
+// -----------------------------------------------------------------------------
+
+namespace {
+
+struct Lcg {
+	uint32_t s = 0x12345678u;
+	uint32_t next() { return s = s * 1664525u + 1013904223u; }
+};
+
+// n x n quad grid on a wavy height field: 2*n*n triangles
+void gridMesh(int n, std::vector<vec3> &verts, std::vector<uint32_t> &idx) {
+	verts.clear();
+	idx.clear();
+	for (int y = 0; y <= n; ++y)
+		for (int x = 0; x <= n; ++x)
+			verts.emplace_back(float(x) / n, float(y) / n, 0.05f * std::sin(x * 0.7f) * std::cos(y * 0.3f));
+	for (int y = 0; y < n; ++y)
+		for (int x = 0; x < n; ++x) {
+			uint32_t a = y * (n + 1) + x, b = a + 1, c = a + (n + 1), d = c + 1;
+			idx.insert(idx.end(), {a, b, d, a, d, c});
+		}
+}
+
+// filled disc with a soft edge, roughly what FreeType hands us for a round glyph
+std::vector<uint8_t> discAlpha(int size) {
+	std::vector<uint8_t> a(size * size);
+	const float r = size * 0.35f, c = size * 0.5f;
+	for (int y = 0; y < size; ++y)
+		for (int x = 0; x < size; ++x) {
+			float d = std::sqrt((x - c) * (x - c) + (y - c) * (y - c));
+			float v = std::clamp(r - d + 0.5f, 0.0f, 1.0f);
+			a[y * size + x] = uint8_t(v * 255.0f);
+		}
+	return a;
+}
+
+// shell-like output: SGR colors, prompts, CR progress bars, backspaces, OSC titles, DEC private modes
+std::string syntheticPtyStream(size_t targetBytes) {
+	static const char *words[] = {"build", "src/models/model.cpp", "ok", "warning:", "linking", "Engine", "-O2", "[100%]", "vulkan", "glyph"};
+	Lcg rng;
+	std::string s;
+	s.reserve(targetBytes + 256);
+	while (s.size() < targetBytes) {
+		switch (rng.next() % 8) {
+		case 0:
+			s += "\x1b]0;user@host: ~/Engine\x07";
+			break;
+		case 1:
+			s += "\x1b[?2004h\x1b[01;32muser@host\x1b[00m:\x1b[01;34m~/Engine\x1b[00m$ ";
+			break;
+		case 2:
+			for (int p = 0; p <= 100; p += 20) {
+				char line[64];
+				std::snprintf(line, sizeof(line), "\r[%3d%%] compiling", p);
+				s += line;
+			}
+			s += "\r\n";
+			break;
+		case 3:
+			s += "ls -la\b\b\b\b\b\bmake\r\n";
+			break;
+		default:
+			for (int w = 0; w < 12; ++w) {
+				if (rng.next() % 5 == 0) {
+					char sgr[16];
+					std::snprintf(sgr, sizeof(sgr), "\x1b[%um", 30 + rng.next() % 8);
+					s += sgr;
+				}
+				s += words[rng.next() % 10];
+				s += (rng.next() % 7 == 0) ? "\x1b[0m " : " ";
+			}
+			s += "\x1b[K\r\n";
+			break;
+		}
+	}
+	return s;
+}
+
+std::string ansiText(size_t targetBytes) {
+	Lcg rng;
+	std::string s;
+	while (s.size() < targetBytes) {
+		char sgr[16];
+		std::snprintf(sgr, sizeof(sgr), "\x1b[%um", 30 + rng.next() % 8);
+		s += sgr;
+		s += "The quick brown fox jumps over the lazy dog 0123456789 ";
+		if (rng.next() % 4 == 0)
+			s += "\x1b[0m\n";
+	}
+	return s;
+}
+
+// Model with just the CPU instance bookkeeping (no device; destroy() sees null handles)
+struct BenchModel : Model {
+	BenchModel(uint32_t stride, uint32_t capacity) {
+		pipeline = std::make_unique<Pipeline>();
+		iStride = stride;
+		maxInstances = capacity;
+		cpu.resize(size_t(stride) * capacity);
+	}
+};
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Cases
+// -----------------------------------------------------------------------------
+
+void EngineBench::registerAll(std::vector<Bench::Case> &cases, const std::vector<std::string> &ptyStreams) {
+	// RayPicking::buildBVH
+	for (int n : {16, 64, 256}) {
+		auto picking = std::make_shared<RayPicking>();
+		auto verts = std::make_shared<std::vector<vec3>>();
+		auto idx = std::make_shared<std::vector<uint32_t>>();
+		gridMesh(n, *verts, *idx);
+		cases.push_back({"RayPicking::buildBVH/" + std::to_string(idx->size() / 3) + "tris", double(idx->size() / 3), 0.0, {}, [=] { picking->buildBVH(*verts, *idx); }});
+	}
+
+	// Text::bitmapToSDF
+	for (int size : {64, 128}) {
+		auto alpha = std::make_shared<std::vector<uint8_t>>(discAlpha(size));
+		cases.push_back({"Text::bitmapToSDF/" + std::to_string(size) + "px", double(size * size), double(size * size), {}, [=] {
+							 auto sdf = Text::bitmapToSDF(alpha->data(), size, size, 12);
+							 Bench::doNotOptimize(sdf);
+						 }});
+	}
+
+	// Text::parseAnsiToRuns
+	{
+		auto text = std::make_shared<std::string>(ansiText(64 * 1024));
+		auto runs = std::make_shared<std::vector<Text::ColorRun>>();
+		const vec4 base(1.0f);
+		cases.push_back({"Text::parseAnsiToRuns/64KiB", 0.0, double(text->size()), {}, [=] {
+							 auto u32 = Text::parseAnsiToRuns(*text, base, *runs);
+							 Bench::doNotOptimize(u32);
+						 }});
+	}
+
+	// TerminalProcess::filter, fed in the reader thread's 4 KiB chunks
+	{
+		std::vector<std::pair<std::string, std::shared_ptr<std::string>>> streams;
+		if (ptyStreams.empty())
+			streams.emplace_back("synthetic", std::make_shared<std::string>(syntheticPtyStream(1024 * 1024)));
+		for (size_t i = 0; i < ptyStreams.size(); ++i)
+			streams.emplace_back("pty" + std::to_string(i), std::make_shared<std::string>(ptyStreams[i]));
+
+		for (auto &[label, stream] : streams) {
+			auto tp = std::make_shared<TerminalProcess>();
+			auto chunks = std::make_shared<std::vector<std::string>>();
+			for (size_t off = 0; off < stream->size(); off += 4096)
+				chunks->push_back(stream->substr(off, 4096));
+			cases.push_back({"TerminalProcess::filter/" + label, 0.0, double(stream->size()), {}, [=] {
+								 tp->clearScrollback(); // keeps its capacity, like a long-running session
+								 for (const auto &c : *chunks)
+									 tp->feedScrollback(c);
+								 Bench::doNotOptimize(tp->getScrollback());
+							 }});
+		}
+	}
+
+	// ByteRing: PTY-sized writes through the ring and out again (reactor thread -> flushUI, on one thread here)
+	{
+		auto ring = std::make_shared<ByteRing>(64 * 1024);
+		auto stream = std::make_shared<std::string>(syntheticPtyStream(1024 * 1024));
+		auto out = std::make_shared<std::vector<char>>(4096);
+		cases.push_back({"ByteRing::write+read/4KiB", 0.0, double(stream->size()), {}, [=] {
+							 for (size_t off = 0; off < stream->size();) {
+								 auto span = ring->writeSpan();
+								 const size_t n = std::min(span.size(), stream->size() - off);
+								 std::copy_n(stream->data() + off, n, span.data());
+								 ring->commitWrite(n);
+								 off += n;
+								 while (ring->read(out->data(), out->size()) > 0)
+									 Bench::doNotOptimize(*out);
+							 }
+						 }});
+	}
+
+	// ScrollbackIndex::find over ~1 MiB of filtered shell output (bloom-rejected lines vs. verified hits)
+	{
+		auto sb = std::make_shared<Scrollback>(0, 0);
+		auto index = std::make_shared<ScrollbackIndex>();
+		TerminalProcess tp;
+		tp.feedScrollback(syntheticPtyStream(1024 * 1024));
+		sb->append(tp.getScrollback().committedView());
+		index->update(*sb);
+		for (const char *needle : {"warning:", "no such text"}) {
+			const std::string n = needle;
+			cases.push_back({"ScrollbackIndex::find/" + std::string(n[0] == 'w' ? "hits" : "miss"), double(index->indexedLines()), double(sb->size()), {}, [=] {
+								 auto hits = index->find(*sb, n, true);
+								 Bench::doNotOptimize(hits);
+							 }});
+		}
+	}
+
+	// Model::upsertBytes / erase churn: replace 256 random instances in a half-full model
+	for (uint32_t capacity : {1024u, 16384u}) {
+		struct Inst {
+			float data[24];
+		};
+		auto model = std::make_shared<BenchModel>(uint32_t(sizeof(Inst)), capacity);
+		auto live = std::make_shared<std::vector<int>>();
+		auto nextId = std::make_shared<int>(0);
+		auto rng = std::make_shared<Lcg>();
+		auto setup = [=] {
+			const Inst inst{};
+			const std::span<const uint8_t> bytes{reinterpret_cast<const uint8_t *>(&inst), sizeof(Inst)};
+			while (model->instanceCount() < capacity / 2) {
+				model->upsertBytes(*nextId, bytes);
+				live->push_back((*nextId)++);
+			}
+		};
+		cases.push_back({"Model::upsertBytes+erase/" + std::to_string(capacity / 2) + "live", 512.0, 0.0, setup, [=] {
+							 const Inst inst{};
+							 const std::span<const uint8_t> bytes{reinterpret_cast<const uint8_t *>(&inst), sizeof(Inst)};
+							 for (int k = 0; k < 256; ++k) {
+								 size_t victim = rng->next() % live->size();
+								 model->erase((*live)[victim]);
+								 model->upsertBytes(*nextId, bytes);
+								 (*live)[victim] = (*nextId)++;
+							 }
+						 }});
+	}
+
+	// Polygon::expandForOutlines
+	for (int n : {32, 128}) {
+		auto in = std::make_shared<std::vector<Polygon::Vertex>>();
+		auto idx = std::make_shared<std::vector<uint32_t>>();
+		std::vector<vec3> pos;
+		gridMesh(n, pos, *idx);
+		for (auto &p : pos)
+			in->push_back({p, vec3(0, 0, 1), glm::vec2(p.x, p.y), vec4(1.0f)});
+		auto outVerts = std::make_shared<std::vector<Polygon::Attributes>>();
+		auto outIdx = std::make_shared<std::vector<uint32_t>>();
+		cases.push_back({"Polygon::expandForOutlines/" + std::to_string(idx->size() / 3) + "tris", double(idx->size() / 3), 0.0, {}, [=] { Polygon::expandForOutlines(*in, *idx, *outVerts, *outIdx); }});
+	}
+
+	// Events::Registry::dispatch
+	for (int handlers : {16, 256}) {
+		auto registry = std::make_shared<Events::Registry<UpdateCallback>>();
+		auto acc = std::make_shared<float>(0.0f);
+		for (int h = 0; h < handlers; ++h)
+			registry->add([acc](float dt) { *acc += dt; });
+		cases.push_back({"Events::Registry::dispatch/" + std::to_string(handlers) + "handlers", double(handlers), 0.0, {}, [=] {
+							 registry->dispatch(0.016f);
+							 Bench::doNotOptimize(*acc);
+						 }});
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Checks
+// -----------------------------------------------------------------------------
+
+bool EngineBench::checkAll() {
+	bool ok = true;
+
+	// TerminalProcess::filter: a read can end anywhere, the output must not depend on where
+	struct FilterCheck {
+		const char *name;
+		std::vector<std::string> reads;
+		std::string expect;
+	};
+	const FilterCheck filterChecks[] = {
+		{"CRLF split", {"one\r", "\ntwo"}, "one\ntwo"},
+		{"CR then text", {"50%\r", "99%"}, "99%"},
+		{"SGR split", {"\x1b[3", "1mred\x1b", "[0m"}, "\x1b[31mred\x1b[0m"},
+		{"OSC split", {"\x1b]0;ti", "tle\x1b", "\\ok"}, "ok"},
+		{"CSI split", {"a\x1b[?20", "04hb"}, "ab"},
+	};
+	for (const auto &c : filterChecks) {
+		TerminalProcess tp;
+		for (const auto &r : c.reads)
+			tp.feedScrollback(r);
+		const std::string got(tp.getScrollback().committedView());
+		if (got != c.expect) {
+			std::fprintf(stderr, "[Bench] check failed: TerminalProcess::filter/%s\n", c.name);
+			ok = false;
+		}
+	}
+
+	// ByteRing: bytes come out in order across the wrap point, and a full ring hands out an empty span
+	{
+		ByteRing ring(64);
+		std::string in, got;
+		Lcg rng;
+		char buf[64];
+		for (int round = 0; round < 40; ++round) {
+			for (std::span<char> span = ring.writeSpan(); !span.empty(); span = ring.writeSpan()) {
+				const size_t n = std::min<size_t>(span.size(), 1 + rng.next() % 23);
+				for (size_t k = 0; k < n; ++k)
+					span[k] = char('a' + rng.next() % 26);
+				in.append(span.data(), n);
+				ring.commitWrite(n);
+			}
+			got.append(buf, ring.read(buf, 1 + rng.next() % 40));
+		}
+		while (size_t n = ring.read(buf, sizeof(buf)))
+			got.append(buf, n);
+		if (got != in || ring.readable() != 0) {
+			std::fprintf(stderr, "[Bench] check failed: ByteRing/wrap\n");
+			ok = false;
+		}
+	}
+
+	// Scrollback: limits drop whole lines from the front, positions stay stream offsets
+	{
+		Scrollback sb(8, 0);
+		std::string last;
+		for (int i = 0; i < 100; ++i) {
+			last = "line" + std::to_string(i);
+			sb.append(last + "\n");
+		}
+		const size_t n = sb.lineCount();
+		const bool bounded = n <= 8 + 8 / 8 + 1 && sb.droppedLines() + n == 101;
+		const bool positions = sb.firstStreamPos() == sb.lineStreamPos(0) && sb.committedView().substr(0, sb.line(0).size()) == sb.line(0);
+		if (!bounded || !positions || sb.line(n - 2) != last + "\n" || !sb.line(n - 1).empty()) {
+			std::fprintf(stderr, "[Bench] check failed: Scrollback/limits\n");
+			ok = false;
+		}
+	}
+
+	// ScrollbackIndex::find: the bloom filter must not reject a line that has a match (count against a plain scan)
+	{
+		Scrollback sb(0, 0);
+		TerminalProcess tp;
+		tp.feedScrollback(syntheticPtyStream(64 * 1024));
+		sb.append(tp.getScrollback().committedView());
+		ScrollbackIndex index;
+		index.update(sb);
+		for (const char *needle : {"warning:", "no such text"}) {
+			const std::string_view all = sb.committedView();
+			size_t expect = 0;
+			for (size_t at = all.find(needle); at != std::string_view::npos; at = all.find(needle, at + 1))
+				++expect;
+			if (index.find(sb, needle, true).size() != expect) {
+				std::fprintf(stderr, "[Bench] check failed: ScrollbackIndex::find/%s\n", needle);
+				ok = false;
+			}
+		}
+	}
+
+	// Search hits → Text cells: hits carry line/column, Text::locateInLine adds a cell per soft wrap and none for
+	// glyph-less code points ('\t')
+	{
+		Scrollback sb(0, 0);
+		sb.append(std::string_view("first\n\t\tabcdefg\n"));
+		ScrollbackIndex index;
+		index.update(sb);
+		const auto hits = index.find(sb, "fg");
+		if (hits.size() != 1 || hits[0].line != 1 || hits[0].column != 7) {
+			std::fprintf(stderr, "[Bench] check failed: ScrollbackIndex::find/line+column\n");
+			ok = false;
+		}
+
+		std::unordered_map<uint32_t, Text::Glyph> glyphs;
+		for (char32_t c : std::u32string_view(U"abcdefg ")) {
+			Text::Glyph g;
+			g.advanceX = 10;
+			glyphs[uint32_t(c)] = g;
+		}
+		const std::u32string_view line = U"\t\tabcdefg"; // wraps before 'f' at 50 px
+		const Text::LinePos f = Text::locateInLine(line, 7, glyphs, 50.0f);
+		const Text::LinePos end = Text::locateInLine(line, 9, glyphs, 50.0f);
+		if (f.glyphs != 5 || f.wraps != 0 || !f.wrapsHere || end.glyphs != 7 || end.wraps != 1 || end.wrapsHere) {
+			std::fprintf(stderr, "[Bench] check failed: Text::locateInLine/wrap+tab\n");
+			ok = false;
+		}
+	}
+
+	// VtScreen: wide characters take two cells, CSI ? r (restore DEC private modes) is not DECSTBM
+	{
+		VtScreen vt(3, 4);
+		auto feed = [&](std::string_view s) { vt.feed(s.data(), s.size()); };
+		feed("a\xe4\xb8\xad"); // U+4E2D
+		const bool wide = vt.cell(0, 1).ch == U'\u4e2d' && vt.cell(0, 2).ch == VtScreen::kWideTail && vt.cursorCol() == 3;
+		feed("\xe4\xb8\xad"); // no room for both halves: wraps
+		const bool wrapped = vt.cursorRow() == 1 && vt.cell(1, 0).ch == U'\u4e2d' && vt.cursorCol() == 2;
+		feed("\x1b[2;1Hx"); // overwriting the left half blanks the right one
+		const bool overwritten = vt.cell(1, 0).ch == U'x' && vt.cell(1, 1).ch == U' ';
+		feed("\x1b[3;4H\x1b[?r");
+		const bool restoreModes = vt.cursorRow() == 2 && vt.cursorCol() == 3;
+		if (!wide || !wrapped || !overwritten || !restoreModes) {
+			std::fprintf(stderr, "[Bench] check failed: VtScreen/wide+CSI?r\n");
+			ok = false;
+		}
+	}
+
+	// TextureHeap::destroy: a retiring callback that releases more, like an atlas page losing its last cell at
+	// shutdown; what it queues must still run
+	{
+		bool pageDestroyed = false;
+		TextureHeap heap;
+		heap.release(TextureHeap::kInvalid, [&] { heap.release(TextureHeap::kInvalid, [&] { pageDestroyed = true; }); });
+		heap.destroy();
+		if (!pageDestroyed) {
+			std::fprintf(stderr, "[Bench] check failed: TextureHeap::destroy/release during shutdown\n");
+			ok = false;
+		}
+	}
+
+	// DrawPool::FreeList: offsets are multiples of the (vertex stride) alignment, gaps are reused, frees coalesce
+	{
+		DrawPool::FreeList list;
+		list.reset(1000);
+		VkDeviceSize a = 0, b = 0, c = 0, d = 0;
+		const bool placed = list.take(100, 1, a) && list.take(52, 52, b) && list.take(4, 1, c) && a == 0 && b == 104 && c == 100 && !list.take(1000, 1, d);
+		list.give(b, 52);
+		list.give(a, 100);
+		list.give(c, 4);
+		const bool merged = list.freeTotal() == 1000 && list.take(1000, 1, d) && d == 0;
+		if (!placed || !merged) {
+			std::fprintf(stderr, "[Bench] check failed: DrawPool::FreeList/align+coalesce\n");
+			ok = false;
+		}
+	}
+
+	return ok;
+}
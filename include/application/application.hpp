@@ -2,6 +2,8 @@
 
 #include "engine.hpp"
 
+#include <string>
+
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
@@ -11,6 +13,9 @@ class Application {
 	~Application();
 
 	int run();
+	// No window: render `frames` frames at a fixed 60 Hz step, optionally write the last one to `outPng`
+	// and a Chrome trace of the run to `traceJson` (turns the profiler on).
+	int runHeadless(uint32_t width, uint32_t height, uint32_t frames, const std::string &outPng, const std::string &traceJson = "");
 
   private:
 	GLFWwindow *window = nullptr;
@@ -239,8 +239,8 @@ inline VkShaderModule createShaderModule(VkDevice device, const std::vector<uint
 	return m;
 }
 
-inline ShaderModules compileShaderProgram(const std::string &shaderRootDir, VkDevice device) {
-	ShaderModules modules;
+// SPIR-V of every shader stage found in a program directory
+inline ShaderBinaries compileShaderDir(const std::string &shaderRootDir) {
 	std::vector<std::string> shader_paths;
 
 	for (const auto &entry : fs::directory_iterator(shaderRootDir)) {
@@ -250,7 +250,12 @@ inline ShaderModules compileShaderProgram(const std::string &shaderRootDir, VkDe
 		if (shaderExtensions.contains(ext))
 			shader_paths.push_back(entry.path().string());
 	}
-	auto bins = compileShader(shader_paths);
+	return compileShader(shader_paths);
+}
+
+inline ShaderModules compileShaderProgram(const std::string &shaderRootDir, VkDevice device) {
+	ShaderModules modules;
+	auto bins = compileShaderDir(shaderRootDir);
 
 	auto mk = [&](const std::vector<uint32_t> &bin) -> VkShaderModule { return bin.empty() ? VK_NULL_HANDLE : createShaderModule(device, bin); };
 	modules.vertexShader = mk(bins.vertexShader);
@@ -262,17 +267,21 @@ inline ShaderModules compileShaderProgram(const std::string &shaderRootDir, VkDe
 	return modules;
 }
 
-inline VkShaderModule compileShaderProgram(const std::string &shaderProgram, const shaderc_shader_kind &shaderKind, VkDevice device) {
+inline std::vector<uint32_t> compileShaderSource(const std::string &shaderProgram, const shaderc_shader_kind &shaderKind) {
 	shaderc::SpvCompilationResult result = gCompiler.CompileGlslToSpv(shaderProgram, shaderKind, "inline_shader", "main", gOptions);
 
 	if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
 		throw std::runtime_error(std::string("Shader compilation failed: ") + result.GetErrorMessage());
 	}
 
-	// 2. Convert SPIR-V to a vector<uint32_t> as Vulkan expects
-	std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+	// Convert SPIR-V to a vector<uint32_t> as Vulkan expects
+	return std::vector<uint32_t>(result.cbegin(), result.cend());
+}
+
+inline VkShaderModule compileShaderProgram(const std::string &shaderProgram, const shaderc_shader_kind &shaderKind, VkDevice device) {
+	std::vector<uint32_t> spirv = compileShaderSource(shaderProgram, shaderKind);
 
-	// 3. Create Vulkan shader module
+	// Create Vulkan shader module
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 	createInfo.codeSize = spirv.size() * sizeof(uint32_t);
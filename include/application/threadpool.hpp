@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool:
+// Process-wide worker threads for CPU work that must stay off the render thread (image decoding, SVG raster).
+// - Jobs run in submission order across hardware_concurrency() - 1 workers (at least one).
+// - Jobs must not touch Vulkan or model state: they hand their results back to the render thread, which
+//   polls for them (e.g. from an Events::onUpdate handler).
+// - Jobs still queued at shutdown are dropped; running ones are joined.
+// - waitIdle() blocks until nothing is queued or running (headless runs use it to make async work deterministic).
+class ThreadPool {
+  public:
+	using Job = std::function<void()>;
+
+	static ThreadPool &shared();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+	~ThreadPool();
+
+	void submit(Job job);
+	// returns once every submitted job (including ones submitted by jobs) has finished
+	void waitIdle();
+	size_t size() const { return workers.size(); }
+
+  private:
+	explicit ThreadPool(unsigned threads);
+	void run();
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::condition_variable idle; // signalled when `busy` drops to 0
+	std::deque<Job> jobs;
+	size_t busy{0}; // queued + running jobs
+	bool stopping{false};
+	std::vector<std::thread> workers;
+};
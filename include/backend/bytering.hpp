@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+// ByteRing:
+// Bounded lock-free single-producer / single-consumer byte queue (PTY reads on the I/O thread -> UI thread).
+// - Fixed power-of-two capacity allocated once; memory stays flat however fast the producer is.
+// - The producer reads straight into writeSpan() and publishes with commitWrite(); an empty span means full,
+//   and the producer has to stop (not grow), so back-pressure reaches the writer on the other end.
+// - Positions are free-running counters (wrap-around is handled by the mask), head/tail sit on separate
+//   cache lines so the two threads don't false-share.
+class ByteRing {
+  public:
+	static constexpr size_t kDefaultCapacity = size_t(1) << 20;
+
+	explicit ByteRing(size_t capacity = kDefaultCapacity);
+
+	ByteRing(const ByteRing &) = delete;
+	ByteRing &operator=(const ByteRing &) = delete;
+
+	size_t capacity() const { return mask + 1; }
+	size_t readable() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+	// producer
+	std::span<char> writeSpan(); // contiguous free space (may be shorter than the total free at the wrap point)
+	void commitWrite(size_t n);
+
+	// consumer
+	size_t read(char *out, size_t max); // copies up to `max` bytes, returns how many
+	void clear();						// drops everything unread
+
+  private:
+	std::unique_ptr<char[]> buf;
+	size_t mask;
+
+	alignas(64) std::atomic<size_t> head{0};  // written by the producer
+	alignas(64) std::atomic<size_t> tail{0};  // written by the consumer
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// IoReactor:
+// One epoll thread serving the read side of every terminal session (Linux).
+// - Blocks in epoll_wait with no timeout: it wakes exactly when a PTY has data, or on shutdown (eventfd).
+// - Handlers run on the reactor thread; their result keeps the fd armed, pauses it (taken out of the epoll set
+//   until resume(), e.g. while the consumer's ring is full) or removes it (EOF).
+// - remove() is synchronous: once it returns the handler is not running and never runs again. Handlers must
+//   not call back into the reactor.
+// - Created on first shared(); the application stops it with shutdown() during teardown, so the thread is joined
+//   while the process is still whole rather than during static destruction.
+class IoReactor {
+  public:
+	enum class Result { Continue, Pause, Remove };
+	using Handler = std::function<Result(int fd)>;
+
+	static IoReactor &shared();
+	static IoReactor *current(); // nullptr before the first shared() and after shutdown() (safe in destructors)
+	// Joins the reactor thread and drops every handler still registered; a later shared() starts a new one.
+	static void shutdown();
+
+	IoReactor(const IoReactor &) = delete;
+	IoReactor &operator=(const IoReactor &) = delete;
+	~IoReactor();
+
+	uint64_t add(int fd, Handler handler); // 0 on failure
+	void remove(uint64_t id);
+	void resume(uint64_t id); // re-arms a paused fd; no-op otherwise
+
+  private:
+	IoReactor();
+	void run();
+
+	struct Entry {
+		int fd;
+		Handler handler;
+		bool paused = false;
+	};
+
+	int epfd{-1};
+	int wakefd{-1};
+	std::thread thread;
+
+	std::mutex mtx; // held while a handler runs, so remove() can't race it
+	std::unordered_map<uint64_t, Entry> entries;
+	uint64_t nextId{1};
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+// Scrollback:
+// Line-indexed, bounded byte buffer for the terminal's filtered PTY output.
+// - Bytes live in one contiguous buffer; dropping the oldest lines only advances `head`, and the dead prefix
+//   is compacted away once it outgrows the live part (amortized O(1) per byte).
+// - Bounded by a line count and a byte budget (0 = unbounded); the current (unterminated) line is never dropped.
+//   Lines are dropped in batches once a limit is exceeded by 1/8, so consumers that re-lay out on a front
+//   trim pay for it once per batch rather than once per line.
+// - The editable input line is kept as a tail right after the committed bytes, so view() hands the
+//   renderer scrollback + input without building a concatenated copy.
+// Positions are stream offsets (bytes since the terminal started), so they stay stable while old lines drop.
+class Scrollback {
+  public:
+	static constexpr size_t kDefaultMaxLines = 100000;
+	static constexpr size_t kDefaultMaxBytes = size_t(32) << 20;
+
+	Scrollback(size_t maxLines = kDefaultMaxLines, size_t maxBytes = kDefaultMaxBytes);
+
+	void setLimits(size_t maxLines, size_t maxBytes);
+	size_t getMaxLines() const { return maxLines; }
+	size_t getMaxBytes() const { return maxBytes; }
+
+	// committed output
+	void push_back(char c);
+	void append(const char *s, size_t n);
+	void append(std::string_view s) { append(s.data(), s.size()); }
+	void pop_back();
+	void truncateLine(); // CR: drop everything after the last '\n', O(1)
+	void clear();
+
+	bool empty() const { return size() == 0; }
+	size_t size() const { return committedEnd() - head; } // committed bytes (no tail)
+	char back() const { return buf[committedEnd() - 1]; }
+
+	// editable line shown after the committed bytes
+	void setTail(std::string_view s);
+	const std::string &getTail() const { return tail; }
+
+	// committed + tail; valid until the next mutation
+	std::string_view view();
+	std::string_view committedView() const { return std::string_view(buf).substr(head, size()); }
+
+	// live lines (the last one is the current line, possibly empty)
+	size_t lineCount() const { return lineStarts.size(); }
+	std::string_view line(size_t i) const;
+	uint64_t lineStreamPos(size_t i) const { return lineStarts[i]; }
+	uint64_t droppedLines() const { return dropped; }
+	uint64_t firstStreamPos() const { return origin + head; }
+	uint64_t endStreamPos() const { return origin + committedEnd(); }
+
+	// Lowest committed end (stream position) since the last call: committed bytes before it are unchanged
+	// (CR/BS/clear can rewrite the current line). Resets to the current end.
+	uint64_t takeStableEnd();
+
+  private:
+	size_t committedEnd() const { return tailAttached ? buf.size() - tail.size() : buf.size(); }
+	void detachTail() {
+		if (tailAttached) {
+			buf.resize(buf.size() - tail.size());
+			tailAttached = false;
+		}
+	}
+	void enforceLimits();
+	void compact();
+	void lowerStableEnd() { stableEnd = std::min(stableEnd, endStreamPos()); }
+
+	std::string buf;
+	size_t head = 0;	 // index in buf of the first live byte
+	uint64_t origin = 0; // stream position of buf[0]
+	std::deque<uint64_t> lineStarts;
+	uint64_t dropped = 0;
+	uint64_t stableEnd = 0;
+
+	std::string tail;
+	bool tailAttached = false;
+
+	size_t maxLines;
+	size_t maxBytes;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "scrollback.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ScrollbackIndex:
+// Incremental search index over a Scrollback's completed lines.
+// - One entry per line: a 256-bit bloom filter of its (ASCII-lowercased) trigrams, with SGR sequences stripped,
+//   plus its visible character count. A hit carries its line and column too: what Text needs to map it to its
+//   own character indices (Text::charRangeAt), which soft wraps and glyph-less characters shift.
+// - update() indexes lines completed since the last call and forgets lines the scrollback dropped; the current
+//   (unterminated) line can still change and is scanned linearly at query time.
+// - find() skips every line whose bloom lacks one of the query's trigrams and verifies the rest with an SSE2
+//   first/last-byte substring scan.
+class ScrollbackIndex {
+  public:
+	struct Hit {
+		uint64_t lineStreamPos; // Scrollback stream position of the line's first byte
+		size_t textStart;		// Text character index of the first matched character
+		size_t textEnd;			// one past the last
+		size_t line;			// sb.line() index at find() time
+		size_t column;			// code point column of textStart in that line
+	};
+
+	void update(const Scrollback &sb);
+	void clear();
+
+	// Needle matched against visible text (no SGR); ignoreCase folds ASCII only. Requires update() first.
+	std::vector<Hit> find(const Scrollback &sb, std::string_view needle, bool ignoreCase = false, size_t maxHits = 10000) const;
+
+	size_t indexedLines() const { return lines.size(); }
+
+  private:
+	struct Line {
+		uint64_t streamPos;
+		uint64_t visibleStart; // running count of visible characters (including '\n') before this line
+		bool plain;			   // no ESC: the raw bytes are the visible text
+		uint64_t bloom[4];
+	};
+
+	void add(std::string_view raw, uint64_t streamPos);
+
+	std::deque<Line> lines; // lines[i] mirrors sb.line(i) for every completed live line
+	uint64_t visibleEnd = 0; // visibleStart of the next line
+	std::string scratch;
+};
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "bytering.hpp"
+#include "scrollback.hpp"
+#include "scrollbackindex.hpp"
+#include "vtscreen.hpp"
+
 #include <atomic>
 #include <memory>
-#include <mutex>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <vector>
 
 class Text;
 
@@ -27,25 +32,77 @@ class TerminalProcess {
 	// We only care about positions >= maxCursorIndex (inside the input line).
 	void setCaretFromAbsolutePos(size_t absolutePos);
 
+	// Scrollback bounds (0 = unbounded); the oldest lines are dropped first.
+	void setScrollbackLimits(size_t maxLines, size_t maxBytes) { scrollback.setLimits(maxLines, maxBytes); }
+
+	// Finds `needle` in the scrollback and selects every match in Text; returns the match count.
+	size_t search(std::string_view needle, bool ignoreCase = false);
+	const std::vector<ScrollbackIndex::Hit> &searchResults() const { return searchHits; }
+
+	// Terminal size reported to the child (TIOCSWINSZ) and used by the screen model; default 24x80.
+	void setGridSize(int rows, int cols);
+
+	// Most PTY bytes flushUI() filters per call; the rest stays queued for the next frame (and, once the
+	// ring is full, in the kernel: the child blocks on write). A cut frame ends on a line boundary.
+	static constexpr size_t kDefaultOutputBudget = size_t(256) << 10;
+	void setOutputBudget(size_t bytesPerFrame) { outputBudget = bytesPerFrame ? bytesPerFrame : kDefaultOutputBudget; }
+
+	// Replay hook (recorded PTY streams, bench/): runs bytes through the VT filter into the scrollback without a
+	// child. The screen model, the search index and Text don't see them.
+	Action feedScrollback(std::string_view bytes) { return filter(bytes); }
+	const Scrollback &getScrollback() const { return scrollback; }
+	void clearScrollback() {
+		scrollback.clear();
+		searchIndex.clear();
+		searchHits.clear();
+		dirty.store(true, std::memory_order_release);
+	}
+
   private:
 	// Filter/clean VT sequences from PTY output and append to scrollback.
-	Action filter(const std::string &s);
+	Action filter(std::string_view s);
+	void resetFilter();
+	// Alternate screen (full-screen TUIs): push the damaged rows of the cell grid to Text.
+	void flushGrid();
 
 	struct TerminalBackend;
 	std::shared_ptr<TerminalBackend> backend;
 
 	Text *textModel{nullptr};
 
-	std::thread reader;
+	uint64_t ioId{0}; // registration with the shared IoReactor (PTY reads)
+	std::atomic<bool> outputPaused{false}; // reactor stopped reading because `output` was full
 	std::atomic<bool> running{false};
 	std::atomic<bool> dirty{false};
-	std::mutex mtx;
-	std::string pending; // raw bytes from PTY waiting to be filtered
+	ByteRing output;	 // raw PTY bytes, reactor thread -> flushUI
+	std::string pending; // staging for one frame's worth of `output`
+	size_t carried{0};	 // bytes at the front of `pending` held back by the last flush (cut at a line end)
+	size_t outputBudget{kDefaultOutputBudget};
+
+	// filter() state across calls: a read can end between CR and LF or inside an escape sequence
+	enum class FilterState { Normal, Esc, Csi, String };
+	static constexpr size_t kMaxFilterSeq = 256; // longer CSI parameter runs are dropped
+	FilterState filterState{FilterState::Normal};
+	bool pendingCR{false};	// CR seen, waiting for the next byte (LF: newline, anything else: back to BOL)
+	bool stringEsc{false};	// OSC/DCS string ended on ESC (the first half of ST)
+	std::string filterSeq;	// CSI parameters read so far
 
 	// Rendering model
-	std::string scrollback; // PTY output (filtered)
-	std::string inputLine;	// editable command line
-	std::string screen;		// scrollback + inputLine (what Text sees)
+	Scrollback scrollback; // PTY output (filtered); its view() is scrollback + inputLine (what Text sees)
+	ScrollbackIndex searchIndex; // follows `scrollback` line by line
+	std::vector<ScrollbackIndex::Hit> searchHits;
+	std::string inputLine; // editable command line
+
+	// What Text currently shows (flushUI only pushes the difference)
+	uint64_t shownFirst{~uint64_t(0)}; // stream position of Text's first byte
+	uint64_t shownEnd{0};			   // committed end at the last flush
+	std::string shownInput;
+
+	// Screen model: sees every PTY byte. Main-screen output also goes through filter() into the scrollback;
+	// while the alternate screen is active Text shows the grid instead.
+	VtScreen vt;
+	std::vector<std::string> gridRows; // serialized rows Text currently shows (empty = not showing the grid)
+	std::vector<uint8_t> gridDamage;
 
 	// Cursor bookkeeping
 	size_t caretInInput{0};	  // cursor index inside inputLine (0..inputLine.size())
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// VtScreen:
+// VT100/xterm terminal state: a fixed rows x cols cell grid (main + alternate screen), cursor with pending
+// wrap, scroll region, SGR foreground colors and the usual cursor/erase/insert/delete/scroll CSI set.
+// - feed() parses PTY output; it returns early right after a main <-> alternate screen switch so the
+//   caller can route the bytes on either side differently.
+// - Every cell change marks its row damaged; takeDamage() hands the rows over so only those get re-laid out.
+// - Queries (DSR, DA) are answered through takeReplies(), to be written back to the PTY.
+// - Wide (East Asian / emoji) characters take two cells: the character, then a kWideTail cell.
+class VtScreen {
+  public:
+	struct Cell {
+		char32_t ch = U' ';
+		int8_t fg = -1;	   // -1 = default, 0..15 = ANSI palette
+		uint8_t attrs = 0; // kBold | kReverse
+	};
+	static constexpr uint8_t kBold = 1, kReverse = 2;
+	static constexpr char32_t kWideTail = 0; // right half of the wide character in the cell before it
+
+	// 2 for East Asian wide/fullwidth characters and emoji, else 1
+	static int charWidth(char32_t cp);
+
+	VtScreen(int rows = 24, int cols = 80);
+
+	void resize(int rows, int cols);
+	void reset();
+
+	size_t feed(const char *data, size_t n);
+
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	int cursorRow() const { return cur.row; }
+	int cursorCol() const { return cur.col; }
+	bool cursorVisible() const { return showCursor; }
+	bool altScreenActive() const { return alt; }
+	bool applicationCursorKeys() const { return appCursorKeys; }
+	const Cell &cell(int r, int c) const { return grid()[size_t(r) * cols + c]; }
+
+	// damaged rows since the last call (resized to getRows()); false when nothing changed
+	bool takeDamage(std::vector<uint8_t> &rowsOut);
+	std::string takeReplies();
+
+  private:
+	enum class State { Ground, Escape, EscapeIntermediate, Csi, Osc, String };
+
+	struct Cursor {
+		int row = 0, col = 0;
+		int8_t fg = -1;
+		uint8_t attrs = 0;
+		bool wrapPending = false;
+	};
+
+	std::vector<Cell> &grid() { return alt ? altCells : mainCells; }
+	const std::vector<Cell> &grid() const { return alt ? altCells : mainCells; }
+	Cell blank() const { return Cell{U' ', -1, 0}; }
+
+	void damage(int r) {
+		rowDamage[size_t(r)] = 1;
+		anyDamage = true;
+	}
+	void damageRange(int r0, int r1);
+	void damageAll() { damageRange(0, rows - 1); }
+
+	void print(char32_t cp);
+	void control(unsigned char c);
+	void escDispatch(unsigned char c);
+	void csiDispatch(unsigned char final);
+	void sgr();
+	void setMode(int mode, bool on);
+	void switchScreen(bool toAlt, bool saveCursor, bool clear);
+
+	void lineFeed();
+	void reverseIndex();
+	void scrollUp(int top, int bottom, int n);
+	void scrollDown(int top, int bottom, int n);
+	void eraseCells(int row, int c0, int c1);
+	void eraseRows(int r0, int r1);
+	void clampCursor();
+	int param(size_t i, int def) const { return (i < params.size() && params[i] > 0) ? params[i] : def; }
+
+	int rows, cols;
+	std::vector<Cell> mainCells, altCells;
+	std::vector<uint8_t> rowDamage;
+	bool anyDamage = true;
+
+	Cursor cur, savedMain, savedAlt;
+	int scrollTop = 0, scrollBottom = 0;
+	bool alt = false;
+	bool autowrap = true;
+	bool showCursor = true;
+	bool appCursorKeys = false;
+	bool screenSwitched = false;
+
+	// parser
+	State state = State::Ground;
+	std::vector<int> params;
+	bool paramStarted = false;
+	char privateMarker = 0;
+	bool stringEsc = false; // ESC seen inside OSC/string (ST = ESC \)
+	char32_t utf8Cp = 0;
+	int utf8Need = 0;
+
+	std::string replies;
+};
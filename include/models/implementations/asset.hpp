@@ -39,7 +39,7 @@ class Asset : public Model {
 		glm::vec4 outlineColor = Colors::Transparent(0.0f); // loc 13
 		float outlineWidth = 0.0f;							// loc 14
 		uint32_t bonesBase;									// loc 12
-		float _pad0{};										// keep 16B alignment
+		float _pad0{}, _pad1{};								// keep 16B alignment (sizeof == 96)
 	};
 
 	// ---------- lifecycle ----------
@@ -59,7 +59,6 @@ class Asset : public Model {
 	void setBones(int id, std::span<const glm::mat4> palette);
 
 	// ---------- Model virtuals we extend ----------
-	uint32_t createDescriptorPool() override;
 	void createDescriptors() override;
 	void createGraphicsPipeline() override;
 	void record(VkCommandBuffer cmd) override; // flush bones before draw & guard null buffers
@@ -107,3 +106,9 @@ class Asset : public Model {
 	void createOutlinePipeline();
 	void recordOutline(VkCommandBuffer cmd);
 };
+
+template <> struct InstanceLayout::Describe<Asset::InstanceData> {
+	using D = Asset::InstanceData;
+	static constexpr bool std430 = true;
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 6), INSTANCE_FIELD(D, outlineColor, 13), INSTANCE_FIELD(D, outlineWidth, 14), INSTANCE_FIELD(D, bonesBase, 12)};
+};
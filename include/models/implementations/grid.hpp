@@ -38,3 +38,9 @@ class Grid : public Model {
   private:
 	void buildUnitQuadMesh();
 };
+
+template <> struct InstanceLayout::Describe<Grid::InstanceData> {
+	using D = Grid::InstanceData;
+	static constexpr bool std430 = false; // vertex input only
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 1), INSTANCE_FIELD(D, color, 5), INSTANCE_FIELD(D, cellSize, 6), INSTANCE_FIELD(D, lineWidth, 7), INSTANCE_FIELD(D, plane, 8)};
+};
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "model.hpp"
+#include "textureatlas.hpp"
+#include "texturecodec.hpp"
+#include "textureheap.hpp"
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -21,27 +26,58 @@ class Image : public Model {
 	// Instance management
 	struct InstanceData {
 		glm::mat4 model{1.0f};
-		uint32_t frameIndex{0}; // GLOBAL index in the merged texture pool (computed internally)
+		uint32_t frameIndex{0}; // TextureHeap slot of the active frame (computed internally)
 		uint32_t cover{0};
-		uint32_t _pad1{0}, _pad2{0}; // std140 alignment
-		vec2 uvScale;
-		vec2 uvOffset;
+		uint32_t frameBase{0};	// playing: first frame-table entry of its frames (computed internally)
+		uint32_t frameCount{0}; // playing: number of frames; 0 shows frameIndex
+		vec2 uvScale;  // sub-rectangle of the sampled image holding the frame (computed internally):
+		vec2 uvOffset; // its TextureAtlas cell, or all of it
+		float fps{0.0f};	   // playing (computed internally, see play())
+		float startTime{0.0f}; // playing: seconds on this Image's clock (computed internally, rebased)
+		uint32_t playback{0};  // playing: Playback
+		uint32_t _pad{0};	   // std430 alignment
+	};
+
+	// Sprite animation, played on the GPU: the vertex shader picks the frame from the clock pushed with each draw,
+	// so a playing instance costs no CPU work per frame.
+	enum class Playback : uint32_t {
+		Loop = 0,
+		Once = 1,	  // holds the last frame
+		PingPong = 2, // 0..N-1..1, repeated
 	};
 
 	// Create/update an instance’s frames:
 	// - upsert(id, path): single-frame instance (replace if already present)
 	// - upsert(id, paths): multi-frame instance (replace if already present)
+	// Returns immediately: new paths decode on the ThreadPool and show a transparent placeholder until they land.
 	void upsert(int id, const string &path);
 	void upsert(int id, const vector<string> &paths);
 
-	// Change the active *local* frame for an instance (0..frameCount-1). Clamped.
+	// Change the active *local* frame for an instance (0..frameCount-1). Clamped; stops playback.
 	void setFrame(int id, uint32_t frameIndex);
 
+	// Play instance `id`'s frames at `fps`, starting now (`delaySeconds` later; negative starts part-way through).
+	// Instances playing the same frame list share its frame-table entries; upsert() keeps an instance playing.
+	// When the table (kFrameTableSize entries) has no room for a new list, it is logged and the instance doesn't play.
+	void play(int id, float fps, Playback mode = Playback::Loop, float delaySeconds = 0.0f);
+	void stop(int id); // shows the frame set with setFrame() again
+	bool isPlaying(int id) const { return animations.count(id) > 0; }
+
 	void erase(int id);
 
-	// Query how many GPU textures we have
-	uint32_t textureCount() const { return static_cast<uint32_t>(gpuTextures.size()); }
+	// Block compression for paths decoded from now on (default None). Results are cached as KTX2 under
+	// Assets::appdataPath, keyed by the source file's hash; ignored on devices without textureCompressionBC.
+	// Every texture gets a full mip chain; .ktx2 paths load as stored.
+	void setCompression(TextureCodec::Compression c) { compression = c; }
+
+	// Pack frames uploaded from now on into the engine's TextureAtlas when they are small enough (default on).
+	// Only uncompressed frames are packed, and they are sampled without mips.
+	void setAtlas(bool enabled) { atlasEnabled = enabled; }
 
+	// Query how many GPU textures we have (one per distinct path)
+	uint32_t textureCount() const { return static_cast<uint32_t>(textures.size()); }
+
+	// Pixel size of instance `idx`'s local frame `texIdx` (1×1 if either is unknown)
 	vec2 getPixelDimensions(int idx, int texIdx);
 
 	void recalcUV();
@@ -50,7 +86,6 @@ class Image : public Model {
 
   protected:
 	// Model hooks
-	uint32_t createDescriptorPool() override;
 	void createDescriptors() override;
 	void createGraphicsPipeline() override;
 
@@ -68,55 +103,113 @@ class Image : public Model {
 		VkImageView view{VK_NULL_HANDLE};
 		VkSampler sampler{VK_NULL_HANDLE};
 		uint32_t w{0}, h{0};
+		uint32_t heapIndex{TextureHeap::kInvalid};
+		TextureAtlas::Region region; // valid(): packed in an atlas page, which owns the image objects
 	};
 
-	// CPU pixels for staging
-	struct CpuPixels {
-		int w{0}, h{0}, comp{4};
-		std::vector<uint8_t> rgba;
+	// A frame of a playing frame list, as the vertex shader reads it (set=0, binding=2, std430)
+	struct FrameRef {
+		vec2 uvScale{1.0f};
+		vec2 uvOffset{0.0f};
+		uint32_t heapIndex{TextureHeap::kInvalid};
+		uint32_t _pad[3]{};
 	};
 
-	bool set1Dirty = false;
+	// Frame-table entries of a frame list, shared by every instance playing it
+	struct FrameRange {
+		uint32_t base{0}, count{0};
+		uint32_t refs{0};
+	};
 
-	uint32_t cpuTextureCount() const { return static_cast<uint32_t>(cpuFrames.size()); }
+	struct Animation {
+		float fps{0.0f};
+		double startTime{0.0}; // on clockSeconds
+		Playback mode{Playback::Loop};
+		std::map<std::vector<std::string>, FrameRange>::iterator range;
+	};
 
-	void writeSet1Descriptors();
-	void ensureSet1Ready();
+	// CPU texture (levels in their final format) for staging
+	using CpuPixels = TextureCodec::Texture;
+
+	// A decoded/uploaded path and the number of instance frames showing it
+	struct CachedTex {
+		GpuTex tex;
+		uint32_t refs{0};
+		bool pending{true}; // decode in flight: frames show the placeholder
+	};
+
+	// Decoded pixels handed back from the ThreadPool; drained on the render thread by pumpDecodes()
+	struct DecodeInbox {
+		std::mutex mtx;
+		std::vector<std::pair<std::string, CpuPixels>> done;
+	};
 
 	void upsertInternal(int id, const InstanceData &data);
+	void writeInstance(int id); // instance data for the active frame (heap index + uv crop), keeping its transform
 
 	// ----- Mesh & buffers -----
 	void buildUnitQuadMesh(); // 2 triangles, Z=0, UVs in [0,1]
 
 	// ----- Dynamic frames management -----
-	// Public-facing “database” of frames by instance (authoritative).
+	// Public-facing “database” of frames by instance (authoritative). An instance without paths holds {""}.
 	std::map<int, std::vector<std::string>> framesPerInstance;
 
-	// Instance shadow to remember transforms and selected *local* frame across rebuilds.
+	// Instance shadow to remember transforms and selected *local* frame across updates.
 	std::unordered_map<int, glm::mat4> instanceModel;	  // id -> model
 	std::unordered_map<int, uint32_t> instanceLocalFrame; // id -> local frame index (0..N_i-1)
 
-	// Rebuild the flattened texture pool and descriptor set from framesPerInstance.
-	void rebuildTexturePool();
-
-	// Load all frames (CPU), then upload to GPU and create descriptors.
-	void loadAllFramesCPU(const std::map<int, std::vector<std::string>> &framesPerInstance);
-	void uploadAllFramesGPU(); // uses a small staging path
+	// ----- Texture cache -----
+	// Path-keyed and refcounted: each distinct path is decoded and uploaded once, however many frames show it,
+	// and released (through the TextureHeap) when the last one goes. "" is a 1×1 white texture; a path that fails
+	// to load caches a 1×1 magenta one.
+	std::unordered_map<std::string, CachedTex> textures;
+	GpuTex placeholder; // 1×1 transparent, sampled by frames whose decode is in flight
+
+	void acquireTexture(const std::string &path); // a miss queues a decode
+	void releaseTextureRef(const std::string &path);
+	const GpuTex *frameTexture(int id, uint32_t local) const; // nullptr while pending
+
+	// ----- Animation -----
+	static constexpr uint32_t kFrameTableSize = 4096;		 // entries of all frame lists being played
+	static constexpr double kClockRebaseSeconds = 1024.0; // float seconds below this are exact to ~0.1 ms
+	std::unordered_map<int, Animation> animations;
+	std::map<std::vector<std::string>, FrameRange> frameRanges;
+	std::vector<std::pair<uint32_t, uint32_t>> freeFrameEntries{{0u, kFrameTableSize}}; // (base, count), by base
+	VkBuffer frameTableBuffer{VK_NULL_HANDLE};
+	VkDeviceMemory frameTableMemory{VK_NULL_HANDLE};
+	FrameRef *mappedFrameTable{nullptr};
+	double clockSeconds{0.0}; // advanced by Events::onUpdate; pushed to the shaders with each draw
+	double clockBase{0.0};	  // the shaders get float seconds relative to this (see rebaseClock)
+
+	static FrameRef frameRef(const GpuTex &tex);
+	FrameRef frameRef(const std::string &path) const; // the placeholder while pending
+	bool startAnimation(int id);					  // acquires the range of the instance's frame list; false when full
+	void stopAnimation(int id);
+	void writeFrameRange(const std::vector<std::string> &frames, const FrameRange &range);
+	void rebaseClock(); // moves clockBase to now, dropping whole periods from the animations' start times
+
+	// ----- Async decode -----
+	std::shared_ptr<DecodeInbox> inbox = std::make_shared<DecodeInbox>();
+	std::string updateEventId;
+	void pumpDecodes(); // uploads what landed since the last call, then patches the instances showing it
+
+	TextureCodec::Compression compression{TextureCodec::Compression::None};
+	bool bcSupported{false};
+	bool atlasEnabled{true};
+
+	static CpuPixels decode(const std::string &path, TextureCodec::Compression compression, bool bcSupported);
+	// one staging buffer and one submit for the whole batch; registers each texture in the TextureHeap
+	std::vector<GpuTex> upload(const std::vector<const CpuPixels *> &batch);
 	void destroyAllTextures();
+	void releaseTexture(GpuTex &t); // image objects are destroyed once no frame in flight samples them
 
-	// Helpers for Vulkan image upload
-	void transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
-	void copyBufferToImage(VkBuffer staging, VkImage img, uint32_t w, uint32_t h);
-
-	// ----- Flattened pool & per-instance mapping -----
-	std::vector<CpuPixels> cpuFrames;
-	std::vector<GpuTex> gpuTextures;
-
-	// For each instance: first texture global index and count
-	std::unordered_map<int, uint32_t> instanceFirstIndex;
-	std::unordered_map<int, uint32_t> instanceFrameCount;
+	// Helpers for Vulkan image upload (recorded into the batch's command buffer)
+	void transition(VkCommandBuffer cmd, VkImage img, uint32_t levels, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+	void copyBufferToImage(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, VkImage img, const CpuPixels &tex);
+};
 
-	// Descriptor set layout for images (set=1, binding=0)
-	// We'll write N VkDescriptorImageInfo (one per texture)
-	std::vector<VkDescriptorImageInfo> imageInfos;
+template <> struct InstanceLayout::Describe<Image::InstanceData> {
+	using D = Image::InstanceData;
+	static constexpr bool std430 = true;
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 2), INSTANCE_FIELD(D, frameIndex, 6), INSTANCE_FIELD(D, cover, 7), INSTANCE_FIELD(D, uvScale, 8), INSTANCE_FIELD(D, uvOffset, 9), INSTANCE_FIELD(D, frameBase, 10), INSTANCE_FIELD(D, frameCount, 11), INSTANCE_FIELD(D, fps, 12), INSTANCE_FIELD(D, startTime, 13), INSTANCE_FIELD(D, playback, 14)};
 };
@@ -38,3 +38,9 @@ class Line : public Model {
 
 	void buildUnitQuadMesh();
 };
+
+template <> struct InstanceLayout::Describe<Line::InstanceData> {
+	using D = Line::InstanceData;
+	static constexpr bool std430 = false; // vertex input only (p2 sits at a 12-byte offset)
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 1), INSTANCE_FIELD(D, p1, 5), INSTANCE_FIELD(D, p2, 6), INSTANCE_FIELD(D, color, 7), INSTANCE_FIELD(D, lineWidth, 8)};
+};
@@ -29,6 +29,8 @@ class Polygon : public Model {
 		vec3 bary;
 		vec3 edgeMask;
 	};
+	// Un-indexes the triangles and tags each corner with barycentrics and its outline edges (instantiated for Vertex)
+	template <typename T> static void expandForOutlines(const std::vector<T> &inVerts, const std::vector<uint32_t> &inIdx, std::vector<Attributes> &outVerts, std::vector<uint32_t> &outIdx);
 
 	// Initialize GPU buffers and pipeline inputs. Expands verts to barycentric form.
 	void init(const std::vector<Vertex> &verts, const std::vector<uint32_t> &idx);
@@ -50,10 +52,14 @@ class Polygon : public Model {
 		size_t operator()(const EdgeKey &k) const noexcept { return (size_t(k.a) << 32) ^ size_t(k.b); }
 	};
 
-	template <typename T> static void expandForOutlines(const std::vector<T> &inVerts, const std::vector<uint32_t> &inIdx, std::vector<Attributes> &outVerts, std::vector<uint32_t> &outIdx);
-
 	bool cull_ = false;
 
 	std::vector<Attributes> s_cpuVerts;
 	std::vector<uint32_t> s_cpuIdx;
 };
+
+template <> struct InstanceLayout::Describe<Polygon::InstanceData> {
+	using D = Polygon::InstanceData;
+	static constexpr bool std430 = true;
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 4), INSTANCE_FIELD(D, color, 8), INSTANCE_FIELD(D, outlineColor, 9), INSTANCE_FIELD(D, outlineWidth, 10)};
+};
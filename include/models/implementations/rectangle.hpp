@@ -30,3 +30,9 @@ class Rectangle : public Model {
   private:
 	void buildUnitQuadMesh();
 };
+
+template <> struct InstanceLayout::Describe<Rectangle::InstanceData> {
+	using D = Rectangle::InstanceData;
+	static constexpr bool std430 = true;
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 1), INSTANCE_FIELD(D, color, 5), INSTANCE_FIELD(D, outlineColor, 6), INSTANCE_FIELD(D, outlineWidth, 7), INSTANCE_FIELD(D, borderRadius, 8)};
+};
@@ -3,14 +3,22 @@
 #include "model.hpp"
 #include "scene.hpp"
 
+// shared by every ShaderQuad<PC> so it can carry one InstanceLayout
+struct ShaderQuadInstance {
+	mat4 model{1.0f};
+};
+
+template <> struct InstanceLayout::Describe<ShaderQuadInstance> {
+	static constexpr bool std430 = true;
+	static constexpr std::array fields{INSTANCE_FIELD(ShaderQuadInstance, model, 1)};
+};
+
 template <typename PC> class ShaderQuad : public Model {
   public:
 	ShaderQuad(Scene *scene) : Model(scene) {}
 	~ShaderQuad() = default;
 
-	struct InstanceData {
-		mat4 model{1.0f};
-	};
+	using InstanceData = ShaderQuadInstance;
 
 	struct Vertex {
 		vec3 pos;
@@ -21,9 +29,8 @@ template <typename PC> class ShaderQuad : public Model {
 	void init() override {
 		engine = scene->getEngine();
 		buildUnitQuadMesh();
-		initInfo.instanceStrideBytes = sizeof(InstanceData);
-		initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/shaderquad", scene->getDevice());
-		initInfo.shaders.fragmentShader = Assets::compileShaderProgram(fragmentShader, shaderc_glsl_fragment_shader, scene->getDevice());
+		initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/shaderquad", scene->getDevice());
+		initInfo.shaders.fragmentShader = PipelineRegistry::get().shaderSource(fragmentShader, shaderc_glsl_fragment_shader, scene->getDevice());
 
 		pipeline->graphicsPipeline.pushConstantRangeCount = 1;
 		pipeline->graphicsPipeline.pushContantRanges.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -81,12 +88,8 @@ template <typename PC> class ShaderQuad : public Model {
 		using F = VkFormat;
 		m.vertexAttrs = {
 			{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
-
-			{1, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-			{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-			{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-			{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
 		};
+		setInstanceLayout<InstanceData>(m);
 
 		initInfo.mesh = m;
 	}
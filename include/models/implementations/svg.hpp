@@ -2,8 +2,13 @@
 
 #include "colors.hpp"
 #include "model.hpp"
+#include "textureatlas.hpp"
+#include "textureheap.hpp"
 
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -22,10 +27,10 @@ class SVG : public Model {
 	// Instance management
 	struct InstanceData {
 		glm::mat4 model{1.0f};
-		uint32_t frameIndex{0}; // GLOBAL index in the merged texture pool
+		uint32_t frameIndex{0}; // TextureHeap slot of the active frame
 		vec4 color = Colors::White;
-		glm::vec2 uvScale{1.0f};
-		glm::vec2 uvOffset{0.0f};
+		glm::vec2 uvScale{1.0f};  // sub-rectangle of the sampled image holding the raster (computed internally):
+		glm::vec2 uvOffset{0.0f}; // its TextureAtlas cell, or all of it
 	};
 
 	// CPU pixels for staging
@@ -34,7 +39,8 @@ class SVG : public Model {
 		std::vector<uint8_t> rgba;
 	};
 
-	// Same API as Image: single- or multi-frame per instance
+	// Same API as Image: single- or multi-frame per instance. Returns immediately: new paths rasterize on the
+	// ThreadPool and show a transparent placeholder until they land.
 	void upsert(int id, const string &path);
 	void upsert(int id, const vector<string> &paths);
 
@@ -43,8 +49,19 @@ class SVG : public Model {
 
 	void erase(int id);
 
-	uint32_t textureCount() const { return static_cast<uint32_t>(gpuTextures.size()); }
+	// Rasters are square, sized by power-of-two buckets from each instance's on-screen extent (see refreshRasterSizes)
+	static constexpr uint32_t kMinRasterPx = 32;
+	static constexpr uint32_t kMaxRasterPx = 2048;
+	static constexpr uint32_t kDefaultRasterPx = 256; // until the instance has been on screen
+	static constexpr size_t kUnusedRasterBytes = size_t(32) << 20; // LRU budget for rasters no instance shows
 
+	// Pack rasters uploaded from now on into the engine's TextureAtlas when they are small enough (default on)
+	void setAtlas(bool enabled) { atlasEnabled = enabled; }
+
+	// Query how many GPU textures we have (one per distinct path and raster size, including unused cached ones)
+	uint32_t textureCount() const { return static_cast<uint32_t>(textures.size()); }
+
+	// Pixel size of instance `idx`'s local frame `texIdx` (1×1 if either is unknown or still rasterizing)
 	glm::vec2 getPixelDimensions(int idx, int texIdx);
 
 	void recalcUV();
@@ -52,7 +69,6 @@ class SVG : public Model {
 	void record(VkCommandBuffer cmd) override;
 
   protected:
-	uint32_t createDescriptorPool() override;
 	void createDescriptors() override;
 	void createGraphicsPipeline() override;
 
@@ -70,37 +86,82 @@ class SVG : public Model {
 		VkImageView view{VK_NULL_HANDLE};
 		VkSampler sampler{VK_NULL_HANDLE};
 		uint32_t w{0}, h{0};
+		uint32_t heapIndex{TextureHeap::kInvalid};
+		TextureAtlas::Region region; // valid(): packed in an atlas page, which owns the image objects
+	};
+
+	// (path, raster size in px)
+	using RasterKey = std::pair<std::string, uint32_t>;
+
+	// A rasterized/uploaded path at one size and the number of instance frames holding it
+	struct CachedTex {
+		GpuTex tex;
+		uint32_t refs{0};
+		bool pending{true};					  // raster in flight: frames show the placeholder
+		std::list<RasterKey>::iterator unused; // position in `lru` while refs == 0
 	};
 
-	bool set1Dirty = false;
+	// Rasterized pixels handed back from the ThreadPool; drained on the render thread by pumpDecodes()
+	struct DecodeInbox {
+		std::mutex mtx;
+		std::vector<std::pair<RasterKey, CpuPixels>> done;
+	};
 
-	void writeSet1Descriptors();
-	void ensureSet1Ready();
+	// Raster size an instance shows, and the one being rasterized for it after its on-screen size changed
+	// (the old rasters stay on screen until the new active frame lands)
+	struct InstanceRaster {
+		uint32_t shown{kDefaultRasterPx};
+		uint32_t target{kDefaultRasterPx};
+	};
 
 	void upsertInternal(int id, const InstanceData &data);
+	void writeInstance(int id); // instance data for the active frame, keeping its transform and color
 
 	void buildUnitQuadMesh(); // 2 triangles, Z=0, UVs in [0,1]
 
-	// Public-facing “database” of frames by instance (same as Image)
+	// Public-facing “database” of frames by instance (same as Image). An instance without paths holds {""}.
 	std::map<int, std::vector<std::string>> framesPerInstance;
 	std::unordered_map<int, glm::mat4> instanceModel;
 	std::unordered_map<int, uint32_t> instanceLocalFrame; // 0..N_i-1
 
-	void rebuildTexturePool();
+	std::unordered_map<int, InstanceRaster> instanceRaster;
+
+	// (path, size)-keyed, refcounted raster cache: "" is 1×1 white, a failed raster 1×1 magenta. Rasters no
+	// frame holds any more stay cached (a zoom back is free) until `lru` exceeds kUnusedRasterBytes.
+	std::map<RasterKey, CachedTex> textures;
+	std::list<RasterKey> lru; // unused rasters, most recently released first
+	size_t unusedBytes{0};
+	GpuTex placeholder; // 1×1 transparent
+
+	void acquireTexture(const RasterKey &key); // a miss queues a raster
+	void releaseTextureRef(const RasterKey &key);
+	void acquireFrames(const std::vector<std::string> &frames, uint32_t size);
+	void releaseFrames(const std::vector<std::string> &frames, uint32_t size);
+	void evictUnused();
+	const CachedTex *frameEntry(int id, uint32_t local, uint32_t size) const;
+	const GpuTex *frameTexture(int id, uint32_t local) const; // shown raster; nullptr while pending
+
+	std::shared_ptr<DecodeInbox> inbox = std::make_shared<DecodeInbox>();
+	std::string updateEventId;
+	bool atlasEnabled{true};
+	void pumpDecodes();
+	// per update: re-target instances whose on-screen size crossed a bucket, swap in landed re-rasters
+	void refreshRasterSizes();
+	float screenExtentPx(const glm::mat4 &model) const;
+	static uint32_t rasterBucket(float px);
 
 	// *** SVG loading path ***
-	void loadAllFramesCPU(const std::map<int, std::vector<std::string>> &framesPerInstance);
-	void uploadAllFramesGPU();
+	static CpuPixels decode(const RasterKey &key);
+	std::vector<GpuTex> upload(const std::vector<const CpuPixels *> &batch); // one staging buffer, one submit
 	void destroyAllTextures();
+	void releaseTexture(GpuTex &t); // image objects are destroyed once no frame in flight samples them
 
-	void transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
-	void copyBufferToImage(VkBuffer staging, VkImage img, uint32_t w, uint32_t h);
-
-	std::vector<CpuPixels> cpuFrames;
-	std::vector<GpuTex> gpuTextures;
-
-	std::unordered_map<int, uint32_t> instanceFirstIndex;
-	std::unordered_map<int, uint32_t> instanceFrameCount;
+	void transition(VkCommandBuffer cmd, VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+	void copyBufferToImage(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, VkImage img, uint32_t w, uint32_t h);
+};
 
-	std::vector<VkDescriptorImageInfo> imageInfos;
+template <> struct InstanceLayout::Describe<SVG::InstanceData> {
+	using D = SVG::InstanceData;
+	static constexpr bool std430 = false; // vertex input only (color sits at a 68-byte offset)
+	static constexpr std::array fields{INSTANCE_FIELD(D, model, 2), INSTANCE_FIELD(D, frameIndex, 6), INSTANCE_FIELD(D, color, 7), INSTANCE_FIELD(D, uvScale, 8), INSTANCE_FIELD(D, uvOffset, 9)};
 };
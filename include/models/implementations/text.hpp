@@ -4,10 +4,12 @@
 #include "assets.hpp"
 #include "colors.hpp"
 #include "model.hpp"
+#include "textureheap.hpp"
 
 #include <freetype/freetype.h>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -58,19 +60,37 @@ class Text : public Model {
 		float textOriginY;
 		float textExtentX;
 		float textExtentY;
+		uint32_t atlasIndex = 0; // TextureHeap slot of the font atlas
 	};
 
 	void init() override; // pipeline created exactly once here
 	void record(VkCommandBuffer cmd) override;
+	bool hasDrawWork() const override { return indexCount > 0; } // not instanced
 
 	// API
 	void setFont(const string &fontPath);
-	void setText(const std::string &utf8);
+	void setText(std::string_view utf8);
+
+	// Incremental edits for growing text (terminal, logs): applied immediately, re-laying out only from the
+	// start of the line the edit touches and uploading only the changed vertex range.
+	// Fall back to a full rebuild() when the layout is stale (font/size/model/feature changes, atlas repack).
+	void appendText(std::string_view utf8) { replaceTail(text.size(), utf8); }
+	void replaceTail(size_t keepBytes, std::string_view utf8); // text = text[0, keepBytes) + utf8
+	void setCaretOnly(size_t pos);							   // rewrites and uploads the caret quad only
+	size_t textBytes() const { return text.size(); }
 	void setSize(int size);
 	void setLocation(const vec3 &location);
 	void setMaxTextWidthPx(float w);
 	void setCaret(size_t pos);
 	void setSelectionColor(const glm::vec4 &color);
+	void setSelection(const std::vector<pair<size_t, size_t>> &ranges); // inclusive character index ranges (search hits, ...)
+
+	// Text indices of a source position: `line` counts '\n's, `column` counts code points with ANSI sequences
+	// stripped. Soft wraps add a cell and code points without a glyph ('\t', ...) take none, so callers that
+	// know their text by line/column (terminal grid, search hits) go through these rather than counting.
+	size_t caretIndexAt(size_t line, size_t column);
+	// [first, end) char cells of columns [columnBegin, columnEnd) of `line`; empty when none of them has a glyph
+	pair<size_t, size_t> charRangeAt(size_t line, size_t columnBegin, size_t columnEnd);
 	void setLineSpacing(float px);
 	void setColor(const vec4 &rgba);
 
@@ -109,6 +129,8 @@ class Text : public Model {
 		VkDeviceMemory memory = VK_NULL_HANDLE;
 		VkImageView view = VK_NULL_HANDLE;
 		VkSampler sampler = VK_NULL_HANDLE;
+		uint32_t heapIndex = TextureHeap::kInvalid;
+		uint64_t generation = 0; // bumped on every full repack (glyph UVs move)
 	};
 
 	// Shared per-font atlas; this points into a global registry.
@@ -131,12 +153,26 @@ class Text : public Model {
 
 	std::function<void(uint32_t)> onCaretChange;
 
-	void writeAtlasDescriptor();
+	// ---- CPU helpers (pure; no device or font state) ----
+	// Strips SGR sequences from `text`: returns the visible code points and the color of each run of them
+	struct ColorRun {
+		size_t start = 0, end = 0;
+		vec4 color{};
+	};
+	static std::u32string parseAnsiToRuns(const std::string &text, const vec4 &baseColor, std::vector<ColorRun> &runs);
+	// Signed distance field (8-bit, `spreadPx` either side of the edge) of a w×h glyph coverage bitmap
+	static std::vector<uint8_t> bitmapToSDF(const uint8_t *alpha, int w, int h, int spreadPx);
+	// Where `column` of one laid-out line (no '\n') lands: glyphs and soft wraps before it, and whether the glyph
+	// at `column` starts a new visual line. wrapLocal <= 0: no wrapping.
+	struct LinePos {
+		size_t glyphs = 0, wraps = 0;
+		bool wrapsHere = false;
+	};
+	static LinePos locateInLine(std::u32string_view line, size_t column, const std::unordered_map<uint32_t, Glyph> &glyphs, float wrapLocal);
 
   protected:
 	void syncPickingInstances() override;
 	void createGraphicsPipeline() override;	  // sets depth/cull
-	uint32_t createDescriptorPool() override; // adds binding 2 (sampler)
 	void createDescriptors() override;
 
   private:
@@ -192,8 +228,6 @@ class Text : public Model {
 	std::unique_ptr<FTData> ft;
 	void ensureFT();
 
-	bool addedBinding2 = false; // guard to avoid re-adding binding 2 on swapchain rebuilds
-
 	// Text scroll params
 	float scrollOffsetPx_ = 0.f;
 	float contentHeightPx_ = 0.f;
@@ -203,16 +237,20 @@ class Text : public Model {
 	void prewarmBasicLatinAndBox();
 
 	void ensureAtlas();
+	bool ensureGlyphs(const std::u32string &u32); // true when the atlas had to be fully repacked
 
 	void layoutAndBuild();
-	vec2 measureTextBox(std::u32string &u32);
-	void setSelection(const std::vector<pair<size_t, size_t>> &ranges);
+	void layoutFrom(size_t checkpoint);
+	bool layoutCurrent() const;
+	LinePos locate(size_t line, size_t column, size_t &caretBase, size_t &charBase);
+	void writeCaretQuad();
+	void paintSelection(const glm::vec4 &color);
 
 	glm::vec2 localToScreen(const glm::vec2 &p) const;
 	glm::vec2 windowToViewportPx(float mx, float my) const;
 
-	void buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets);
-	void buildCharVisualAndHitboxes(const std::vector<glm::vec4> &boxes);
+	void buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets, size_t from = 0);
+	void buildCharVisualAndHitboxes(const std::vector<glm::vec4> &boxes, size_t from = 0);
 
 	void updateBuffersGPU();
 
@@ -221,13 +259,35 @@ class Text : public Model {
 	void setSelectionBoxPx(const glm::vec2 &startPx, const glm::vec2 &endPx);
 	void clearSelectionBox();
 
-	struct ColorRun {
-		size_t start = 0, end = 0;
-		vec4 color{};
+	struct AnsiLineStart {
+		size_t srcByte = 0; // offset just past an emitted '\n'
+		vec4 color{};		// SGR color in effect there
 	};
 	std::u32string parseAnsiToRuns(std::vector<ColorRun> &runs) const;
+	static std::u32string parseAnsiToRuns(std::string_view text, const vec4 &baseColor, const vec4 &startColor, std::vector<ColorRun> &runs, std::vector<AnsiLineStart> *lines);
+
+	// ---- incremental layout ----
+	// Layout state at the start of every logical line (right after a '\n' in `text`), where x is back at 0 and
+	// the ANSI parser is in its normal state; edits resume layout from the last checkpoint before them.
+	struct LineCheckpoint {
+		size_t srcByte = 0; // offset in `text`
+		vec4 color{};
+		uint32_t verts = 0, idx = 0;	 // cpuVerts / cpuIdx sizes
+		uint32_t carets = 0, chars = 0; // caretSlots_ / charRects sizes
+		float y = 0.f;					 // baseline
+		float measureY = 0.f;
+		vec4 bounds{}; // glyph bounds so far (minX, minY, maxX, maxY)
+	};
+	std::vector<LineCheckpoint> lineCheckpoints_;
+	std::vector<glm::vec4> caretSlots_;
+	std::vector<float> caretBaselines_;
+	float lastBaselineY_ = 0.f;
+	mat4 layoutModel_{1.0f};
+	uint64_t layoutAtlasGeneration_ = 0;
+	uint32_t decoVerts_ = 0; // caret quad reserved at the front of cpuVerts (0 or 4)
+	size_t dirtyVertFrom_ = 0, dirtyIdxFrom_ = 0;
+	bool caretDirty_ = false;
 
-	static std::vector<uint8_t> bitmapToSDF(const uint8_t *alpha, int w, int h, int spreadPx);
 	static vec4 ansiIndexToColor(int idx, const vec4 &fallback);
 
 	// GPU upload (buffers only)
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <vulkan/vulkan_core.h>
+
+// InstanceLayout:
+// Compile-time description of a model's per-instance struct (binding 1 / instance SSBO).
+// - A model lists the fields its shaders read, each with its vertex location, in a Describe<D> specialization
+//   next to the struct; the attribute list (mat4 = 4 consecutive vec4 locations) and the stride follow from it.
+// - check<D>() static_asserts that the fields lie inside D without overlapping, that no two attributes share
+//   a location, and, for structs the shaders also read as a std430 buffer, the std430 alignment and size rules.
+namespace InstanceLayout {
+
+struct Field {
+	uint32_t location;
+	VkFormat fmt;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t align;	  // std430 base alignment
+	uint32_t columns; // locations consumed (mat4 = 4)
+};
+
+struct Attr {
+	uint32_t location;
+	VkFormat fmt;
+	uint32_t offset;
+};
+
+template <typename T> struct FieldType; // only types with a vertex format are allowed
+template <> struct FieldType<float> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32_SFLOAT;
+	static constexpr uint32_t size = 4, align = 4, columns = 1;
+};
+template <> struct FieldType<uint32_t> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32_UINT;
+	static constexpr uint32_t size = 4, align = 4, columns = 1;
+};
+template <> struct FieldType<int32_t> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32_SINT;
+	static constexpr uint32_t size = 4, align = 4, columns = 1;
+};
+template <> struct FieldType<glm::vec2> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32G32_SFLOAT;
+	static constexpr uint32_t size = 8, align = 8, columns = 1;
+};
+template <> struct FieldType<glm::vec3> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr uint32_t size = 12, align = 16, columns = 1;
+};
+template <> struct FieldType<glm::vec4> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32G32B32A32_SFLOAT;
+	static constexpr uint32_t size = 16, align = 16, columns = 1;
+};
+template <> struct FieldType<glm::uvec4> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32G32B32A32_UINT;
+	static constexpr uint32_t size = 16, align = 16, columns = 1;
+};
+template <> struct FieldType<glm::mat4> {
+	static constexpr VkFormat fmt = VK_FORMAT_R32G32B32A32_SFLOAT; // per column
+	static constexpr uint32_t size = 64, align = 16, columns = 4;
+};
+
+template <typename T> constexpr Field field(uint32_t location, size_t offset) {
+	using F = FieldType<std::remove_cvref_t<T>>;
+	return Field{location, F::fmt, uint32_t(offset), F::size, F::align, F::columns};
+}
+
+// Describe<D> provides `static constexpr bool std430` and `static constexpr std::array fields` (INSTANCE_FIELD).
+template <typename D> struct Describe;
+
+template <typename D>
+concept Described = requires {
+	Describe<D>::fields;
+	Describe<D>::std430;
+};
+
+template <typename D> inline constexpr char tag = 0; // one address per described type
+
+template <Described D> constexpr size_t attributeCount() {
+	size_t n = 0;
+	for (const Field &f : Describe<D>::fields)
+		n += f.columns;
+	return n;
+}
+
+template <Described D> constexpr std::array<Attr, attributeCount<D>()> attributes() {
+	std::array<Attr, attributeCount<D>()> out{};
+	size_t k = 0;
+	for (const Field &f : Describe<D>::fields)
+		for (uint32_t c = 0; c < f.columns; ++c)
+			out[k++] = Attr{f.location + c, f.fmt, f.offset + c * (f.size / f.columns)};
+	return out;
+}
+
+// Offset of the first mat4 field (the model matrix, by convention), or UINT32_MAX if there is none.
+template <Described D> constexpr uint32_t modelOffset() {
+	for (const Field &f : Describe<D>::fields)
+		if (f.columns == 4)
+			return f.offset;
+	return UINT32_MAX;
+}
+
+template <Described D> constexpr bool fieldsFit() {
+	const auto &fs = Describe<D>::fields;
+	for (size_t i = 0; i < fs.size(); ++i) {
+		if (fs[i].offset % 4 != 0 || fs[i].offset + fs[i].size > sizeof(D))
+			return false;
+		for (size_t j = i + 1; j < fs.size(); ++j)
+			if (fs[i].offset < fs[j].offset + fs[j].size && fs[j].offset < fs[i].offset + fs[i].size)
+				return false;
+	}
+	return true;
+}
+
+template <Described D> constexpr bool locationsUnique() {
+	const auto attrs = attributes<D>();
+	for (size_t i = 0; i < attrs.size(); ++i)
+		for (size_t j = i + 1; j < attrs.size(); ++j)
+			if (attrs[i].location == attrs[j].location)
+				return false;
+	return true;
+}
+
+template <Described D> constexpr bool std430Aligned() {
+	uint32_t structAlign = 4;
+	for (const Field &f : Describe<D>::fields) {
+		if (f.offset % f.align != 0)
+			return false;
+		structAlign = f.align > structAlign ? f.align : structAlign;
+	}
+	return sizeof(D) % structAlign == 0; // array stride == sizeof(D)
+}
+
+template <Described D> constexpr bool check() {
+	static_assert(std::is_trivially_copyable_v<D> && std::is_standard_layout_v<D>, "InstanceLayout: instance data must be a plain struct (memcpy'd into the instance buffer)");
+	static_assert(fieldsFit<D>(), "InstanceLayout: field misaligned, overlapping another, or outside the struct");
+	static_assert(locationsUnique<D>(), "InstanceLayout: two attributes share a vertex location");
+	static_assert(!Describe<D>::std430 || std430Aligned<D>(), "InstanceLayout: struct is read as std430 but a field is misaligned or the size isn't a multiple of its alignment (add padding)");
+	return true;
+}
+
+} // namespace InstanceLayout
+
+#define INSTANCE_FIELD(Type, member, location) InstanceLayout::field<decltype(Type::member)>(location, offsetof(Type, member))
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "assets.hpp"
+#include "drawpool.hpp"
+#include "frustumculling.hpp"
+#include "instancelayout.hpp"
 #include "pipeline.hpp"
+#include "pipelineregistry.hpp"
 #include "raypicking.hpp"
 
 #include <functional>
 #include <glm/glm.hpp>
 #include <span>
+#include <stdexcept>
 #include <vulkan/vulkan_core.h>
 
 using namespace glm;
@@ -14,6 +19,7 @@ using std::vector;
 
 class Scene;
 class Engine;
+template <typename D> class InstanceBuffer;
 
 struct VPMatrix {
 	mat4 view{1.0f};
@@ -22,6 +28,8 @@ struct VPMatrix {
 };
 
 class Model {
+	template <typename D> friend class InstanceBuffer;
+
   public:
 	Model() : scene(nullptr) {}
 	Model(Scene *scene);
@@ -85,6 +93,9 @@ class Model {
 		}
 	}
 
+	// Typed access without per-call stride checks; D must be the type passed to setInstanceLayout (checked once here).
+	template <InstanceLayout::Described D> InstanceBuffer<D> instances() { return InstanceBuffer<D>(*this); }
+
   public:
 	std::function<void(Model *, float, float, float, float)> onScreenResize;
 	std::function<void(Model *, double, double)> onTick;
@@ -100,6 +111,12 @@ class Model {
 	void enableRayPicking();
 	std::unique_ptr<RayPicking> picking;
 
+	// Frustum-cull instances on the GPU in compute() and draw the survivors indirectly (call after init()).
+	// Bounds are the mesh's bounding sphere under the instance's model matrix, so only for models whose vertex
+	// shader places vertices at model * position (not Line/Grid, whose geometry comes from other fields).
+	void enableGpuCulling();
+	std::unique_ptr<FrustumCulling> culling;
+
   public:
 	void setView(const mat4 &V);
 	void setProj(const mat4 &P);
@@ -110,6 +127,10 @@ class Model {
 
 	VPMatrix &getVP() { return vp; }
 	const VkViewport &getViewport() const { return viewport; }
+	const VkRect2D &getScissor() const { return scissor; } // conservative screen-space bounds of what record() draws
+
+	// false when record() would bail before drawing (no geometry / no instances)
+	virtual bool hasDrawWork() const { return indexCount > 0 && count > 0; }
 
   public:
 	Scene *getScene() { return scene; }
@@ -136,6 +157,14 @@ class Model {
 	virtual void record(VkCommandBuffer cmd);
 	virtual void recordUI(VkCommandBuffer cmd, uint32_t blurLayerIdx);
 
+	// Merged draws (Scenes::record, see DrawPool): whether this model can share one indirect draw with its
+	// neighbours this frame, and whether `o` can join it (same pipeline, view/projection, viewport and scissor).
+	bool canMergeDraw() const;
+	bool mergesWith(const Model &o) const;
+	// record() for a run of models that canMergeDraw() and mergesWith() the first: their instances are copied into
+	// the frame's DrawPool stream and drawn with the first model's binds, one indirect command per model
+	static void recordMerged(VkCommandBuffer cmd, std::span<Model *const> run);
+
   protected:
 	Scene *scene;
 	std::shared_ptr<Engine> engine;
@@ -152,11 +181,35 @@ class Model {
 
 	size_t renderingDepth = 0;
 
+	// Set before Model::init() by subclasses whose shaders read only the set 0 UBO (VPMatrix) and the vertex /
+	// instance attributes, and that have no record(), recordUI() or pushConstants() of their own: the mesh goes into
+	// the DrawPool and Scenes may merge the model's draw with its neighbours'.
+	bool mergeDraws = false;
+
 	virtual void pushConstants(VkCommandBuffer cmd, VkPipelineLayout pipeLayout) {}
-	virtual uint32_t createDescriptorPool();
 	virtual void createDescriptors();
 	virtual void createGraphicsPipeline();
 
+	// Stride and binding-1 attributes generated from InstanceLayout::Describe<D>, validated at compile time.
+	template <InstanceLayout::Described D> void setInstanceLayout(Mesh &m) {
+		static_assert(InstanceLayout::check<D>());
+		for (const InstanceLayout::Attr &a : InstanceLayout::attributes<D>())
+			m.vertexAttrs.push_back({a.location, 1, a.fmt, a.offset});
+		initInfo.instanceStrideBytes = sizeof(D);
+		instanceLayout = &InstanceLayout::tag<D>;
+		instanceModelOffset = InstanceLayout::modelOffset<D>();
+	}
+
+	// Picks up the ray-picking result dispatched in compute() (before the draw, in rendering order).
+	void resolvePicking();
+	// Writes the VPMatrix into the UBO when it changed.
+	void syncUniforms();
+	// Copies dirty CPU instances into the mapped SSBO.
+	void flushInstances();
+	// Binds the mesh (binding 0) and the instances (binding 1: the culled copy when compute() culled this frame)
+	// plus the index buffer, then draws every instance.
+	void drawInstances(VkCommandBuffer cmd);
+
 	virtual void syncPickingInstances() {};
 	template <typename D> void syncPickingInstances() {
 		if (!picking)
@@ -251,11 +304,15 @@ class Model {
 	// mesh
 	Mesh mesh{};
 	uint32_t indexCount{};
+	DrawPool::Geometry geometry; // valid(): the mesh lives in the DrawPool and vbuf / ibuf are its buffers
 
 	// instances
 	uint32_t maxInstances{}, iStride{}, count{};
 	std::vector<uint8_t> cpu;
 	std::unordered_map<int, uint32_t> idToSlot;
+	const char *instanceLayout{nullptr}; // InstanceLayout::tag<D> of the setInstanceLayout type
+	uint32_t instanceModelOffset{UINT32_MAX};
+	bool cullDispatched_ = false;
 
   private:
 	template <typename D> bool setInstance(int id, const D &value) {
@@ -272,3 +329,38 @@ class Model {
 		return true;
 	}
 };
+
+// InstanceBuffer:
+// Typed view of a Model's instances for the InstanceData it was laid out with (Model::instances<D>()).
+// The type is verified when the view is created, so get/upsert are a hash lookup plus a memcpy.
+template <typename D> class InstanceBuffer {
+  public:
+	explicit InstanceBuffer(Model &model) : m(&model) {
+		if (m->instanceLayout != &InstanceLayout::tag<D>)
+			throw std::runtime_error("InstanceBuffer: model is not laid out for this instance type");
+	}
+
+	bool get(int id, D &out) const {
+		auto it = m->idToSlot.find(id);
+		if (it == m->idToSlot.end())
+			return false;
+		std::memcpy(&out, m->cpu.data() + size_t(it->second) * sizeof(D), sizeof(D));
+		return true;
+	}
+
+	void upsert(int id, const D &d) {
+		auto it = m->idToSlot.find(id);
+		if (it == m->idToSlot.end()) {
+			m->upsertBytes(id, std::span<const uint8_t>{reinterpret_cast<const uint8_t *>(&d), sizeof(D)});
+			return;
+		}
+		std::memcpy(m->cpu.data() + size_t(it->second) * sizeof(D), &d, sizeof(D));
+		m->ssboDirty = true;
+		m->pickingInstancesDirty = true;
+	}
+
+	uint32_t size() const { return m->count; }
+
+  private:
+	Model *m;
+};
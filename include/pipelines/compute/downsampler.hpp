@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "pipeline.hpp"
+
+class GraphicsBuffers;
+
+// Downsampler:
+// Builds the mip chain of the RGBA16F accumulation targets after each pass.
+// - Blit:       vkCmdBlitImage per level (old path, also the fallback when storage isn't supported)
+// - SPD:        compute, up to 5 mips per dispatch through shared memory (default)
+// - DualKawase: compute, one dispatch per mip with the dual-Kawase 5-tap filter (softer blur)
+//
+// Targets are addressed by slot: slot = swapImageIndex * 2 + (B ? 1 : 0).
+// Contract matches Rendering::cmdBuildMipsForImageRuntime: mip0 comes in as COLOR_ATTACHMENT_OPTIMAL,
+// the whole chain leaves as SHADER_READ_ONLY_OPTIMAL.
+// With a region (mip0 coords), lower mips must come in as SHADER_READ_ONLY_OPTIMAL and only the
+// texels covering the region are rebuilt; everything else is kept.
+class Downsampler {
+  public:
+	enum class Mode { Blit, SPD, DualKawase };
+
+	Downsampler() = default;
+	~Downsampler(); // calls destroy()
+
+	// pipelines (once per device)
+	void create(VkDevice device, VkPhysicalDevice physicalDevice);
+	void destroy();
+
+	// descriptor sets for the current GraphicsBuffers (call again after swapchain recreation)
+	void bindTargets(const GraphicsBuffers &buffers);
+	void releaseTargets();
+
+	void record(VkCommandBuffer cmd, uint32_t slot, const VkRect2D *region = nullptr);
+
+	void setMode(Mode m) { mode = m; }
+	Mode getMode() const { return storageMips ? mode : Mode::Blit; }
+
+	void setKawaseOffset(float o) { kawaseOffset = o; }
+
+	static constexpr uint32_t kMipsPerDispatch = 5;
+
+  private:
+	struct SpdPC {
+		int32_t srcW, srcH;
+		int32_t groupX, groupY;
+		uint32_t mipCount;
+		uint32_t _pad;
+	};
+	struct KawasePC {
+		int32_t dstW, dstH;
+		int32_t dstX, dstY;
+		float texelX, texelY;
+		float offset;
+		float _pad;
+	};
+
+	struct Target {
+		VkImage image = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> spdSets;	 // one per dispatch
+		std::vector<VkDescriptorSet> kawaseSets; // one per level (mip k -> k+1)
+	};
+
+	void createSpdPipeline();
+	void createKawasePipeline();
+	VkDescriptorSetLayout createSetLayout(VkDescriptorType srcType, uint32_t dstCount);
+
+	void recordSPD(VkCommandBuffer cmd, const Target &t, const VkRect2D *region);
+	void recordKawase(VkCommandBuffer cmd, const Target &t, const VkRect2D *region);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+
+	std::unique_ptr<Pipeline> spd;
+	std::unique_ptr<Pipeline> kawase;
+	VkPushConstantRange spdRange{};
+	VkPushConstantRange kawaseRange{};
+
+	VkSampler linearSampler = VK_NULL_HANDLE;
+	VkDescriptorPool targetPool = VK_NULL_HANDLE;
+	std::vector<Target> targets;
+
+	VkExtent2D extent{};
+	uint32_t mipLevels = 1;
+	bool storageMips = false;
+
+	Mode mode = Mode::SPD;
+	float kawaseOffset = 1.0f;
+};
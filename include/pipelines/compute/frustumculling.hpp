@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vulkan/vulkan_core.h>
+
+#include "pipeline.hpp"
+
+// FrustumCulling:
+// GPU culling + compaction for one instanced Model (Model::enableGpuCulling).
+// - record() (compute cmd): tests every instance's bounding sphere (mesh sphere * model matrix) against the
+//   view frustum and appends the visible instances' bytes to a device-local copy, counting them into an
+//   indexed indirect command with an atomic. Billboards are drawn around their projected centre, so they are
+//   culled in clip space instead: the centre's NDC position, padded by the quad's on-screen half-extent.
+// - draw() (graphics cmd): the caller binds instanceBuffer() as binding 1, then one vkCmdDrawIndexedIndirectCount
+//   (vkCmdDrawIndexedIndirect when the device lacks drawIndirectCount) draws what survived.
+// Shaders don't change: the compacted instances are the same structs, so gl_InstanceIndex just gets denser.
+class FrustumCulling {
+  public:
+	struct InitInfo {
+		uint32_t maxInstances = 1;
+		uint32_t strideBytes = 0;	   // instance struct size (multiple of 4)
+		uint32_t modelOffsetBytes = 0; // offset of the mat4 model inside it
+		glm::vec4 localSphere{0.f};	   // xyz center, w radius, in mesh space
+		float billboardSizeNDC = 0.2f; // on-screen size of a unit billboard quad (rectangle/image/shaderquad.vert)
+		bool indirectCount = false;	   // drawIndirectCount enabled on the device
+	};
+
+	FrustumCulling();
+	~FrustumCulling();
+
+	InitInfo initInfo{};
+
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkBuffer sourceInstances);
+	void destroy();
+
+	// billboard: the vertex shader draws the quad around the projected instance origin (see the class comment).
+	// firstIndex / vertexOffset: where the mesh starts in a shared (DrawPool) index / vertex buffer.
+	void record(VkCommandBuffer cmd, const glm::mat4 &view, const glm::mat4 &proj, bool billboard, uint32_t instanceCount, uint32_t indexCount, uint32_t firstIndex = 0, int32_t vertexOffset = 0);
+	void draw(VkCommandBuffer cmd) const;
+
+	VkBuffer instanceBuffer() const { return visibleBuf; }
+
+  private:
+	struct CullPC {
+		// world space, normalized, inside when dot(n, p) + d >= 0. Billboards: rows 0..3 of proj * view, then
+		// (NDC half-extent of the quad, mesh reach) in planes[4].xy
+		glm::vec4 planes[6];
+		glm::vec4 sphere;
+		uint32_t count;
+		uint32_t strideWords;
+		uint32_t modelWord;
+		uint32_t billboard;
+	};
+	static_assert(sizeof(CullPC) <= 128, "FrustumCulling: push constants exceed the guaranteed 128 bytes");
+
+	// indexed indirect command followed by the draw count (countBufferOffset = 20)
+	struct ArgsGPU {
+		VkDrawIndexedIndirectCommand cmd;
+		uint32_t drawCount;
+	};
+
+	void createDescriptors(VkBuffer sourceInstances);
+
+	std::unique_ptr<Pipeline> pipeline;
+	VkPushConstantRange pcRange{};
+
+	VkBuffer visibleBuf = VK_NULL_HANDLE, argsBuf = VK_NULL_HANDLE;
+	VkDeviceMemory visibleMem = VK_NULL_HANDLE, argsMem = VK_NULL_HANDLE;
+};
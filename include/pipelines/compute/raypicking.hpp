@@ -111,8 +111,6 @@ class RayPicking {
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 	std::unique_ptr<Pipeline> pipeline;
 
-	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
-
 	VkBuffer nodesBuf = VK_NULL_HANDLE, trisBuf = VK_NULL_HANDLE, posBuf = VK_NULL_HANDLE;
 	VkDeviceMemory nodesMem = VK_NULL_HANDLE, trisMem = VK_NULL_HANDLE, posMem = VK_NULL_HANDLE;
 
@@ -57,13 +57,18 @@ class Pipeline {
 		};
 		std::vector<DynamicRef> dynamicOrder; // order required by vkCmdBindDescriptorSets
 		std::vector<uint32_t> dynamicOffsets; // same length as dynamicOrder
+		struct SharedSet {
+			VkDescriptorSetLayout layout = VK_NULL_HANDLE; // registry-shared
+			VkDescriptorSet set = VK_NULL_HANDLE;
+		};
+		std::vector<SharedSet> sharedSets; // by set index; set != VK_NULL_HANDLE: owned elsewhere, not allocated here
 	};
 
 	VkDevice device{};
 	VkPhysicalDevice physicalDevice{};
 
-	VkDescriptorPool descriptorPool{};
-	vector<VkDescriptorPoolSize> descriptorPoolSizes;
+	VkDescriptorPool descriptorPool{};	   // optional, caller-owned; sets come from the DescriptorAllocator when unset
+	VkDescriptorPool descriptorSetPool{}; // DescriptorAllocator pool the sets were allocated from
 
 	VkSampleCountFlagBits samplesCountFlagBits{};
 
@@ -81,13 +86,18 @@ class Pipeline {
 	void createWriteDescriptorSet(uint32_t dstBinding, VkDescriptorType descriptorType, const VkDescriptorBufferInfo &bufInfo, uint32_t descriptorCount = 1, uint32_t setIndex = 0);
 	void createDescriptorSetLayoutBinding(uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags flags, uint32_t descriptorCount = 1, uint32_t setIndex = 0);
 	void setDynamicOffset(uint32_t setIndex, uint32_t binding, uint32_t offsetBytes, uint32_t arrayElement = 0);
+	// bind a set owned elsewhere (e.g. the TextureHeap) at `setIndex` instead of declaring and allocating one
+	void useSharedSet(uint32_t setIndex, VkDescriptorSetLayout layout, VkDescriptorSet set);
 
 	void createVertexInputBindingDescription(uint32_t binding, uint32_t stride, VkVertexInputRate inputRate);
 
   public:
-	void createDescriptorPool(uint32_t setCount);
 	void createDescriptors();
 	void createGraphicsPipeline();
 
 	void createComputePipeline();
+
+  private:
+	bool isSharedSet(uint32_t setIndex) const { return setIndex < descriptorSets.sharedSets.size() && descriptorSets.sharedSets[setIndex].set != VK_NULL_HANDLE; }
+	void releaseDescriptorSets();
 };
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "assets.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// PipelineRegistry:
+// Process-wide, reference-counted cache of the immutable objects behind a Pipeline, so every model built from
+// the same shaders and state shares one set of shader modules, set layouts, pipeline layout and VkPipeline.
+// - Shader modules are keyed by their SPIR-V, set layouts by their bindings, pipeline layouts by their set
+//   layouts + push constant ranges, pipelines by the SPIR-V of each stage + layout + all fixed-function state.
+// - Every acquire takes a reference and every release drops one; the object is destroyed with the last. A
+//   shared pipeline holds a reference on its layout, a shared layout on its set layouts.
+// - Objects the registry can't key (immutable samplers, specialization constants, pNext chains other than binding
+//   flags / dynamic rendering, or built from modules/layouts it didn't hand out) are created private; releasing a
+//   handle it doesn't know destroys it directly, so Pipeline releases everything it holds the same way.
+class PipelineRegistry {
+  public:
+	static PipelineRegistry &get();
+
+	// shader programs (directory of stage files, see Assets::compileShaderDir) / single stages
+	Assets::ShaderModules shaderProgram(const std::string &shaderRootDir, VkDevice device);
+	VkShaderModule shaderModule(const std::vector<uint32_t> &spirv, VkDevice device);
+	VkShaderModule shaderSource(const std::string &glsl, shaderc_shader_kind kind, VkDevice device); // inline GLSL, compiled once per run
+	void releaseShaderProgram(Assets::ShaderModules &modules, VkDevice device);
+	void releaseShaderModule(VkShaderModule module, VkDevice device);
+
+	VkDescriptorSetLayout acquireSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo &ci);
+	VkDescriptorSetLayout retainSetLayout(VkDescriptorSetLayout layout); // another reference on a shared layout
+	void releaseSetLayout(VkDescriptorSetLayout layout, VkDevice device);
+
+	VkPipelineLayout acquirePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo &ci);
+	void releasePipelineLayout(VkPipelineLayout layout, VkDevice device);
+
+	// create infos must reference a layout from acquirePipelineLayout() to be shared
+	VkPipeline acquireGraphicsPipeline(VkDevice device, const VkGraphicsPipelineCreateInfo &ci);
+	VkPipeline acquireComputePipeline(VkDevice device, const VkComputePipelineCreateInfo &ci);
+	void releasePipeline(VkPipeline pipeline, VkDevice device);
+
+	struct Stats {
+		size_t shaderModules = 0, setLayouts = 0, pipelineLayouts = 0, pipelines = 0; // live shared objects
+		uint64_t hits = 0, misses = 0;												   // acquires served from / added to the cache
+	};
+	Stats stats() const;
+
+  private:
+	PipelineRegistry() = default;
+
+	template <typename Handle> struct Shared {
+		struct Entry {
+			std::string key;
+			uint32_t refs = 0;
+		};
+		std::unordered_map<std::string, Handle> byKey;
+		std::unordered_map<Handle, Entry> entries;
+
+		Handle find(const std::string &key); // takes a reference on a hit
+		void add(Handle h, std::string key);
+		bool owns(Handle h) const { return entries.contains(h); }
+		// false: not a shared handle (the caller destroys it); `last` is set when this dropped the final reference
+		bool release(Handle h, bool &last);
+	};
+
+	struct Module {
+		uint64_t hash = 0;
+		std::vector<uint32_t> spirv;
+		uint32_t refs = 0;
+	};
+
+	VkShaderModule moduleLocked(const std::vector<uint32_t> &spirv, VkDevice device);
+	void releaseModuleLocked(VkShaderModule module, VkDevice device);
+	void releaseSetLayoutLocked(VkDescriptorSetLayout layout, VkDevice device);
+	void releasePipelineLayoutLocked(VkPipelineLayout layout, VkDevice device);
+	bool stageKey(std::string &key, const VkPipelineShaderStageCreateInfo &stage) const;
+	template <typename Create> VkPipeline pipelineLocked(std::string key, VkPipelineLayout layout, bool shareable, Create &&create);
+
+	mutable std::mutex mutex;
+	std::unordered_map<uint64_t, VkShaderModule> modulesByHash;
+	std::unordered_map<VkShaderModule, Module> modules;
+	std::unordered_map<std::string, Assets::ShaderBinaries> programs; // directory -> SPIR-V, read once per run
+	std::unordered_map<std::string, std::vector<uint32_t>> sources;	  // kind + GLSL -> SPIR-V
+	Shared<VkDescriptorSetLayout> setLayouts;
+	Shared<VkPipelineLayout> pipelineLayouts;
+	std::unordered_map<VkPipelineLayout, std::vector<VkDescriptorSetLayout>> layoutSets;
+	Shared<VkPipeline> pipelines;
+	std::unordered_map<VkPipeline, VkPipelineLayout> pipelineLayoutOf;
+	uint64_t hits = 0, misses = 0;
+};
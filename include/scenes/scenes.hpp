@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bindcache.hpp"
 #include "scene.hpp"
 
 #include <boost/graph/adjacency_list.hpp>
@@ -37,6 +38,14 @@ class Scenes {
 	void record(VkCommandBuffer cmd);
 	void recordUI(VkCommandBuffer cmd, uint32_t blurLayerIdx);
 
+	// What recordUI(cmd, blurLayerIdx) would touch this frame: populated == at least one visible
+	// model with draw work; bounds == union of their scissors, clamped to the framebuffer.
+	struct BlurLayerInfo {
+		bool populated = false;
+		VkRect2D bounds{};
+	};
+	BlurLayerInfo blurLayerInfo(uint32_t blurLayerIdx, VkExtent2D extent) const;
+
 	// Single-root graph API (no world compute here)
 	SceneNode addChild(const string &name, Scene *child, SceneNode parent = SceneNode()); // parent defaults to root
 	void link(SceneNode parent, SceneNode child);										  // reparent (root cannot be child)
@@ -55,6 +64,9 @@ class Scenes {
 
 	std::shared_ptr<Engine> getEngine() const { return engine; }
 
+	// Bind state of the command buffer record()/recordUI() is filling (see BindCache)
+	BindCache &bindCache() const { return binds; }
+
 	Model *getRayPicked() const { return rayPicked; }
 	void setRayPicked(Model *picked) const { rayPicked = picked; }
 
@@ -63,6 +75,9 @@ class Scenes {
 	void registerName(const string &name, SceneNode v);
 	void renameInternal(SceneNode v, const string &newName); // optional if you ever rename nodes
 	void initializeRenderingOrder();
+	void batchLayer(const vector<Model *> &layer);
+	size_t mergeRun(size_t first) const;
+	template <typename Fn> void recordDraws(VkCommandBuffer cmd, Fn &&draw);
 
   private:
 	std::shared_ptr<Engine> engine;
@@ -70,6 +85,22 @@ class Scenes {
 	SceneNode rootNode = SceneNode();			 // valid after setRoot/ensureRootExists
 	unordered_map<string, SceneNode> nameToNode; // unique names -> nodes
 	vector<vector<Model *>> renderingOrder;
+	mutable BindCache binds;
+
+	// batchLayer() output: visible models of one layer (+ index in it) grouped by pipeline; runs of mergeable
+	// models in a batch are recorded as one indirect draw (Model::recordMerged)
+	struct Draw {
+		Model *model;
+		size_t index;
+		uint32_t batch;
+	};
+	struct Batch {
+		VkPipeline pipeline;
+		VkRect2D bounds; // union of its models' scissors
+	};
+	vector<Draw> drawOrder;
+	vector<Batch> batches;
+	vector<Model *> run; // recordDraws() scratch
 
 	static Model *rayPicked;
 
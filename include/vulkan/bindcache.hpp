@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// BindCache:
+// Graphics state last bound into the command buffer being recorded, so consecutive draws only re-issue what changed.
+// - Model::record (and the overrides that bind their own state) go through it; anything that binds behind its
+//   back must invalidate() it.
+// - Scenes invalidates it at the start of record()/recordUI(): a new command buffer, or one the engine has
+//   recorded its own passes into.
+// - Descriptor sets are keyed by the layout they were bound with, so a pipeline with another layout rebinds them.
+class BindCache {
+  public:
+	void invalidate() {
+		boundViewport = boundScissor = false;
+		boundPipeline = VK_NULL_HANDLE;
+		setLayout = VK_NULL_HANDLE;
+		sets.clear();
+		dynOffsets.clear();
+		vbs.clear();
+		vbOffsets.clear();
+		ib = VK_NULL_HANDLE;
+		ibOffset = 0;
+	}
+
+	void viewport(VkCommandBuffer cmd, const VkViewport &v) {
+		if (boundViewport && std::memcmp(&v, &lastViewport, sizeof(VkViewport)) == 0)
+			return;
+		vkCmdSetViewport(cmd, 0, 1, &v);
+		lastViewport = v;
+		boundViewport = true;
+	}
+
+	void scissor(VkCommandBuffer cmd, const VkRect2D &r) {
+		if (boundScissor && std::memcmp(&r, &lastScissor, sizeof(VkRect2D)) == 0)
+			return;
+		vkCmdSetScissor(cmd, 0, 1, &r);
+		lastScissor = r;
+		boundScissor = true;
+	}
+
+	void pipeline(VkCommandBuffer cmd, VkPipeline p) {
+		if (p == boundPipeline)
+			return;
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, p);
+		boundPipeline = p;
+	}
+
+	void descriptorSets(VkCommandBuffer cmd, VkPipelineLayout layout, std::span<const VkDescriptorSet> s, std::span<const uint32_t> offsets) {
+		if (s.empty())
+			return;
+		if (layout == setLayout && std::ranges::equal(s, sets) && std::ranges::equal(offsets, dynOffsets))
+			return;
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, uint32_t(s.size()), s.data(), uint32_t(offsets.size()), offsets.empty() ? nullptr : offsets.data());
+		setLayout = layout;
+		sets.assign(s.begin(), s.end());
+		dynOffsets.assign(offsets.begin(), offsets.end());
+	}
+
+	// bindings 0..bufs.size()-1
+	void vertexBuffers(VkCommandBuffer cmd, std::span<const VkBuffer> bufs, std::span<const VkDeviceSize> offsets) {
+		if (bufs.empty())
+			return;
+		if (std::ranges::equal(bufs, vbs) && std::ranges::equal(offsets, vbOffsets))
+			return;
+		vkCmdBindVertexBuffers(cmd, 0, uint32_t(bufs.size()), bufs.data(), offsets.data());
+		vbs.assign(bufs.begin(), bufs.end());
+		vbOffsets.assign(offsets.begin(), offsets.end());
+	}
+
+	void indexBuffer(VkCommandBuffer cmd, VkBuffer buf, VkDeviceSize offset) {
+		if (buf == ib && offset == ibOffset)
+			return;
+		vkCmdBindIndexBuffer(cmd, buf, offset, VK_INDEX_TYPE_UINT32);
+		ib = buf;
+		ibOffset = offset;
+	}
+
+  private:
+	bool boundViewport = false, boundScissor = false;
+	VkViewport lastViewport{};
+	VkRect2D lastScissor{};
+
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+
+	VkPipelineLayout setLayout = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> sets;
+	std::vector<uint32_t> dynOffsets;
+
+	std::vector<VkBuffer> vbs;
+	std::vector<VkDeviceSize> vbOffsets;
+
+	VkBuffer ib = VK_NULL_HANDLE;
+	VkDeviceSize ibOffset = 0;
+};
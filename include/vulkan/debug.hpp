@@ -72,7 +72,8 @@ inline void vkCheckImpl(VkResult res, const char* expr, const char* file, int li
 
 class Debug {
   public:
-	Debug();
+	// headless: no window-system extensions, so no GLFW/display is needed to create the instance
+	explicit Debug(bool headless = false);
 	~Debug();
 
 	VkInstance getInstance() const { return instance; }
@@ -82,6 +83,7 @@ class Debug {
 	VkInstance instance = VK_NULL_HANDLE;
 	VkDebugUtilsMessengerEXT debugMessenger = VK_NULL_HANDLE;
 	bool validationEnabled = false;
+	bool headless = false;
 
 	void createInstance();
 	void setupDebugMessenger();
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// DescriptorAllocator:
+// Engine-wide, growable descriptor set allocator (a pool of pools) replacing one VkDescriptorPool per model.
+// - allocate()/free(): long-lived sets (a Pipeline's sets, freed when it dies) from FREE_DESCRIPTOR_SET pools.
+//   A full pool is retried once sets were freed from it; otherwise a new pool is added, each twice the size of
+//   the last (up to kMaxSetsPerPool) and never smaller than what the failing request needs.
+//   free() only queues the sets: command buffers still in flight may use them, so they go back to their pool
+//   frameOverlap frames later.
+// - allocateTransient(): sets that only live for one frame, from per-frame pools reset in bulk by resetFrame()
+//   once that frame's fence was waited on. resetFrame() also retires the queued frees (once per frame).
+// - get() is the engine's live allocator; it throws before create() / after destroy().
+class DescriptorAllocator {
+  public:
+	static constexpr uint32_t kFirstSetsPerPool = 64;
+	static constexpr uint32_t kMaxSetsPerPool = 4096;
+	static constexpr uint32_t kTransientSetsPerPool = 256;
+
+	DescriptorAllocator() = default;
+	~DescriptorAllocator();
+
+	static DescriptorAllocator &get();
+	static DescriptorAllocator *current() { return active; } // nullptr when there is none (safe in destructors)
+
+	void create(VkDevice device, uint32_t frameOverlap);
+	void destroy();
+
+	// `need`: total descriptors per type over all `layouts` (sizes a new pool if the current ones are full)
+	// returns the pool the sets came from, to hand back to free()
+	VkDescriptorPool allocate(std::span<const VkDescriptorSetLayout> layouts, std::span<const VkDescriptorPoolSize> need, VkDescriptorSet *out);
+	void free(VkDescriptorPool pool, std::span<const VkDescriptorSet> sets);
+
+	VkDescriptorSet allocateTransient(uint32_t frame, VkDescriptorSetLayout layout, std::span<const VkDescriptorPoolSize> need = {});
+	void resetFrame(uint32_t frameIndex);
+
+	// descriptor counts per type of a set of layout bindings
+	static std::vector<VkDescriptorPoolSize> countDescriptors(std::span<const VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorPoolSize> into = {});
+
+  private:
+	struct Pool {
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		bool exhausted = false; // an allocation failed; only worth retrying after a free()
+	};
+
+	struct FramePools {
+		std::vector<VkDescriptorPool> pools;
+		size_t current = 0;
+	};
+
+	struct Retired {
+		VkDescriptorPool pool;
+		std::vector<VkDescriptorSet> sets;
+		uint64_t frame; // resetFrame() count when freed
+	};
+
+	inline static DescriptorAllocator *active = nullptr;
+
+	VkDescriptorPool createPool(uint32_t maxSets, std::span<const VkDescriptorPoolSize> need, VkDescriptorPoolCreateFlags flags);
+	VkResult tryAllocate(VkDescriptorPool pool, std::span<const VkDescriptorSetLayout> layouts, VkDescriptorSet *out) const;
+
+	VkDevice device = VK_NULL_HANDLE;
+	std::vector<Pool> pools;
+	uint32_t nextSetsPerPool = kFirstSetsPerPool;
+	std::vector<FramePools> frames;
+	std::deque<Retired> retired;
+	uint64_t frame = 0;
+};
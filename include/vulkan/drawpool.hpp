@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+class LogicalDevice;
+
+// DrawPool:
+// Engine-wide buffers that let compatible models draw as one vkCmdDrawIndexedIndirect (Scenes::record merges them).
+// - Geometry: one device-local vertex and index buffer shared by the models that opt in (Model::mergeDraws).
+//   acquireGeometry() uploads a mesh once per distinct content (every Rectangle shares the same quad) and returns
+//   where it lives; draws pass firstIndex / vertexOffset. releaseGeometry() frees the range once its last user
+//   is gone and no frame in flight reads it (through TextureHeap::release). A full pool returns false: the model
+//   keeps its own buffers and draws alone.
+// - Per frame in flight: a host-visible instance stream and indirect-args stream, reset by beginFrame() once the
+//   frame's fence was waited on. A merged draw copies its models' instances back to back and writes one command per
+//   model; when this frame's streams are full the models draw one by one instead.
+// - Merging needs multiDrawIndirect and drawIndirectFirstInstance (LogicalDevice::supportsMultiDrawIndirect); without
+//   them canMerge() is false and pooled models still draw individually from the shared geometry.
+class DrawPool {
+  public:
+	static constexpr VkDeviceSize kVertexBytes = 8ull << 20;
+	static constexpr uint32_t kIndexCount = 2u << 20;
+	static constexpr VkDeviceSize kInstanceBytes = 4ull << 20; // per frame in flight
+	static constexpr uint32_t kMaxCommands = 16384;			  // per frame in flight
+
+	// First-fit free list over [0, capacity) with coalescing; offsets and sizes in the caller's unit.
+	class FreeList {
+	  public:
+		void reset(VkDeviceSize capacity);
+		// lowest offset that is a multiple of `align` (any positive value, e.g. a vertex stride) with `size` free after it
+		bool take(VkDeviceSize size, VkDeviceSize align, VkDeviceSize &offset);
+		void give(VkDeviceSize offset, VkDeviceSize size);
+		VkDeviceSize freeTotal() const;
+
+	  private:
+		struct Range {
+			VkDeviceSize offset, size;
+		};
+		std::vector<Range> ranges; // sorted by offset, never adjacent
+	};
+
+	struct Geometry {
+		uint32_t firstIndex = 0;
+		int32_t vertexOffset = 0;
+		uint32_t entry = UINT32_MAX; // UINT32_MAX: not pooled
+
+		bool valid() const { return entry != UINT32_MAX; }
+	};
+
+	// Where a merged draw writes this frame: `data` is mapped at `offset` into `buffer`.
+	struct Slice {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		uint8_t *data = nullptr;
+	};
+
+	DrawPool() = default;
+	~DrawPool();
+
+	static DrawPool &get();
+	static DrawPool *current() { return active; } // nullptr when there is none (safe in destructors)
+
+	void create(const LogicalDevice &device, VkPhysicalDevice physicalDevice, uint32_t frameOverlap);
+	void destroy();
+
+	VkBuffer vertexBuffer() const { return vertexBuf; }
+	VkBuffer indexBuffer() const { return indexBuf; }
+	bool canMerge() const { return multiDraw; }
+
+	bool acquireGeometry(const void *vertices, size_t vertexBytes, uint32_t stride, const uint32_t *indices, size_t indexCount, Geometry &out);
+	void releaseGeometry(Geometry &geometry);
+
+	void beginFrame(uint32_t frameIndex);
+	// 16-byte aligned instance bytes / `count` indirect commands in this frame's streams; false when full
+	bool allocInstances(VkDeviceSize bytes, Slice &out);
+	bool allocCommands(uint32_t count, Slice &out);
+	// the `count` commands written at `args` (from allocCommands), split by the device's maxDrawIndirectCount
+	void drawIndirect(VkCommandBuffer cmd, const Slice &args, uint32_t count) const;
+
+  private:
+	struct Entry {
+		std::vector<uint8_t> vertices; // content key (compared on a hash hit)
+		std::vector<uint32_t> indices;
+		uint32_t stride = 0;
+		VkDeviceSize vertexByteOffset = 0;
+		uint32_t firstIndex = 0;
+		uint32_t refs = 0;
+	};
+	struct Frame {
+		VkBuffer instances = VK_NULL_HANDLE, args = VK_NULL_HANDLE;
+		VkDeviceMemory instanceMemory = VK_NULL_HANDLE, argsMemory = VK_NULL_HANDLE;
+		uint8_t *instanceData = nullptr, *argsData = nullptr;
+		VkDeviceSize instanceUsed = 0;
+		uint32_t commandsUsed = 0;
+	};
+
+	inline static DrawPool *active = nullptr;
+
+	void createBuffer(VkDeviceSize bytes, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer &buf, VkDeviceMemory &mem) const;
+	void upload(const void *vertices, VkDeviceSize vertexBytes, VkDeviceSize vertexOffset, const uint32_t *indices, VkDeviceSize indexCount, VkDeviceSize firstIndex) const;
+	bool streamsFull();
+
+	const LogicalDevice *logical = nullptr; // borrowed: single-use upload commands
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+
+	VkBuffer vertexBuf = VK_NULL_HANDLE, indexBuf = VK_NULL_HANDLE;
+	VkDeviceMemory vertexMem = VK_NULL_HANDLE, indexMem = VK_NULL_HANDLE;
+	FreeList vertexFree, indexFree; // bytes / indices
+	std::vector<Entry> entries;
+	std::vector<uint32_t> freeEntries;
+	std::unordered_multimap<uint64_t, uint32_t> byContent;
+
+	std::vector<Frame> frames;
+	uint32_t frame = 0;
+	bool multiDraw = false;
+	uint32_t maxDrawCount = 1;
+	bool warnedFull = false;
+};
@@ -3,16 +3,24 @@
 #include "commandbuffers.hpp"
 #include "dearimgui.hpp"
 #include "debug.hpp"
+#include "descriptorallocator.hpp"
+#include "downsampler.hpp"
+#include "drawpool.hpp"
 #include "graphicsbuffers.hpp"
 #include "logicaldevice.hpp"
 #include "physicaldevice.hpp"
+#include "pipelinecache.hpp"
 #include "scenes.hpp"
 #include "surface.hpp"
 #include "swapchain.hpp"
 #include "synchronization.hpp"
+#include "textureatlas.hpp"
+#include "textureheap.hpp"
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
@@ -21,29 +29,66 @@ struct GLFWwindow;
 class Engine {
   public:
 	Engine() = default;
-	~Engine() = default;
+	~Engine();
 
 	void init(GLFWwindow *window);
 	void drawFrame(Scenes &scenes, bool framebufferResizedFlag);
 	void recreateSwapchain(Scenes &scenes);
 	void beginImGuiFrame();
 
+	// Headless: no window, surface, swapchain or ImGui. Frames are rendered into the GraphicsBuffers
+	// targets only and copied to a host-visible buffer, so it runs on software ICDs (lavapipe) / CI.
+	void initHeadless(uint32_t width, uint32_t height);
+	void drawFrameHeadless(Scenes &scenes);
+
+	// Last submitted headless frame as tightly packed RGBA8 (sRGB encoded like the swapchain, alpha forced opaque).
+	// Waits for that frame's fence. Returns false if nothing was rendered yet.
+	bool readbackFrame(std::vector<uint8_t> &rgba, uint32_t &width, uint32_t &height);
+	bool writeFramePNG(const std::string &path);
+	static bool writePNG(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height);
+
 	VkDevice getDevice() const { return logicalDevice ? logicalDevice->getDevice() : VK_NULL_HANDLE; }
 	VkPhysicalDevice getPhysicalDevice() const { return physicalDevice ? physicalDevice->getPhysicalDevice() : VK_NULL_HANDLE; }
 	const GraphicsBuffers &getGraphicsBuffer() const { return *graphicsBuffers; }
 	const LogicalDevice &getLogicalDevice() const { return *logicalDevice; }
 	const Swapchain &getSwapchain() const { return *swapchain; }
+	Downsampler &getDownsampler() { return *downsampler; }
 	GLFWwindow *getWindow() const { return window; }
 
+	bool isHeadless() const { return headless; }
+	VkExtent2D getExtent() const { return swapchain ? swapchain->getExtent() : headlessExtent; }
+
   private:
+	struct Readback {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void *mapped = nullptr;
+	};
+
+	void submitCompute(Scenes &scenes);
+	VkImage recordLayers(VkCommandBuffer cmd, Scenes &scenes, uint32_t imageIndex);
+	void createReadbacks();
+	void destroyReadbacks();
+
 	GLFWwindow *window = nullptr;
+	bool headless = false;
+	VkExtent2D headlessExtent{};
+	uint32_t headlessImageIndex = 0;
+	int32_t lastReadbackFrame = -1;
+	std::vector<Readback> readbacks; // one per frame overlap
 
 	std::unique_ptr<Debug> debug;
 	std::unique_ptr<Surface> surface;
 	std::unique_ptr<PhysicalDevice> physicalDevice;
 	std::unique_ptr<LogicalDevice> logicalDevice;
+	std::unique_ptr<PipelineCache> pipelineCache; // after logicalDevice: saved and destroyed before it
+	std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+	std::unique_ptr<TextureAtlas> textureAtlas; // before textureHeap: outlives the cell frees the heap defers
+	std::unique_ptr<DrawPool> drawPool;			// before textureHeap: outlives the geometry frees the heap defers
+	std::unique_ptr<TextureHeap> textureHeap;
 	std::unique_ptr<Swapchain> swapchain;
 	std::unique_ptr<GraphicsBuffers> graphicsBuffers;
+	std::unique_ptr<Downsampler> downsampler;
 	std::unique_ptr<CommandBuffers> commandBuffers;
 	std::unique_ptr<Synchronization> synchronization;
 	std::unique_ptr<DearImGui> imgui;
@@ -11,6 +11,8 @@
 // You sample "src" using getSceneSetA(i) or getSceneSetB(i).
 //
 // Usage flags allow COLOR_ATTACHMENT, SAMPLED, TRANSFER_SRC, TRANSFER_DST for runtime blur/mip gen.
+// STORAGE is added when the color format supports it, so the compute downsampler can write every mip
+// through the per-mip views (getColorAMipView / getColorBMipView).
 
 class GraphicsBuffers {
   public:
@@ -29,16 +31,19 @@ class GraphicsBuffers {
 	VkFormat getDepthFormat() const { return depthFmt; }
 	VkExtent2D getExtent() const { return size; }
 	uint32_t getMipLevels() const { return mipLevels; }
+	bool supportsStorageMips() const { return storageMips; }
 
 	// accumulation targets A (often used as src or dst depending on frame stage)
 	VkImage getColorAImage(uint32_t i) const { return sceneColorAImages[i]; }
 	VkImageView getColorAAttView(uint32_t i) const { return sceneColorAAttViews[i]; }		// mip0 only
 	VkImageView getColorASampleView(uint32_t i) const { return sceneColorASampleViews[i]; } // full mip chain
+	VkImageView getColorAMipView(uint32_t i, uint32_t mip) const { return sceneColorAMipViews[i][mip]; } // single mip (storage)
 
 	// accumulation targets B
 	VkImage getColorBImage(uint32_t i) const { return sceneColorBImages[i]; }
 	VkImageView getColorBAttView(uint32_t i) const { return sceneColorBAttViews[i]; }
 	VkImageView getColorBSampleView(uint32_t i) const { return sceneColorBSampleViews[i]; }
+	VkImageView getColorBMipView(uint32_t i, uint32_t mip) const { return sceneColorBMipViews[i][mip]; }
 
 	// depth target (shared per-swapimage usage in passes)
 	VkImage getDepthImage() const { return depthImage; }
@@ -61,6 +66,7 @@ class GraphicsBuffers {
 
 	VkExtent2D size{};
 	uint32_t mipLevels = 1;
+	bool storageMips = false;
 
 	VkFormat sceneColorFmt = VK_FORMAT_R16G16B16A16_SFLOAT;
 	VkFormat depthFmt = VK_FORMAT_D32_SFLOAT;
@@ -71,12 +77,14 @@ class GraphicsBuffers {
 	std::vector<VkDeviceMemory> sceneColorAMemory;
 	std::vector<VkImageView> sceneColorAAttViews;	 // COLOR_ATTACHMENT view (mip0 only)
 	std::vector<VkImageView> sceneColorASampleViews; // full mip chain, for sampling
+	std::vector<std::vector<VkImageView>> sceneColorAMipViews; // one view per mip (only if storageMips)
 
 	// B ping target (per swapchain image)
 	std::vector<VkImage> sceneColorBImages;
 	std::vector<VkDeviceMemory> sceneColorBMemory;
 	std::vector<VkImageView> sceneColorBAttViews;
 	std::vector<VkImageView> sceneColorBSampleViews;
+	std::vector<std::vector<VkImageView>> sceneColorBMipViews;
 
 	// depth (single image, single view)
 	VkImage depthImage = VK_NULL_HANDLE;
@@ -19,6 +19,14 @@ class LogicalDevice {
 	uint32_t getGraphicsQueueFamily() const { return qGraphics; }
 	uint32_t getPresentQueueFamily() const { return qPresent; }
 
+	// vkCmdDrawIndexedIndirectCount usable (Vulkan 1.2 drawIndirectCount feature, enabled when supported)
+	bool supportsDrawIndirectCount() const { return drawIndirectCount; }
+	// BCn textures sampleable (textureCompressionBC feature, enabled when supported)
+	bool supportsTextureCompressionBC() const { return textureCompressionBC; }
+	// vkCmdDrawIndexedIndirect with drawCount > 1 and non-zero firstInstance (multiDrawIndirect +
+	// drawIndirectFirstInstance features, enabled when both are supported; DrawPool merges draws with it)
+	bool supportsMultiDrawIndirect() const { return multiDrawIndirect; }
+
 	VkCommandBuffer beginSingleUseCmd() const;
 	void endSingleUseCmdGraphics(VkCommandBuffer cmd) const;
 
@@ -33,6 +41,10 @@ class LogicalDevice {
 	uint32_t qGraphics = 0;
 	uint32_t qPresent = 0;
 
+	bool drawIndirectCount = false;
+	bool textureCompressionBC = false;
+	bool multiDrawIndirect = false;
+
 	VkCommandPool uploadCmdPool = VK_NULL_HANDLE;
 
 	void createLogicalDevice(const QueueFamilyIndices &families, const std::vector<const char *> &deviceExtensions, bool enableValidation);
@@ -21,6 +21,8 @@ static const std::vector<const char *> requiredDeviceExtensions = {
 	// dynamic rendering and sync2 are core in 1.3, but older (1.2) drivers may expose them as extensions.
 };
 
+// surface == VK_NULL_HANDLE -> headless: no present/swapchain requirements, present family aliases graphics,
+// and any device type is accepted (so software ICDs like lavapipe work).
 class PhysicalDevice {
   public:
 	PhysicalDevice(VkInstance instance, VkSurfaceKHR surface);
@@ -28,6 +30,7 @@ class PhysicalDevice {
 
 	VkPhysicalDevice getPhysicalDevice() const { return physicalDevice; }
 	const QueueFamilyIndices &getQueueFamilies() const { return families; }
+	bool isHeadless() const { return surface == VK_NULL_HANDLE; }
 
 	SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice dev) const;
 
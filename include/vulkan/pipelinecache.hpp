@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vulkan/vulkan.h>
+
+// PipelineCache:
+// One VkPipelineCache per device, owned by the Engine and used by every Pipeline (and the ImGui backend).
+// - create() seeds it from `path` when the file was written by the same device and driver: our header
+//   (vendor/device ID, driver version, pipelineCacheUUID, size, checksum) and the driver's own header must
+//   both match, otherwise the file is ignored and an empty cache is created.
+// - destroy() writes the current contents back (temp file + rename) before destroying it.
+// - get() is the handle of the live cache, VK_NULL_HANDLE before create() / after destroy().
+class PipelineCache {
+  public:
+	PipelineCache() = default;
+	~PipelineCache();
+
+	static VkPipelineCache get() { return active; }
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, const std::string &path);
+	void save() const;
+	void destroy();
+
+  private:
+	inline static VkPipelineCache active = VK_NULL_HANDLE;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties props{};
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	std::string path;
+};
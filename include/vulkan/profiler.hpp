@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Profiler:
+// Per-frame CPU scopes + GPU timestamp pairs (vkCmdWriteTimestamp2), published into a lock-free ring of
+// finished frames that the ImGui panel and the Chrome trace exporter read from.
+// - CPU scopes: PROFILE_SCOPE("name"), only recorded on the thread that calls newFrame() (others are ignored).
+// - GPU scopes: PROFILE_GPU_SCOPE(cmd, "name") around recorded work (inside or outside rendering).
+//   Results are fetched in beginGpuFrame() once the slot's fence was waited on, so the GPU half of a record
+//   belongs to an older frame (gpuFrame) than the CPU half (frame).
+// Everything is a no-op while disabled (toggled with F3 in the windowed app, or ENGINE_PROFILE=1).
+class Profiler {
+  public:
+	static constexpr uint32_t kMaxEvents = 256; // per frame, per timeline
+	static constexpr uint32_t kRingFrames = 64;
+	static constexpr uint32_t kMaxQueries = kMaxEvents * 2;
+
+	struct Event {
+		char name[48];
+		uint64_t beginNs, endNs; // CPU: since profiler start; GPU: since the first timestamp of that frame
+		uint32_t depth;
+	};
+
+	struct FrameRecord {
+		uint64_t frame = 0;
+		uint64_t gpuFrame = 0;
+		uint64_t cpuBeginNs = 0, cpuEndNs = 0;
+		uint32_t cpuCount = 0, gpuCount = 0;
+		std::array<Event, kMaxEvents> cpu;
+		std::array<Event, kMaxEvents> gpu;
+	};
+
+	static Profiler &get();
+
+	// GPU side (once per device); without timestamp support only CPU scopes are recorded
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t frameOverlap);
+	void destroy();
+
+	void setEnabled(bool e) { enabledRequested.store(e, std::memory_order_relaxed); }
+	bool isEnabled() const { return frameEnabled; }
+	void setPanelVisible(bool v) { panelVisible = v; }
+	bool isPanelVisible() const { return panelVisible; }
+
+	// CPU frame boundary: publishes the previous frame and starts a new one (main loop, once per iteration)
+	void newFrame();
+	// after the slot's fence wait: read back its timestamps, reset its queries in `firstCmd`
+	void beginGpuFrame(VkCommandBuffer firstCmd, uint32_t frameSlot);
+
+	int32_t cpuBegin(const char *name);
+	void cpuEnd(int32_t scope);
+	int32_t gpuBegin(VkCommandBuffer cmd, const char *name);
+	void gpuEnd(VkCommandBuffer cmd, int32_t scope);
+
+	// readers (any thread)
+	bool latest(FrameRecord &out) const;
+	size_t snapshot(std::vector<FrameRecord> &out, size_t maxFrames = kRingFrames) const;
+	bool exportChromeTrace(const std::string &path) const;
+
+	// ImGui window; call between ImGui::NewFrame() and ImGui::Render()
+	void drawPanel();
+
+	class CpuScope {
+	  public:
+		explicit CpuScope(const char *name) : scope(Profiler::get().cpuBegin(name)) {}
+		~CpuScope() { Profiler::get().cpuEnd(scope); }
+
+	  private:
+		int32_t scope;
+	};
+
+	class GpuScope {
+	  public:
+		GpuScope(VkCommandBuffer cmd, const char *name) : cmd(cmd), scope(Profiler::get().gpuBegin(cmd, name)) {}
+		~GpuScope() { Profiler::get().gpuEnd(cmd, scope); }
+
+	  private:
+		VkCommandBuffer cmd;
+		int32_t scope;
+	};
+
+  private:
+	Profiler();
+
+	struct GpuScopeInfo {
+		char name[48];
+		uint32_t queryBegin, queryEnd;
+		uint32_t depth;
+	};
+
+	struct GpuSlot {
+		VkQueryPool pool = VK_NULL_HANDLE;
+		uint64_t frame = 0;
+		uint32_t queries = 0;
+		uint32_t scopeCount = 0;
+		std::array<GpuScopeInfo, kMaxEvents> scopes;
+	};
+
+	struct RingSlot {
+		std::atomic<uint64_t> seq{0}; // odd while being written
+		FrameRecord rec;
+	};
+
+	uint64_t nowNs() const;
+	bool onOwnerThread() const { return std::this_thread::get_id() == owner; }
+	void collect(GpuSlot &slot);
+	void publish();
+
+	VkDevice device = VK_NULL_HANDLE;
+	double timestampPeriodNs = 0.0;
+	uint64_t timestampMask = 0;
+	std::vector<GpuSlot> gpuSlots;
+	GpuSlot *activeSlot = nullptr;
+	uint32_t gpuDepth = 0;
+
+	std::atomic<bool> enabledRequested{false};
+	bool frameEnabled = false;
+	bool panelVisible = false;
+	std::thread::id owner;
+	uint64_t startNs = 0;
+	uint64_t frameCounter = 0;
+	uint32_t cpuDepth = 0;
+
+	std::unique_ptr<FrameRecord> building;
+	std::unique_ptr<RingSlot[]> ring;
+	std::atomic<uint64_t> published{0}; // number of records written
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::CpuScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(cmd, name) Profiler::GpuScope PROFILE_CONCAT(profileGpuScope_, __LINE__)(cmd, name)
@@ -1,8 +1,51 @@
 #pragma once
 
+#include <algorithm>
 #include <vulkan/vulkan_core.h>
 
 namespace Rendering {
+// --- rect helpers (dirty-rect compositing) ---
+inline bool rectEmpty(const VkRect2D &r) { return r.extent.width == 0 || r.extent.height == 0; }
+
+inline VkRect2D rectUnion(const VkRect2D &a, const VkRect2D &b) {
+	if (rectEmpty(a))
+		return b;
+	if (rectEmpty(b))
+		return a;
+	const int32_t x0 = std::min(a.offset.x, b.offset.x);
+	const int32_t y0 = std::min(a.offset.y, b.offset.y);
+	const int32_t x1 = std::max(a.offset.x + (int32_t)a.extent.width, b.offset.x + (int32_t)b.extent.width);
+	const int32_t y1 = std::max(a.offset.y + (int32_t)a.extent.height, b.offset.y + (int32_t)b.extent.height);
+	return VkRect2D{{x0, y0}, {uint32_t(x1 - x0), uint32_t(y1 - y0)}};
+}
+
+inline bool rectOverlaps(const VkRect2D &a, const VkRect2D &b) {
+	if (rectEmpty(a) || rectEmpty(b))
+		return false;
+	return a.offset.x < b.offset.x + (int32_t)b.extent.width && b.offset.x < a.offset.x + (int32_t)a.extent.width && a.offset.y < b.offset.y + (int32_t)b.extent.height && b.offset.y < a.offset.y + (int32_t)a.extent.height;
+}
+
+// clamp to [0, extent); returns an empty rect if nothing is left
+inline VkRect2D rectClamp(const VkRect2D &r, VkExtent2D extent) {
+	const int32_t x0 = std::clamp(r.offset.x, 0, (int32_t)extent.width);
+	const int32_t y0 = std::clamp(r.offset.y, 0, (int32_t)extent.height);
+	const int32_t x1 = std::clamp(r.offset.x + (int32_t)r.extent.width, 0, (int32_t)extent.width);
+	const int32_t y1 = std::clamp(r.offset.y + (int32_t)r.extent.height, 0, (int32_t)extent.height);
+	if (x1 <= x0 || y1 <= y0)
+		return VkRect2D{{0, 0}, {0, 0}};
+	return VkRect2D{{x0, y0}, {uint32_t(x1 - x0), uint32_t(y1 - y0)}};
+}
+
+// [x0, x1) range of mip `level` touched by a mip0 rect, grown by `pad` texels for filter footprints
+inline void rectRangeAtMip(const VkRect2D &r, uint32_t level, uint32_t w, uint32_t h, int32_t pad, int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1) {
+	const int32_t mw = (int32_t)std::max(1u, w >> level);
+	const int32_t mh = (int32_t)std::max(1u, h >> level);
+	x0 = std::max(0, (r.offset.x >> level) - pad);
+	y0 = std::max(0, (r.offset.y >> level) - pad);
+	x1 = std::min(mw, ((r.offset.x + (int32_t)r.extent.width - 1) >> level) + 1 + pad);
+	y1 = std::min(mh, ((r.offset.y + (int32_t)r.extent.height - 1) >> level) + 1 + pad);
+}
+
 // generic layout / access transition for a whole subresource range
 inline static void cmdTransitionImage(VkCommandBuffer cmd, VkImage image, VkImageAspectFlags aspect, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t baseMip, uint32_t levelCount, VkPipelineStageFlags2 srcStageMask, VkAccessFlags2 srcAccessMask, VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask) {
 	VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
@@ -79,6 +122,47 @@ inline static void cmdBuildMipsForImageRuntime(VkCommandBuffer cmd, VkImage imag
 	cmdTransitionImage(cmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, mipLevels, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
 }
 
+// Partial variant of the above for dirty-rect compositing.
+// Assumptions:
+// - level0 in COLOR_ATTACHMENT_OPTIMAL, levels 1.. in SHADER_READ_ONLY_OPTIMAL and still valid outside `region`.
+// - only texels of each mip touched by `region` (mip0 coords, +1 texel for the linear footprint) are re-blitted.
+inline static void cmdBuildMipsForImageRegion(VkCommandBuffer cmd, VkImage image, uint32_t w, uint32_t h, uint32_t mipLevels, const VkRect2D &region) {
+	if (mipLevels <= 1)
+		return;
+
+	cmdTransitionImage(cmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+	for (uint32_t level = 1; level < mipLevels; ++level) {
+		// keep the untouched texels: SHADER_READ_ONLY_OPTIMAL (not UNDEFINED) -> TRANSFER_DST_OPTIMAL
+		cmdTransitionImage(cmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, level, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+		int32_t x0, y0, x1, y1;
+		rectRangeAtMip(region, level, w, h, 1, x0, y0, x1, y1);
+		const int32_t srcW = (int32_t)std::max(1u, w >> (level - 1));
+		const int32_t srcH = (int32_t)std::max(1u, h >> (level - 1));
+
+		VkImageBlit blit{};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[0] = {std::min(x0 * 2, srcW), std::min(y0 * 2, srcH), 0};
+		blit.srcOffsets[1] = {std::min(x1 * 2, srcW), std::min(y1 * 2, srcH), 1};
+
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[0] = {x0, y0, 0};
+		blit.dstOffsets[1] = {x1, y1, 1};
+
+		if (x1 > x0 && y1 > y0 && blit.srcOffsets[1].x > blit.srcOffsets[0].x && blit.srcOffsets[1].y > blit.srcOffsets[0].y)
+			vkCmdBlitImage(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		cmdTransitionImage(cmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, level, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+	}
+
+	cmdTransitionImage(cmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, mipLevels, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+}
+
 // Copy src.mip0 -> dst.mip0 before we start drawing new translucent layer.
 // We'll:
 //   dst: UNDEFINED -> TRANSFER_DST_OPTIMAL
@@ -120,9 +204,34 @@ inline void cmdCopyBaseMipToDstAndMakeColorAttachment(VkCommandBuffer cmd, VkIma
 	cmdTransitionImage(cmd, dstImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
 }
 
+// Region variant: dst.mip0 still holds the previous composite outside `region`, so only the rect is copied.
+//   dst: dstOldLayout -> TRANSFER_DST_OPTIMAL (contents kept)
+//   vkCmdCopyImage src->dst (same format/size, no filtering needed)
+//   dst: TRANSFER_DST_OPTIMAL -> COLOR_ATTACHMENT_OPTIMAL
+// src.mip0 must already be TRANSFER_SRC_OPTIMAL (caller does it, same as the full copy).
+inline void cmdCopyBaseMipRegionToDstAndMakeColorAttachment(VkCommandBuffer cmd, VkImage srcImg, VkImage dstImg, const VkRect2D &region, VkImageLayout dstOldLayout) {
+	cmdTransitionImage(cmd, dstImg, VK_IMAGE_ASPECT_COLOR_BIT, dstOldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+	if (!rectEmpty(region)) {
+		VkImageCopy cp{};
+		cp.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		cp.srcSubresource.mipLevel = 0;
+		cp.srcSubresource.layerCount = 1;
+		cp.srcOffset = {region.offset.x, region.offset.y, 0};
+		cp.dstSubresource = cp.srcSubresource;
+		cp.dstOffset = cp.srcOffset;
+		cp.extent = {region.extent.width, region.extent.height, 1};
+
+		vkCmdCopyImage(cmd, srcImg, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstImg, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cp);
+	}
+
+	cmdTransitionImage(cmd, dstImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+}
+
 // Begin dynamic rendering to a color attachment (and optional depth).
 // loadOp configurable: for opaque bootstrap we CLEAR, for translucent layers we LOAD.
-inline void cmdBeginRenderingColorDepth(VkCommandBuffer cmd, VkImageView colorAttView, VkImageView depthView, VkExtent2D extent, VkClearColorValue clearColor, VkClearDepthStencilValue clearDepth, VkAttachmentLoadOp colorLoad, VkAttachmentStoreOp colorStore, VkAttachmentLoadOp depthLoad, VkAttachmentStoreOp depthStore) {
+// renderArea (optional) narrows the pass to a dirty rect; defaults to the full extent.
+inline void cmdBeginRenderingColorDepth(VkCommandBuffer cmd, VkImageView colorAttView, VkImageView depthView, VkExtent2D extent, VkClearColorValue clearColor, VkClearDepthStencilValue clearDepth, VkAttachmentLoadOp colorLoad, VkAttachmentStoreOp colorStore, VkAttachmentLoadOp depthLoad, VkAttachmentStoreOp depthStore, const VkRect2D *renderArea = nullptr) {
 	// color attachment info
 	VkRenderingAttachmentInfo colorAtt{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
 	colorAtt.imageView = colorAttView;
@@ -146,6 +255,8 @@ inline void cmdBeginRenderingColorDepth(VkCommandBuffer cmd, VkImageView colorAt
 	VkRenderingInfo ri{VK_STRUCTURE_TYPE_RENDERING_INFO};
 	ri.renderArea.offset = {0, 0};
 	ri.renderArea.extent = extent;
+	if (renderArea)
+		ri.renderArea = *renderArea;
 	ri.layerCount = 1;
 	ri.colorAttachmentCount = 1;
 	ri.pColorAttachments = &colorAtt;
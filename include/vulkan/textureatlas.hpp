@@ -0,0 +1,98 @@
+#pragma once
+
+#include "textureheap.hpp"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// TextureAtlas:
+// Engine-wide pages that pack small textures (icons, small SVG rasters) so they share one VkImage, one
+// allocation, one sampler and one TextureHeap slot per page instead of a set each.
+// - A page holds one format and one Filter; its sampler is shared by every page with that Filter.
+// - allocate() places a w×h texture with a skyline (bottom-left) packer, reusing cells freed earlier when one
+//   fits (cut down to the request, the leftover stays free); stage() + record() then copy it in, with a
+//   kPadding border extruded from its edges so linear filtering never bleeds in a neighbour. Pages are
+//   single-level: atlased textures are sampled without mips.
+// - release() keeps the cell until no frame in flight samples it (through TextureHeap::release); a page whose
+//   last cell goes is destroyed, unless it is the last page of its format and Filter.
+// - Shaders sample the page at the region's sub-rectangle: uvOffset = (x, y) / kPageSize, uvScale = (w, h) / kPageSize.
+class TextureAtlas {
+  public:
+	static constexpr uint32_t kPageSize = 1024;
+	static constexpr uint32_t kMaxEntryPx = 256; // larger textures keep their own image
+	static constexpr uint32_t kPadding = 1;
+
+	enum class Filter {
+		Nearest,	// nearest both ways (SVG rasters, drawn close to 1:1)
+		NearestMag, // pixel-exact when magnified, linear when minified (Image)
+		Linear,
+	};
+
+	struct Region {
+		uint32_t page{0}; // 0: not in the atlas
+		uint32_t heapIndex{TextureHeap::kInvalid}; // the page's slot
+		uint32_t x{0}, y{0}, w{0}, h{0}; // texels inside the page, without the padding
+		uint32_t cellW{0}, cellH{0};	 // reserved cell (padding included, split to size), freed as a whole
+
+		bool valid() const { return page != 0; }
+	};
+
+	TextureAtlas() = default;
+	~TextureAtlas();
+
+	static TextureAtlas &get();
+	static TextureAtlas *current() { return active; } // nullptr when there is none (safe in destructors)
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice);
+	void destroy();
+
+	// 4-byte texel formats only; w and h at most kMaxEntryPx
+	static bool fits(VkFormat format, uint32_t w, uint32_t h);
+	static size_t stagingBytes(uint32_t w, uint32_t h) { return size_t(w + 2 * kPadding) * size_t(h + 2 * kPadding) * 4; }
+	// writes w×h texels plus the extruded border into dst (stagingBytes(w, h))
+	static void stage(const uint8_t *texels, uint32_t w, uint32_t h, uint8_t *dst);
+
+	Region allocate(VkFormat format, Filter filter, uint32_t w, uint32_t h);
+	// copies the staged texels at `offset` into the region's page; the caller submits `cmd` before sampling
+	void record(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, const Region &region);
+	void release(const Region &region);
+
+	size_t pageCount() const { return pages.size(); }
+
+  private:
+	struct Node {
+		uint32_t x, y, w; // skyline segment: [x, x + w) is filled up to y
+	};
+	struct Cell {
+		uint32_t x, y, w, h;
+	};
+	struct Page {
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		Filter filter{Filter::Nearest};
+		VkImage image{VK_NULL_HANDLE};
+		VkDeviceMemory memory{VK_NULL_HANDLE};
+		VkImageView view{VK_NULL_HANDLE};
+		VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+		uint32_t heapIndex{TextureHeap::kInvalid};
+		std::vector<Node> skyline;
+		std::vector<Cell> freed;
+		uint32_t live{0}; // allocated cells, including released ones not retired yet
+	};
+
+	inline static TextureAtlas *active = nullptr;
+
+	bool place(Page &page, uint32_t w, uint32_t h, Cell &out);
+	void splitFreed(Page &page, const Cell &cell, uint32_t w, uint32_t h);
+	uint32_t createPage(VkFormat format, Filter filter);
+	void destroyPage(Page &page);
+	void freeCell(uint32_t pageId, const Cell &cell);
+	VkSampler sampler(Filter filter);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	std::map<uint32_t, Page> pages;
+	std::map<Filter, VkSampler> samplers;
+	uint32_t nextPage = 1;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// TextureCodec:
+// CPU-side texture preparation (thread-safe, no Vulkan calls): everything a texture needs before it is copied
+// into a VkImage, so it can run on the ThreadPool.
+// - fromRGBA8(): sRGB-correct box-filtered mip chain, optionally block-compressed (BC1 for opaque images, BC7
+//   mode 6 when there is alpha; 8× / 4× smaller than RGBA8).
+// - readKTX2()/writeKTX2(): uncompressed-payload KTX2 (supercompressionScheme 0) with any format formatInfo()
+//   knows; also the on-disk format of the compressed texture cache.
+class TextureCodec {
+  public:
+	enum class Compression {
+		None, // RGBA8
+		BC1,  // opaque (alpha is dropped)
+		BC7,
+		Auto, // BC1 when every texel is opaque, BC7 otherwise
+	};
+
+	struct Level {
+		uint32_t w{1}, h{1};
+		size_t offset{0}, size{0}; // into Texture::data
+	};
+
+	struct Texture {
+		VkFormat format{VK_FORMAT_R8G8B8A8_SRGB};
+		std::vector<Level> levels; // [0] is the full-size image
+		std::vector<uint8_t> data;
+
+		uint32_t width() const { return levels.empty() ? 0u : levels[0].w; }
+		uint32_t height() const { return levels.empty() ? 0u : levels[0].h; }
+	};
+
+	struct FormatInfo {
+		uint32_t blockDim;	 // 1 for plain texels, 4 for BCn
+		uint32_t blockBytes; // bytes per texel / block
+	};
+
+	// false for formats this codec (and Image) does not handle
+	static bool formatInfo(VkFormat format, FormatInfo &out);
+	static bool isBlockCompressed(VkFormat format);
+	static uint32_t mipCount(uint32_t w, uint32_t h);
+
+	static Texture fromRGBA8(const uint8_t *rgba, uint32_t w, uint32_t h, bool mipmaps, Compression compression);
+	// a single-level RGBA8 texel, e.g. the 1×1 fallbacks
+	static Texture solid(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+
+	static bool readKTX2(const std::string &path, Texture &out, std::string *error = nullptr);
+	static bool writeKTX2(const std::string &path, const Texture &tex);
+
+  private:
+	static void encodeBC1(const uint8_t *rgba, uint32_t w, uint32_t h, uint8_t *out);
+	static void encodeBC7(const uint8_t *rgba, uint32_t w, uint32_t h, uint8_t *out);
+};
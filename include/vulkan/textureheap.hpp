@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// TextureHeap:
+// Engine-wide bindless texture table: one descriptor set holding a partially bound array of combined image
+// samplers (set=kSet, binding=0), shared by every model that samples textures (Image, SVG, Text).
+// - add() writes a texture into a free slot and returns its index, stable until release(); shaders read the
+//   index from their instance data / push constants. The binding is UPDATE_AFTER_BIND and
+//   UPDATE_UNUSED_WHILE_PENDING, so a slot is written while frames using the set are still in flight.
+// - release() keeps the slot (and defers `onRetired`, e.g. destroying the image) until every frame that may still
+//   sample it has completed; beginFrame() is called by the Engine once the frame's fence was waited on.
+// - Pipelines take the set with Pipeline::useSharedSet(TextureHeap::kSet, heap.layout(), heap.set()).
+class TextureHeap {
+  public:
+	static constexpr uint32_t kSet = 1;
+	static constexpr uint32_t kMaxTextures = 4096; // clamped to the device's update-after-bind limits
+	static constexpr uint32_t kInvalid = UINT32_MAX;
+
+	TextureHeap() = default;
+	~TextureHeap();
+
+	static TextureHeap &get();
+	static TextureHeap *current() { return active; } // nullptr when there is none (safe in destructors)
+
+	void create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameOverlap);
+	void destroy();
+
+	VkDescriptorSetLayout layout() const { return setLayout; }
+	VkDescriptorSet set() const { return descriptorSet; }
+	uint32_t capacity() const { return slotCount; }
+
+	uint32_t add(VkImageView view, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	void release(uint32_t index, std::function<void()> onRetired = {});
+
+	void beginFrame();
+
+  private:
+	struct Retired {
+		uint32_t index; // kInvalid: only `destroy` is deferred
+		uint64_t frame; // beginFrame() count when released
+		std::function<void()> destroy;
+	};
+
+	inline static TextureHeap *active = nullptr;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	uint32_t slotCount = 0;
+	std::vector<uint32_t> freeSlots; // popped from the back; starts with the low indices there
+	std::deque<Retired> retired;
+	uint64_t frame = 0;
+	uint32_t frameOverlap = 2;
+};
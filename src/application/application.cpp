@@ -1,7 +1,10 @@
 #include "application.hpp"
 #include "assets.hpp"
 #include "events.hpp"
+#include "ioreactor.hpp"
 #include "mouse.hpp"
+#include "profiler.hpp"
+#include "threadpool.hpp"
 #include <stdexcept>
 
 Application::~Application() { cleanup(); }
@@ -14,6 +17,47 @@ int Application::run() {
 	return 0;
 }
 
+int Application::runHeadless(uint32_t width, uint32_t height, uint32_t frames, const std::string &outPng, const std::string &traceJson) {
+	Assets::initialize();
+	if (!traceJson.empty())
+		Profiler::get().setEnabled(true);
+
+	engine = std::make_shared<Engine>();
+	engine->initHeadless(width, height);
+	scenes = std::make_unique<Scenes>(engine);
+	scenes->swapChainUpdate(float(width), float(height), int(width), int(height));
+
+	// fixed step so goldens don't depend on how fast the machine is
+	constexpr double kStepMs = 1000.0 / 60.0;
+	for (uint32_t i = 0; i < frames; ++i) {
+		Profiler::get().newFrame();
+		timeSinceLastFrameMs = kStepMs;
+		elapsedTimeMs = kStepMs * i;
+
+		// Decodes finish before the update that pumps them (Image/SVG drain theirs from onUpdate), so
+		// every frame, and the captured one, shows the same textures whatever the machine's speed.
+		ThreadPool::shared().waitIdle();
+		Events::onUpdate.dispatch(timeSinceLastFrameMs);
+		scenes->tick(timeSinceLastFrameMs, elapsedTimeMs);
+		engine->drawFrameHeadless(*scenes);
+	}
+
+	int rc = 0;
+	if (!traceJson.empty()) {
+		vkDeviceWaitIdle(engine->getDevice());
+		Profiler::get().newFrame(); // publish the last frame
+		if (!Profiler::get().exportChromeTrace(traceJson))
+			rc = 1;
+	}
+	if (!outPng.empty() && !engine->writeFramePNG(outPng)) {
+		std::fprintf(stderr, "[Application] failed to write %s\n", outPng.c_str());
+		rc = 1;
+	}
+
+	vkDeviceWaitIdle(engine->getDevice());
+	return rc;
+}
+
 void Application::initWindow() {
 	glfwSetErrorCallback([](int code, const char *desc) { std::fprintf(stderr, "[GLFW] Error %d: %s\n", code, desc); });
 	if (!glfwInit()) {
@@ -64,6 +108,16 @@ void Application::initEngine() {
 	engine = std::make_shared<Engine>();
 	engine->init(window);
 	scenes = std::make_unique<Scenes>(engine);
+
+	// F3: profiler on/off (panel follows)
+	Events::registerKeyPress([](int key, int, int action, int) {
+		if (key != GLFW_KEY_F3 || action != Events::ACTION_PRESS)
+			return;
+		Profiler &prof = Profiler::get();
+		const bool on = !prof.isPanelVisible();
+		prof.setPanelVisible(on);
+		prof.setEnabled(on);
+	});
 }
 
 void Application::updateTime() {
@@ -104,6 +158,7 @@ void Application::updateTime() {
 
 void Application::mainLoop() {
 	while (!glfwWindowShouldClose(window)) {
+		Profiler::get().newFrame();
 		glfwPollEvents();
 
 		updateTime();
@@ -133,6 +188,8 @@ void Application::mainLoop() {
 
 void Application::cleanup() {
 	scenes.reset();
+	// terminal sessions went with the scenes: join the PTY reader thread now, not during static destruction
+	IoReactor::shutdown();
 	engine.reset();
 	if (window) {
 		glfwDestroyWindow(window);
@@ -0,0 +1,71 @@
+#include "threadpool.hpp"
+
+#include <cstdio>
+#include <exception>
+
+ThreadPool &ThreadPool::shared() {
+	// leave a core for the render thread; hardware_concurrency() is 0 when it can't tell
+	const unsigned n = std::thread::hardware_concurrency();
+	static ThreadPool pool(n > 1 ? n - 1 : 1);
+	return pool;
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+	workers.reserve(threads);
+	for (unsigned i = 0; i < threads; ++i)
+		workers.emplace_back([this] { run(); });
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		stopping = true;
+		busy -= jobs.size();
+		jobs.clear();
+	}
+	cv.notify_all();
+	idle.notify_all();
+	for (std::thread &t : workers)
+		if (t.joinable())
+			t.join();
+}
+
+void ThreadPool::submit(Job job) {
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		if (stopping)
+			return;
+		jobs.push_back(std::move(job));
+		++busy;
+	}
+	cv.notify_one();
+}
+
+void ThreadPool::waitIdle() {
+	std::unique_lock<std::mutex> lk(mtx);
+	idle.wait(lk, [this] { return busy == 0; });
+}
+
+void ThreadPool::run() {
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lk(mtx);
+			cv.wait(lk, [this] { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		try {
+			job();
+		} catch (const std::exception &e) {
+			std::fprintf(stderr, "[ThreadPool] job failed: %s\n", e.what());
+		}
+
+		std::lock_guard<std::mutex> lk(mtx);
+		if (--busy == 0)
+			idle.notify_all();
+	}
+}
@@ -0,0 +1,36 @@
+#include "bytering.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+ByteRing::ByteRing(size_t capacity) {
+	capacity = std::bit_ceil(std::max<size_t>(capacity, 64));
+	buf = std::make_unique<char[]>(capacity);
+	mask = capacity - 1;
+}
+
+std::span<char> ByteRing::writeSpan() {
+	const size_t h = head.load(std::memory_order_relaxed);
+	const size_t t = tail.load(std::memory_order_acquire);
+	const size_t free = capacity() - (h - t);
+	const size_t at = h & mask;
+	return {buf.get() + at, std::min(free, capacity() - at)};
+}
+
+void ByteRing::commitWrite(size_t n) { head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+size_t ByteRing::read(char *out, size_t max) {
+	const size_t t = tail.load(std::memory_order_relaxed);
+	const size_t n = std::min(max, head.load(std::memory_order_acquire) - t);
+	if (n == 0)
+		return 0;
+	const size_t at = t & mask;
+	const size_t first = std::min(n, capacity() - at);
+	std::memcpy(out, buf.get() + at, first);
+	std::memcpy(out + first, buf.get(), n - first);
+	tail.store(t + n, std::memory_order_release);
+	return n;
+}
+
+void ByteRing::clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
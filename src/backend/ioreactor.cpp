@@ -0,0 +1,141 @@
+#include "ioreactor.hpp"
+
+#if defined(__linux__) || defined(__LINUX__) || defined(__gnu_linux__)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static std::mutex sharedMtx;
+static std::unique_ptr<IoReactor> sharedReactor;
+
+IoReactor &IoReactor::shared() {
+	std::lock_guard<std::mutex> lk(sharedMtx);
+	if (!sharedReactor)
+		sharedReactor.reset(new IoReactor());
+	return *sharedReactor;
+}
+
+IoReactor *IoReactor::current() {
+	std::lock_guard<std::mutex> lk(sharedMtx);
+	return sharedReactor.get();
+}
+
+void IoReactor::shutdown() {
+	std::unique_ptr<IoReactor> reactor;
+	{
+		std::lock_guard<std::mutex> lk(sharedMtx);
+		reactor = std::move(sharedReactor);
+	}
+	reactor.reset(); // joins outside the lock: current() stays callable meanwhile
+}
+
+IoReactor::IoReactor() {
+	epfd = ::epoll_create1(EPOLL_CLOEXEC);
+	wakefd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (epfd < 0 || wakefd < 0)
+		throw std::runtime_error(std::string("IoReactor::IoReactor: ") + std::strerror(errno));
+
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.u64 = 0; // id 0 is the shutdown eventfd
+	::epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+
+	thread = std::thread([this] { run(); });
+}
+
+IoReactor::~IoReactor() {
+	const uint64_t one = 1;
+	(void)!::write(wakefd, &one, sizeof(one));
+	if (thread.joinable())
+		thread.join();
+	::close(wakefd);
+	::close(epfd);
+}
+
+uint64_t IoReactor::add(int fd, Handler handler) {
+	std::lock_guard<std::mutex> lk(mtx);
+	const uint64_t id = nextId++;
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.u64 = id;
+	if (::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		std::fprintf(stderr, "[IoReactor] epoll_ctl(ADD, %d) failed: %s\n", fd, std::strerror(errno));
+		return 0;
+	}
+	entries.emplace(id, Entry{fd, std::move(handler)});
+	return id;
+}
+
+void IoReactor::remove(uint64_t id) {
+	std::lock_guard<std::mutex> lk(mtx);
+	auto it = entries.find(id);
+	if (it == entries.end())
+		return;
+	if (!it->second.paused)
+		::epoll_ctl(epfd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+	entries.erase(it);
+}
+
+void IoReactor::resume(uint64_t id) {
+	std::lock_guard<std::mutex> lk(mtx);
+	auto it = entries.find(id);
+	if (it == entries.end() || !it->second.paused)
+		return;
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.u64 = id;
+	if (::epoll_ctl(epfd, EPOLL_CTL_ADD, it->second.fd, &ev) == 0)
+		it->second.paused = false;
+}
+
+void IoReactor::run() {
+	epoll_event events[64];
+	for (;;) {
+		const int n = ::epoll_wait(epfd, events, 64, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			std::fprintf(stderr, "[IoReactor] epoll_wait failed: %s\n", std::strerror(errno));
+			return;
+		}
+
+		for (int i = 0; i < n; ++i) {
+			const uint64_t id = events[i].data.u64;
+			if (id == 0)
+				return; // shutdown
+
+			std::lock_guard<std::mutex> lk(mtx);
+			auto it = entries.find(id);
+			if (it == entries.end() || it->second.paused)
+				continue; // removed/paused earlier in this batch
+			Entry &e = it->second;
+
+			// paused and removed fds leave the epoll set: a hung-up fd would otherwise report EPOLLHUP forever
+			switch (e.handler(e.fd)) {
+			case Result::Continue:
+				break;
+			case Result::Pause:
+				::epoll_ctl(epfd, EPOLL_CTL_DEL, e.fd, nullptr);
+				e.paused = true;
+				break;
+			case Result::Remove:
+				::epoll_ctl(epfd, EPOLL_CTL_DEL, e.fd, nullptr);
+				entries.erase(it);
+				break;
+			}
+		}
+	}
+}
+
+#else
+
+// no PTY sessions off Linux: nothing to stop
+IoReactor *IoReactor::current() { return nullptr; }
+void IoReactor::shutdown() {}
+
+#endif
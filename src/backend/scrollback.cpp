@@ -0,0 +1,113 @@
+#include "scrollback.hpp"
+
+#include <cstring>
+
+Scrollback::Scrollback(size_t maxLines, size_t maxBytes) : maxLines(maxLines), maxBytes(maxBytes) { lineStarts.push_back(0); }
+
+void Scrollback::setLimits(size_t maxLines, size_t maxBytes) {
+	this->maxLines = maxLines;
+	this->maxBytes = maxBytes;
+	detachTail();
+	enforceLimits();
+}
+
+void Scrollback::push_back(char c) {
+	detachTail();
+	buf.push_back(c);
+	if (c == '\n') {
+		lineStarts.push_back(origin + buf.size());
+		enforceLimits();
+	}
+}
+
+void Scrollback::append(const char *s, size_t n) {
+	if (n == 0)
+		return;
+	detachTail();
+	const uint64_t base = origin + buf.size();
+	buf.append(s, n);
+	bool newline = false;
+	for (const char *p = s, *e = s + n; (p = static_cast<const char *>(std::memchr(p, '\n', size_t(e - p)))) != nullptr; ++p) {
+		lineStarts.push_back(base + uint64_t(p - s) + 1);
+		newline = true;
+	}
+	if (newline)
+		enforceLimits();
+}
+
+void Scrollback::pop_back() {
+	detachTail();
+	if (buf.size() <= head)
+		return;
+	if (buf.back() == '\n' && lineStarts.size() > 1)
+		lineStarts.pop_back();
+	buf.pop_back();
+	lowerStableEnd();
+}
+
+void Scrollback::truncateLine() {
+	detachTail();
+	buf.resize(size_t(lineStarts.back() - origin));
+	lowerStableEnd();
+}
+
+void Scrollback::clear() {
+	lowerStableEnd();
+	origin += committedEnd();
+	buf.clear();
+	head = 0;
+	tailAttached = false;
+	lineStarts.clear();
+	lineStarts.push_back(origin);
+}
+
+void Scrollback::setTail(std::string_view s) {
+	detachTail();
+	tail.assign(s);
+}
+
+std::string_view Scrollback::view() {
+	if (!tailAttached) {
+		buf.append(tail);
+		tailAttached = true;
+	}
+	return std::string_view(buf).substr(head);
+}
+
+uint64_t Scrollback::takeStableEnd() {
+	const uint64_t r = stableEnd;
+	stableEnd = endStreamPos();
+	return r;
+}
+
+std::string_view Scrollback::line(size_t i) const {
+	const size_t b = size_t(lineStarts[i] - origin);
+	const size_t e = i + 1 < lineStarts.size() ? size_t(lineStarts[i + 1] - origin) : committedEnd();
+	return std::string_view(buf).substr(b, e - b);
+}
+
+void Scrollback::enforceLimits() {
+	const bool overLines = maxLines && lineStarts.size() > maxLines + maxLines / 8;
+	const bool overBytes = maxBytes && size() > maxBytes + maxBytes / 8;
+	if (!overLines && !overBytes)
+		return;
+
+	bool trimmed = false;
+	while (lineStarts.size() > 1 && ((maxLines && lineStarts.size() > maxLines) || (maxBytes && size() > maxBytes))) {
+		lineStarts.pop_front();
+		head = size_t(lineStarts.front() - origin);
+		++dropped;
+		trimmed = true;
+	}
+	if (trimmed)
+		compact();
+}
+
+void Scrollback::compact() {
+	// only once the dead prefix is at least as big as what's live, so every byte moves O(1) times
+	if (head < 64 * 1024 || head < buf.size() - head)
+		return;
+	buf.erase(0, head);
+	origin += head;
+	head = 0;
+}
@@ -0,0 +1,158 @@
+#include "scrollbackindex.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static inline char ascii_lower(char c) { return (c >= 'A' && c <= 'Z') ? char(c + 32) : c; }
+
+static inline uint32_t trigram_bit(char a, char b, char c) {
+	const uint32_t t = uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16;
+	return (t * 0x9E3779B1u) >> 24; // 0..255
+}
+
+static inline size_t utf8_count(std::string_view s) {
+	size_t n = 0;
+	for (char c : s)
+		n += (uint8_t(c) & 0xC0) != 0x80;
+	return n;
+}
+
+// Visible bytes of `raw`: ESC sequences (SGR is all the filter keeps) removed.
+static void strip_escapes(std::string_view raw, std::string &out) {
+	out.clear();
+	for (size_t i = 0; i < raw.size(); ++i) {
+		if (raw[i] != '\x1b') {
+			out.push_back(raw[i]);
+			continue;
+		}
+		if (i + 1 < raw.size() && raw[i + 1] == '[') {
+			i += 2;
+			while (i < raw.size() && !(uint8_t(raw[i]) >= 0x40 && uint8_t(raw[i]) <= 0x7E))
+				++i;
+		} else {
+			++i;
+		}
+	}
+}
+
+// First occurrence of `needle` (size >= 1) in `hay` at or after `from`: compare the first and last needle
+// bytes 16 positions at a time and memcmp only where both match.
+static size_t find_substring(std::string_view hay, std::string_view needle, size_t from) {
+	const size_t k = needle.size();
+#if defined(__SSE2__)
+	if (k >= 2) {
+		const __m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[k - 1]);
+		size_t i = from;
+		for (; i + k - 1 + 16 <= hay.size(); i += 16) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay.data() + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hay.data() + i + k - 1));
+			unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+			while (mask) {
+				const unsigned bit = unsigned(__builtin_ctz(mask));
+				if (std::memcmp(hay.data() + i + bit + 1, needle.data() + 1, k - 2) == 0)
+					return i + bit;
+				mask &= mask - 1;
+			}
+		}
+		from = i;
+	}
+#endif
+	return hay.find(needle, from);
+}
+
+void ScrollbackIndex::clear() {
+	lines.clear();
+	visibleEnd = 0;
+}
+
+void ScrollbackIndex::update(const Scrollback &sb) {
+	const uint64_t first = sb.firstStreamPos();
+	while (!lines.empty() && lines.front().streamPos < first)
+		lines.pop_front();
+
+	// the current line (and anything after a rewound '\n') is not indexed yet
+	const size_t n = sb.lineCount();
+	const uint64_t current = sb.lineStreamPos(n - 1);
+	while (!lines.empty() && lines.back().streamPos >= current) {
+		visibleEnd = lines.back().visibleStart;
+		lines.pop_back();
+	}
+	if (!lines.empty() && lines.front().streamPos != first)
+		clear(); // lost sync (cleared scrollback): reindex what's live
+
+	for (size_t i = lines.size(); i + 1 < n; ++i)
+		add(sb.line(i), sb.lineStreamPos(i));
+}
+
+void ScrollbackIndex::add(std::string_view raw, uint64_t streamPos) {
+	Line l{streamPos, visibleEnd, raw.find('\x1b') == std::string_view::npos, {0, 0, 0, 0}};
+
+	std::string_view vis = raw;
+	if (!l.plain) {
+		strip_escapes(raw, scratch);
+		vis = scratch;
+	}
+	for (size_t i = 2; i < vis.size(); ++i) {
+		const uint32_t bit = trigram_bit(ascii_lower(vis[i - 2]), ascii_lower(vis[i - 1]), ascii_lower(vis[i]));
+		l.bloom[bit >> 6] |= uint64_t(1) << (bit & 63);
+	}
+	visibleEnd += utf8_count(vis);
+	lines.push_back(l);
+}
+
+std::vector<ScrollbackIndex::Hit> ScrollbackIndex::find(const Scrollback &sb, std::string_view needle, bool ignoreCase, size_t maxHits) const {
+	std::vector<Hit> hits;
+	if (needle.empty() || sb.lineCount() == 0)
+		return hits;
+
+	std::string query(needle);
+	if (ignoreCase)
+		for (char &c : query)
+			c = ascii_lower(c);
+	const size_t queryChars = utf8_count(query);
+
+	uint64_t want[4] = {0, 0, 0, 0};
+	for (size_t i = 2; i < query.size(); ++i) {
+		const uint32_t bit = trigram_bit(ascii_lower(query[i - 2]), ascii_lower(query[i - 1]), ascii_lower(query[i]));
+		want[bit >> 6] |= uint64_t(1) << (bit & 63);
+	}
+
+	const uint64_t base = lines.empty() ? visibleEnd : lines.front().visibleStart;
+	std::string stripped, folded;
+
+	auto scan = [&](std::string_view raw, bool plain, size_t line, uint64_t streamPos, uint64_t visibleStart) {
+		std::string_view vis = raw;
+		if (!plain) {
+			strip_escapes(raw, stripped);
+			vis = stripped;
+		}
+		if (ignoreCase) {
+			folded.assign(vis);
+			for (char &c : folded)
+				c = ascii_lower(c);
+			vis = folded;
+		}
+		for (size_t at = find_substring(vis, query, 0); at != std::string_view::npos && hits.size() < maxHits; at = find_substring(vis, query, at + 1)) {
+			const size_t column = utf8_count(vis.substr(0, at));
+			const size_t start = size_t(visibleStart - base) + column;
+			hits.push_back(Hit{streamPos, start, start + queryChars, line, column});
+		}
+	};
+
+	for (size_t i = 0; i < lines.size() && hits.size() < maxHits; ++i) {
+		const Line &l = lines[i];
+		if ((l.bloom[0] & want[0]) != want[0] || (l.bloom[1] & want[1]) != want[1] || (l.bloom[2] & want[2]) != want[2] || (l.bloom[3] & want[3]) != want[3])
+			continue;
+		scan(sb.line(i), l.plain, i, l.streamPos, l.visibleStart);
+	}
+
+	// current line: still mutable, not indexed
+	if (hits.size() < maxHits) {
+		const std::string_view cur = sb.line(sb.lineCount() - 1);
+		scan(cur, cur.find('\x1b') == std::string_view::npos, sb.lineCount() - 1, sb.lineStreamPos(sb.lineCount() - 1), visibleEnd);
+	}
+	return hits;
+}
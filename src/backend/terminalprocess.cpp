@@ -1,16 +1,16 @@
 #include "terminalprocess.hpp"
 #include "events.hpp"
+#include "ioreactor.hpp"
 #include "text.hpp"
 
 #if defined(__linux__) || defined(__LINUX__) || defined(__gnu_linux__)
 #include <pty.h>
 #include <utmp.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
-#include <mutex>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include <cerrno>
@@ -23,6 +23,12 @@
 #include <termios.h>
 #include <unistd.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 // -----------------------------------------------------------------------------
 // Small helpers
 // -----------------------------------------------------------------------------
@@ -56,6 +62,52 @@ static inline ssize_t write_all(int fd, const void *buf, size_t len) {
 	return (ssize_t)len;
 }
 
+// First byte in [p, e) the VT filter has to look at: ESC, CR, BS, DEL and C0 controls other than \n / \t.
+// Everything before it is plain text that can be appended as one run.
+static inline const char *find_special(const char *p, const char *e) {
+	auto special = [](unsigned char c) { return (c < 0x20 && c != '\n' && c != '\t') || c == 0x7F; };
+#if defined(__SSE2__)
+	const __m128i c1f = _mm_set1_epi8(0x1F), nl = _mm_set1_epi8('\n'), tab = _mm_set1_epi8('\t'), del = _mm_set1_epi8(0x7F);
+	for (; e - p >= 16; p += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, c1f), v); // v <= 0x1F (unsigned)
+		const __m128i keep = _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, tab));
+		const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_andnot_si128(keep, ctl), _mm_cmpeq_epi8(v, del)));
+		if (mask)
+			return p + __builtin_ctz(unsigned(mask));
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const uint8x16_t c1f = vdupq_n_u8(0x1F), nl = vdupq_n_u8('\n'), tab = vdupq_n_u8('\t'), del = vdupq_n_u8(0x7F);
+	for (; e - p >= 16; p += 16) {
+		const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+		const uint8x16_t keep = vorrq_u8(vceqq_u8(v, nl), vceqq_u8(v, tab));
+		const uint8x16_t hit = vorrq_u8(vbicq_u8(vcleq_u8(v, c1f), keep), vceqq_u8(v, del));
+		if (vmaxvq_u8(hit)) {
+			for (int i = 0; i < 16; ++i)
+				if (special((unsigned char)p[i]))
+					return p + i;
+		}
+	}
+#endif
+	for (; p < e; ++p)
+		if (special((unsigned char)*p))
+			return p;
+	return e;
+}
+
+// Length of the prefix of [p, p + n) that ends on a line: through the last '\n', or, in a line longer than
+// that, before a trailing UTF-8 sequence that may be incomplete. Never 0 for n > 0.
+static inline size_t safe_cut(const char *p, size_t n) {
+	if (const void *nl = ::memrchr(p, '\n', n))
+		return size_t(static_cast<const char *>(nl) - p) + 1;
+	size_t k = n;
+	while (k > 0 && n - k < 3 && ((unsigned char)p[k - 1] & 0xC0) == 0x80)
+		--k;
+	if (k > 0 && (unsigned char)p[k - 1] >= 0xC0)
+		--k; // lead byte: its sequence may continue in the next read
+	return k ? k : n;
+}
+
 static inline std::string utf32_to_utf8(char32_t cp) {
 	std::string out;
 	if (cp <= 0x7F) {
@@ -76,6 +128,46 @@ static inline std::string utf32_to_utf8(char32_t cp) {
 	return out;
 }
 
+// xterm input encoding for keys the character callback doesn't deliver (alternate screen passthrough)
+static std::string vt_key_sequence(int key, int mods, bool appCursorKeys) {
+	if ((mods & Events::MOD_CONTROL_KEY) && key >= 'A' && key <= 'Z')
+		return std::string(1, char(key - 'A' + 1));
+	const char *csi = appCursorKeys ? "\x1bO" : "\x1b[";
+	switch (key) {
+	case GLFW_KEY_ENTER:
+	case GLFW_KEY_KP_ENTER:
+		return "\r";
+	case GLFW_KEY_BACKSPACE:
+		return "\x7f";
+	case GLFW_KEY_TAB:
+		return "\t";
+	case GLFW_KEY_ESCAPE:
+		return "\x1b";
+	case GLFW_KEY_UP:
+		return std::string(csi) + 'A';
+	case GLFW_KEY_DOWN:
+		return std::string(csi) + 'B';
+	case GLFW_KEY_RIGHT:
+		return std::string(csi) + 'C';
+	case GLFW_KEY_LEFT:
+		return std::string(csi) + 'D';
+	case GLFW_KEY_HOME:
+		return std::string(csi) + 'H';
+	case GLFW_KEY_END:
+		return std::string(csi) + 'F';
+	case GLFW_KEY_INSERT:
+		return "\x1b[2~";
+	case GLFW_KEY_DELETE:
+		return "\x1b[3~";
+	case GLFW_KEY_PAGE_UP:
+		return "\x1b[5~";
+	case GLFW_KEY_PAGE_DOWN:
+		return "\x1b[6~";
+	default:
+		return {};
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Internal backend holder
 // -----------------------------------------------------------------------------
@@ -108,12 +200,15 @@ void TerminalProcess::init(Text *textModel) {
 	backend = std::make_shared<TerminalBackend>();
 
 	int mfd = -1, sfd = -1;
-	if (openpty(&mfd, &sfd, nullptr, nullptr, nullptr) < 0) {
+	struct winsize ws{};
+	ws.ws_row = (unsigned short)vt.getRows();
+	ws.ws_col = (unsigned short)vt.getCols();
+	if (openpty(&mfd, &sfd, nullptr, nullptr, &ws) < 0) {
 		// Show an error message in the text model
-		scrollback.assign("\033[31m[terminal] openpty() failed.\033[0m\n");
-		screen = scrollback;
+		scrollback.clear();
+		scrollback.append("\033[31m[terminal] openpty() failed.\033[0m\n");
 		if (textModel)
-			textModel->setText(screen);
+			textModel->setText(scrollback.view());
 		return;
 	}
 
@@ -122,10 +217,10 @@ void TerminalProcess::init(Text *textModel) {
 
 	pid_t pid = fork();
 	if (pid < 0) {
-		scrollback.assign("\033[31m[terminal] fork() failed.\033[0m\n");
-		screen = scrollback;
+		scrollback.clear();
+		scrollback.append("\033[31m[terminal] fork() failed.\033[0m\n");
 		if (textModel)
-			textModel->setText(screen);
+			textModel->setText(scrollback.view());
 		close(mfd);
 		close(sfd);
 		return;
@@ -152,14 +247,16 @@ void TerminalProcess::init(Text *textModel) {
 		cfmakeraw(&tio);
 		// keep signals so Ctrl-C / Ctrl-Z still work
 		tio.c_lflag |= ISIG;
+		// "\n" -> "\r\n" like a real tty, the screen model treats LF as a bare line feed
+		tio.c_oflag |= OPOST | ONLCR;
 		tio.c_cc[VERASE] = 0x7f;
 #ifdef ECHOCTL
 		tio.c_lflag &= ~ECHOCTL;
 #endif
 		tcsetattr(STDIN_FILENO, TCSANOW, &tio);
 
-		// Env. Pick ONE TERM.
-		setenv("TERM", "dumb", 1);
+		// Env. Pick ONE TERM: the screen model speaks xterm.
+		setenv("TERM", "xterm-256color", 1);
 
 		const char *shell = getenv("SHELL");
 		if (!shell || !*shell)
@@ -177,39 +274,34 @@ void TerminalProcess::init(Text *textModel) {
 
 	running.store(true);
 	scrollback.clear();
+	scrollback.setTail({});
 	inputLine.clear();
-	screen.clear();
+	vt.reset();
+	gridRows.clear();
 	if (textModel)
-		textModel->setText(screen);
-
-	// Reader thread: read from PTY and append to pending buffer
-	reader = std::thread([this]() {
-		std::vector<char> buf(4096);
-		while (running.load()) {
-			pollfd pfd{backend->master_fd, POLLIN, 0};
-			int pr = ::poll(&pfd, 1, 50);
-			if (pr < 0) {
-				if (errno == EINTR)
-					continue;
-				break;
-			}
-			if (pr == 0)
-				continue;
-
-			if (pfd.revents & POLLIN) {
-				ssize_t n = ::read(backend->master_fd, buf.data(), buf.size());
-				if (n > 0) {
-					std::lock_guard<std::mutex> lk(mtx);
-					pending.append(buf.data(), (size_t)n);
-					dirty.store(true, std::memory_order_release);
-				} else if (n == 0) {
-					// EOF
-					break;
-				} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
-					break;
-				}
-			}
+		textModel->setText(scrollback.view());
+
+	// PTY reads happen on the shared reactor thread, straight into the output ring. When the ring is full the
+	// fd is paused: the kernel buffer fills up and the child blocks instead of us buffering without bound.
+	output.clear();
+	outputPaused.store(false);
+	ioId = IoReactor::shared().add(mfd, [this](int fd) {
+		const std::span<char> space = output.writeSpan();
+		if (space.empty()) {
+			outputPaused.store(true, std::memory_order_release);
+			dirty.store(true, std::memory_order_release); // flushUI resumes us after draining
+			return IoReactor::Result::Pause;
 		}
+		// one read per wakeup keeps a flooding session from starving the others
+		const ssize_t n = ::read(fd, space.data(), space.size());
+		if (n > 0) {
+			output.commitWrite((size_t)n);
+			dirty.store(true, std::memory_order_release);
+			return IoReactor::Result::Continue;
+		}
+		if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+			return IoReactor::Result::Continue;
+		return IoReactor::Result::Remove; // EOF / EIO: the child is gone
 	});
 
 	// --- Input wiring ---
@@ -222,6 +314,13 @@ void TerminalProcess::init(Text *textModel) {
 
 		std::string utf8 = utf32_to_utf8((char32_t)codepoint);
 
+		// full-screen programs do their own echo/editing
+		if (vt.altScreenActive()) {
+			if (backend && backend->master_fd >= 0)
+				write_all(backend->master_fd, utf8.data(), utf8.size());
+			return;
+		}
+
 		if (caretInInput > inputLine.size())
 			caretInInput = inputLine.size();
 
@@ -240,6 +339,19 @@ void TerminalProcess::init(Text *textModel) {
 		if (action != Events::ACTION_PRESS && action != Events::ACTION_REPEAT)
 			return;
 
+		if (vt.altScreenActive()) {
+			std::string seq;
+			if ((mods & Events::MOD_CONTROL_KEY) && (key == GLFW_KEY_V || key == 'V')) {
+				const char *clip = glfwGetClipboardString(nullptr);
+				seq = clip ? clip : "";
+			} else {
+				seq = vt_key_sequence(key, mods, vt.applicationCursorKeys());
+			}
+			if (!seq.empty())
+				write_all(backend->master_fd, seq.data(), seq.size());
+			return;
+		}
+
 		// Ctrl-C: send interrupt to PTY
 		if ((mods & Events::MOD_CONTROL_KEY) && (key == GLFW_KEY_C || key == 'C')) {
 			const char intr = 0x03;
@@ -290,7 +402,7 @@ void TerminalProcess::init(Text *textModel) {
 			write_all(backend->master_fd, lineToSend.data(), lineToSend.size());
 
 			// Add the line to scrollback; clear inputLine
-			scrollback += inputLine;
+			scrollback.append(inputLine);
 			scrollback.push_back('\n');
 			inputLine.clear();
 			caretInInput = 0;
@@ -358,15 +470,18 @@ void TerminalProcess::shutdown() {
 		keyRegId.clear();
 	}
 
-	// Close PTY master to unblock reader
+	// Stop reads (synchronous: the handler is not running once this returns), then close the PTY master
+	if (ioId) {
+		if (IoReactor *reactor = IoReactor::current()) // gone after IoReactor::shutdown(), with our handler
+			reactor->remove(ioId);
+		ioId = 0;
+	}
+	output.clear();
 	if (backend && backend->master_fd >= 0) {
 		::close(backend->master_fd);
 		backend->master_fd = -1;
 	}
 
-	if (reader.joinable())
-		reader.join();
-
 	// Reap child if it has exited
 	if (backend && backend->child > 0) {
 		int st = 0;
@@ -379,30 +494,40 @@ void TerminalProcess::shutdown() {
 // VT filtering: append to scrollback
 // -----------------------------------------------------------------------------
 
-TerminalProcess::Action TerminalProcess::filter(const std::string &s) {
+TerminalProcess::Action TerminalProcess::filter(std::string_view s) {
 	// Byte-level VT filtering:
 	//  - Keep only SGR (CSI ... 'm') for color.
 	//  - Drop other CSI (K, H, J, cursor moves, DEC private like ?2004h/l).
 	//  - Drop OSC/DCS/SOS/PM/APC strings.
 	//  - Map "\r\n"→'\n'; lone '\r' resets to BOL.
-	enum State { S_Normal, S_Esc, S_Csi, S_String } st = S_Normal;
+	// Reads end anywhere, so the state (a CR waiting for its LF, a half-read sequence) carries over to the next call.
 	Action action = Action::APPEND;
 	size_t i = 0;
 	while (i < s.size()) {
 		unsigned char c = (unsigned char)s[i];
-		switch (st) {
-		case S_Normal:
-			if (c == '\r') {
-				if (i + 1 < s.size() && s[i + 1] == '\n') {
+		switch (filterState) {
+		case FilterState::Normal: {
+			if (pendingCR) {
+				pendingCR = false;
+				if (c == '\n') {
 					scrollback.push_back('\n');
-					i += 2;
+					++i;
 					break;
 				}
 				// BOL: truncate current line
-				if (auto p = scrollback.find_last_of('\n'); p == std::string::npos)
-					scrollback.clear();
-				else
-					scrollback.erase(p + 1);
+				scrollback.truncateLine();
+			}
+			// plain run up to the next control byte goes in as one append
+			const char *run = s.data() + i;
+			const char *stop = find_special(run, s.data() + s.size());
+			if (stop != run) {
+				scrollback.append(run, size_t(stop - run));
+				i += size_t(stop - run);
+				break;
+			}
+			if (c == '\r') {
+				// decided by the next byte, which may only come with the next read
+				pendingCR = true;
 				++i;
 				break;
 			}
@@ -414,7 +539,7 @@ TerminalProcess::Action TerminalProcess::filter(const std::string &s) {
 				break;
 			}
 			if (c == 0x1B) {
-				st = S_Esc;
+				filterState = FilterState::Esc;
 				++i;
 				break;
 			} // ESC
@@ -426,80 +551,70 @@ TerminalProcess::Action TerminalProcess::filter(const std::string &s) {
 			scrollback.push_back((char)c);
 			++i;
 			break;
+		}
 
-		case S_Esc:
-			if (i < s.size()) {
-				unsigned char n = (unsigned char)s[i];
-				if (n == '[') {
-					st = S_Csi;
-					++i;
-					break;
-				} // CSI
-				if (n == ']') {
-					st = S_String;
-					++i;
-					break;
-				} // OSC to BEL/ST
-				if (n == 'P' || n == 'X' || n == '^' || n == '_') { // DCS/SOS/PM/APC
-					st = S_String;
-					++i;
-					break;
-				}
+		case FilterState::Esc:
+			if (c == '[') {
+				filterState = FilterState::Csi;
+				filterSeq.clear();
+				++i;
+				break;
+			} // CSI
+			if (c == ']' || c == 'P' || c == 'X' || c == '^' || c == '_') { // OSC to BEL/ST, DCS/SOS/PM/APC
+				filterState = FilterState::String;
+				stringEsc = false;
+				++i;
+				break;
 			}
 			// Unknown single-ESC sequence → drop
-			st = S_Normal;
+			filterState = FilterState::Normal;
 			break;
 
-		case S_Csi: {
+		case FilterState::Csi: {
 			size_t j = i;
-			// Optional private marker '?'
-			if (j < s.size() && s[j] == '?')
-				++j;
-			// Params & intermediates up to final (0x40..0x7E)
+			// Params, private markers & intermediates up to final (0x40..0x7E)
 			while (j < s.size()) {
 				unsigned char ch = (unsigned char)s[j];
 				if (ch >= 0x40 && ch <= 0x7E)
 					break;
 				++j;
 			}
-			if (j >= s.size()) { // truncated; drop
-				st = S_Normal;
+			if (j >= s.size()) { // continues in the next read
+				if (filterSeq.size() + (j - i) > kMaxFilterSeq) { // runaway sequence; drop it
+					filterSeq.clear();
+					filterState = FilterState::Normal;
+				} else {
+					filterSeq.append(s.data() + i, j - i);
+				}
 				i = j;
 				break;
 			}
-			char final = s[j];
-			if (final == 'm') {
+			if (s[j] == 'm') {
 				// Keep SGR for renderer to colorize
 				scrollback.append("\x1b[", 2);
+				if (!filterSeq.empty())
+					scrollback.append(filterSeq.data(), filterSeq.size());
 				scrollback.append(s.data() + i, (j - i) + 1);
 			}
 			// else: DROP all other CSI (K, H, J, A/B/C/D, ?2004h/l, etc.)
-			st = S_Normal;
+			filterSeq.clear();
+			filterState = FilterState::Normal;
 			i = j + 1;
 			break;
 		}
 
-		case S_String: {
-			// OSC/DCS/etc until BEL (0x07) or ST (ESC \)
+		case FilterState::String: {
+			// OSC/DCS/etc until BEL (0x07) or ST (ESC \); intentionally dropped
 			size_t j = i;
-			bool done = false;
 			while (j < s.size()) {
-				unsigned char ch = (unsigned char)s[j];
-				if (ch == 0x07) {
-					++j;
-					done = true;
-					break;
-				} // BEL
-				if (ch == 0x1B && j + 1 < s.size() && s[j + 1] == '\\') {
-					j += 2;
-					done = true;
+				unsigned char ch = (unsigned char)s[j++];
+				if (ch == 0x07 || (stringEsc && ch == '\\')) {
+					filterState = FilterState::Normal;
 					break;
-				} // ST
-				++j;
+				}
+				stringEsc = ch == 0x1B;
 			}
-			st = S_Normal;
 			i = j;
-			(void)done; // intentionally dropped
 			break;
 		}
 		}
@@ -507,6 +622,13 @@ TerminalProcess::Action TerminalProcess::filter(const std::string &s) {
 	return action;
 }
 
+void TerminalProcess::resetFilter() {
+	filterState = FilterState::Normal;
+	pendingCR = false;
+	stringEsc = false;
+	filterSeq.clear();
+}
+
 // -----------------------------------------------------------------------------
 // UI flush: rebuild Text from scrollback + inputLine
 // -----------------------------------------------------------------------------
@@ -515,27 +637,73 @@ bool TerminalProcess::flushUI() {
 	if (!dirty.exchange(false, std::memory_order_acq_rel))
 		return false;
 
-	std::string delta;
-	{
-		std::lock_guard<std::mutex> lk(mtx);
-		delta.swap(pending);
-	}
-
-	if (!delta.empty()) {
-		filter(delta); // updates scrollback
+	// At most one budget of output per frame; a flood is worked off over several frames instead of
+	// stalling this one. Whatever is left keeps the terminal dirty.
+	if (pending.size() < carried + outputBudget)
+		pending.resize(carried + outputBudget);
+	const size_t got = carried + output.read(pending.data() + carried, outputBudget);
+	// A budget cut lands anywhere: end this frame at the last complete line (or UTF-8 character) and hold
+	// the rest back for the next one, so Text never shows half a character or a half-drawn line.
+	const size_t take = output.readable() ? safe_cut(pending.data(), got) : got;
+	const std::string_view delta(pending.data(), take);
+	carried = got - take;
+	if (carried || output.readable())
+		dirty.store(true, std::memory_order_release);
+	if (outputPaused.exchange(false, std::memory_order_acq_rel))
+		if (IoReactor *reactor = IoReactor::current())
+			reactor->resume(ioId);
+
+	// Every byte goes through the screen model; main-screen output also lands in the scrollback.
+	// feed() stops right after a screen switch so each side of it is routed correctly.
+	for (size_t off = 0; off < delta.size();) {
+		const bool wasAlt = vt.altScreenActive();
+		const size_t used = vt.feed(delta.data() + off, delta.size() - off);
+		if (!wasAlt)
+			filter(delta.substr(off, used));
+		else if (!vt.altScreenActive())
+			resetFilter(); // whatever the filter held from before the switch is stale now
+		off += used;
 	}
-
-	// Rebuild screen = scrollback + inputLine
-	screen.clear();
-	screen.reserve(scrollback.size() + inputLine.size());
-	screen.append(scrollback);
-	screen.append(inputLine);
+	if (!delta.empty())
+		searchIndex.update(scrollback);
+	if (carried)
+		std::memmove(pending.data(), pending.data() + take, carried);
+	const std::string replies = vt.takeReplies();
+	if (!replies.empty() && backend && backend->master_fd >= 0)
+		write_all(backend->master_fd, replies.data(), replies.size());
 
 	if (!textModel)
 		return false;
 
-	textModel->setText(screen);
-	textModel->rebuild();
+	if (vt.altScreenActive()) {
+		flushGrid();
+		return true;
+	}
+	if (!gridRows.empty()) {
+		// back from the alternate screen: Text holds the grid, show the scrollback again in full
+		gridRows.clear();
+		shownFirst = ~uint64_t(0);
+	}
+
+	// screen = scrollback + inputLine, read straight out of the scrollback buffer
+	scrollback.setTail(inputLine);
+
+	// Hand Text only what changed: everything it shows before the first rewritten committed byte stays.
+	const uint64_t first = scrollback.firstStreamPos();
+	const uint64_t end = scrollback.endStreamPos();
+	const uint64_t stable = std::min(scrollback.takeStableEnd(), shownEnd);
+	const std::string_view view = scrollback.view();
+	if (first != shownFirst || stable < first) {
+		// first flush, or old lines were dropped from the front: everything moves
+		textModel->setText(view);
+		textModel->rebuild();
+	} else if (stable != end || stable != shownEnd || inputLine != shownInput) {
+		const size_t keep = size_t(stable - first);
+		textModel->replaceTail(keep, view.substr(keep));
+	}
+	shownFirst = first;
+	shownEnd = end;
+	shownInput = inputLine;
 
 	// Length in *Text* coordinates (visible glyphs, no ANSI)
 	size_t len = textModel->textLength();
@@ -553,10 +721,131 @@ bool TerminalProcess::flushUI() {
 	size_t caretPos = visibleScrollbackLen + caretInInput - 1;
 
 	cursorIndex = caretPos;
-	textModel->setCaret(cursorIndex);
-	textModel->rebuild();
+	textModel->setCaretOnly(cursorIndex);
+
+	return true;
+}
+
+// SGR for a VtScreen palette index, in the single-parameter form Text::parseAnsiToRuns understands
+static void append_sgr(std::string &out, int fg) {
+	if (fg < 0)
+		out += "\x1b[0m";
+	else {
+		out += fg < 8 ? "\x1b[3" : "\x1b[9";
+		out += char('0' + (fg & 7));
+		out += 'm';
+	}
+}
+
+// Text draws foregrounds only: bold picks the bright palette entry, and reverse video (vim/less/htop status bars)
+// has no background to swap with, so it is drawn bright instead of blending into the surrounding text.
+static int display_fg(const VtScreen::Cell &cell) {
+	if (!(cell.attrs & (VtScreen::kBold | VtScreen::kReverse)))
+		return cell.fg;
+	if (cell.fg < 0)
+		return (cell.attrs & VtScreen::kReverse) ? 14 : 15; // bright cyan / bright white
+	return cell.fg | 8;
+}
+
+// The right half of a wide character is drawn by the character itself; an orphaned one (half overwritten by
+// ICH/DCH/resize) is serialized as a space.
+static bool is_wide_tail(const VtScreen &vt, int r, int c) { return c > 0 && vt.cell(r, c).ch == VtScreen::kWideTail && VtScreen::charWidth(vt.cell(r, c - 1).ch) == 2; }
+
+void TerminalProcess::flushGrid() {
+	const int rows = vt.getRows(), cols = vt.getCols();
+	const bool full = gridRows.size() != size_t(rows);
+	vt.takeDamage(gridDamage);
+	if (full)
+		gridRows.assign(size_t(rows), std::string());
+
+	// Re-serialize damaged rows; Text only has to re-lay out from the first row that actually changed.
+	int firstChanged = full ? 0 : rows;
+	std::string row;
+	for (int r = 0; r < rows; ++r) {
+		if (!full && !gridDamage[size_t(r)])
+			continue;
+		row.clear();
+		int fg = -1;
+		for (int c = 0; c < cols; ++c) {
+			if (is_wide_tail(vt, r, c))
+				continue;
+			const VtScreen::Cell &cell = vt.cell(r, c);
+			if (display_fg(cell) != fg) {
+				fg = display_fg(cell);
+				append_sgr(row, fg);
+			}
+			row += utf32_to_utf8(cell.ch == VtScreen::kWideTail ? U' ' : cell.ch);
+		}
+		if (fg >= 0)
+			append_sgr(row, -1); // rows start in the default color
+		if (row != gridRows[size_t(r)]) {
+			gridRows[size_t(r)].swap(row);
+			firstChanged = std::min(firstChanged, r);
+		}
+	}
+
+	if (firstChanged < rows) {
+		size_t keep = 0;
+		for (int r = 0; r < firstChanged; ++r)
+			keep += gridRows[size_t(r)].size() + 1;
+		std::string tail;
+		for (int r = firstChanged; r < rows; ++r) {
+			tail += gridRows[size_t(r)];
+			if (r + 1 < rows)
+				tail += '\n';
+		}
+		if (full) {
+			textModel->setText(tail);
+			textModel->rebuild();
+		} else {
+			textModel->replaceTail(keep, tail);
+		}
+	}
 
-    return true;
+	// Text owns the caret numbering (slots per line, wraps, glyph-less cells); it only needs the serialized column
+	maxCursorIndex = 0;
+	cursorIndex = ~size_t(0);
+	if (vt.cursorVisible()) {
+		size_t column = 0;
+		for (int c = 0; c < vt.cursorCol(); ++c)
+			column += !is_wide_tail(vt, vt.cursorRow(), c);
+		cursorIndex = textModel->caretIndexAt(size_t(vt.cursorRow()), column);
+	}
+	textModel->setCaretOnly(cursorIndex);
+}
+
+void TerminalProcess::setGridSize(int rows, int cols) {
+	vt.resize(rows, cols);
+	gridRows.clear(); // next grid flush re-sends everything
+	if (backend && backend->master_fd >= 0) {
+		struct winsize ws{};
+		ws.ws_row = (unsigned short)vt.getRows();
+		ws.ws_col = (unsigned short)vt.getCols();
+		ioctl(backend->master_fd, TIOCSWINSZ, &ws);
+	}
+	dirty.store(true, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Scrollback search
+// -----------------------------------------------------------------------------
+
+size_t TerminalProcess::search(std::string_view needle, bool ignoreCase) {
+	searchIndex.update(scrollback);
+	searchHits = searchIndex.find(scrollback, needle, ignoreCase);
+
+	// hits are scrollback lines/columns: only meaningful while Text shows the scrollback (one Text line per line)
+	if (textModel && gridRows.empty()) {
+		std::vector<std::pair<size_t, size_t>> ranges;
+		ranges.reserve(searchHits.size());
+		for (const auto &h : searchHits) {
+			const auto [first, end] = textModel->charRangeAt(h.line, h.column, h.column + (h.textEnd - h.textStart));
+			if (end > first)
+				ranges.emplace_back(first, end - 1);
+		}
+		textModel->setSelection(ranges);
+	}
+	return searchHits.size();
 }
 
 // -----------------------------------------------------------------------------
@@ -642,10 +931,26 @@ void TerminalProcess::shutdown() {
 // VT filtering: append to scrollback
 // -----------------------------------------------------------------------------
 
-TerminalProcess::Action TerminalProcess::filter(const std::string &s) {
+TerminalProcess::Action TerminalProcess::filter(std::string_view s) {
 	return Action::APPEND;
 }
 
+void TerminalProcess::resetFilter() {
+	
+}
+
+void TerminalProcess::flushGrid() {
+	
+}
+
+void TerminalProcess::setGridSize(int rows, int cols) {
+	
+}
+
+size_t TerminalProcess::search(std::string_view needle, bool ignoreCase) {
+	return 0;
+}
+
 // -----------------------------------------------------------------------------
 // UI flush: rebuild Text from scrollback + inputLine
 // -----------------------------------------------------------------------------
@@ -0,0 +1,618 @@
+#include "vtscreen.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+VtScreen::VtScreen(int rows, int cols) : rows(std::max(1, rows)), cols(std::max(1, cols)) { reset(); }
+
+void VtScreen::reset() {
+	mainCells.assign(size_t(rows) * cols, blank());
+	altCells.assign(size_t(rows) * cols, blank());
+	rowDamage.assign(size_t(rows), 1);
+	anyDamage = true;
+	cur = savedMain = savedAlt = Cursor{};
+	scrollTop = 0;
+	scrollBottom = rows - 1;
+	alt = false;
+	autowrap = true;
+	showCursor = true;
+	appCursorKeys = false;
+	state = State::Ground;
+	utf8Need = 0;
+}
+
+void VtScreen::resize(int newRows, int newCols) {
+	newRows = std::max(1, newRows);
+	newCols = std::max(1, newCols);
+	if (newRows == rows && newCols == cols)
+		return;
+
+	// keep the cursor row on screen when shrinking: drop rows from the top
+	const int shift = std::max(0, cur.row - (newRows - 1));
+	auto remap = [&](std::vector<Cell> &cells) {
+		std::vector<Cell> out(size_t(newRows) * newCols, blank());
+		for (int r = 0; r < newRows && r + shift < rows; ++r)
+			std::copy_n(cells.begin() + size_t(r + shift) * cols, std::min(cols, newCols), out.begin() + size_t(r) * newCols);
+		cells.swap(out);
+	};
+	remap(mainCells);
+	remap(altCells);
+
+	rows = newRows;
+	cols = newCols;
+	cur.row -= shift;
+	scrollTop = 0;
+	scrollBottom = rows - 1;
+	rowDamage.assign(size_t(rows), 1);
+	anyDamage = true;
+	clampCursor();
+	for (Cursor *c : {&savedMain, &savedAlt}) {
+		c->row = std::clamp(c->row, 0, rows - 1);
+		c->col = std::clamp(c->col, 0, cols - 1);
+	}
+}
+
+bool VtScreen::takeDamage(std::vector<uint8_t> &rowsOut) {
+	rowsOut.assign(rowDamage.begin(), rowDamage.end());
+	std::fill(rowDamage.begin(), rowDamage.end(), 0);
+	const bool any = anyDamage;
+	anyDamage = false;
+	return any;
+}
+
+std::string VtScreen::takeReplies() {
+	std::string r;
+	r.swap(replies);
+	return r;
+}
+
+// -----------------------------------------------------------------------------
+// Parser
+// -----------------------------------------------------------------------------
+
+size_t VtScreen::feed(const char *data, size_t n) {
+	screenSwitched = false;
+	for (size_t i = 0; i < n; ++i) {
+		const unsigned char c = (unsigned char)data[i];
+
+		switch (state) {
+		case State::Ground:
+			if (utf8Need) {
+				if ((c & 0xC0) == 0x80) {
+					utf8Cp = (utf8Cp << 6) | (c & 0x3F);
+					if (--utf8Need == 0)
+						print(utf8Cp);
+					break;
+				}
+				utf8Need = 0; // broken sequence; `c` starts over
+				print(U'?');
+			}
+			if (c == 0x1B)
+				state = State::Escape;
+			else if (c < 0x20 || c == 0x7F)
+				control(c);
+			else if (c < 0x80)
+				print(c);
+			else if ((c & 0xE0) == 0xC0)
+				utf8Cp = c & 0x1F, utf8Need = 1;
+			else if ((c & 0xF0) == 0xE0)
+				utf8Cp = c & 0x0F, utf8Need = 2;
+			else if ((c & 0xF8) == 0xF0)
+				utf8Cp = c & 0x07, utf8Need = 3;
+			else
+				print(U'?');
+			break;
+
+		case State::Escape:
+			if (c == '[') {
+				state = State::Csi;
+				params.clear();
+				paramStarted = false;
+				privateMarker = 0;
+			} else if (c == ']') {
+				state = State::Osc;
+				stringEsc = false;
+			} else if (c == 'P' || c == 'X' || c == '^' || c == '_') {
+				state = State::String;
+				stringEsc = false;
+			} else if (c == '(' || c == ')' || c == '*' || c == '+' || c == '#' || c == '%') {
+				state = State::EscapeIntermediate; // charset / DEC line attrs: one more byte, ignored
+			} else {
+				state = State::Ground;
+				escDispatch(c);
+			}
+			break;
+
+		case State::EscapeIntermediate:
+			state = State::Ground;
+			break;
+
+		case State::Csi:
+			if (c >= '0' && c <= '9') {
+				if (!paramStarted) {
+					params.push_back(0);
+					paramStarted = true;
+				}
+				params.back() = std::min(params.back() * 10 + int(c - '0'), 9999);
+			} else if (c == ';' || c == ':') {
+				if (!paramStarted)
+					params.push_back(0);
+				paramStarted = false;
+			} else if (c >= 0x3C && c <= 0x3F) { // < = > ?
+				privateMarker = char(c);
+			} else if (c >= 0x20 && c <= 0x2F) { // intermediates (e.g. "CSI ! p")
+				privateMarker = char(c);
+			} else if (c >= 0x40 && c <= 0x7E) {
+				state = State::Ground;
+				csiDispatch(c);
+			} else if (c == 0x1B) {
+				state = State::Escape;
+			} else if (c < 0x20) {
+				control(c); // C0 inside CSI still executes
+			}
+			break;
+
+		case State::Osc:
+		case State::String:
+			if (stringEsc) {
+				stringEsc = false;
+				if (c == '\\') {
+					state = State::Ground;
+					break;
+				}
+			}
+			if (c == 0x07)
+				state = State::Ground;
+			else if (c == 0x1B)
+				stringEsc = true;
+			break;
+		}
+
+		if (screenSwitched)
+			return i + 1;
+	}
+	return n;
+}
+
+void VtScreen::control(unsigned char c) {
+	switch (c) {
+	case 0x08: // BS
+		if (cur.col > 0)
+			--cur.col;
+		cur.wrapPending = false;
+		break;
+	case 0x09: // HT
+		cur.col = std::min(cols - 1, (cur.col / 8 + 1) * 8);
+		cur.wrapPending = false;
+		break;
+	case 0x0A: // LF / VT / FF
+	case 0x0B:
+	case 0x0C:
+		lineFeed();
+		break;
+	case 0x0D: // CR
+		cur.col = 0;
+		cur.wrapPending = false;
+		break;
+	default: // BEL, SO/SI, DEL, ...
+		break;
+	}
+}
+
+void VtScreen::escDispatch(unsigned char c) {
+	switch (c) {
+	case '7':
+		(alt ? savedAlt : savedMain) = cur;
+		break;
+	case '8':
+		cur = alt ? savedAlt : savedMain;
+		clampCursor();
+		break;
+	case 'D':
+		lineFeed();
+		break;
+	case 'E':
+		cur.col = 0;
+		lineFeed();
+		break;
+	case 'M':
+		reverseIndex();
+		break;
+	case 'c':
+		reset();
+		break;
+	default: // keypad modes (= >) etc.
+		break;
+	}
+}
+
+void VtScreen::csiDispatch(unsigned char final) {
+	if (privateMarker >= 0x20 && privateMarker <= 0x2F) {
+		if (privateMarker == '!' && final == 'p') { // DECSTR soft reset
+			cur.fg = -1;
+			cur.attrs = 0;
+			scrollTop = 0;
+			scrollBottom = rows - 1;
+			autowrap = true;
+			showCursor = true;
+			appCursorKeys = false;
+		}
+		return;
+	}
+
+	const int n = param(0, 1);
+	auto &g = grid();
+	Cell *line = &g[size_t(cur.row) * cols];
+
+	switch (final) {
+	case '@': { // ICH
+		const int k = std::min(n, cols - cur.col);
+		std::move_backward(line + cur.col, line + cols - k, line + cols);
+		std::fill(line + cur.col, line + cur.col + k, blank());
+		damage(cur.row);
+		break;
+	}
+	case 'A': // CUU
+		cur.row = std::max(cur.row >= scrollTop ? scrollTop : 0, cur.row - n);
+		break;
+	case 'B': // CUD
+	case 'e': // VPR
+		cur.row = std::min(cur.row <= scrollBottom ? scrollBottom : rows - 1, cur.row + n);
+		break;
+	case 'C': // CUF
+	case 'a': // HPR
+		cur.col += n;
+		break;
+	case 'D': // CUB
+		cur.col -= n;
+		break;
+	case 'E': // CNL
+		cur.row = std::min(cur.row <= scrollBottom ? scrollBottom : rows - 1, cur.row + n);
+		cur.col = 0;
+		break;
+	case 'F': // CPL
+		cur.row = std::max(cur.row >= scrollTop ? scrollTop : 0, cur.row - n);
+		cur.col = 0;
+		break;
+	case 'G': // CHA
+	case '`': // HPA
+		cur.col = n - 1;
+		break;
+	case 'H': // CUP
+	case 'f':
+		cur.row = param(0, 1) - 1;
+		cur.col = param(1, 1) - 1;
+		break;
+	case 'd': // VPA
+		cur.row = n - 1;
+		break;
+	case 'J': { // ED
+		const int mode = params.empty() ? 0 : params[0];
+		if (mode == 0) {
+			eraseCells(cur.row, cur.col, cols - 1);
+			eraseRows(cur.row + 1, rows - 1);
+		} else if (mode == 1) {
+			eraseRows(0, cur.row - 1);
+			eraseCells(cur.row, 0, cur.col);
+		} else {
+			eraseRows(0, rows - 1);
+		}
+		break;
+	}
+	case 'K': { // EL
+		const int mode = params.empty() ? 0 : params[0];
+		if (mode == 0)
+			eraseCells(cur.row, cur.col, cols - 1);
+		else if (mode == 1)
+			eraseCells(cur.row, 0, cur.col);
+		else
+			eraseCells(cur.row, 0, cols - 1);
+		break;
+	}
+	case 'L': // IL
+		if (cur.row >= scrollTop && cur.row <= scrollBottom)
+			scrollDown(cur.row, scrollBottom, n);
+		cur.col = 0;
+		break;
+	case 'M': // DL
+		if (cur.row >= scrollTop && cur.row <= scrollBottom)
+			scrollUp(cur.row, scrollBottom, n);
+		cur.col = 0;
+		break;
+	case 'P': { // DCH
+		const int k = std::min(n, cols - cur.col);
+		std::move(line + cur.col + k, line + cols, line + cur.col);
+		std::fill(line + cols - k, line + cols, blank());
+		damage(cur.row);
+		break;
+	}
+	case 'X': // ECH
+		eraseCells(cur.row, cur.col, cur.col + n - 1);
+		break;
+	case 'S': // SU
+		scrollUp(scrollTop, scrollBottom, n);
+		break;
+	case 'T': // SD (5 params = mouse highlight tracking, ignored)
+		if (params.size() <= 1)
+			scrollDown(scrollTop, scrollBottom, n);
+		break;
+	case 'r': { // DECSTBM
+		if (privateMarker) // CSI ? r: restore DEC private modes (xterm), not a scroll region
+			return;
+		const int top = param(0, 1) - 1, bottom = param(1, rows) - 1;
+		if (top < bottom && bottom < rows) {
+			scrollTop = top;
+			scrollBottom = bottom;
+		}
+		cur.row = cur.col = 0;
+		break;
+	}
+	case 'm':
+		if (!privateMarker)
+			sgr();
+		return; // SGR doesn't touch the pending wrap
+	case 'h':
+	case 'l':
+		if (privateMarker == '?')
+			for (int p : params)
+				setMode(p, final == 'h');
+		return;
+	case 'n': // DSR
+		if (!privateMarker && !params.empty()) {
+			if (params[0] == 5) {
+				replies += "\x1b[0n";
+			} else if (params[0] == 6) {
+				char buf[32];
+				std::snprintf(buf, sizeof(buf), "\x1b[%d;%dR", cur.row + 1, cur.col + 1);
+				replies += buf;
+			}
+		}
+		return;
+	case 'c': // DA
+		if (privateMarker == '>')
+			replies += "\x1b[>0;10;1c";
+		else if (!privateMarker)
+			replies += "\x1b[?1;2c";
+		return;
+	case 's':
+		if (!privateMarker)
+			(alt ? savedAlt : savedMain) = cur;
+		return;
+	case 'u':
+		if (!privateMarker) {
+			cur = alt ? savedAlt : savedMain;
+			clampCursor();
+		}
+		return;
+	default: // window ops, mouse, ... ignored
+		return;
+	}
+
+	cur.wrapPending = false;
+	clampCursor();
+}
+
+void VtScreen::sgr() {
+	if (params.empty()) {
+		cur.fg = -1;
+		cur.attrs = 0;
+		return;
+	}
+	for (size_t i = 0; i < params.size(); ++i) {
+		const int p = params[i];
+		if (p == 0) {
+			cur.fg = -1;
+			cur.attrs = 0;
+		} else if (p == 1) {
+			cur.attrs |= kBold;
+		} else if (p == 22) {
+			cur.attrs &= ~kBold;
+		} else if (p == 7) {
+			cur.attrs |= kReverse;
+		} else if (p == 27) {
+			cur.attrs &= ~kReverse;
+		} else if (p >= 30 && p <= 37) {
+			cur.fg = int8_t(p - 30);
+		} else if (p == 39) {
+			cur.fg = -1;
+		} else if (p >= 90 && p <= 97) {
+			cur.fg = int8_t(p - 90 + 8);
+		} else if (p == 38 || p == 48) {
+			// extended: 5;idx or 2;r;g;b (only the 16-color part of the palette maps onto Text's colors)
+			int idx = -1;
+			if (i + 2 < params.size() && params[i + 1] == 5) {
+				idx = params[i + 2];
+				i += 2;
+			} else if (i + 4 < params.size() && params[i + 1] == 2) {
+				i += 4;
+			}
+			if (p == 38)
+				cur.fg = (idx >= 0 && idx < 16) ? int8_t(idx) : int8_t(-1);
+		}
+		// backgrounds / underline / italics: Text has no use for them
+	}
+}
+
+void VtScreen::setMode(int mode, bool on) {
+	switch (mode) {
+	case 1: // DECCKM
+		appCursorKeys = on;
+		break;
+	case 7: // DECAWM
+		autowrap = on;
+		if (!on)
+			cur.wrapPending = false;
+		break;
+	case 25: // DECTCEM
+		showCursor = on;
+		break;
+	case 47:
+		switchScreen(on, false, false);
+		break;
+	case 1047:
+		switchScreen(on, false, true);
+		break;
+	case 1048:
+		if (on)
+			savedMain = cur;
+		else
+			cur = savedMain;
+		clampCursor();
+		break;
+	case 1049:
+		switchScreen(on, true, true);
+		break;
+	default: // bracketed paste, mouse modes, focus events, ...
+		break;
+	}
+}
+
+void VtScreen::switchScreen(bool toAlt, bool saveCursor, bool clear) {
+	if (toAlt == alt)
+		return;
+	if (toAlt) {
+		if (saveCursor)
+			savedMain = cur;
+		alt = true;
+		if (clear)
+			std::fill(altCells.begin(), altCells.end(), blank());
+	} else {
+		if (clear)
+			std::fill(altCells.begin(), altCells.end(), blank());
+		alt = false;
+		if (saveCursor)
+			cur = savedMain;
+	}
+	cur.wrapPending = false;
+	clampCursor();
+	damageAll();
+	screenSwitched = true;
+}
+
+// -----------------------------------------------------------------------------
+// Grid ops
+// -----------------------------------------------------------------------------
+
+int VtScreen::charWidth(char32_t cp) {
+	static constexpr char32_t wide[][2] = {
+		{0x1100, 0x115F},	// Hangul Jamo
+		{0x2329, 0x232A},	// angle brackets
+		{0x2E80, 0x303E},	// CJK radicals, Kangxi, CJK symbols
+		{0x3041, 0x33FF},	// Kana, Bopomofo, CJK compatibility
+		{0x3400, 0x4DBF},	// CJK extension A
+		{0x4E00, 0x9FFF},	// CJK unified ideographs
+		{0xA000, 0xA4CF},	// Yi
+		{0xAC00, 0xD7A3},	// Hangul syllables
+		{0xF900, 0xFAFF},	// CJK compatibility ideographs
+		{0xFE30, 0xFE4F},	// CJK compatibility forms
+		{0xFF00, 0xFF60},	// fullwidth forms
+		{0xFFE0, 0xFFE6},	// fullwidth signs
+		{0x1F300, 0x1F64F}, // pictographs, emoticons
+		{0x1F680, 0x1F6FF}, // transport and map symbols
+		{0x1F900, 0x1F9FF}, // supplemental symbols and pictographs
+		{0x20000, 0x3FFFD}, // CJK extensions B..
+	};
+	if (cp < wide[0][0])
+		return 1;
+	for (const auto &r : wide)
+		if (cp >= r[0] && cp <= r[1])
+			return 2;
+	return 1;
+}
+
+void VtScreen::print(char32_t cp) {
+	const int width = cols > 1 ? charWidth(cp) : 1;
+	if (cur.wrapPending) {
+		cur.col = 0;
+		lineFeed();
+	}
+	if (width == 2 && cur.col + 1 >= cols) { // no room for both halves in the last column
+		if (autowrap) {
+			cur.col = 0;
+			lineFeed();
+		} else {
+			cur.col = cols - 2;
+		}
+	}
+
+	// overwriting either half of a wide character blanks the other one
+	Cell *line = &grid()[size_t(cur.row) * cols];
+	const int end = cur.col + width;
+	if (cur.col > 0 && line[cur.col].ch == kWideTail)
+		line[cur.col - 1] = blank();
+	if (end < cols && line[end].ch == kWideTail)
+		line[end] = blank();
+	line[cur.col] = Cell{cp, cur.fg, cur.attrs};
+	if (width == 2)
+		line[cur.col + 1] = Cell{kWideTail, cur.fg, cur.attrs};
+	damage(cur.row);
+
+	if (end >= cols) {
+		cur.col = cols - 1;
+		cur.wrapPending = autowrap;
+	} else {
+		cur.col = end;
+	}
+}
+
+void VtScreen::lineFeed() {
+	cur.wrapPending = false;
+	if (cur.row == scrollBottom)
+		scrollUp(scrollTop, scrollBottom, 1);
+	else if (cur.row < rows - 1)
+		++cur.row;
+}
+
+void VtScreen::reverseIndex() {
+	cur.wrapPending = false;
+	if (cur.row == scrollTop)
+		scrollDown(scrollTop, scrollBottom, 1);
+	else if (cur.row > 0)
+		--cur.row;
+}
+
+void VtScreen::scrollUp(int top, int bottom, int n) {
+	n = std::clamp(n, 0, bottom - top + 1);
+	if (n == 0)
+		return;
+	auto &g = grid();
+	std::move(g.begin() + size_t(top + n) * cols, g.begin() + size_t(bottom + 1) * cols, g.begin() + size_t(top) * cols);
+	std::fill(g.begin() + size_t(bottom + 1 - n) * cols, g.begin() + size_t(bottom + 1) * cols, blank());
+	damageRange(top, bottom);
+}
+
+void VtScreen::scrollDown(int top, int bottom, int n) {
+	n = std::clamp(n, 0, bottom - top + 1);
+	if (n == 0)
+		return;
+	auto &g = grid();
+	std::move_backward(g.begin() + size_t(top) * cols, g.begin() + size_t(bottom + 1 - n) * cols, g.begin() + size_t(bottom + 1) * cols);
+	std::fill(g.begin() + size_t(top) * cols, g.begin() + size_t(top + n) * cols, blank());
+	damageRange(top, bottom);
+}
+
+void VtScreen::eraseCells(int row, int c0, int c1) {
+	c0 = std::max(0, c0);
+	c1 = std::min(cols - 1, c1);
+	if (row < 0 || row >= rows || c0 > c1)
+		return;
+	auto &g = grid();
+	std::fill(g.begin() + size_t(row) * cols + c0, g.begin() + size_t(row) * cols + c1 + 1, blank());
+	damage(row);
+}
+
+void VtScreen::eraseRows(int r0, int r1) {
+	for (int r = std::max(0, r0); r <= std::min(rows - 1, r1); ++r)
+		eraseCells(r, 0, cols - 1);
+}
+
+void VtScreen::damageRange(int r0, int r1) {
+	for (int r = std::max(0, r0); r <= std::min(rows - 1, r1); ++r)
+		rowDamage[size_t(r)] = 1;
+	anyDamage = true;
+}
+
+void VtScreen::clampCursor() {
+	cur.row = std::clamp(cur.row, 0, rows - 1);
+	cur.col = std::clamp(cur.col, 0, cols - 1);
+}
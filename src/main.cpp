@@ -1,7 +1,35 @@
 #include "application.hpp"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Usage:
+//   Engine                                         windowed
+//   Engine --headless 1280x720 [--frames 60] [--out frame.png] [--trace trace.json]
 int main(int argc, char *argv[]) {
+	bool headless = false;
+	uint32_t width = 1920, height = 1080, frames = 1;
+	std::string out, trace;
+
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--headless") == 0) {
+			headless = true;
+			if (i + 1 < argc && std::sscanf(argv[i + 1], "%ux%u", &width, &height) == 2)
+				++i;
+		} else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			out = argv[++i];
+		} else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			trace = argv[++i];
+		}
+	}
+
 	Application app;
+	if (headless)
+		return app.runHeadless(width, height, frames, out, trace);
 	app.run();
 	return 0;
 }
@@ -71,20 +71,13 @@ void Asset::init() {
 		{4, 0, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(Vertex, tanSgn))}, {5, 0, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(Vertex, matId))},			 {10, 0, F::VK_FORMAT_R32G32B32A32_UINT, uint32_t(offsetof(Vertex, boneIds))}, {11, 0, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(Vertex, weights))},
 	};
 
-	// Per-instance attributes (binding 1)
-	m.vertexAttrs.push_back({6, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)});
-	m.vertexAttrs.push_back({7, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)});
-	m.vertexAttrs.push_back({8, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)});
-	m.vertexAttrs.push_back({9, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)});
-	m.vertexAttrs.push_back({13, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, outlineColor))});
-	m.vertexAttrs.push_back({14, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, outlineWidth))});
-	m.vertexAttrs.push_back({12, 1, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(InstanceData, bonesBase))});
+	// Per-instance attributes (binding 1) and stride
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
 
 	// Shaders (place SPIR-V under <shaderRootPath>/asset)
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/asset", engine->getDevice());
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/asset", engine->getDevice());
 
 	// Base init creates set=0, buffers (empty now), descriptor pool, etc.
 	Model::init();
@@ -498,15 +491,6 @@ void Asset::applyBoneTransform(int id, string boneName, mat4 model, bool overrid
 // --------------------------------------------------
 // Descriptor set=1 management (SSBO)
 // --------------------------------------------------
-uint32_t Asset::createDescriptorPool() {
-	uint32_t baseSets = Model::createDescriptorPool();
-
-	// capacity for set=1 (SSBO with bone palettes)
-	pipeline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1});
-
-	return (std::max)(baseSets, 2u);
-}
-
 void Asset::createDescriptors() {
 	// Declare set=1 layout BEFORE allocation so base includes it
 	pipeline->createDescriptorSetLayoutBinding(
@@ -663,15 +647,9 @@ void Asset::ensureBonesBaseFor(int id) {
 		return;
 	const uint32_t slot = it->second;
 
-	if (iStride != sizeof(InstanceData))
-		return; // safety
-
-	// Mutate CPU shadow struct to set bonesBase
-	uint8_t *dst = cpu.data() + size_t(slot) * iStride;
-	InstanceData tmp{};
-	std::memcpy(&tmp, dst, sizeof(InstanceData));
-	tmp.bonesBase = slot * MAX_BONES; // in mat4 units
-	std::memcpy(dst, &tmp, sizeof(InstanceData));
+	// Mutate CPU shadow struct to set bonesBase (stride == sizeof(InstanceData) by setInstanceLayout)
+	const uint32_t bonesBase = slot * MAX_BONES; // in mat4 units
+	std::memcpy(cpu.data() + size_t(slot) * sizeof(InstanceData) + offsetof(InstanceData, bonesBase), &bonesBase, sizeof(bonesBase));
 
 	ssboDirty = true;			  // instance buffer update needed
 	pickingInstancesDirty = true; // ray picking depends on model
@@ -683,36 +661,17 @@ void Asset::recordOutline(VkCommandBuffer cmd) {
 	if (count == 0 || indexCount == 0)
 		return;
 
-	// Bind viewport & scissor same as base
-	vkCmdSetViewport(cmd, 0, 1, &viewport);
-	vkCmdSetScissor(cmd, 0, 1, &scissor);
-
-	// Bind outline pipeline
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, outline->pipeline);
-
-	// Bind its descriptor sets
-	const auto &dsets = outline->descriptorSets.descriptorSets;
-	const auto &dynOffsets = outline->descriptorSets.dynamicOffsets;
-	if (!dsets.empty()) {
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, outline->pipelineLayout, 0, static_cast<uint32_t>(dsets.size()), dsets.data(), static_cast<uint32_t>(dynOffsets.size()), dynOffsets.empty() ? nullptr : dynOffsets.data());
-	}
+	// Viewport & scissor same as base (already bound by Model::record)
+	BindCache &binds = scene->getScenes().bindCache();
+	binds.viewport(cmd, viewport);
+	binds.scissor(cmd, scissor);
 
-	// Bind vertex buffers: 0 = geometry, 1 = instance SSBO (same as base)
-	VkBuffer vbs[2];
-	VkDeviceSize offs[2] = {0, 0};
-	uint32_t vbCount = 0;
-	if (vbuf != VK_NULL_HANDLE)
-		vbs[vbCount++] = vbuf;
-	if (iStride > 0 && ssbo != VK_NULL_HANDLE)
-		vbs[vbCount++] = ssbo;
+	// Bind outline pipeline and its descriptor sets
+	binds.pipeline(cmd, outline->pipeline);
+	binds.descriptorSets(cmd, outline->pipelineLayout, outline->descriptorSets.descriptorSets, outline->descriptorSets.dynamicOffsets);
 
-	if (vbCount == 0)
-		return;
-
-	vkCmdBindVertexBuffers(cmd, 0, vbCount, vbs, offs);
-	vkCmdBindIndexBuffer(cmd, ibuf, 0, VK_INDEX_TYPE_UINT32);
-
-	vkCmdDrawIndexed(cmd, indexCount, count, 0, 0, 0);
+	// Vertex buffers, index buffer and draw: same as base (culled instances when GPU culling is on)
+	drawInstances(cmd);
 }
 
 void Asset::createOutlinePipeline() {
@@ -728,20 +687,7 @@ void Asset::createOutlinePipeline() {
 
 	// Load OUTLINE shaders (place SPIR-V under <shaderRootPath>/asset_outline)
 	// e.g. asset_outline.vert + asset_outline.frag
-	outline->shaders = Assets::compileShaderProgram(outlineShaderPath, outline->device);
-
-	// --- Descriptor pool sizes (same kinds as base: UBO + instance SSBO + bones SSBO) ---
-	outline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
-	if (iStride > 0) {
-		outline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2});
-		// set0: instances SSBO, set1: bones SSBO
-	} else {
-		outline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1});
-		// only bones SSBO
-	}
-
-	// We need 2 descriptor sets: set=0 (camera+instances) and set=1 (bones)
-	outline->createDescriptorPool(/*setCount=*/2);
+	outline->shaders = PipelineRegistry::get().shaderProgram(outlineShaderPath, outline->device);
 
 	// --- Descriptor set layouts & writes, mirroring Model + Asset ---
 
@@ -7,11 +7,9 @@ Grid::Grid(Scene *scene) : Model(scene) {}
 void Grid::init() {
 	engine = scene->getScenes().getEngine();
 	buildUnitQuadMesh();
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/grid", engine->getDevice());
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/grid", engine->getDevice());
 	Model::init();
-	InstanceData placeholder{};
-	upsertInstance(0, placeholder);
+	instances<InstanceData>().upsert(0, InstanceData{});
 }
 
 void Grid::syncPickingInstances() { Model::syncPickingInstances<InstanceData>(); }
@@ -36,15 +34,8 @@ void Grid::buildUnitQuadMesh() {
 	using F = VkFormat;
 	m.vertexAttrs = {
 		{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
-		{1, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-		{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-		{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-		{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
-		{5, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, color))},
-		{6, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, cellSize))},
-		{7, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, lineWidth))},
-		{8, 1, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(InstanceData, plane))},
 	};
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 }
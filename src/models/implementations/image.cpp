@@ -1,91 +1,39 @@
 #include "image.hpp"
 #include "debug.hpp"
 #include "engine.hpp"
+#include "events.hpp"
 #include "memory.hpp"
+#include "profiler.hpp"
 #include "scenes.hpp"
+#include "textureheap.hpp"
+#include "threadpool.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.hpp>
 
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
-
-namespace {
-constexpr uint32_t kTexArraySize = 1024; // fixed-sized descriptor array
-} // namespace
-
-// --------------------------------------------------
-// Helpers
-// --------------------------------------------------
-
-static inline uint32_t atLeast1(uint32_t v) { return v ? v : 1u; }
-
-// Remove (or stop using) coverScale/coverOffset and add:
-static inline glm::vec2 pixelCropScale(uint32_t texW, uint32_t texH, float viewW, float viewH) {
-	// fraction of the texture we want to sample in each axis
-	// clamp to [0,1] (assumption: tex >= view)
-	auto s = glm::vec2((texW > 0 ? viewW / float(texW) : 1.0f), (texH > 0 ? viewH / float(texH) : 1.0f));
-	return glm::clamp(s, glm::vec2(0.0f), glm::vec2(1.0f));
-}
-static inline glm::vec2 pixelCropOffset(const glm::vec2 &scale) {
-	// center the crop window
-	return (glm::vec2(1.0f) - scale) * 0.5f;
-}
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
 
 Image::Image(Scene *scene) : Model(scene) {}
-Image::~Image() { destroyAllTextures(); }
-
-// --------------------------------------------------
-// Private: descriptor maintenance
-// --------------------------------------------------
-
-void Image::writeSet1Descriptors() {
-	if (!pipeline)
-		return;
-	if (pipeline->descriptorSets.descriptorSets.size() <= 1)
-		return;
-	VkDescriptorSet set1 = pipeline->descriptorSets.descriptorSets[1];
-	if (set1 == VK_NULL_HANDLE)
-		return;
-	if (imageInfos.empty())
-		return;
-
-	// ***** IMPORTANT: avoid VUID-03047 by ensuring the set isn't in use *****
-	// This is the simplest safe option without changing your frame graph:
-	// stall before rewriting descriptors bound by in-flight command buffers.
-	vkDeviceWaitIdle(pipeline->device);
-
-	// pad to full array so any index is valid
-	std::vector<VkDescriptorImageInfo> padded = imageInfos;
-	while (padded.size() < kTexArraySize)
-		padded.push_back(padded[0]);
-
-	VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-	w.dstSet = set1;
-	w.dstBinding = 0;
-	w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	w.descriptorCount = static_cast<uint32_t>(padded.size());
-	w.pImageInfo = padded.data();
-
-	vkUpdateDescriptorSets(pipeline->device, 1, &w, 0, nullptr);
-	set1Dirty = false;
-}
-
-void Image::ensureSet1Ready() {
-	// If we can write now, do it; otherwise mark as dirty and a later call will succeed.
-	if (!pipeline || pipeline->descriptorSets.descriptorSets.size() <= 1) {
-		set1Dirty = true;
-		return;
-	}
-	if (pipeline->descriptorSets.descriptorSets[1] == VK_NULL_HANDLE) {
-		set1Dirty = true;
-		return;
-	}
-	if (imageInfos.empty()) {
-		set1Dirty = true;
-		return;
-	}
-	writeSet1Descriptors();
+Image::~Image() {
+	if (!updateEventId.empty())
+		Events::unregisterUpdate(updateEventId);
+	destroyAllTextures();
+
+	const auto &dev = pipeline->device;
+	if (mappedFrameTable)
+		vkUnmapMemory(dev, frameTableMemory);
+	if (frameTableBuffer)
+		vkDestroyBuffer(dev, frameTableBuffer, nullptr);
+	if (frameTableMemory)
+		vkFreeMemory(dev, frameTableMemory, nullptr);
 }
 
 // --------------------------------------------------
@@ -96,24 +44,38 @@ void Image::init() {
 	engine = scene->getScenes().getEngine();
 
 	buildUnitQuadMesh();
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
-
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/image", engine->getDevice());
 
-	// Ensure we have at least one white tex so set=1 can be valid
-	loadAllFramesCPU(framesPerInstance);
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/image", engine->getDevice());
 
 	pipeline->graphicsPipeline.pushConstantRangeCount = 1;
-	pipeline->graphicsPipeline.pushContantRanges.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	pipeline->graphicsPipeline.pushContantRanges.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	pipeline->graphicsPipeline.pushContantRanges.offset = 0;
-	pipeline->graphicsPipeline.pushContantRanges.size = sizeof(uint32_t) * 8;
+	pipeline->graphicsPipeline.pushContantRanges.size = sizeof(uint32_t) * 12;
 
-	// Base pipeline/buffers/descriptors (set=0 created here; Image::create* will add set=1)
+	// Base pipeline/buffers/descriptors (set=0 created here; Image::createDescriptors binds the TextureHeap at set=1)
 	Model::init();
 
-	// Upload textures and (try to) write set=1
-	uploadAllFramesGPU();
-	ensureSet1Ready();
+	bcSupported = engine->getLogicalDevice().supportsTextureCompressionBC();
+
+	const CpuPixels clear = TextureCodec::solid(0, 0, 0, 0);
+	placeholder = upload({&clear}).front();
+
+	// decodes land between frames, on the render thread; the animation clock advances with them
+	updateEventId = Events::registerUpdate([this](float dtMs) {
+		clockSeconds += dtMs / 1000.0;
+		if (clockSeconds - clockBase > kClockRebaseSeconds)
+			rebaseClock();
+		pumpDecodes();
+	});
+
+	// Frames upserted (and played) before init: queue their decodes now
+	for (const auto &kv : framesPerInstance)
+		for (const auto &p : kv.second)
+			acquireTexture(p);
+	for (const auto &[frames, range] : frameRanges)
+		writeFrameRange(frames, range);
+	for (const auto &kv : framesPerInstance)
+		writeInstance(kv.first);
 }
 
 void Image::syncPickingInstances() { Model::syncPickingInstances<InstanceData>(); }
@@ -122,75 +84,89 @@ void Image::syncPickingInstances() { Model::syncPickingInstances<InstanceData>()
 // Public API: dynamic updates
 // --------------------------------------------------
 
-void Image::upsert(int id, const string &path) {
-	framesPerInstance[id] = std::vector<std::string>{path};
-
-	if (!instanceModel.count(id))
-		instanceModel[id] = glm::mat4(1.0f);
-	instanceLocalFrame[id] = 0u;
-
-	rebuildTexturePool(); // content change
-	ensureSet1Ready();	  // descriptor may need rewrite after swapchain events
-}
+void Image::upsert(int id, const string &path) { upsert(id, std::vector<std::string>{path}); }
 
 void Image::upsert(int id, const vector<string> &paths) {
-	framesPerInstance[id] = paths;
+	std::vector<std::string> frames = paths.empty() ? std::vector<std::string>{std::string()} : paths;
 
 	if (!instanceModel.count(id))
 		instanceModel[id] = glm::mat4(1.0f);
 	instanceLocalFrame[id] = 0u;
 
-	rebuildTexturePool();
-	ensureSet1Ready();
+	// a playing instance keeps playing, from the range of its new frame list
+	auto ait = animations.find(id);
+	const bool playing = ait != animations.end();
+	const Animation animation = playing ? ait->second : Animation{};
+	stopAnimation(id);
+
+	if (!engine) { // not initialized yet: init() uploads
+		framesPerInstance[id] = std::move(frames);
+	} else {
+		// acquire before releasing, so paths the instance keeps are neither dropped nor decoded again
+		for (const auto &p : frames)
+			acquireTexture(p);
+		auto it = framesPerInstance.find(id);
+		if (it != framesPerInstance.end())
+			for (const auto &p : it->second)
+				releaseTextureRef(p);
+		framesPerInstance[id] = std::move(frames);
+	}
+
+	if (playing) {
+		animations[id] = animation;
+		startAnimation(id); // the new list may not fit: then it shows frame 0
+	}
+	if (engine)
+		writeInstance(id);
 }
 
 void Image::setFrame(int id, uint32_t frameIndex) {
-	if (!framesPerInstance.count(id))
-		return;
-
-	uint32_t count = instanceFrameCount.count(id) ? instanceFrameCount[id] : 0u;
-	if (count == 0)
+	auto it = framesPerInstance.find(id);
+	if (it == framesPerInstance.end())
 		return;
 
-	instanceLocalFrame[id] = std::min(frameIndex, count - 1);
-
-	uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-	const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-	const uint32_t global = std::min(base + instanceLocalFrame[id], (cap ? cap : 1u) - 1u);
-
-	glm::vec2 uvScale(1.0f), uvOffset(0.0f);
-	if (global < gpuTextures.size()) {
-		const uint32_t tw = std::max(1u, gpuTextures[global].w);
-		const uint32_t th = std::max(1u, gpuTextures[global].h);
-
-		// viewport.width, viewport.height are your current viewport dimensions in pixels (already on the class)
-		const float viewW = (viewport.width > 0.0f) ? viewport.width : 1.0f;
-		const float viewH = (viewport.height > 0.0f) ? viewport.height : 1.0f;
+	stopAnimation(id);
+	instanceLocalFrame[id] = std::min(frameIndex, static_cast<uint32_t>(it->second.size()) - 1u);
+	if (engine)
+		writeInstance(id);
+}
 
-		uvScale = pixelCropScale(tw, th, viewW, viewH); // size of the crop window in UVs
-		uvOffset = pixelCropOffset(uvScale);			// centered
-	}
+void Image::play(int id, float fps, Playback mode, float delaySeconds) {
+	if (!framesPerInstance.count(id))
+		return;
 
-	InstanceData data{};
-	data.model = instanceModel.count(id) ? instanceModel[id] : glm::mat4(1.0f);
-	data.frameIndex = global;
-	data.uvScale = uvScale;
-	data.uvOffset = uvOffset;
+	stopAnimation(id);
+	Animation &a = animations[id];
+	a.fps = fps;
+	a.startTime = clockSeconds + delaySeconds;
+	a.mode = mode;
+	if (!startAnimation(id))
+		return;
+	if (engine)
+		writeInstance(id);
+}
 
-	upsertInternal(id, data);
-	ensureSet1Ready();
+void Image::stop(int id) {
+	if (!animations.count(id))
+		return;
+	stopAnimation(id);
+	if (engine)
+		writeInstance(id);
 }
 
 void Image::erase(int id) {
+	stopAnimation(id);
+
+	auto it = framesPerInstance.find(id);
+	if (it != framesPerInstance.end() && engine)
+		for (const auto &p : it->second)
+			releaseTextureRef(p);
+
 	framesPerInstance.erase(id);
 	instanceModel.erase(id);
 	instanceLocalFrame.erase(id);
-	instanceFirstIndex.erase(id);
-	instanceFrameCount.erase(id);
 
 	Model::erase(id);
-	rebuildTexturePool();
-	ensureSet1Ready();
 }
 
 // --------------------------------------------------
@@ -200,41 +176,140 @@ void Image::erase(int id) {
 void Image::upsertInternal(int id, const InstanceData &data) {
 	std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t *>(&data), sizeof(InstanceData));
 	upsertBytes(id, bytes);
-	if (set1Dirty)
-		ensureSet1Ready();
+}
+
+void Image::writeInstance(int id) {
+	const uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
+	const GpuTex *frame = frameTexture(id, local);
+	const FrameRef ref = frameRef(frame ? *frame : placeholder);
+
+	InstanceData data{};
+	if (!getInstance(id, data))
+		data.model = instanceModel.count(id) ? instanceModel[id] : glm::mat4(1.0f);
+	// the shaders crop to the viewport themselves; the sub-rectangle only says where the frame is
+	data.frameIndex = ref.heapIndex;
+	data.uvScale = ref.uvScale;
+	data.uvOffset = ref.uvOffset;
+
+	// playing: the vertex shader picks the frame from frameBase..frameBase + frameCount - 1
+	data.frameBase = data.frameCount = data.playback = 0u;
+	data.fps = data.startTime = 0.0f;
+	auto ait = animations.find(id);
+	if (ait != animations.end()) {
+		const Animation &a = ait->second;
+		data.frameBase = a.range->second.base;
+		data.frameCount = a.range->second.count;
+		data.fps = a.fps;
+		data.startTime = static_cast<float>(a.startTime - clockBase);
+		data.playback = static_cast<uint32_t>(a.mode);
+	}
+
+	upsertInternal(id, data);
 }
 
 void Image::recalcUV() {
-	for (const auto &kv : framesPerInstance) {
-		const int id = kv.first;
+	for (const auto &kv : framesPerInstance)
+		writeInstance(kv.first);
+}
 
-		uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
-		uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-		const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-		const uint32_t global = std::min(base + local, (cap ? cap : 1u) - 1u);
+// --------------------------------------------------
+// Animation
+// --------------------------------------------------
+
+Image::FrameRef Image::frameRef(const GpuTex &tex) {
+	FrameRef ref;
+	ref.heapIndex = tex.heapIndex;
+	if (tex.region.valid()) {
+		ref.uvScale = glm::vec2(tex.region.w, tex.region.h) / float(TextureAtlas::kPageSize);
+		ref.uvOffset = glm::vec2(tex.region.x, tex.region.y) / float(TextureAtlas::kPageSize);
+	}
+	return ref;
+}
 
-		glm::vec2 uvScale(1.0f), uvOffset(0.0f);
-		if (global < gpuTextures.size()) {
-			const uint32_t tw = std::max(1u, gpuTextures[global].w);
-			const uint32_t th = std::max(1u, gpuTextures[global].h);
+Image::FrameRef Image::frameRef(const std::string &path) const {
+	auto it = textures.find(path);
+	return frameRef(it == textures.end() || it->second.pending ? placeholder : it->second.tex);
+}
 
-			// viewport.width, viewport.height are your current viewport dimensions in pixels (already on the class)
-			const float viewW = (viewport.width > 0.0f) ? viewport.width : 1.0f;
-			const float viewH = (viewport.height > 0.0f) ? viewport.height : 1.0f;
+bool Image::startAnimation(int id) {
+	const std::vector<std::string> &frames = framesPerInstance.at(id);
+	auto [rit, inserted] = frameRanges.try_emplace(frames);
+	++rit->second.refs;
+	animations.at(id).range = rit;
+	if (!inserted)
+		return true;
+
+	// first fit in the free entries
+	const uint32_t count = static_cast<uint32_t>(frames.size());
+	auto slot = std::find_if(freeFrameEntries.begin(), freeFrameEntries.end(), [&](const auto &f) { return f.second >= count; });
+	if (slot == freeFrameEntries.end()) {
+		// the table is bound for the frames in flight, so it can't grow in place: this one doesn't play
+		frameRanges.erase(rit);
+		animations.erase(id);
+		std::fprintf(stderr, "[Image] frame table full (%u entries): instance %d shows a single frame instead of playing %u\n", kFrameTableSize, id, count);
+		return false;
+	}
+	rit->second.base = slot->first;
+	rit->second.count = count;
+	slot->first += count;
+	slot->second -= count;
+	if (slot->second == 0)
+		freeFrameEntries.erase(slot);
+
+	writeFrameRange(frames, rit->second);
+	return true;
+}
 
-			uvScale = pixelCropScale(tw, th, viewW, viewH); // size of the crop window in UVs
-			uvOffset = pixelCropOffset(uvScale);			// centered
-		}
+void Image::stopAnimation(int id) {
+	auto it = animations.find(id);
+	if (it == animations.end())
+		return;
+	auto rit = it->second.range;
+	animations.erase(it);
+	if (--rit->second.refs > 0)
+		return;
 
-		InstanceData data{};
-		data.model = instanceModel.count(id) ? instanceModel[id] : glm::mat4(1.0f);
-		data.frameIndex = global;
-		data.uvScale = uvScale;
-		data.uvOffset = uvOffset;
+	// give the entries back, merged with free neighbours
+	const FrameRange range = rit->second;
+	frameRanges.erase(rit);
+	auto pos = std::lower_bound(freeFrameEntries.begin(), freeFrameEntries.end(), std::make_pair(range.base, 0u));
+	pos = freeFrameEntries.insert(pos, {range.base, range.count});
+	if (auto next = std::next(pos); next != freeFrameEntries.end() && pos->first + pos->second == next->first) {
+		pos->second += next->second;
+		freeFrameEntries.erase(next);
+	}
+	if (pos != freeFrameEntries.begin()) {
+		auto prev = std::prev(pos);
+		if (prev->first + prev->second == pos->first) {
+			prev->second += pos->second;
+			freeFrameEntries.erase(pos);
+		}
+	}
+}
 
-		upsertInternal(id, data);
+// The shaders get float seconds, which lose precision as the clock grows: once in a while, measure from now and
+// drop whole periods from each animation's elapsed time (the shader picks the same frame from what's left).
+void Image::rebaseClock() {
+	clockBase = clockSeconds;
+	for (auto &[id, a] : animations) {
+		const double elapsed = clockSeconds - a.startTime;
+		if (elapsed <= 0.0 || a.fps <= 0.0f) // not started yet (or standing still): nothing to fold
+			continue;
+		const uint32_t count = a.range->second.count;
+		const uint32_t frames = (a.mode == Playback::PingPong && count > 1) ? 2 * count - 2 : count;
+		const double period = frames / double(a.fps);
+		a.startTime = clockSeconds - (a.mode == Playback::Once ? std::min(elapsed, period) : std::fmod(elapsed, period));
 	}
-	ensureSet1Ready();
+	if (engine)
+		for (const auto &kv : animations)
+			writeInstance(kv.first);
+}
+
+void Image::writeFrameRange(const std::vector<std::string> &frames, const FrameRange &range) {
+	if (!mappedFrameTable) // before init: written once the table exists
+		return;
+	for (uint32_t i = 0; i < range.count; ++i)
+		mappedFrameTable[range.base + i] = frameRef(frames[i]);
 }
 
 // --------------------------------------------------
@@ -262,182 +337,192 @@ void Image::buildUnitQuadMesh() {
 	m.vertexAttrs = {
 		{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
 		{1, 0, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(Vertex, uv))},
-
-		{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-		{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-		{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-		{5, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
-		{6, 1, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(InstanceData, frameIndex))},
-		{7, 1, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(InstanceData, cover))},
-		{8, 1, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(InstanceData, uvScale))},
-		{9, 1, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(InstanceData, uvOffset))},
 	};
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 }
 
-glm::vec2 Image::getPixelDimensions(int /*idx*/, int texIdx) {
-	if (texIdx < 0 || static_cast<size_t>(texIdx) >= gpuTextures.size())
+glm::vec2 Image::getPixelDimensions(int idx, int texIdx) {
+	const GpuTex *t = texIdx < 0 ? nullptr : frameTexture(idx, static_cast<uint32_t>(texIdx));
+	if (!t)
 		return glm::vec2(1.0f, 1.0f);
-
-	const auto &t = gpuTextures[static_cast<size_t>(texIdx)];
-	return glm::vec2(static_cast<float>(t.w), static_cast<float>(t.h));
-}
-
-uint32_t Image::createDescriptorPool() {
-	uint32_t baseSets = Model::createDescriptorPool();
-
-	// capacity for set=1
-	pipeline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kTexArraySize});
-
-	return std::max(baseSets, 2u);
+	return glm::vec2(static_cast<float>(t->w), static_cast<float>(t->h));
 }
 
 void Image::createDescriptors() {
-	// Declare set=1 layout FIRST so base allocates it.
-	pipeline->createDescriptorSetLayoutBinding(
-		/*binding*/ 0,
-		/*type*/ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		/*stages*/ VK_SHADER_STAGE_FRAGMENT_BIT,
-		/*count*/ kTexArraySize,
-		/*set*/ 1);
-
-	// Allocate pool & sets (set=0 and set=1)
+	// set=1: the engine-wide bindless texture table; instances index it with frameIndex
+	const TextureHeap &heap = TextureHeap::get();
+	pipeline->useSharedSet(TextureHeap::kSet, heap.layout(), heap.set());
+
+	// set=0
 	Model::createDescriptors();
 
-	// If a resize triggered reallocation, satisfy any pending write now.
-	ensureSet1Ready();
+	// set=0, binding 2: frame table of the instances being played (VS), written in place like the instance SSBO
+	if (!frameTableBuffer) {
+		pipeline->createBuffer(sizeof(FrameRef) * kFrameTableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameTableBuffer, frameTableMemory);
+		VK_CHECK(vkMapMemory(pipeline->device, frameTableMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&mappedFrameTable)));
+	}
+	pipeline->createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+	VkDescriptorBufferInfo framesInfo{frameTableBuffer, 0, sizeof(FrameRef) * kFrameTableSize};
+	pipeline->createWriteDescriptorSet(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, framesInfo);
 }
 
 void Image::createGraphicsPipeline() {
-	// Pipeline can be recreated on resize; after that, set=1 may be reallocated.
 	Model::createGraphicsPipeline();
 
 	pipeline->graphicsPipeline.rasterizationStateCI.cullMode = VK_CULL_MODE_NONE;
 
     pipeline->graphicsPipeline.depthStencilStateCI.depthTestEnable = VK_FALSE;
     pipeline->graphicsPipeline.depthStencilStateCI.depthWriteEnable = VK_FALSE;
-
-	if (set1Dirty)
-		ensureSet1Ready();
 }
 
 // --------------------------------------------------
-// Rebuild pipeline resources when frames change
+// Texture cache
 // --------------------------------------------------
 
-void Image::rebuildTexturePool() {
-	loadAllFramesCPU(framesPerInstance);
-	uploadAllFramesGPU();
+void Image::acquireTexture(const std::string &path) {
+	auto [it, inserted] = textures.try_emplace(path);
+	++it->second.refs;
+	if (!inserted)
+		return;
 
-	for (const auto &kv : framesPerInstance) {
-		const int id = kv.first;
-
-		if (!instanceModel.count(id))
-			instanceModel[id] = glm::mat4(1.0f);
-		uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
-
-		uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-		uint32_t count = instanceFrameCount.count(id) ? instanceFrameCount[id] : 0u;
-		if (count == 0) {
-			local = 0;
-		} else {
-			local = std::min(local, count - 1);
+	// the job only holds the inbox weakly: a decode that outlives this Image is skipped or dropped
+	ThreadPool::shared().submit([path, weak = std::weak_ptr<DecodeInbox>(inbox), c = compression, bc = bcSupported] {
+		if (weak.expired())
+			return;
+		CpuPixels cp = decode(path, c, bc);
+		if (auto in = weak.lock()) {
+			std::lock_guard<std::mutex> lk(in->mtx);
+			in->done.emplace_back(path, std::move(cp));
 		}
+	});
+}
 
-		const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-		const uint32_t global = std::min(base + local, (cap ? cap : 1u) - 1u);
-
-		glm::vec2 uvScale(1.0f), uvOffset(0.0f);
-		if (global < gpuTextures.size()) {
-			const uint32_t tw = std::max(1u, gpuTextures[global].w);
-			const uint32_t th = std::max(1u, gpuTextures[global].h);
-
-			// viewport.width, viewport.height are your current viewport dimensions in pixels (already on the class)
-			const float viewW = (viewport.width > 0.0f) ? viewport.width : 1.0f;
-			const float viewH = (viewport.height > 0.0f) ? viewport.height : 1.0f;
+void Image::releaseTextureRef(const std::string &path) {
+	auto it = textures.find(path);
+	if (it == textures.end() || --it->second.refs > 0)
+		return;
+	// frames in flight may still sample it, the heap retires it afterwards; a pending decode is dropped on landing
+	if (!it->second.pending)
+		releaseTexture(it->second.tex);
+	textures.erase(it);
+}
 
-			uvScale = pixelCropScale(tw, th, viewW, viewH); // size of the crop window in UVs
-			uvOffset = pixelCropOffset(uvScale);			// centered
-		}
+const Image::GpuTex *Image::frameTexture(int id, uint32_t local) const {
+	auto fit = framesPerInstance.find(id);
+	if (fit == framesPerInstance.end() || fit->second.empty())
+		return nullptr;
+	auto tit = textures.find(fit->second[std::min<size_t>(local, fit->second.size() - 1)]);
+	return tit == textures.end() || tit->second.pending ? nullptr : &tit->second.tex;
+}
 
-		InstanceData data{};
-		data.model = instanceModel[id];
-		data.frameIndex = global;
-		data.uvScale = uvScale;
-		data.uvOffset = uvOffset;
+void Image::pumpDecodes() {
+	std::vector<std::pair<std::string, CpuPixels>> done;
+	{
+		std::lock_guard<std::mutex> lk(inbox->mtx);
+		done.swap(inbox->done);
+	}
+	if (done.empty())
+		return;
+	PROFILE_SCOPE("Image::pumpDecodes");
+
+	// paths released meanwhile (or landed twice after a release + re-acquire) are dropped
+	std::vector<CachedTex *> landed;
+	std::vector<const CpuPixels *> pixels;
+	for (auto &[path, cp] : done) {
+		auto it = textures.find(path);
+		if (it == textures.end() || !it->second.pending)
+			continue;
+		it->second.pending = false;
+		landed.push_back(&it->second);
+		pixels.push_back(&cp);
+	}
+	if (landed.empty())
+		return;
 
-		upsertInternal(id, data);
+	std::vector<GpuTex> uploaded = upload(pixels);
+	std::unordered_set<const GpuTex *> patched;
+	for (size_t i = 0; i < landed.size(); ++i) {
+		landed[i]->tex = uploaded[i];
+		patched.insert(&landed[i]->tex);
 	}
 
-	ensureSet1Ready();
+	// swap the placeholder for the real texture in every instance whose active frame just landed
+	for (const auto &kv : framesPerInstance) {
+		const uint32_t local = instanceLocalFrame.count(kv.first) ? instanceLocalFrame[kv.first] : 0u;
+		if (patched.count(frameTexture(kv.first, local)))
+			writeInstance(kv.first);
+	}
+	// and in the frame lists being played
+	for (const auto &[frames, range] : frameRanges) {
+		const bool landedHere = std::any_of(frames.begin(), frames.end(), [&](const std::string &p) {
+			auto it = textures.find(p);
+			return it != textures.end() && patched.count(&it->second.tex);
+		});
+		if (landedHere)
+			writeFrameRange(frames, range);
+	}
 }
 
-// --------------------------------------------------
-// Frame loading (CPU) & upload (GPU)
-// --------------------------------------------------
-
-void Image::loadAllFramesCPU(const std::map<int, std::vector<std::string>> &list) {
-	cpuFrames.clear();
-	instanceFirstIndex.clear();
-	instanceFrameCount.clear();
-
-	uint32_t cursor = 0;
-	for (const auto &kv : list) {
-		const int instanceId = kv.first;
-		const auto &paths = kv.second;
-
-		instanceFirstIndex[instanceId] = cursor;
-		instanceFrameCount[instanceId] = static_cast<uint32_t>(paths.size());
-
-		if (paths.empty()) {
-			// 1×1 white
-			CpuPixels cp;
-			cp.w = cp.h = 1;
-			cp.comp = 4;
-			cp.rgba = {255, 255, 255, 255};
-			cpuFrames.push_back(std::move(cp));
-			cursor++;
-			instanceFrameCount[instanceId] = 1u;
-			continue;
+// Runs on the ThreadPool
+Image::CpuPixels Image::decode(const std::string &path, TextureCodec::Compression compression, bool bcSupported) {
+	if (path.empty())
+		return TextureCodec::solid(255, 255, 255, 255); // 1×1 white
+	const CpuPixels failed = TextureCodec::solid(255, 0, 255, 255); // 1×1 magenta
+
+	std::string ext = std::filesystem::path(path).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+	if (ext == ".ktx2") {
+		CpuPixels t;
+		std::string err;
+		if (!TextureCodec::readKTX2(path, t, &err)) {
+			std::fprintf(stderr, "[Image] %s: %s\n", path.c_str(), err.c_str());
+			return failed;
 		}
-
-		for (const auto &p : paths) {
-			int w = 0, h = 0, comp = 0;
-			stbi_uc *px = stbi_load(p.c_str(), &w, &h, &comp, STBI_rgb_alpha);
-			if (!px || w <= 0 || h <= 0) {
-				// 1×1 magenta on failure
-				CpuPixels cp;
-				cp.w = cp.h = 1;
-				cp.comp = 4;
-				cp.rgba = {255, 0, 255, 255};
-				cpuFrames.push_back(std::move(cp));
-			} else {
-				CpuPixels cp;
-				cp.w = w;
-				cp.h = h;
-				cp.comp = 4;
-				cp.rgba.resize(static_cast<size_t>(w * h * 4));
-				std::memcpy(cp.rgba.data(), px, cp.rgba.size());
-				stbi_image_free(px);
-				cpuFrames.push_back(std::move(cp));
-			}
-			cursor++;
+		if (TextureCodec::isBlockCompressed(t.format) && !bcSupported) {
+			std::fprintf(stderr, "[Image] %s: BC textures are not supported by this device\n", path.c_str());
+			return failed;
 		}
+		return t;
 	}
 
-	if (cpuFrames.empty()) {
-		CpuPixels cp;
-		cp.w = cp.h = 1;
-		cp.comp = 4;
-		cp.rgba = {255, 255, 255, 255};
-		cpuFrames.push_back(std::move(cp));
+	const std::vector<uint8_t> bytes = Assets::readAllBytes(path);
+	if (bytes.empty())
+		return failed;
+
+	// compressed results are cached by content, so an edited file gets a new entry
+	if (!bcSupported)
+		compression = TextureCodec::Compression::None;
+	std::string cachePath;
+	if (compression != TextureCodec::Compression::None) {
+		const std::string key = Assets::computeHashHex(std::string(bytes.begin(), bytes.end())) + "-" + std::to_string(int(compression));
+		cachePath = Assets::joinPath(Assets::joinPath(Assets::appdataPath, "texture_cache"), key + ".ktx2");
+		CpuPixels cached;
+		if (Assets::fileExists(cachePath) && TextureCodec::readKTX2(cachePath, cached))
+			return cached;
 	}
+
+	int w = 0, h = 0, comp = 0;
+	stbi_uc *px = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &comp, STBI_rgb_alpha);
+	if (!px || w <= 0 || h <= 0) {
+		if (px)
+			stbi_image_free(px);
+		return failed;
+	}
+
+	CpuPixels t = TextureCodec::fromRGBA8(px, uint32_t(w), uint32_t(h), /*mipmaps=*/true, compression);
+	stbi_image_free(px);
+	if (!cachePath.empty())
+		TextureCodec::writeKTX2(cachePath, t);
+	return t;
 }
 
-void Image::transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
-	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
+// --------------------------------------------------
+// Upload (GPU)
+// --------------------------------------------------
 
+void Image::transition(VkCommandBuffer cmd, VkImage img, uint32_t levels, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
 	VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
 	b.oldLayout = oldL;
 	b.newLayout = newL;
@@ -446,160 +531,163 @@ void Image::transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPi
 	b.image = img;
 	b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	b.subresourceRange.baseMipLevel = 0;
-	b.subresourceRange.levelCount = 1;
+	b.subresourceRange.levelCount = levels;
 	b.subresourceRange.baseArrayLayer = 0;
 	b.subresourceRange.layerCount = 1;
 
 	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
-	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd);
 }
 
-void Image::copyBufferToImage(VkBuffer staging, VkImage img, uint32_t w, uint32_t h) {
-	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
-
-	VkBufferImageCopy reg{};
-	reg.bufferOffset = 0;
-	reg.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	reg.imageSubresource.mipLevel = 0;
-	reg.imageSubresource.baseArrayLayer = 0;
-	reg.imageSubresource.layerCount = 1;
-	reg.imageExtent = {w, h, 1};
+void Image::copyBufferToImage(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, VkImage img, const CpuPixels &tex) {
+	// one region per mip level; compressed levels are whole blocks, tightly packed
+	std::vector<VkBufferImageCopy> regs(tex.levels.size());
+	for (size_t l = 0; l < tex.levels.size(); ++l) {
+		VkBufferImageCopy &reg = regs[l];
+		reg.bufferOffset = offset + tex.levels[l].offset;
+		reg.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		reg.imageSubresource.mipLevel = static_cast<uint32_t>(l);
+		reg.imageSubresource.baseArrayLayer = 0;
+		reg.imageSubresource.layerCount = 1;
+		reg.imageExtent = {tex.levels[l].w, tex.levels[l].h, 1};
+	}
 
-	vkCmdCopyBufferToImage(cmd, staging, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &reg);
-	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd);
+	vkCmdCopyBufferToImage(cmd, staging, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regs.size()), regs.data());
 }
 
-void Image::uploadAllFramesGPU() {
+std::vector<Image::GpuTex> Image::upload(const std::vector<const CpuPixels *> &batch) {
 	const auto &dev = engine->getDevice();
 	const auto &pdev = engine->getPhysicalDevice();
+	std::vector<GpuTex> out(batch.size());
+
+	// small uncompressed frames go in the atlas (level 0 only), the rest get an image of their own
+	TextureAtlas &atlas = TextureAtlas::get();
+	std::vector<bool> packed(batch.size());
+	for (size_t i = 0; i < batch.size(); ++i)
+		packed[i] = atlasEnabled && TextureAtlas::fits(batch[i]->format, batch[i]->width(), batch[i]->height());
+
+	// one staging buffer for the batch; each texture starts 16-byte aligned (a multiple of every texel/block size)
+	auto align16 = [](VkDeviceSize v) { return (v + 15) & ~VkDeviceSize(15); };
+	VkDeviceSize total = 0;
+	for (size_t i = 0; i < batch.size(); ++i)
+		total = align16(total) + static_cast<VkDeviceSize>(packed[i] ? TextureAtlas::stagingBytes(batch[i]->width(), batch[i]->height()) : batch[i]->data.size());
+
+	VkBuffer staging{};
+	VkDeviceMemory stagingMem{};
+	pipeline->createBuffer(total, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
+	uint8_t *mapped = nullptr;
+	VK_CHECK(vkMapMemory(dev, stagingMem, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&mapped)));
 
-	auto destroyTex = [&](GpuTex &t) {
-		if (t.sampler) {
-			vkDestroySampler(dev, t.sampler, nullptr);
-			t.sampler = VK_NULL_HANDLE;
-		}
-		if (t.view) {
-			vkDestroyImageView(dev, t.view, nullptr);
-			t.view = VK_NULL_HANDLE;
-		}
-		if (t.image) {
-			vkDestroyImage(dev, t.image, nullptr);
-			t.image = VK_NULL_HANDLE;
-		}
-		if (t.memory) {
-			vkFreeMemory(dev, t.memory, nullptr);
-			t.memory = VK_NULL_HANDLE;
+	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
+	VkDeviceSize offset = 0;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		const CpuPixels &cp = *batch[i];
+		GpuTex &t = out[i];
+		t.w = cp.width();
+		t.h = cp.height();
+		offset = align16(offset);
+
+		if (packed[i]) {
+			t.region = atlas.allocate(cp.format, TextureAtlas::Filter::NearestMag, t.w, t.h);
+			t.heapIndex = t.region.heapIndex;
+			TextureAtlas::stage(cp.data.data() + cp.levels[0].offset, t.w, t.h, mapped + offset);
+			atlas.record(cmd, staging, offset, t.region);
+			offset += static_cast<VkDeviceSize>(TextureAtlas::stagingBytes(t.w, t.h));
+			continue;
 		}
-	};
-
-	// Build new textures into temporaries
-	std::vector<GpuTex> newTextures(cpuFrames.size());
-	std::vector<VkDescriptorImageInfo> newInfos;
-	newInfos.reserve(cpuFrames.size());
-
-	for (size_t i = 0; i < cpuFrames.size(); ++i) {
-		const auto &cp = cpuFrames[i];
 
 		VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
 		ici.imageType = VK_IMAGE_TYPE_2D;
-		ici.format = VK_FORMAT_R8G8B8A8_SRGB;
-		ici.extent = {(uint32_t)cp.w, (uint32_t)cp.h, 1};
-		ici.mipLevels = 1;
+		const uint32_t levels = static_cast<uint32_t>(cp.levels.size());
+		ici.format = cp.format;
+		ici.extent = {cp.width(), cp.height(), 1};
+		ici.mipLevels = levels;
 		ici.arrayLayers = 1;
 		ici.samples = VK_SAMPLE_COUNT_1_BIT;
 		ici.tiling = VK_IMAGE_TILING_OPTIMAL;
 		ici.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-		VK_CHECK(vkCreateImage(dev, &ici, nullptr, &newTextures[i].image));
+		VK_CHECK(vkCreateImage(dev, &ici, nullptr, &t.image));
 
 		VkMemoryRequirements req{};
-		vkGetImageMemoryRequirements(dev, newTextures[i].image, &req);
+		vkGetImageMemoryRequirements(dev, t.image, &req);
 
 		VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
 		ai.allocationSize = req.size;
 		ai.memoryTypeIndex = Memory::findMemoryType(pdev, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK(vkAllocateMemory(dev, &ai, nullptr, &newTextures[i].memory));
-		VK_CHECK(vkBindImageMemory(dev, newTextures[i].image, newTextures[i].memory, 0));
-
-		// staging upload
-		VkBuffer staging{};
-		VkDeviceMemory stagingMem{};
-		VkDeviceSize bytes = static_cast<VkDeviceSize>(cp.rgba.size());
-		pipeline->createBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
-		void *p = nullptr;
-		VK_CHECK(vkMapMemory(dev, stagingMem, 0, VK_WHOLE_SIZE, 0, &p));
-		std::memcpy(p, cp.rgba.data(), cp.rgba.size());
-		vkUnmapMemory(dev, stagingMem);
-
-		transition(newTextures[i].image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
-		copyBufferToImage(staging, newTextures[i].image, (uint32_t)cp.w, (uint32_t)cp.h);
-		transition(newTextures[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
-
-		vkDestroyBuffer(dev, staging, nullptr);
-		vkFreeMemory(dev, stagingMem, nullptr);
+		VK_CHECK(vkAllocateMemory(dev, &ai, nullptr, &t.memory));
+		VK_CHECK(vkBindImageMemory(dev, t.image, t.memory, 0));
+
+		std::memcpy(mapped + offset, cp.data.data(), cp.data.size());
+		transition(cmd, t.image, levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		copyBufferToImage(cmd, staging, offset, t.image, cp);
+		transition(cmd, t.image, levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		offset += static_cast<VkDeviceSize>(cp.data.size());
 
 		VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
 		vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		vci.image = newTextures[i].image;
-		vci.format = VK_FORMAT_R8G8B8A8_SRGB;
+		vci.image = t.image;
+		vci.format = cp.format;
 		vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		vci.subresourceRange.levelCount = 1;
+		vci.subresourceRange.levelCount = levels;
 		vci.subresourceRange.layerCount = 1;
-		VK_CHECK(vkCreateImageView(dev, &vci, nullptr, &newTextures[i].view));
+		VK_CHECK(vkCreateImageView(dev, &vci, nullptr, &t.view));
 
+		// pixel-exact when magnified / at 1:1, trilinear through the mips when minified
 		VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
 		sci.magFilter = VK_FILTER_NEAREST;
-		sci.minFilter = VK_FILTER_NEAREST;
-		sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sci.minFilter = VK_FILTER_LINEAR;
+		sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 		sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 		sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		sci.maxLod = 0.0f;
-		VK_CHECK(vkCreateSampler(dev, &sci, nullptr, &newTextures[i].sampler));
-
-		newTextures[i].w = (uint32_t)cp.w;
-		newTextures[i].h = (uint32_t)cp.h;
-
-		VkDescriptorImageInfo ii{};
-		ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		ii.imageView = newTextures[i].view;
-		ii.sampler = newTextures[i].sampler;
-		newInfos.push_back(ii);
+		sci.maxLod = static_cast<float>(levels);
+		VK_CHECK(vkCreateSampler(dev, &sci, nullptr, &t.sampler));
 	}
+	vkUnmapMemory(dev, stagingMem);
+	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd); // waits for the copies
 
-	// swap them in (we'll write descriptors lazily below)
-	vkDeviceWaitIdle(dev);
-	for (auto &t : gpuTextures)
-		destroyTex(t);
-	gpuTextures = std::move(newTextures);
-	imageInfos = std::move(newInfos);
+	vkDestroyBuffer(dev, staging, nullptr);
+	vkFreeMemory(dev, stagingMem, nullptr);
 
-	ensureSet1Ready();
+	TextureHeap &heap = TextureHeap::get();
+	for (GpuTex &t : out)
+		if (!t.region.valid())
+			t.heapIndex = heap.add(t.view, t.sampler);
+	return out;
 }
 
-void Image::destroyAllTextures() {
-	const auto &dev = engine->getDevice();
-	for (auto &t : gpuTextures) {
-		if (t.sampler) {
+void Image::releaseTexture(GpuTex &t) {
+	if (t.region.valid()) { // the atlas keeps the cell until no frame in flight samples it
+		if (TextureAtlas *atlas = TextureAtlas::current())
+			atlas->release(t.region);
+		t = GpuTex{};
+		return;
+	}
+	auto destroy = [dev = engine->getDevice(), t] {
+		if (t.sampler)
 			vkDestroySampler(dev, t.sampler, nullptr);
-			t.sampler = VK_NULL_HANDLE;
-		}
-		if (t.view) {
+		if (t.view)
 			vkDestroyImageView(dev, t.view, nullptr);
-			t.view = VK_NULL_HANDLE;
-		}
-		if (t.image) {
+		if (t.image)
 			vkDestroyImage(dev, t.image, nullptr);
-			t.image = VK_NULL_HANDLE;
-		}
-		if (t.memory) {
+		if (t.memory)
 			vkFreeMemory(dev, t.memory, nullptr);
-			t.memory = VK_NULL_HANDLE;
-		}
-	}
-	gpuTextures.clear();
-	imageInfos.clear();
+	};
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(t.heapIndex, destroy);
+	else
+		destroy();
+	t = GpuTex{};
+}
+
+void Image::destroyAllTextures() {
+	for (auto &kv : textures)
+		if (!kv.second.pending)
+			releaseTexture(kv.second.tex);
+	textures.clear();
+	if (placeholder.heapIndex != TextureHeap::kInvalid)
+		releaseTexture(placeholder);
 }
 
 void Image::record(VkCommandBuffer cmd) {
@@ -608,8 +696,10 @@ void Image::record(VkCommandBuffer cmd) {
 	struct {
 		uvec4 fb;
 		uvec4 vp;
-	} pc = {fbPx, vpPx};
+		float time; // clockSeconds - clockBase, for the instances being played
+		float _pad[3];
+	} pc = {fbPx, vpPx, static_cast<float>(clockSeconds - clockBase), {}};
 
-	vkCmdPushConstants(cmd, pipeline->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
+	vkCmdPushConstants(cmd, pipeline->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
 	Model::record(cmd);
 }
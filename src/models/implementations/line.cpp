@@ -7,8 +7,7 @@ Line::Line(Scene *scene) : Model(scene) {}
 void Line::init() {
 	engine = scene->getScenes().getEngine();
 	buildUnitQuadMesh();
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/line", engine->getDevice());
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/line", engine->getDevice());
 
 	pipeline->graphicsPipeline.pushConstantRangeCount = 1;
 	pipeline->graphicsPipeline.pushContantRanges.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
@@ -16,8 +15,7 @@ void Line::init() {
 	pipeline->graphicsPipeline.pushContantRanges.size = sizeof(LinePC);
 
 	Model::init();
-	InstanceData placeholder{};
-	upsertInstance(0, placeholder);
+	instances<InstanceData>().upsert(0, InstanceData{});
 }
 
 void Line::syncPickingInstances() { Model::syncPickingInstances<InstanceData>(); }
@@ -52,15 +50,8 @@ void Line::buildUnitQuadMesh() {
 	using F = VkFormat;
 	m.vertexAttrs = {
 		{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
-		{1, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-		{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-		{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-		{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
-		{5, 1, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(InstanceData, p1))},
-		{6, 1, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(InstanceData, p2))},
-		{7, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, color))},
-		{8, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, lineWidth))},
 	};
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 }
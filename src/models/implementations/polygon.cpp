@@ -100,6 +100,9 @@ template <typename T> void Polygon::expandForOutlines(const std::vector<T> &inVe
 	}
 }
 
+// emitted here so engine_bench can call it from another TU
+template void Polygon::expandForOutlines<Polygon::Vertex>(const std::vector<Polygon::Vertex> &, const std::vector<uint32_t> &, std::vector<Polygon::Attributes> &, std::vector<uint32_t> &);
+
 void Polygon::init(const std::vector<Vertex> &verts, const std::vector<uint32_t> &idx) {
 	engine = scene->getScenes().getEngine();
 
@@ -124,28 +127,18 @@ void Polygon::init(const std::vector<Vertex> &verts, const std::vector<uint32_t>
 		{3, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Attributes, edgeMask))},
 	};
 
-	// Binding 1: per-instance data (mat4 as 4x vec4 + colors + width)
-	m.vertexAttrs.push_back({4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)});
-	m.vertexAttrs.push_back({5, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)});
-	m.vertexAttrs.push_back({6, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)});
-	m.vertexAttrs.push_back({7, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)});
-	m.vertexAttrs.push_back({8, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, color))});
-	m.vertexAttrs.push_back({9, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, outlineColor))});
-	m.vertexAttrs.push_back({10, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, outlineWidth))});
+	// Binding 1: per-instance data (mat4 as 4x vec4 + colors + width), stride included
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 
-	// This tells your Model to create a binding description for binding=1
-	// with VK_VERTEX_INPUT_RATE_INSTANCE and the given stride.
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
-
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/polygon", engine->getDevice());
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/polygon", engine->getDevice());
+	mergeDraws = true; // polygon.vert reads only the VPMatrix and its attributes
 
 	Model::init();
 
 	// Ensure a default instance exists
-	InstanceData placeholder{};
-	upsertInstance(0, placeholder);
+	instances<InstanceData>().upsert(0, InstanceData{});
 }
 
 void Polygon::initNGon(size_t n) {
@@ -8,11 +8,10 @@ Rectangle::Rectangle(Scene *scene) : Model(scene) {}
 void Rectangle::init() {
 	engine = scene->getScenes().getEngine();
 	buildUnitQuadMesh();
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/rectangle", engine->getDevice());
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/rectangle", engine->getDevice());
+	mergeDraws = true; // rectangle.vert reads only the VPMatrix and its attributes
 	Model::init();
-	InstanceData placeholder{};
-	upsertInstance(0, placeholder);
+	instances<InstanceData>().upsert(0, InstanceData{});
 }
 
 void Rectangle::syncPickingInstances() { Model::syncPickingInstances<InstanceData>(); }
@@ -37,16 +36,8 @@ void Rectangle::buildUnitQuadMesh() {
 	using F = VkFormat;
 	m.vertexAttrs = {
 		{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
-
-		{1, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-		{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-		{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-		{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
-		{5, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, color))},
-        {6, 1, VK_FORMAT_R32G32B32A32_SFLOAT,    uint32_t(offsetof(InstanceData, outlineColor))},
-		{7, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, outlineWidth))},
-		{8, 1, F::VK_FORMAT_R32_SFLOAT, uint32_t(offsetof(InstanceData, borderRadius))},
 	};
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 }
@@ -1,19 +1,24 @@
 #include "svg.hpp"
 #include "debug.hpp"
 #include "engine.hpp"
+#include "events.hpp"
 #include "memory.hpp"
+#include "profiler.hpp"
 #include "scenes.hpp"
+#include "textureheap.hpp"
+#include "threadpool.hpp"
 
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <limits>
+#include <unordered_set>
 
 #include <lunasvg.h>
 
 using namespace lunasvg;
 
 namespace {
-constexpr uint32_t kTexArraySize = 1024;
 
 // helper: lowercase file extension
 std::string getExtLower(const std::string &p) {
@@ -81,56 +86,15 @@ static SVG::CpuPixels cropAlphaTight(const SVG::CpuPixels &in, uint8_t alphaThre
 	return out;
 }
 
+size_t rasterBytes(uint32_t w, uint32_t h) { return size_t(w) * size_t(h) * 4; }
+
 } // namespace
 
 SVG::SVG(Scene *scene) : Model(scene) {}
-SVG::~SVG() { destroyAllTextures(); }
-
-// ---------------- Descriptor maintenance ----------------
-
-void SVG::writeSet1Descriptors() {
-	if (!pipeline)
-		return;
-	if (pipeline->descriptorSets.descriptorSets.size() <= 1)
-		return;
-	VkDescriptorSet set1 = pipeline->descriptorSets.descriptorSets[1];
-	if (set1 == VK_NULL_HANDLE)
-		return;
-	if (imageInfos.empty())
-		return;
-
-	// Avoid VUID about updating in-use sets: stall (simple, safe)
-	vkDeviceWaitIdle(pipeline->device);
-
-	std::vector<VkDescriptorImageInfo> padded = imageInfos;
-	while (padded.size() < kTexArraySize)
-		padded.push_back(padded[0]);
-
-	VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-	w.dstSet = set1;
-	w.dstBinding = 0;
-	w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	w.descriptorCount = static_cast<uint32_t>(padded.size());
-	w.pImageInfo = padded.data();
-
-	vkUpdateDescriptorSets(pipeline->device, 1, &w, 0, nullptr);
-	set1Dirty = false;
-}
-
-void SVG::ensureSet1Ready() {
-	if (!pipeline || pipeline->descriptorSets.descriptorSets.size() <= 1) {
-		set1Dirty = true;
-		return;
-	}
-	if (pipeline->descriptorSets.descriptorSets[1] == VK_NULL_HANDLE) {
-		set1Dirty = true;
-		return;
-	}
-	if (imageInfos.empty()) {
-		set1Dirty = true;
-		return;
-	}
-	writeSet1Descriptors();
+SVG::~SVG() {
+	if (!updateEventId.empty())
+		Events::unregisterUpdate(updateEventId);
+	destroyAllTextures();
 }
 
 // ---------------- Init ----------------
@@ -139,13 +103,9 @@ void SVG::init() {
 	engine = scene->getScenes().getEngine();
 
 	buildUnitQuadMesh();
-	initInfo.instanceStrideBytes = sizeof(InstanceData);
 
 	// reuse image shaders, or point to "svg" if you duplicate them
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/svg", engine->getDevice());
-
-	// ensure we have at least one white tex so set=1 is valid
-	loadAllFramesCPU(framesPerInstance);
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/svg", engine->getDevice());
 
 	pipeline->graphicsPipeline.pushConstantRangeCount = 1;
 	pipeline->graphicsPipeline.pushContantRanges.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -154,70 +114,82 @@ void SVG::init() {
 
 	Model::init();
 
-	uploadAllFramesGPU();
-	ensureSet1Ready();
+	CpuPixels clear;
+	clear.w = clear.h = 1;
+	clear.rgba = {0, 0, 0, 0};
+	placeholder = upload({&clear}).front();
+
+	// rasters land between frames, on the render thread
+	updateEventId = Events::registerUpdate([this](float) {
+		pumpDecodes();
+		refreshRasterSizes();
+	});
+
+	// frames upserted before init: queue their rasters now
+	for (const auto &kv : framesPerInstance) {
+		acquireFrames(kv.second, instanceRaster[kv.first].shown);
+		writeInstance(kv.first);
+	}
 }
 
 void SVG::syncPickingInstances() { Model::syncPickingInstances<InstanceData>(); }
 
 // ---------------- Public API ----------------
 
-void SVG::upsert(int id, const string &path) {
-	framesPerInstance[id] = std::vector<std::string>{path};
-
-	if (!instanceModel.count(id))
-		instanceModel[id] = glm::mat4(1.0f);
-	instanceLocalFrame[id] = 0u;
-
-	rebuildTexturePool();
-	ensureSet1Ready();
-}
+void SVG::upsert(int id, const string &path) { upsert(id, std::vector<std::string>{path}); }
 
 void SVG::upsert(int id, const vector<string> &paths) {
-	framesPerInstance[id] = paths;
+	std::vector<std::string> frames = paths.empty() ? std::vector<std::string>{std::string()} : paths;
 
 	if (!instanceModel.count(id))
 		instanceModel[id] = glm::mat4(1.0f);
 	instanceLocalFrame[id] = 0u;
+	InstanceRaster &raster = instanceRaster[id];
 
-	rebuildTexturePool();
-	ensureSet1Ready();
-}
-
-void SVG::setFrame(int id, uint32_t frameIndex) {
-	if (!framesPerInstance.count(id))
-		return;
-
-	uint32_t count = instanceFrameCount.count(id) ? instanceFrameCount[id] : 0u;
-	if (count == 0)
+	if (!engine) { // not initialized yet: init() queues the rasters
+		framesPerInstance[id] = std::move(frames);
 		return;
+	}
 
-	instanceLocalFrame[id] = std::min(frameIndex, count - 1);
+	// acquire before releasing, so paths the instance keeps are neither dropped nor rasterized again
+	acquireFrames(frames, raster.shown);
+	auto it = framesPerInstance.find(id);
+	if (it != framesPerInstance.end()) {
+		releaseFrames(it->second, raster.shown);
+		if (raster.target != raster.shown)
+			releaseFrames(it->second, raster.target);
+	}
+	raster.target = raster.shown;
+	framesPerInstance[id] = std::move(frames);
 
-	uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-	const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-	const uint32_t global = std::min(base + instanceLocalFrame[id], (cap ? cap : 1u) - 1u);
+	writeInstance(id);
+}
 
-	InstanceData data{};
-	data.model = instanceModel.count(id) ? instanceModel[id] : glm::mat4(1.0f);
-	data.frameIndex = global;
-	data.uvScale = glm::vec2(1.0f);
-	data.uvOffset = glm::vec2(0.0f);
+void SVG::setFrame(int id, uint32_t frameIndex) {
+	auto it = framesPerInstance.find(id);
+	if (it == framesPerInstance.end())
+		return;
 
-	upsertInternal(id, data);
-	ensureSet1Ready();
+	instanceLocalFrame[id] = std::min(frameIndex, static_cast<uint32_t>(it->second.size()) - 1u);
+	if (engine)
+		writeInstance(id);
 }
 
 void SVG::erase(int id) {
+	auto it = framesPerInstance.find(id);
+	auto rit = instanceRaster.find(id);
+	if (it != framesPerInstance.end() && rit != instanceRaster.end() && engine) {
+		releaseFrames(it->second, rit->second.shown);
+		if (rit->second.target != rit->second.shown)
+			releaseFrames(it->second, rit->second.target);
+	}
+
 	framesPerInstance.erase(id);
 	instanceModel.erase(id);
 	instanceLocalFrame.erase(id);
-	instanceFirstIndex.erase(id);
-	instanceFrameCount.erase(id);
+	instanceRaster.erase(id);
 
 	Model::erase(id);
-	rebuildTexturePool();
-	ensureSet1Ready();
 }
 
 // ---------------- Internal ----------------
@@ -225,40 +197,29 @@ void SVG::erase(int id) {
 void SVG::upsertInternal(int id, const InstanceData &data) {
 	std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t *>(&data), sizeof(InstanceData));
 	upsertBytes(id, bytes);
-	if (set1Dirty)
-		ensureSet1Ready();
 }
 
-void SVG::recalcUV() {
-	for (const auto &kv : framesPerInstance) {
-		const int id = kv.first;
+void SVG::writeInstance(int id) {
+	const uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
+	const GpuTex *tex = frameTexture(id, local);
 
-		uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
-		uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-		const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-		const uint32_t global = std::min(base + local, (cap ? cap : 1u) - 1u);
-
-		glm::vec2 uvScale(1.0f), uvOffset(0.0f);
-		// if (global < gpuTextures.size()) {
-		// 	const uint32_t tw = std::max(1u, gpuTextures[global].w);
-		// 	const uint32_t th = std::max(1u, gpuTextures[global].h);
-
-		// 	const float viewW = (viewport.width > 0.0f) ? viewport.width : 1.0f;
-		// 	const float viewH = (viewport.height > 0.0f) ? viewport.height : 1.0f;
-
-		// 	uvScale = pixelCropScale(tw, th, viewW, viewH);
-		// 	uvOffset = pixelCropOffset(uvScale);
-		// }
-
-		InstanceData data{};
+	InstanceData data{};
+	if (!getInstance(id, data))
 		data.model = instanceModel.count(id) ? instanceModel[id] : glm::mat4(1.0f);
-		data.frameIndex = global;
-		data.uvScale = uvScale;
-		data.uvOffset = uvOffset;
-
-		upsertInternal(id, data);
+	data.frameIndex = tex ? tex->heapIndex : placeholder.heapIndex;
+	data.uvScale = glm::vec2(1.0f);
+	data.uvOffset = glm::vec2(0.0f);
+	if (tex && tex->region.valid()) {
+		data.uvScale = glm::vec2(tex->region.w, tex->region.h) / float(TextureAtlas::kPageSize);
+		data.uvOffset = glm::vec2(tex->region.x, tex->region.y) / float(TextureAtlas::kPageSize);
 	}
-	ensureSet1Ready();
+
+	upsertInternal(id, data);
+}
+
+void SVG::recalcUV() {
+	for (const auto &kv : framesPerInstance)
+		writeInstance(kv.first);
 }
 
 // ---------------- Mesh & pipeline ----------------
@@ -281,43 +242,28 @@ void SVG::buildUnitQuadMesh() {
 	m.isrc.count = 6;
 
 	using F = VkFormat;
-
 	m.vertexAttrs = {
 		{0, 0, F::VK_FORMAT_R32G32B32_SFLOAT, uint32_t(offsetof(Vertex, pos))},
 		{1, 0, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(Vertex, uv))},
-
-		{2, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 0)},
-		{3, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 1)},
-		{4, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 2)},
-		{5, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + sizeof(glm::vec4) * 3)},
-		{6, 1, F::VK_FORMAT_R32_UINT, uint32_t(offsetof(InstanceData, frameIndex))},
-		{7, 1, F::VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, color))},
-		{8, 1, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(InstanceData, uvScale))},
-		{9, 1, F::VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(InstanceData, uvOffset))},
 	};
+	setInstanceLayout<InstanceData>(m);
 
 	initInfo.mesh = m;
 }
 
-glm::vec2 SVG::getPixelDimensions(int /*idx*/, int texIdx) {
-	if (texIdx < 0 || static_cast<size_t>(texIdx) >= gpuTextures.size())
+glm::vec2 SVG::getPixelDimensions(int idx, int texIdx) {
+	const GpuTex *t = texIdx < 0 ? nullptr : frameTexture(idx, static_cast<uint32_t>(texIdx));
+	if (!t)
 		return glm::vec2(1.0f, 1.0f);
-
-	const auto &t = gpuTextures[static_cast<size_t>(texIdx)];
-	return glm::vec2(static_cast<float>(t.w), static_cast<float>(t.h));
-}
-
-uint32_t SVG::createDescriptorPool() {
-	uint32_t baseSets = Model::createDescriptorPool();
-	pipeline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kTexArraySize});
-	return std::max(baseSets, 2u);
+	return glm::vec2(static_cast<float>(t->w), static_cast<float>(t->h));
 }
 
 void SVG::createDescriptors() {
-	pipeline->createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, kTexArraySize, 1);
+	// set=1: the engine-wide bindless texture table; instances index it with frameIndex
+	const TextureHeap &heap = TextureHeap::get();
+	pipeline->useSharedSet(TextureHeap::kSet, heap.layout(), heap.set());
 
 	Model::createDescriptors();
-	ensureSet1Ready();
 }
 
 void SVG::createGraphicsPipeline() {
@@ -326,139 +272,221 @@ void SVG::createGraphicsPipeline() {
 	pipeline->graphicsPipeline.rasterizationStateCI.cullMode = VK_CULL_MODE_NONE;
 	pipeline->graphicsPipeline.depthStencilStateCI.depthTestEnable = VK_FALSE;
 	pipeline->graphicsPipeline.depthStencilStateCI.depthWriteEnable = VK_FALSE;
-
-	if (set1Dirty)
-		ensureSet1Ready();
 }
 
-// ---------------- Rebuild on frames change ----------------
-
-void SVG::rebuildTexturePool() {
-	loadAllFramesCPU(framesPerInstance);
-	uploadAllFramesGPU();
+// ---------------- Texture cache ----------------
 
-	for (const auto &kv : framesPerInstance) {
-		const int id = kv.first;
+void SVG::acquireTexture(const RasterKey &key) {
+	auto [it, inserted] = textures.try_emplace(key);
+	CachedTex &e = it->second;
+	if (!inserted && e.refs == 0) { // back from the LRU
+		lru.erase(e.unused);
+		unusedBytes -= rasterBytes(e.tex.w, e.tex.h);
+	}
+	++e.refs;
+	if (!inserted)
+		return;
 
-		if (!instanceModel.count(id))
-			instanceModel[id] = glm::mat4(1.0f);
+	// the job only holds the inbox weakly: a raster that outlives this SVG is skipped or dropped
+	ThreadPool::shared().submit([key, weak = std::weak_ptr<DecodeInbox>(inbox)] {
+		if (weak.expired())
+			return;
+		CpuPixels cp = decode(key);
+		if (auto in = weak.lock()) {
+			std::lock_guard<std::mutex> lk(in->mtx);
+			in->done.emplace_back(key, std::move(cp));
+		}
+	});
+}
 
-		uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
+void SVG::releaseTextureRef(const RasterKey &key) {
+	auto it = textures.find(key);
+	if (it == textures.end() || --it->second.refs > 0)
+		return;
+	if (it->second.pending) { // dropped on landing
+		textures.erase(it);
+		return;
+	}
+	lru.push_front(key);
+	it->second.unused = lru.begin();
+	unusedBytes += rasterBytes(it->second.tex.w, it->second.tex.h);
+	evictUnused();
+}
 
-		uint32_t base = instanceFirstIndex.count(id) ? instanceFirstIndex[id] : 0u;
-		uint32_t count = instanceFrameCount.count(id) ? instanceFrameCount[id] : 0u;
-		if (count == 0) {
-			local = 0;
-		} else {
-			local = std::min(local, count - 1);
-		}
+void SVG::acquireFrames(const std::vector<std::string> &frames, uint32_t size) {
+	for (const auto &p : frames)
+		acquireTexture({p, size});
+}
 
-		const uint32_t cap = std::max(1u, std::min<uint32_t>((uint32_t)imageInfos.size(), kTexArraySize));
-		const uint32_t global = std::min(base + local, (cap ? cap : 1u) - 1u);
+void SVG::releaseFrames(const std::vector<std::string> &frames, uint32_t size) {
+	for (const auto &p : frames)
+		releaseTextureRef({p, size});
+}
 
-		glm::vec2 uvScale(1.0f), uvOffset(0.0f);
-		// if (global < gpuTextures.size()) {
-		// 	const uint32_t tw = std::max(1u, gpuTextures[global].w);
-		// 	const uint32_t th = std::max(1u, gpuTextures[global].h);
+void SVG::evictUnused() {
+	while (unusedBytes > kUnusedRasterBytes && !lru.empty()) {
+		auto it = textures.find(lru.back());
+		lru.pop_back();
+		unusedBytes -= rasterBytes(it->second.tex.w, it->second.tex.h);
+		// frames in flight may still sample it, the heap retires it afterwards
+		releaseTexture(it->second.tex);
+		textures.erase(it);
+	}
+}
 
-		// 	const float viewW = (viewport.width > 0.0f) ? viewport.width : 1.0f;
-		// 	const float viewH = (viewport.height > 0.0f) ? viewport.height : 1.0f;
+const SVG::CachedTex *SVG::frameEntry(int id, uint32_t local, uint32_t size) const {
+	auto fit = framesPerInstance.find(id);
+	if (fit == framesPerInstance.end() || fit->second.empty())
+		return nullptr;
+	auto tit = textures.find({fit->second[std::min<size_t>(local, fit->second.size() - 1)], size});
+	return tit == textures.end() ? nullptr : &tit->second;
+}
 
-		// 	uvScale = pixelCropScale(tw, th, viewW, viewH);
-		// 	uvOffset = pixelCropOffset(uvScale);
-		// }
+const SVG::GpuTex *SVG::frameTexture(int id, uint32_t local) const {
+	auto rit = instanceRaster.find(id);
+	const CachedTex *e = frameEntry(id, local, rit == instanceRaster.end() ? kDefaultRasterPx : rit->second.shown);
+	return !e || e->pending ? nullptr : &e->tex;
+}
 
-		InstanceData data{};
-		data.model = instanceModel[id];
-		data.frameIndex = global;
-		data.uvScale = uvScale;
-		data.uvOffset = uvOffset;
+void SVG::pumpDecodes() {
+	std::vector<std::pair<RasterKey, CpuPixels>> done;
+	{
+		std::lock_guard<std::mutex> lk(inbox->mtx);
+		done.swap(inbox->done);
+	}
+	if (done.empty())
+		return;
+	PROFILE_SCOPE("SVG::pumpDecodes");
+
+	// paths released meanwhile (or landed twice after a release + re-acquire) are dropped
+	std::vector<CachedTex *> landed;
+	std::vector<const CpuPixels *> pixels;
+	for (auto &[key, cp] : done) {
+		auto it = textures.find(key);
+		if (it == textures.end() || !it->second.pending)
+			continue;
+		it->second.pending = false;
+		landed.push_back(&it->second);
+		pixels.push_back(&cp);
+	}
+	if (landed.empty())
+		return;
 
-		upsertInternal(id, data);
+	std::vector<GpuTex> uploaded = upload(pixels);
+	std::unordered_set<const GpuTex *> patched;
+	for (size_t i = 0; i < landed.size(); ++i) {
+		landed[i]->tex = uploaded[i];
+		patched.insert(&landed[i]->tex);
 	}
 
-	ensureSet1Ready();
+	// swap the placeholder for the real texture in every instance whose active frame just landed
+	for (const auto &kv : framesPerInstance) {
+		const uint32_t local = instanceLocalFrame.count(kv.first) ? instanceLocalFrame[kv.first] : 0u;
+		if (patched.count(frameTexture(kv.first, local)))
+			writeInstance(kv.first);
+	}
 }
 
-// ---------------- Frame loading (SVG → CPU) ----------------
-void SVG::loadAllFramesCPU(const std::map<int, std::vector<std::string>> &list) {
-	cpuFrames.clear();
-	instanceFirstIndex.clear();
-	instanceFrameCount.clear();
-
-	uint32_t cursor = 0;
-	for (const auto &kv : list) {
-		const int instanceId = kv.first;
-		const auto &paths = kv.second;
+// ---------------- Raster sizes ----------------
 
-		instanceFirstIndex[instanceId] = cursor;
-		instanceFrameCount[instanceId] = static_cast<uint32_t>(paths.size());
+void SVG::refreshRasterSizes() {
+	for (const auto &[id, frames] : framesPerInstance) {
+		InstanceData data{};
+		if (!getInstance(id, data))
+			continue;
+		const float px = screenExtentPx(data.model);
+		if (px <= 0.0f)
+			continue; // behind the camera: keep what it has
+
+		// grow as soon as the raster is too small; shrink only once it is 4× too big, so a size hovering
+		// around a bucket boundary does not re-rasterize every frame
+		InstanceRaster &raster = instanceRaster[id];
+		const uint32_t want = rasterBucket(px);
+		if (want != raster.target && (want > raster.target || want * 4 <= raster.target)) {
+			if (raster.target != raster.shown)
+				releaseFrames(frames, raster.target);
+			raster.target = want;
+			if (raster.target != raster.shown)
+				acquireFrames(frames, raster.target);
+		}
+		if (raster.target == raster.shown)
+			continue;
 
-		if (paths.empty()) {
-			CpuPixels cp;
-			cp.w = cp.h = 1;
-			cp.comp = 4;
-			cp.rgba = {255, 255, 255, 255};
-			cpuFrames.push_back(std::move(cp));
-			cursor++;
-			instanceFrameCount[instanceId] = 1u;
+		// swap once the active frame landed at the new size; the old size goes to the LRU
+		const uint32_t local = instanceLocalFrame.count(id) ? instanceLocalFrame[id] : 0u;
+		const CachedTex *next = frameEntry(id, local, raster.target);
+		if (!next || next->pending)
 			continue;
+		releaseFrames(frames, raster.shown);
+		raster.shown = raster.target;
+		writeInstance(id);
+	}
+}
+
+// Larger side, in framebuffer pixels, of the unit quad under `model`; 0 when a corner is behind the camera
+float SVG::screenExtentPx(const glm::mat4 &model) const {
+	const glm::mat4 mvp = vp.proj * vp.view * model;
+	glm::vec2 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+	for (float y : {-0.5f, 0.5f})
+		for (float x : {-0.5f, 0.5f}) {
+			const glm::vec4 c = mvp * glm::vec4(x, y, 0.0f, 1.0f);
+			if (c.w <= 1e-6f)
+				return 0.0f;
+			const glm::vec2 ndc = glm::vec2(c) / c.w;
+			lo = glm::min(lo, ndc);
+			hi = glm::max(hi, ndc);
 		}
+	const glm::vec2 px = (hi - lo) * 0.5f * glm::vec2(viewport.width, viewport.height);
+	return std::max(px.x, px.y);
+}
 
-		for (const auto &p : paths) {
-			CpuPixels cp{};
-			bool ok = false;
-
-			std::string ext = getExtLower(p);
-			if (ext == "svg") {
-				// ---- LunaSVG path ----
-				auto document = lunasvg::Document::loadFromFile(p);
-				if (document) {
-					auto bitmap = document->renderToBitmap(256, 256);
-					if (!bitmap.isNull()) {
-						const int w = bitmap.width();
-						const int h = bitmap.height();
-						const unsigned char *rgba = bitmap.data(); // RGBA
-
-						cp.w = w;
-						cp.h = h;
-						cp.comp = 4;
-						cp.rgba.resize(static_cast<size_t>(w) * static_cast<size_t>(h) * 4);
-
-						std::memcpy(cp.rgba.data(), rgba, cp.rgba.size());
-
-                        cp = cropAlphaTight(cp, /*alphaThreshold=*/1, /*pad=*/1);
-						ok = true;
-					}
-				}
-			}
+uint32_t SVG::rasterBucket(float px) {
+	uint32_t size = kMinRasterPx;
+	while (float(size) < px && size < kMaxRasterPx)
+		size <<= 1;
+	return size;
+}
 
-			if (!ok) {
-				// fallback: 1x1 magenta (same as before)
-				cp.w = cp.h = 1;
-				cp.comp = 4;
-				cp.rgba = {255, 0, 255, 255};
-			}
+// ---------------- Frame loading (SVG → CPU, on the ThreadPool) ----------------
 
-			cpuFrames.push_back(std::move(cp));
-			cursor++;
-		}
+SVG::CpuPixels SVG::decode(const RasterKey &key) {
+	const auto &[path, size] = key;
+	CpuPixels cp{};
+	cp.w = cp.h = 1;
+	cp.comp = 4;
+	if (path.empty()) {
+		cp.rgba = {255, 255, 255, 255};
+		return cp;
 	}
 
-	if (cpuFrames.empty()) {
-		CpuPixels cp;
-		cp.w = cp.h = 1;
-		cp.comp = 4;
-		cp.rgba = {255, 255, 255, 255};
-		cpuFrames.push_back(std::move(cp));
+	if (getExtLower(path) == "svg") {
+		// ---- LunaSVG path ----
+		auto document = lunasvg::Document::loadFromFile(path);
+		if (document) {
+			auto bitmap = document->renderToBitmap(int(size), int(size));
+			if (!bitmap.isNull()) {
+				const int w = bitmap.width();
+				const int h = bitmap.height();
+				const unsigned char *rgba = bitmap.data(); // RGBA
+
+				cp.w = w;
+				cp.h = h;
+				cp.rgba.resize(static_cast<size_t>(w) * static_cast<size_t>(h) * 4);
+				std::memcpy(cp.rgba.data(), rgba, cp.rgba.size());
+
+				return cropAlphaTight(cp, /*alphaThreshold=*/1, /*pad=*/1);
+			}
+		}
 	}
+
+	// fallback: 1x1 magenta (same as before)
+	cp.rgba = {255, 0, 255, 255};
+	return cp;
 }
 
 // ---------------- Vulkan upload ----------------
 
-void SVG::transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
-	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
-
+void SVG::transition(VkCommandBuffer cmd, VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
 	VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
 	b.oldLayout = oldL;
 	b.newLayout = newL;
@@ -472,14 +500,11 @@ void SVG::transition(VkImage img, VkImageLayout oldL, VkImageLayout newL, VkPipe
 	b.subresourceRange.layerCount = 1;
 
 	vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
-	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd);
 }
 
-void SVG::copyBufferToImage(VkBuffer staging, VkImage img, uint32_t w, uint32_t h) {
-	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
-
+void SVG::copyBufferToImage(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, VkImage img, uint32_t w, uint32_t h) {
 	VkBufferImageCopy reg{};
-	reg.bufferOffset = 0;
+	reg.bufferOffset = offset;
 	reg.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	reg.imageSubresource.mipLevel = 0;
 	reg.imageSubresource.baseArrayLayer = 0;
@@ -487,38 +512,46 @@ void SVG::copyBufferToImage(VkBuffer staging, VkImage img, uint32_t w, uint32_t
 	reg.imageExtent = {w, h, 1};
 
 	vkCmdCopyBufferToImage(cmd, staging, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &reg);
-	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd);
 }
 
-void SVG::uploadAllFramesGPU() {
+std::vector<SVG::GpuTex> SVG::upload(const std::vector<const CpuPixels *> &batch) {
 	const auto &dev = engine->getDevice();
 	const auto &pdev = engine->getPhysicalDevice();
+	std::vector<GpuTex> out(batch.size());
 
-	auto destroyTex = [&](GpuTex &t) {
-		if (t.sampler) {
-			vkDestroySampler(dev, t.sampler, nullptr);
-			t.sampler = VK_NULL_HANDLE;
-		}
-		if (t.view) {
-			vkDestroyImageView(dev, t.view, nullptr);
-			t.view = VK_NULL_HANDLE;
-		}
-		if (t.image) {
-			vkDestroyImage(dev, t.image, nullptr);
-			t.image = VK_NULL_HANDLE;
-		}
-		if (t.memory) {
-			vkFreeMemory(dev, t.memory, nullptr);
-			t.memory = VK_NULL_HANDLE;
-		}
-	};
+	// small rasters go in the atlas, the rest get an image of their own
+	TextureAtlas &atlas = TextureAtlas::get();
+	std::vector<bool> packed(batch.size());
+	for (size_t i = 0; i < batch.size(); ++i)
+		packed[i] = atlasEnabled && TextureAtlas::fits(VK_FORMAT_B8G8R8A8_SRGB, uint32_t(batch[i]->w), uint32_t(batch[i]->h));
 
-	std::vector<GpuTex> newTextures(cpuFrames.size());
-	std::vector<VkDescriptorImageInfo> newInfos;
-	newInfos.reserve(cpuFrames.size());
+	// one staging buffer for the batch; 4-byte texels keep every offset aligned
+	VkDeviceSize total = 0;
+	for (size_t i = 0; i < batch.size(); ++i)
+		total += static_cast<VkDeviceSize>(packed[i] ? TextureAtlas::stagingBytes(uint32_t(batch[i]->w), uint32_t(batch[i]->h)) : batch[i]->rgba.size());
 
-	for (size_t i = 0; i < cpuFrames.size(); ++i) {
-		const auto &cp = cpuFrames[i];
+	VkBuffer staging{};
+	VkDeviceMemory stagingMem{};
+	pipeline->createBuffer(total, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
+	uint8_t *mapped = nullptr;
+	VK_CHECK(vkMapMemory(dev, stagingMem, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&mapped)));
+
+	VkCommandBuffer cmd = engine->getLogicalDevice().beginSingleUseCmd();
+	VkDeviceSize offset = 0;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		const CpuPixels &cp = *batch[i];
+		GpuTex &t = out[i];
+		t.w = (uint32_t)cp.w;
+		t.h = (uint32_t)cp.h;
+
+		if (packed[i]) {
+			t.region = atlas.allocate(VK_FORMAT_B8G8R8A8_SRGB, TextureAtlas::Filter::Nearest, t.w, t.h);
+			t.heapIndex = t.region.heapIndex;
+			TextureAtlas::stage(cp.rgba.data(), t.w, t.h, mapped + offset);
+			atlas.record(cmd, staging, offset, t.region);
+			offset += static_cast<VkDeviceSize>(TextureAtlas::stagingBytes(t.w, t.h));
+			continue;
+		}
 
 		VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
 		ici.imageType = VK_IMAGE_TYPE_2D;
@@ -531,44 +564,31 @@ void SVG::uploadAllFramesGPU() {
 		ici.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-		VK_CHECK(vkCreateImage(dev, &ici, nullptr, &newTextures[i].image));
+		VK_CHECK(vkCreateImage(dev, &ici, nullptr, &t.image));
 
 		VkMemoryRequirements req{};
-		vkGetImageMemoryRequirements(dev, newTextures[i].image, &req);
+		vkGetImageMemoryRequirements(dev, t.image, &req);
 
 		VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
 		ai.allocationSize = req.size;
 		ai.memoryTypeIndex = Memory::findMemoryType(pdev, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK(vkAllocateMemory(dev, &ai, nullptr, &newTextures[i].memory));
-		VK_CHECK(vkBindImageMemory(dev, newTextures[i].image, newTextures[i].memory, 0));
-
-		VkBuffer staging{};
-		VkDeviceMemory stagingMem{};
-		VkDeviceSize bytes = static_cast<VkDeviceSize>(cp.rgba.size());
-		pipeline->createBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
-
-		void *p = nullptr;
-		VK_CHECK(vkMapMemory(dev, stagingMem, 0, VK_WHOLE_SIZE, 0, &p));
-		std::memcpy(p, cp.rgba.data(), cp.rgba.size());
-		vkUnmapMemory(dev, stagingMem);
-
-		transition(newTextures[i].image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		VK_CHECK(vkAllocateMemory(dev, &ai, nullptr, &t.memory));
+		VK_CHECK(vkBindImageMemory(dev, t.image, t.memory, 0));
 
-		copyBufferToImage(staging, newTextures[i].image, (uint32_t)cp.w, (uint32_t)cp.h);
-
-		transition(newTextures[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
-
-		vkDestroyBuffer(dev, staging, nullptr);
-		vkFreeMemory(dev, stagingMem, nullptr);
+		std::memcpy(mapped + offset, cp.rgba.data(), cp.rgba.size());
+		transition(cmd, t.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+		copyBufferToImage(cmd, staging, offset, t.image, (uint32_t)cp.w, (uint32_t)cp.h);
+		transition(cmd, t.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+		offset += static_cast<VkDeviceSize>(cp.rgba.size());
 
 		VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
 		vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		vci.image = newTextures[i].image;
+		vci.image = t.image;
 		vci.format = VK_FORMAT_B8G8R8A8_SRGB;
 		vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		vci.subresourceRange.levelCount = 1;
 		vci.subresourceRange.layerCount = 1;
-		VK_CHECK(vkCreateImageView(dev, &vci, nullptr, &newTextures[i].view));
+		VK_CHECK(vkCreateImageView(dev, &vci, nullptr, &t.view));
 
 		VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
 		sci.magFilter = VK_FILTER_NEAREST;
@@ -578,49 +598,54 @@ void SVG::uploadAllFramesGPU() {
 		sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 		sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 		sci.maxLod = 0.0f;
-		VK_CHECK(vkCreateSampler(dev, &sci, nullptr, &newTextures[i].sampler));
-
-		newTextures[i].w = (uint32_t)cp.w;
-		newTextures[i].h = (uint32_t)cp.h;
-
-		VkDescriptorImageInfo ii{};
-		ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		ii.imageView = newTextures[i].view;
-		ii.sampler = newTextures[i].sampler;
-		newInfos.push_back(ii);
+		VK_CHECK(vkCreateSampler(dev, &sci, nullptr, &t.sampler));
 	}
+	vkUnmapMemory(dev, stagingMem);
+	engine->getLogicalDevice().endSingleUseCmdGraphics(cmd); // waits for the copies
 
-	vkDeviceWaitIdle(dev);
-	for (auto &t : gpuTextures)
-		destroyTex(t);
-	gpuTextures = std::move(newTextures);
-	imageInfos = std::move(newInfos);
+	vkDestroyBuffer(dev, staging, nullptr);
+	vkFreeMemory(dev, stagingMem, nullptr);
 
-	ensureSet1Ready();
+	TextureHeap &heap = TextureHeap::get();
+	for (GpuTex &t : out)
+		if (!t.region.valid())
+			t.heapIndex = heap.add(t.view, t.sampler);
+	return out;
 }
 
-void SVG::destroyAllTextures() {
-	const auto &dev = engine->getDevice();
-	for (auto &t : gpuTextures) {
-		if (t.sampler) {
+void SVG::releaseTexture(GpuTex &t) {
+	if (t.region.valid()) { // the atlas keeps the cell until no frame in flight samples it
+		if (TextureAtlas *atlas = TextureAtlas::current())
+			atlas->release(t.region);
+		t = GpuTex{};
+		return;
+	}
+	auto destroy = [dev = engine->getDevice(), t] {
+		if (t.sampler)
 			vkDestroySampler(dev, t.sampler, nullptr);
-			t.sampler = VK_NULL_HANDLE;
-		}
-		if (t.view) {
+		if (t.view)
 			vkDestroyImageView(dev, t.view, nullptr);
-			t.view = VK_NULL_HANDLE;
-		}
-		if (t.image) {
+		if (t.image)
 			vkDestroyImage(dev, t.image, nullptr);
-			t.image = VK_NULL_HANDLE;
-		}
-		if (t.memory) {
+		if (t.memory)
 			vkFreeMemory(dev, t.memory, nullptr);
-			t.memory = VK_NULL_HANDLE;
-		}
-	}
-	gpuTextures.clear();
-	imageInfos.clear();
+	};
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(t.heapIndex, destroy);
+	else
+		destroy();
+	t = GpuTex{};
+}
+
+void SVG::destroyAllTextures() {
+	for (auto &kv : textures)
+		if (!kv.second.pending)
+			releaseTexture(kv.second.tex);
+	textures.clear();
+	lru.clear();
+	unusedBytes = 0;
+	if (placeholder.heapIndex != TextureHeap::kInvalid)
+		releaseTexture(placeholder);
 }
 
 void SVG::record(VkCommandBuffer cmd) {
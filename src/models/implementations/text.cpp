@@ -6,8 +6,10 @@
 #include "events.hpp"
 #include "memory.hpp"
 #include "mouse.hpp"
+#include "profiler.hpp"
 #include "rectangle.hpp"
 #include "scenes.hpp"
+#include "textureheap.hpp"
 
 #include <ft2build.h>
 #include <utility>
@@ -240,7 +242,6 @@ struct SharedAtlas {
 		int packRowH = 0;
 		std::vector<uint32_t> prewarmGlyphs;
 		uint32_t refCount = 0;
-		std::unordered_set<Text *> users;
 	};
 
 	std::unordered_map<std::string, FontAtlas> fonts;
@@ -271,11 +272,11 @@ static bool loadGlyphNoHint(FT_Face face, uint32_t cp) {
 	return true;
 }
 
-static std::u32string utf8_to_u32(const std::string &s) {
+static std::u32string utf8_to_u32(std::string_view s) {
 	std::u32string out;
 	std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> conv;
 	try {
-		out = conv.from_bytes(s);
+		out = conv.from_bytes(s.data(), s.data() + s.size());
 	} catch (...) {
 	}
 	return out;
@@ -287,6 +288,9 @@ static inline float modelScaleX(const glm::mat4 &M) {
 	return glm::length(ex);
 }
 
+// layoutFrom's soft wrap rule: a glyph that would cross the wrap width starts a new visual line (spaces never do)
+static inline bool wrapsBefore(float x, const Text::Glyph &g, char32_t c, float wrapLocal) { return wrapLocal > 0.f && (x + g.advanceX) > wrapLocal && c != U' '; }
+
 static inline float modelScaleY(const glm::mat4 &M) {
 	glm::vec3 ey(M[0][1], M[1][1], M[2][1]);
 	return glm::length(ey);
@@ -319,6 +323,29 @@ static inline bool rectsOverlap(const glm::vec4 &A, const glm::vec4 &B) {
 // =======================================================
 namespace {
 
+// Hand the atlas' GPU objects to the TextureHeap, which destroys them once no frame in flight samples them.
+void releaseAtlasGPU(Text::Atlas &atlas, VkDevice dev) {
+	auto destroy = [dev, image = atlas.image, memory = atlas.memory, view = atlas.view, sampler = atlas.sampler] {
+		if (view)
+			vkDestroyImageView(dev, view, nullptr);
+		if (image)
+			vkDestroyImage(dev, image, nullptr);
+		if (memory)
+			vkFreeMemory(dev, memory, nullptr);
+		if (sampler)
+			vkDestroySampler(dev, sampler, nullptr);
+	};
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(atlas.heapIndex, destroy);
+	else
+		destroy();
+	atlas.image = VK_NULL_HANDLE;
+	atlas.memory = VK_NULL_HANDLE;
+	atlas.view = VK_NULL_HANDLE;
+	atlas.sampler = VK_NULL_HANDLE;
+	atlas.heapIndex = TextureHeap::kInvalid;
+}
+
 // Upload new full atlas image for this font.
 void createAtlasGPUForFont(SharedAtlas::FontAtlas &fa, Text *self) {
 	if (!self || !self->getEngine())
@@ -327,26 +354,9 @@ void createAtlasGPUForFont(SharedAtlas::FontAtlas &fa, Text *self) {
 	VkDevice dev = self->getEngine()->getDevice();
 	VkPhysicalDevice phys = self->getEngine()->getPhysicalDevice();
 
-	// Tear down any previous image/view/sampler for this font.
-	if (fa.atlas.image || fa.atlas.view || fa.atlas.sampler || fa.atlas.memory) {
-		vkDeviceWaitIdle(dev);
-		if (fa.atlas.view) {
-			vkDestroyImageView(dev, fa.atlas.view, nullptr);
-			fa.atlas.view = VK_NULL_HANDLE;
-		}
-		if (fa.atlas.image) {
-			vkDestroyImage(dev, fa.atlas.image, nullptr);
-			fa.atlas.image = VK_NULL_HANDLE;
-		}
-		if (fa.atlas.memory) {
-			vkFreeMemory(dev, fa.atlas.memory, nullptr);
-			fa.atlas.memory = VK_NULL_HANDLE;
-		}
-		if (fa.atlas.sampler) {
-			vkDestroySampler(dev, fa.atlas.sampler, nullptr);
-			fa.atlas.sampler = VK_NULL_HANDLE;
-		}
-	}
+	// Retire any previous image/view/sampler for this font (frames in flight may still sample it).
+	if (fa.atlas.image || fa.atlas.view || fa.atlas.sampler || fa.atlas.memory)
+		releaseAtlasGPU(fa.atlas, dev);
 
 	if (fa.atlas.texW <= 0 || fa.atlas.texH <= 0 || fa.host.empty())
 		return;
@@ -428,13 +438,8 @@ void createAtlasGPUForFont(SharedAtlas::FontAtlas &fa, Text *self) {
 	sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 	VK_CHECK(vkCreateSampler(dev, &sci, nullptr, &fa.atlas.sampler));
 
-	// Atlas GPU handles changed → all Text instances using this font
-	// must refresh their descriptors for set=0,binding=2 (uAtlas).
-	for (Text *t : fa.users) {
-		if (!t)
-			continue;
-		t->writeAtlasDescriptor();
-	}
+	// Every Text using this font reads the new slot from its push constants on its next record().
+	fa.atlas.heapIndex = TextureHeap::get().add(fa.atlas.view, fa.atlas.sampler);
 }
 
 // Upload sub-rect for newly appended glyphs.
@@ -571,6 +576,7 @@ void rebuildFontAtlas(SharedAtlas::FontAtlas &fa, Text::FTData *ft, const std::u
 
 	fa.atlas.glyphs.clear();
 	fa.host.clear();
+	++fa.atlas.generation;
 
 	std::vector<uint32_t> glyphList(needSet.begin(), needSet.end());
 	std::sort(glyphList.begin(), glyphList.end());
@@ -701,27 +707,10 @@ Text::~Text() {
 			if (it != SA.fonts.end()) {
 				auto &fa = it->second;
 				if (fa.refCount > 0) {
-					fa.users.erase(this);
 					--fa.refCount;
 					if (fa.refCount == 0) {
-						vkDeviceWaitIdle(d);
 						// All Texts for this font are gone -> free GPU objects.
-						if (fa.atlas.view) {
-							vkDestroyImageView(d, fa.atlas.view, nullptr);
-							fa.atlas.view = VK_NULL_HANDLE;
-						}
-						if (fa.atlas.image) {
-							vkDestroyImage(d, fa.atlas.image, nullptr);
-							fa.atlas.image = VK_NULL_HANDLE;
-						}
-						if (fa.atlas.memory) {
-							vkFreeMemory(d, fa.atlas.memory, nullptr);
-							fa.atlas.memory = VK_NULL_HANDLE;
-						}
-						if (fa.atlas.sampler) {
-							vkDestroySampler(d, fa.atlas.sampler, nullptr);
-							fa.atlas.sampler = VK_NULL_HANDLE;
-						}
+						releaseAtlasGPU(fa.atlas, d);
 
 						fa.host.clear();
 						fa.atlas.glyphs.clear();
@@ -757,13 +746,14 @@ glm::vec2 Text::windowToViewportPx(float mx, float my) const {
 		return glm::vec2(0.0f);
 	}
 
-	int winW = 0, winH = 0;
+	VkExtent2D ext = engine->getExtent();
+
+	int winW = (int)ext.width, winH = (int)ext.height;
 	GLFWwindow *wnd = engine->getWindow();
 	if (wnd) {
 		glfwGetWindowSize(wnd, &winW, &winH);
 	}
 
-	VkExtent2D ext = engine->getSwapchain().getExtent();
 	const int sw = (int)ext.width;
 	const int sh = (int)ext.height;
 
@@ -823,17 +813,25 @@ void Text::setSelectionBoxPx(const glm::vec2 &startPx, const glm::vec2 &endPx) {
 
 void Text::clearSelectionBox() {
 	selectionBoxActive_ = false;
-	if (!selectionRanges.empty()) {
-		auto [first, last] = selectionRanges[0];
+	paintSelection(Colors::Transparent(0.0f));
+	selectionRanges.clear();
+}
+
+// Recolors the char hitboxes covered by selectionRanges.
+void Text::paintSelection(const glm::vec4 &color) {
+	if (!charHitboxes)
+		return;
+	auto boxes = charHitboxes->instances<Rectangle::InstanceData>();
+	for (auto [first, last] : selectionRanges) {
 		for (uint32_t i = static_cast<uint32_t>(first); i <= static_cast<uint32_t>(last) && i < lastcharInstanceCount_; ++i) {
 			Rectangle::InstanceData out{};
-			charHitboxes->getInstance(i, out);
-			out.color = Colors::Transparent(0.0f);
-			out.outlineColor = Colors::Transparent(0.0f);
-			charHitboxes->upsertInstance(i, out);
+			if (!boxes.get(int(i), out))
+				continue;
+			out.color = color;
+			out.outlineColor = color;
+			boxes.upsert(int(i), out);
 		}
 	}
-	selectionRanges.clear();
 }
 
 void Text::prewarmBasicLatinAndBox() {
@@ -856,18 +854,28 @@ void Text::prewarmBasicLatinAndBox() {
 
 vec4 Text::ansiIndexToColor(int idx, const vec4 &fallback) {
 	static const vec4 ansi[8] = {{0, 0, 0, 1}, {0.5, 0, 0, 1}, {0, 0.5, 0, 1}, {0.5, 0.5, 0, 1}, {0, 0, 0.65, 1}, {0.5, 0, 0.5, 1}, {0, 0.5, 0.5, 1}, {1, 1, 1, 1}};
+	static const vec4 bright[8] = {{0.5, 0.5, 0.5, 1}, {1, 0.3, 0.3, 1}, {0.3, 1, 0.3, 1}, {1, 1, 0.3, 1}, {0.4, 0.4, 1, 1}, {1, 0.3, 1, 1}, {0.3, 1, 1, 1}, {1, 1, 1, 1}};
+	if (idx >= 90 && idx <= 97)
+		return bright[idx - 90];
 	return (idx >= 30 && idx <= 37) ? ansi[idx - 30] : fallback;
 }
 
-std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
+std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const { return parseAnsiToRuns(text, baseColor, baseColor, runs, nullptr); }
+
+std::u32string Text::parseAnsiToRuns(const std::string &text, const vec4 &baseColor, std::vector<ColorRun> &runs) { return parseAnsiToRuns(text, baseColor, baseColor, runs, nullptr); }
+
+std::u32string Text::parseAnsiToRuns(std::string_view text, const vec4 &baseColor, const vec4 &startColor, std::vector<ColorRun> &runs, std::vector<AnsiLineStart> *lines) {
 	const std::u32string src = utf8_to_u32(text);
 	runs.clear();
+	if (lines)
+		lines->clear();
 
 	std::u32string clean;
 	clean.reserve(src.size());
 
-	vec4 current = baseColor;
+	vec4 current = startColor;
 	size_t runStart = 0; // index in 'clean' (not in 'src')
+	size_t srcByte = 0;	 // UTF-8 offset just past src[i] (for `lines`)
 
 	auto push_run = [&](size_t from, size_t to, const vec4 &col) {
 		if (to > from)
@@ -883,6 +891,7 @@ std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
 
 	for (size_t i = 0; i < src.size(); ++i) {
 		char32_t c = src[i];
+		srcByte += c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
 
 		if (state == NORMAL) {
 			// IMPORTANT: handle ESC before generic C0 filtering,
@@ -900,6 +909,8 @@ std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
 			if (c < 0x20 && c != U'\n' && c != U'\t')
 				continue;
 			clean.push_back(c);
+			if (c == U'\n' && lines)
+				lines->push_back({srcByte, current});
 			continue;
 		}
 
@@ -944,8 +955,7 @@ std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
 				} else if (code >= 30 && code <= 37) {
 					current = ansiIndexToColor(code, baseColor);
 				} else if (code >= 90 && code <= 97) {
-					// bright versions; map as you like
-					current = ansiIndexToColor(code, baseColor); // or a brighter palette
+					current = ansiIndexToColor(code, baseColor); // bright palette (bold / reverse terminal cells)
 				} else if (code == 22) {
 					// normal intensity (undo bold); if you track bold, clear it here
 					// (no color change needed)
@@ -967,6 +977,7 @@ std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
 				// peek next char if present
 				if (i + 1 < src.size() && src[i + 1] == U'\\') {
 					++i;
+					++srcByte;
 					state = NORMAL;
 					continue;
 				} else {
@@ -982,6 +993,7 @@ std::u32string Text::parseAnsiToRuns(std::vector<ColorRun> &runs) const {
 			if (c == U'\033') {
 				if (i + 1 < src.size() && src[i + 1] == U'\\') {
 					++i;
+					++srcByte;
 					state = NORMAL;
 				}
 				// else remain in ST_STRING (payload continues)
@@ -1087,8 +1099,13 @@ std::vector<uint8_t> Text::bitmapToSDF(const uint8_t *alpha, int w, int h, int s
 // We now use a shared per-font atlas. This method only ensures that
 // the shared atlas for this font has all glyphs that this Text needs.
 void Text::ensureAtlas() {
+	std::vector<ColorRun> runs;
+	ensureGlyphs(parseAnsiToRuns(runs));
+}
+
+bool Text::ensureGlyphs(const std::u32string &u32) {
 	if (!ft || !ft->face)
-		return;
+		return false;
 
 	auto &SA = getSharedAtlas();
 	std::lock_guard<std::mutex> lock(SA.mtx);
@@ -1097,16 +1114,13 @@ void Text::ensureAtlas() {
 	// First time this Text touches this font's atlas: bump refcount
 	if (!registeredInSharedAtlas_) {
 		++fa.refCount;
-		fa.users.insert(this);
 		registeredInSharedAtlas_ = true;
 	}
 
 	// Point this instance to the shared Atlas struct.
 	atlas = &fa.atlas;
 
-	// Parse text & collect glyphs we need
-	std::vector<ColorRun> runs;
-	std::u32string u32 = parseAnsiToRuns(runs);
+	// Collect glyphs we need
 	std::unordered_set<uint32_t> need;
 
 	for (auto c : u32) {
@@ -1138,7 +1152,7 @@ void Text::ensureAtlas() {
 
 		if (!needFullRepack) {
 			// Nothing else to do; GPU already updated for appended glyphs.
-			return;
+			return false;
 		}
 
 		// Out of room → fall back to a full repack with the superset.
@@ -1149,34 +1163,11 @@ void Text::ensureAtlas() {
 	// Full build (initial or after repack), with a deterministic glyph order.
 	rebuildFontAtlas(fa, ft.get(), need, this);
 	atlas = &fa.atlas;
-}
-
-void Text::writeAtlasDescriptor() {
-	if (!pipeline)
-		return;
-	auto &sets = pipeline->descriptorSets.descriptorSets;
-	if (sets.empty() || sets[0] == VK_NULL_HANDLE)
-		return;
-	if (!atlas || !atlas->sampler || !atlas->view)
-		return;
-
-	VkDescriptorImageInfo ii{};
-	ii.sampler = atlas->sampler;
-	ii.imageView = atlas->view;
-	ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-	w.dstSet = sets[0];
-	w.dstBinding = 2; // matches your FS: layout(set=0, binding=2)
-	w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	w.descriptorCount = 1;
-	w.pImageInfo = &ii;
-
-	vkUpdateDescriptorSets(pipeline->device, 1, &w, 0, nullptr);
+	return true;
 }
 
 // ---------------- Layout & geometry ----------------
-void Text::buildCharVisualAndHitboxes(const std::vector<glm::vec4> &chars) {
+void Text::buildCharVisualAndHitboxes(const std::vector<glm::vec4> &chars, size_t from) {
 	if (!charHitboxes) {
 		charHitboxes = std::make_unique<Rectangle>(scene);
 		charHitboxes->setMaxInstances(65535);
@@ -1189,18 +1180,7 @@ void Text::buildCharVisualAndHitboxes(const std::vector<glm::vec4> &chars) {
 			charHitboxes->setViewport(viewport.width, viewport.height, viewport.x, viewport.y);
 		};
 
-		charHitboxes->onTick = [&](Model *m, double, double t) {
-			if (!selectionRanges.empty()) {
-				auto [first, last] = selectionRanges[0];
-				for (uint32_t i = static_cast<uint32_t>(first); i <= static_cast<uint32_t>(last) && i < lastcharInstanceCount_; ++i) {
-					Rectangle::InstanceData out{};
-					m->getInstance(i, out);
-					out.color = selectionColor;
-					out.outlineColor = selectionColor;
-					m->upsertInstance(i, out);
-				}
-			}
-		};
+		charHitboxes->onTick = [&](Model *m, double, double t) { paintSelection(selectionColor); };
 
 		charHitboxesInited_ = true;
 	}
@@ -1213,7 +1193,7 @@ void Text::buildCharVisualAndHitboxes(const std::vector<glm::vec4> &chars) {
 	const float minHitboxLocalW = 8.0f * onePxLocalX; // ~8 px wide
 	const float minHeightLocal = 1.0f * onePxLocalY;  // ≥1 px tall
 
-	size_t i = 0;
+	size_t i = from; // instances before `from` are unchanged
 	for (; i < chars.size(); ++i) {
 		const glm::vec4 r = chars[i]; // x0,y0,x1,y1 (y may be inverted)
 		const float x0 = r.x;
@@ -1252,7 +1232,7 @@ void Text::buildCharVisualAndHitboxes(const std::vector<glm::vec4> &chars) {
 	lastcharInstanceCount_ = chars.size();
 }
 
-void Text::buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets) {
+void Text::buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets, size_t from) {
 	textLength_ = static_cast<uint32_t>(carets.size());
 
 	if (!caretHitboxes) {
@@ -1286,7 +1266,7 @@ void Text::buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets) {
 	const float minHitboxLocalW = 8.0f * onePxLocalX; // ~8 px wide
 	const float minHeightLocal = 1.0f * onePxLocalY;  // ≥1 px tall
 
-	size_t i = 0;
+	size_t i = from; // instances before `from` are unchanged
 	for (; i < carets.size(); ++i) {
 		const glm::vec4 r = carets[i]; // x0,y0,x1,y1 (y may be inverted)
 		const float x0 = r.x;
@@ -1326,47 +1306,23 @@ void Text::buildCaretVisualAndHitboxes(const std::vector<glm::vec4> &carets) {
 	lastCaretInstanceCount_ = carets.size();
 }
 
-vec2 Text::measureTextBox(std::u32string &u32) {
-	if (!atlas)
-		return {0, 0};
-
-	float x = 0, y = 0, maxX = 0;
-	float lh = (float)ft->pixelHeight + lineSpacing;
-	for (auto c : u32) {
-		if (c == U'\n') {
-			y += lh;
-			x = 0;
-			continue;
-		}
-		auto it = atlas->glyphs.find((uint32_t)c);
-		if (it == atlas->glyphs.end())
-			continue;
-		x += (float)it->second.advanceX;
-		if (x > maxTextWidthPx && maxTextWidthPx > 0) {
-			y += lh;
-			x = 0;
-		}
-		maxX = std::max(maxX, x);
-	}
-	return {maxX, y + lh};
-}
-
 void Text::layoutAndBuild() {
-	// --- Clear CPU geometry ---
-	cpuVerts.clear();
-	cpuIdx.clear();
+	PROFILE_SCOPE("Text::layoutAndBuild");
 
-	charRects.clear();
-
-	// Global bounds of all glyph quads in LOCAL space.
-	// Used by billboard mode to normalize inPos to [-0.5, 0.5].
-	float textMinX = std::numeric_limits<float>::infinity();
-	float textMinY = std::numeric_limits<float>::infinity();
-	float textMaxX = -std::numeric_limits<float>::infinity();
-	float textMaxY = -std::numeric_limits<float>::infinity();
+	lineCheckpoints_.clear();
+	dirtyVertFrom_ = dirtyIdxFrom_ = 0;
+	layoutFrom(0);
+}
 
+void Text::layoutFrom(size_t checkpoint) {
 	if (!atlas || atlas->glyphs.empty()) {
 		// Nothing to render yet; keep geometry empty.
+		cpuVerts.clear();
+		cpuIdx.clear();
+		charRects.clear();
+		caretSlots_.clear();
+		caretBaselines_.clear();
+		lineCheckpoints_.clear();
 		pc.textOriginX = 0.0f;
 		pc.textOriginY = 0.0f;
 		pc.textExtentX = 1.0f;
@@ -1384,41 +1340,62 @@ void Text::layoutAndBuild() {
 	// Vertical “trim” so boxes don’t graze glyph pixels
 	const float yTightPad = 1.0f * onePxLocalY;
 
-	// --- Parse text & ANSI color runs ---
-	std::vector<ColorRun> runs;
-	std::u32string u32 = parseAnsiToRuns(runs);
-
-	contentHeightPx_ = measureTextBox(u32).y;
-
-	std::vector<vec4> colorOf(u32.size(), baseColor);
-	for (const auto &r : runs)
-		for (size_t i = r.start; i < r.end && i < colorOf.size(); ++i)
-			colorOf[i] = r.color;
-
 	// --- Line metrics ---
 	const float lh = (float)ft->pixelHeight + lineSpacing;
 	const float ascent = (float)ft->face->size->metrics.ascender / 64.0f;
 	const float descent = (float)std::abs(ft->face->size->metrics.descender / 64.0f);
 
-	// --- Accumulate geometry in two buckets (decorations first) ---
-	std::vector<Vertex> decoVerts, glyphVerts;
-	std::vector<uint32_t> decoIdx, glyphIdx;
+	layoutModel_ = pc.model;
+	layoutAtlasGeneration_ = atlas->generation;
+
+	// --- Resume point: first line of the text, or the start of the line an edit touched ---
+	if (lineCheckpoints_.empty()) {
+		const float inf = std::numeric_limits<float>::infinity();
+		decoVerts_ = caretOn ? 4u : 0u; // caret quad goes first (drawn under the glyphs)
+		LineCheckpoint first;
+		first.color = baseColor;
+		first.verts = decoVerts_;
+		first.idx = decoVerts_ ? 6u : 0u;
+		first.y = ascent - scrollOffsetPx_;
+		first.bounds = vec4(inf, inf, -inf, -inf);
+		lineCheckpoints_.push_back(first);
+		checkpoint = 0;
+	}
+	const LineCheckpoint cp = lineCheckpoints_[checkpoint];
+	lineCheckpoints_.resize(checkpoint + 1);
 
-	auto addQuad = [](std::vector<Vertex> &V, std::vector<uint32_t> &I, const Vertex q[4]) {
-		uint32_t base = (uint32_t)V.size();
-		V.insert(V.end(), q, q + 4);
-		I.insert(I.end(), {base + 0, base + 1, base + 2, base + 0, base + 2, base + 3});
-	};
+	cpuVerts.resize(cp.verts);
+	cpuIdx.resize(cp.idx);
+	caretSlots_.resize(cp.carets);
+	caretBaselines_.resize(cp.carets);
+	charRects.resize(cp.chars);
+	dirtyVertFrom_ = std::min(dirtyVertFrom_, size_t(cp.verts));
+	dirtyIdxFrom_ = std::min(dirtyIdxFrom_, size_t(cp.idx));
+
+	// Global bounds of all glyph quads in LOCAL space.
+	// Used by billboard mode to normalize inPos to [-0.5, 0.5].
+	float textMinX = cp.bounds.x;
+	float textMinY = cp.bounds.y;
+	float textMaxX = cp.bounds.z;
+	float textMaxY = cp.bounds.w;
+
+	// --- Parse text & ANSI color runs (from the resume point on) ---
+	std::vector<ColorRun> runs;
+	std::vector<AnsiLineStart> lineStarts;
+	std::u32string u32 = parseAnsiToRuns(std::string_view(text).substr(cp.srcByte), baseColor, cp.color, runs, &lineStarts);
+
+	std::vector<vec4> colorOf(u32.size(), cp.color);
+	for (const auto &r : runs)
+		for (size_t i = r.start; i < r.end && i < colorOf.size(); ++i)
+			colorOf[i] = r.color;
 
-	auto pushCaretQuad = [&](glm::vec4 r, const vec4 &color) {
-		Vertex q[4]{{{r.x, r.y}, {0, 0}, color, 0.0f}, {{r.z, r.y}, {0, 0}, color, 0.0f}, {{r.z, r.w}, {0, 0}, color, 0.0f}, {{r.x, r.w}, {0, 0}, color, 0.0f}};
-		addQuad(decoVerts, decoIdx, q);
+	auto pushQuad = [&](const Vertex q[4]) {
+		uint32_t base = (uint32_t)cpuVerts.size();
+		cpuVerts.insert(cpuVerts.end(), q, q + 4);
+		cpuIdx.insert(cpuIdx.end(), {base + 0, base + 1, base + 2, base + 0, base + 2, base + 3});
 	};
 
-	std::vector<glm::vec4> caretSlots;
 	std::vector<float> caretCentersOnLine;
-	std::vector<float> caretBaselines;
-	std::vector<float> caretHeightsPx;
 	std::vector<float> caretHeightsOnLine;
 
 	// Per-line bitmap bounds (loose = SDF bitmap; tight = bitmap minus SDF spread)
@@ -1475,9 +1452,7 @@ void Text::layoutAndBuild() {
 			{{x1, y1}, {u1, v1}, col, g.sdfSpreadPx},
 			{{x0, y1}, {u0, v1}, col, g.sdfSpreadPx},
 		};
-		uint32_t base = (uint32_t)glyphVerts.size();
-		glyphVerts.insert(glyphVerts.end(), q, q + 4);
-		glyphIdx.insert(glyphIdx.end(), {base + 0, base + 1, base + 2, base + 0, base + 2, base + 3});
+		pushQuad(q);
 	};
 
 	auto finalizeLine = [&](float baseY) {
@@ -1490,11 +1465,6 @@ void Text::layoutAndBuild() {
 			return;
 		}
 
-		// Compute a single max height-above-baseline for the entire line
-		float maxH = 0.0f;
-		for (float h : caretHeightsOnLine)
-			maxH = std::max(maxH, h);
-
 		// Prefer tight union; fallback to metrics trimmed by spread
 		float y0, y1;
 		if (lineTopBoundTight < lineBotBoundTight) {
@@ -1557,9 +1527,8 @@ void Text::layoutAndBuild() {
 					right = mid + 0.5f * minWLocal;
 				}
 
-				caretSlots.emplace_back(left, y0, right, y1);
-				caretBaselines.push_back(baseY);
-				caretHeightsPx.push_back(maxH);
+				caretSlots_.emplace_back(left, y0, right, y1);
+				caretBaselines_.push_back(baseY);
 			}
 		}
 
@@ -1573,11 +1542,14 @@ void Text::layoutAndBuild() {
 		lineBotBoundTight = -std::numeric_limits<float>::infinity();
 	};
 
-	float x = 0.f, y = ascent - scrollOffsetPx_;
+	float x = 0.f, y = cp.y;
 	pushCaretCenter(0.f);
 	pushCaretHeight(0.0f);
 
-	// Selection accumulator
+	// content height: a line per '\n' and one more whenever the advance overflows maxTextWidthPx (resumed)
+	float measureX = 0.f, measureY = cp.measureY;
+	size_t nextLineStart = 0;
+
 	for (size_t i = 0; i < u32.size(); ++i) {
 		const char32_t c = u32[i];
 
@@ -1588,6 +1560,24 @@ void Text::layoutAndBuild() {
 			y += lh;
 			pushCaretCenter(0.f);
 			pushCaretHeight(0.0f);
+			measureX = 0.f;
+			measureY += lh;
+
+			// everything from here on can be re-laid out without touching earlier lines
+			if (nextLineStart < lineStarts.size()) {
+				const AnsiLineStart &ls = lineStarts[nextLineStart++];
+				LineCheckpoint next;
+				next.srcByte = cp.srcByte + ls.srcByte;
+				next.color = ls.color;
+				next.verts = (uint32_t)cpuVerts.size();
+				next.idx = (uint32_t)cpuIdx.size();
+				next.carets = (uint32_t)caretSlots_.size();
+				next.chars = (uint32_t)charRects.size();
+				next.y = y;
+				next.measureY = measureY;
+				next.bounds = vec4(textMinX, textMinY, textMaxX, textMaxY);
+				lineCheckpoints_.push_back(next);
+			}
 			continue;
 		}
 
@@ -1596,8 +1586,14 @@ void Text::layoutAndBuild() {
 			continue;
 		const Glyph &g = itg->second;
 
+		measureX += (float)g.advanceX;
+		if (measureX > maxTextWidthPx && maxTextWidthPx > 0) {
+			measureY += lh;
+			measureX = 0.f;
+		}
+
 		// Optional wrapping
-		if (wrapLocal > 0.f && (x + g.advanceX) > wrapLocal && c != U' ') {
+		if (wrapsBefore(x, g, c, wrapLocal)) {
 			pushCaretCenter(x);
 			finalizeLine(y);
 			x = 0.f;
@@ -1622,28 +1618,10 @@ void Text::layoutAndBuild() {
 		x = nx;
 	}
 	finalizeLine(y);
+	lastBaselineY_ = y;
+	contentHeightPx_ = measureY + lh;
 
-	// Active caret visual: 1 px wide, shifted left by its width and up by (origin - yMin)
-	if (caretOn && caretPosition < caretSlots.size()) {
-		const auto r = caretSlots[caretPosition];
-		const float cx = 0.5f * (r.x + r.z);
-		// baseline and per-slot height (pixels)
-		const float baseline = (caretPosition < caretBaselines.size()) ? caretBaselines[caretPosition] : y;
-		const float t = (float)ft->face->size->metrics.ascender / 64.0f;
-		const float b = (float)-ft->face->size->metrics.descender / 64.0f; // descender is negative
-		const float yTop = baseline - t;
-		const float yBot = baseline + b;
-		const float halfW = 1.0f * onePxLocalX;
-		pushCaretQuad({cx - halfW + onePxLocalX, yTop, cx + halfW + onePxLocalX, yBot}, caretColor);
-	}
-
-	// Concatenate: decorations first, then glyphs
-	cpuVerts = std::move(decoVerts);
-	cpuIdx = std::move(decoIdx);
-	const uint32_t base = (uint32_t)cpuVerts.size();
-	cpuVerts.insert(cpuVerts.end(), glyphVerts.begin(), glyphVerts.end());
-	for (uint32_t i : glyphIdx)
-		cpuIdx.push_back(base + i);
+	writeCaretQuad();
 
 	// Store text center/extent in push constants (reusing TextPC::_pad[]):
 	//   textOriginX/Y = origin, textExtentX/Y = extents
@@ -1665,16 +1643,146 @@ void Text::layoutAndBuild() {
 	}
 
 	if (features.selection) {
-		buildCharVisualAndHitboxes(charRects);
+		buildCharVisualAndHitboxes(charRects, cp.chars);
 	}
 
 	if (features.caret) {
-		buildCaretVisualAndHitboxes(caretSlots);
+		buildCaretVisualAndHitboxes(caretSlots_, cp.carets);
+	}
+}
+
+// Active caret visual: 1 px wide, shifted left by its width and up by (origin - yMin).
+// Lives in cpuVerts[0..3] so moving it never touches the glyph geometry.
+void Text::writeCaretQuad() {
+	if (decoVerts_ == 0 || cpuVerts.size() < 4 || cpuIdx.size() < 6)
+		return;
+
+	Vertex q[4]{}; // zero-area when the caret has no slot
+	if (caretPosition < caretSlots_.size()) {
+		const float onePxLocalX = 1.0f / std::max(1e-6f, modelScaleX(layoutModel_));
+		const auto r = caretSlots_[caretPosition];
+		const float cx = 0.5f * (r.x + r.z);
+		// baseline and per-slot height (pixels)
+		const float baseline = (caretPosition < caretBaselines_.size()) ? caretBaselines_[caretPosition] : lastBaselineY_;
+		const float t = (float)ft->face->size->metrics.ascender / 64.0f;
+		const float b = (float)-ft->face->size->metrics.descender / 64.0f; // descender is negative
+		const float yTop = baseline - t;
+		const float yBot = baseline + b;
+		const float halfW = 1.0f * onePxLocalX;
+		const glm::vec4 rc{cx - halfW + onePxLocalX, yTop, cx + halfW + onePxLocalX, yBot};
+		q[0] = {{rc.x, rc.y}, {0, 0}, caretColor, 0.0f};
+		q[1] = {{rc.z, rc.y}, {0, 0}, caretColor, 0.0f};
+		q[2] = {{rc.z, rc.w}, {0, 0}, caretColor, 0.0f};
+		q[3] = {{rc.x, rc.w}, {0, 0}, caretColor, 0.0f};
+	}
+	std::copy(q, q + 4, cpuVerts.begin());
+	const uint32_t idx[6] = {0, 1, 2, 0, 2, 3};
+	std::copy(idx, idx + 6, cpuIdx.begin());
+	caretDirty_ = true;
+}
+
+// Per visual line layoutFrom emits a caret at the start, one after every glyph and one at the end, and one char
+// cell fewer: a cell per glyph plus the one that ends the line (at a '\n' or a soft wrap).
+Text::LinePos Text::locateInLine(std::u32string_view line, size_t column, const std::unordered_map<uint32_t, Glyph> &glyphs, float wrapLocal) {
+	LinePos pos;
+	float x = 0.f;
+	for (size_t i = 0; i < line.size() && i <= column; ++i) {
+		auto it = glyphs.find((uint32_t)line[i]);
+		if (it == glyphs.end())
+			continue;
+		const bool wrap = wrapsBefore(x, it->second, line[i], wrapLocal);
+		if (i == column) {
+			pos.wrapsHere = wrap;
+			break;
+		}
+		if (wrap) {
+			++pos.wraps;
+			x = 0.f;
+		}
+		++pos.glyphs;
+		x += (float)it->second.advanceX;
+	}
+	return pos;
+}
+
+Text::LinePos Text::locate(size_t line, size_t column, size_t &caretBase, size_t &charBase) {
+	if (!layoutCurrent()) {
+		needRebuild = true;
+		rebuild();
 	}
+	caretBase = caretSlots_.size();
+	charBase = charRects.size();
+	if (!atlas || line >= lineCheckpoints_.size())
+		return {};
+
+	const LineCheckpoint &cp = lineCheckpoints_[line];
+	caretBase = cp.carets;
+	charBase = cp.chars;
+	const size_t end = line + 1 < lineCheckpoints_.size() ? lineCheckpoints_[line + 1].srcByte - 1 : text.size(); // without the '\n'
+	std::vector<ColorRun> runs;
+	const std::u32string u32 = parseAnsiToRuns(std::string_view(text).substr(cp.srcByte, end - cp.srcByte), baseColor, cp.color, runs, nullptr);
+	const float wrapLocal = maxTextWidthPx > 0.f ? (maxTextWidthPx / std::max(1e-6f, modelScaleX(pc.model))) : 0.f;
+	return locateInLine(u32, column, atlas->glyphs, wrapLocal);
+}
+
+size_t Text::caretIndexAt(size_t line, size_t column) {
+	size_t caretBase = 0, charBase = 0;
+	const LinePos p = locate(line, column, caretBase, charBase);
+	return caretBase + p.glyphs + 2 * (p.wraps + (p.wrapsHere ? 1 : 0));
+}
+
+pair<size_t, size_t> Text::charRangeAt(size_t line, size_t columnBegin, size_t columnEnd) {
+	size_t caretBase = 0, charBase = 0;
+	const LinePos b = locate(line, columnBegin, caretBase, charBase);
+	const LinePos e = locate(line, columnEnd, caretBase, charBase);
+	const size_t first = charBase + b.glyphs + b.wraps + (b.wrapsHere ? 1 : 0);
+	const size_t last = charBase + e.glyphs + e.wraps; // cells before columnEnd, not counting a wrap it starts
+	return {first, std::max(first, last)};
+}
+
+bool Text::layoutCurrent() const { return !needRebuild && !needAtlas && atlas && !lineCheckpoints_.empty() && layoutAtlasGeneration_ == atlas->generation && layoutModel_ == pc.model; }
+
+void Text::replaceTail(size_t keepBytes, std::string_view utf8) {
+	PROFILE_SCOPE("Text::replaceTail");
+
+	keepBytes = std::min(keepBytes, text.size());
+	const bool incremental = layoutCurrent();
+	text.resize(keepBytes);
+	text.append(utf8);
+
+	if (!incremental) {
+		needAtlas = true;
+		needRebuild = true;
+		rebuild();
+		return;
+	}
+
+	// last line start at or before the edit (checkpoint 0 is the start of the text)
+	auto it = std::upper_bound(lineCheckpoints_.begin(), lineCheckpoints_.end(), keepBytes, [](size_t b, const LineCheckpoint &c) { return b < c.srcByte; });
+	const size_t k = size_t(it - lineCheckpoints_.begin()) - 1;
+
+	std::vector<ColorRun> runs;
+	if (ensureGlyphs(parseAnsiToRuns(std::string_view(text).substr(lineCheckpoints_[k].srcByte), baseColor, baseColor, runs, nullptr)))
+		layoutAndBuild(); // atlas repacked: every glyph's UVs moved
+	else
+		layoutFrom(k);
+	updateBuffersGPU();
+}
+
+void Text::setCaretOnly(size_t pos) {
+	caretPosition = (uint32_t)pos;
+	if (!layoutCurrent()) {
+		needRebuild = true;
+		rebuild();
+		return;
+	}
+	writeCaretQuad();
+	updateBuffersGPU();
 }
 
 // ---------------- Upload VB/IB (host visible) ----------------
 void Text::uploadVBIB() {
+	PROFILE_SCOPE("Text::uploadVBIB");
 	using F = VkFormat;
 
 	initInfo.mesh.vsrc.data = nullptr;
@@ -1699,7 +1807,7 @@ void Text::init() {
 	pipeline->graphicsPipeline.colorFormat = engine->getGraphicsBuffer().getSceneColorFormat();
 	pipeline->graphicsPipeline.depthFormat = engine->getGraphicsBuffer().getDepthFormat();
 
-	auto ext = engine->getSwapchain().getExtent();
+	auto ext = engine->getExtent();
 	setViewport((float)ext.width, (float)ext.height);
 
 	// Build the shared atlas BEFORE descriptor allocation
@@ -1711,7 +1819,7 @@ void Text::init() {
 	layoutAndBuild();
 	uploadVBIB();
 
-	initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/text", pipeline->device);
+	initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/text", pipeline->device);
 	initInfo.maxInstances = 1;
 	initInfo.instanceStrideBytes = 0;
 
@@ -1723,71 +1831,23 @@ void Text::init() {
 	// Allocates descriptor sets
 	Model::init();
 
-	// NOW sets exist → bind the atlas
-	writeAtlasDescriptor();
-
 	// Enable features if any
 	enableFeatures();
 }
 
-void Text::setSelection(const std::vector<pair<size_t, size_t>> &ranges) { selectionRanges = ranges; }
-
-// ========================= Overridden hooks =========================
-uint32_t Text::createDescriptorPool() {
-	// First let Model add UBO + SSBO pool sizes
-	uint32_t baseSets = Model::createDescriptorPool();
-
-	// We need capacity for the atlas sampler at set=0, binding=2
-	pipeline->descriptorPoolSizes.push_back(VkDescriptorPoolSize{
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		1 // we only have one sampler in this set
-	});
-
-	// We only actually use set=0, so 1 is enough,
-	// but returning baseSets (2) is also fine.
-	return baseSets; // or just return 1;
+void Text::setSelection(const std::vector<pair<size_t, size_t>> &ranges) {
+	paintSelection(Colors::Transparent(0.0f)); // un-highlight the previous ranges
+	selectionRanges = ranges;
 }
 
+// ========================= Overridden hooks =========================
 void Text::createDescriptors() {
-	// Add binding=2 in set=0 exactly once (Model owns binding=0 UBO)
-	if (!addedBinding2) {
-		pipeline->createDescriptorSetLayoutBinding(
-			/*binding*/ 2,
-			/*type*/ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			/*stages*/ VK_SHADER_STAGE_FRAGMENT_BIT,
-			/*count*/ 1,
-			/*set*/ 0);
-		addedBinding2 = true;
-	}
+	// set=1: the engine-wide bindless texture table; the font atlas slot is pushed as pc.atlasIndex
+	const TextureHeap &heap = TextureHeap::get();
+	pipeline->useSharedSet(TextureHeap::kSet, heap.layout(), heap.set());
 
-	// Let the base allocate pool+sets
+	// set=0 (UBO)
 	Model::createDescriptors();
-
-	// Now it’s safe to write binding=2 if the atlas exists.
-	if (!pipeline)
-		return;
-	auto &sets = pipeline->descriptorSets.descriptorSets;
-	if (sets.empty() || sets[0] == VK_NULL_HANDLE)
-		return;
-	if (!atlas || !atlas->sampler || !atlas->view)
-		return;
-
-	// simple safety for engines without per-frame descriptor mgmt
-	vkDeviceWaitIdle(pipeline->device);
-
-	VkDescriptorImageInfo ii{};
-	ii.sampler = atlas->sampler;
-	ii.imageView = atlas->view;
-	ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-	w.dstSet = sets[0];
-	w.dstBinding = 2;
-	w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	w.descriptorCount = 1;
-	w.pImageInfo = &ii;
-
-	vkUpdateDescriptorSets(pipeline->device, 1, &w, 0, nullptr);
 }
 
 void Text::createGraphicsPipeline() {
@@ -1814,7 +1874,7 @@ void Text::updateBuffersGPU() {
 
 	// 2) Reserve (or reuse) our slice
 	//    - If we already have enough capacity, keep offsets and just upload into them.
-	//    - Else, free the old slice and grab a new one.
+	//    - Else, free the old slice and grab a new one (with headroom, so appends don't move it every time).
 	auto needV = vbytes;
 	auto needI = ibytes;
 	bool needNew = (!arenaAllocated_) || (needV > vbCapacity_) || (needI > ibCapacity_);
@@ -1824,15 +1884,25 @@ void Text::updateBuffersGPU() {
 		vbOffset_ = ibOffset_ = vbCapacity_ = ibCapacity_ = 0;
 	}
 	if (needNew) {
-		if (!SharedTextArena::inst().alloc(needV, needI, vbOffset_, ibOffset_, vbCapacity_, ibCapacity_)) {
+		auto &arena = SharedTextArena::inst();
+		if (!arena.alloc(needV + needV / 2, needI + needI / 2, vbOffset_, ibOffset_, vbCapacity_, ibCapacity_) && !arena.alloc(needV, needI, vbOffset_, ibOffset_, vbCapacity_, ibCapacity_)) {
 			std::cerr << "TextArenaOutOfMemory" << std::endl;
 			exit(0);
 		}
 		arenaAllocated_ = true;
+		dirtyVertFrom_ = dirtyIdxFrom_ = 0; // fresh slice: everything goes up
 	}
 
-	// 3) Upload into our slice
-	SharedTextArena::inst().upload(engine.get(), cpuVerts.data(), vbytes, vbOffset_, cpuIdx.data(), ibytes, ibOffset_);
+	// 3) Upload into our slice: the re-laid-out tail, plus the caret quad in front of it
+	auto &arena = SharedTextArena::inst();
+	const size_t vFrom = std::min(dirtyVertFrom_, cpuVerts.size());
+	const size_t iFrom = std::min(dirtyIdxFrom_, cpuIdx.size());
+	if (caretDirty_ && decoVerts_ && vFrom > 0)
+		arena.upload(engine.get(), cpuVerts.data(), decoVerts_ * sizeof(Vertex), vbOffset_, cpuIdx.data(), 6 * sizeof(uint32_t), ibOffset_);
+	arena.upload(engine.get(), cpuVerts.data() + vFrom, (cpuVerts.size() - vFrom) * sizeof(Vertex), vbOffset_ + vFrom * sizeof(Vertex), cpuIdx.data() + iFrom, (cpuIdx.size() - iFrom) * sizeof(uint32_t), ibOffset_ + iFrom * sizeof(uint32_t));
+	dirtyVertFrom_ = cpuVerts.size();
+	dirtyIdxFrom_ = cpuIdx.size();
+	caretDirty_ = false;
 
 	indexCount = (uint32_t)cpuIdx.size();
 }
@@ -1852,8 +1922,8 @@ void Text::setLocation(const vec3 &location) {
 	model = glm::scale(model, {s, s, 1.0f});
 	setModel(model);
 }
-void Text::setText(const std::string &utf8) {
-	text = utf8;
+void Text::setText(std::string_view utf8) {
+	text.assign(utf8);
 	// We recompute needed glyphs lazily in ensureAtlas().
 	needAtlas = true;
 	needRebuild = true;
@@ -2024,22 +2094,22 @@ void Text::record(VkCommandBuffer cmd) {
 	if (!SharedTextArena::inst().inited || indexCount == 0)
 		return;
 
-	vkCmdSetViewport(cmd, 0, 1, &viewport);
-	vkCmdSetScissor(cmd, 0, 1, &scissor);
+	BindCache &binds = scene->getScenes().bindCache();
+	binds.viewport(cmd, viewport);
+	binds.scissor(cmd, scissor);
 
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
-	if (!dsets.empty()) {
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout, 0, static_cast<uint32_t>(dsets.size()), dsets.data(), static_cast<uint32_t>(dynOffsets.size()), dynOffsets.empty() ? nullptr : dynOffsets.data());
-	}
+	binds.pipeline(cmd, pipe);
+	binds.descriptorSets(cmd, pipeLayout, dsets, dynOffsets);
 
+	pc.atlasIndex = (atlas && atlas->heapIndex != TextureHeap::kInvalid) ? atlas->heapIndex : 0u;
 	vkCmdPushConstants(cmd, pipeLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(TextPC), &pc);
 
 	// Bind shared arena buffers at our slice offsets
 	VkBuffer vbs[1] = {SharedTextArena::inst().vbuf};
 	VkDeviceSize offs[1] = {vbOffset_};
-	vkCmdBindVertexBuffers(cmd, 0, 1, vbs, offs);
+	binds.vertexBuffers(cmd, vbs, offs);
 
-	vkCmdBindIndexBuffer(cmd, SharedTextArena::inst().ibuf, ibOffset_, VK_INDEX_TYPE_UINT32);
+	binds.indexBuffer(cmd, SharedTextArena::inst().ibuf, ibOffset_);
 
 	// draw exactly one instance (text is not instanced)
 	vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
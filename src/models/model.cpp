@@ -3,9 +3,11 @@
 #include "engine.hpp"
 #include "events.hpp"
 #include "mouse.hpp"
+#include "profiler.hpp"
 #include "scene.hpp"
 #include "scenes.hpp"
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
@@ -50,13 +52,21 @@ void Model::swapChainUpdate(float vw, float vh, float fbw, float fbh) {
 }
 
 void Model::compute(VkCommandBuffer cmd) {
+	cullDispatched_ = false;
+	if (culling && indexCount > 0) {
+		flushInstances();
+		culling->record(cmd, vp.view, vp.proj, vp.billboard != 0u, count, indexCount, geometry.firstIndex, geometry.vertexOffset);
+		cullDispatched_ = true;
+	}
+
 	if (picking) {
 		if (pickingInstancesDirty)
 			syncPickingInstances();
 
-		int winW = 0, winH = 0;
-		glfwGetWindowSize(engine->getWindow(), &winW, &winH);
-		VkExtent2D ext = engine->getSwapchain().getExtent();
+		VkExtent2D ext = engine->getExtent();
+		int winW = (int)ext.width, winH = (int)ext.height; // headless: no window, mouse is in pixels
+		if (engine->getWindow())
+			glfwGetWindowSize(engine->getWindow(), &winW, &winH);
 
 		float mx, my;
 		Mouse::getPixel(mx, my);
@@ -126,13 +136,10 @@ bool Model::mouseIsOver() {
 
 uint32_t Model::getPickedInstance() { return mouseIsOver() ? picking->hitInfo.primId : -1u; }
 
-void Model::enableRayPicking() {
-	if (!picking) {
-		picking = std::make_unique<RayPicking>();
-	}
-
+// Mesh-space positions from the location 0 / binding 0 attribute; returns an error message or nullptr.
+static const char *meshPositions(const Model::Mesh &mesh, std::vector<vec3> &verts) {
 	// Find position attribute (location 0, binding 0 is a common convention)
-	const Model::VertexAttr *posAttr = nullptr; // <-- FIXED TYPE
+	const Model::VertexAttr *posAttr = nullptr;
 	for (const auto &a : mesh.vertexAttrs) {
 		if (a.location == 0 && a.binding == 0) {
 			posAttr = &a;
@@ -140,10 +147,8 @@ void Model::enableRayPicking() {
 		}
 	}
 
-	if (!posAttr) {
-		std::fprintf(stderr, "[RayPicking] No position attribute (location=0) found; BVH not built.\n");
-		return;
-	}
+	if (!posAttr)
+		return "No position attribute (location=0) found";
 
 	const uint32_t vStride = mesh.vsrc.stride;
 	const uint8_t *vData = static_cast<const uint8_t *>(mesh.vsrc.data);
@@ -152,18 +157,12 @@ void Model::enableRayPicking() {
 	const bool fmtVec3 = (posAttr->fmt == VK_FORMAT_R32G32B32_SFLOAT);
 	const bool fmtVec4 = (posAttr->fmt == VK_FORMAT_R32G32B32A32_SFLOAT);
 
-	if (!fmtVec3 && !fmtVec4) {
-		std::fprintf(stderr, "[RayPicking] Unsupported position format (need R32G32B32 or R32G32B32A32 SFLOAT); BVH not built.\n");
-		return;
-	}
-	if (vCount == 0) {
-		std::fprintf(stderr, "[RayPicking] Empty vertex buffer; BVH not built.\n");
-		return;
-	}
-
-	// Build a vertex array with a .pos member (what buildBVH expects)
-	std::vector<vec3> verts(vCount);
+	if (!fmtVec3 && !fmtVec4)
+		return "Unsupported position format (need R32G32B32 or R32G32B32A32 SFLOAT)";
+	if (vCount == 0)
+		return "Empty vertex buffer";
 
+	verts.resize(vCount);
 	const size_t posOff = posAttr->offset; // offset within each vertex
 	for (size_t i = 0; i < vCount; ++i) {
 		const uint8_t *p = vData + i * vStride + posOff;
@@ -171,6 +170,20 @@ void Model::enableRayPicking() {
 		// both vec3 and vec4 share the first 3 floats
 		verts[i] = glm::vec3(f[0], f[1], f[2]);
 	}
+	return nullptr;
+}
+
+void Model::enableRayPicking() {
+	if (!picking) {
+		picking = std::make_unique<RayPicking>();
+	}
+
+	// Build a vertex array with a .pos member (what buildBVH expects)
+	std::vector<vec3> verts;
+	if (const char *err = meshPositions(mesh, verts)) {
+		std::fprintf(stderr, "[RayPicking] %s; BVH not built.\n", err);
+		return;
+	}
 
 	// Indices (assumed uint32_t)
 	std::vector<uint32_t> indices;
@@ -184,13 +197,48 @@ void Model::enableRayPicking() {
 	picking->buildBVH(verts, indices);
 
 	// Init the ray-picking compute pipeline, then upload the built data
-	picking->initInfo.shaders = Assets::compileShaderProgram(Assets::shaderRootPath + "/raypicking", pipeline->device);
+	picking->initInfo.shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/raypicking", pipeline->device);
 	picking->initInfo.maxInstances = std::max(1u, maxInstances);
 	// Sizes were set by buildBVH() (in our version); if not, keep your own sizes.
 	picking->init(pipeline->device, pipeline->physicalDevice);
 }
 
+void Model::enableGpuCulling() {
+	if (culling)
+		return;
+	if (ssbo == VK_NULL_HANDLE || instanceModelOffset == UINT32_MAX) {
+		std::fprintf(stderr, "[FrustumCulling] Model has no instance buffer or no mat4 model field (setInstanceLayout); culling not enabled.\n");
+		return;
+	}
+
+	std::vector<vec3> verts;
+	if (const char *err = meshPositions(mesh, verts)) {
+		std::fprintf(stderr, "[FrustumCulling] %s; culling not enabled.\n", err);
+		return;
+	}
+
+	// AABB center + farthest vertex: not the minimal sphere, but tight enough and one pass
+	vec3 bmin = verts[0], bmax = verts[0];
+	for (const vec3 &v : verts) {
+		bmin = glm::min(bmin, v);
+		bmax = glm::max(bmax, v);
+	}
+	const vec3 center = 0.5f * (bmin + bmax);
+	float radius = 0.f;
+	for (const vec3 &v : verts)
+		radius = std::max(radius, glm::length(v - center));
+
+	culling = std::make_unique<FrustumCulling>();
+	culling->initInfo.maxInstances = std::max(1u, maxInstances);
+	culling->initInfo.strideBytes = iStride;
+	culling->initInfo.modelOffsetBytes = instanceModelOffset;
+	culling->initInfo.localSphere = vec4(center, radius);
+	culling->initInfo.indirectCount = engine->getLogicalDevice().supportsDrawIndirectCount();
+	culling->init(pipeline->device, pipeline->physicalDevice, ssbo);
+}
+
 void Model::init() {
+	PROFILE_SCOPE("Model::init");
 	engine = scene->getScenes().getEngine();
 	pipeline->device = engine->getDevice();
 	pipeline->physicalDevice = engine->getPhysicalDevice();
@@ -204,7 +252,7 @@ void Model::init() {
 	maxInstances = initInfo.maxInstances;
 	iStride = initInfo.instanceStrideBytes;
 
-	auto extent = engine->getSwapchain().getExtent();
+	auto extent = engine->getExtent();
 	auto vw = (float)extent.width;
 	auto vh = (float)extent.height;
 	viewport = {0.0f, 0.0f, vw, vh, 0.0f, 1.0f};
@@ -232,18 +280,26 @@ void Model::init() {
 		vkFreeMemory(pipeline->device, smem, nullptr);
 	};
 
-	// --- Vertex buffer: DEVICE_LOCAL + TRANSFER_DST ---
-	if (mesh.vsrc.bytes) {
-		pipeline->createBuffer(mesh.vsrc.bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vbuf, vmem);
-		stageCopy(mesh.vsrc.data, mesh.vsrc.bytes, vbuf);
-	}
-
-	// --- Index buffer: DEVICE_LOCAL + TRANSFER_DST ---
-	if (mesh.isrc.count) {
-		VkDeviceSize ibytes = sizeof(uint32_t) * mesh.isrc.count;
-		pipeline->createBuffer(ibytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ibuf, imem);
-		stageCopy(mesh.isrc.data, ibytes, ibuf);
+	// --- Mesh in the shared DrawPool buffers (mergeDraws), else its own ---
+	DrawPool *drawPool = mergeDraws ? DrawPool::current() : nullptr;
+	if (drawPool && drawPool->acquireGeometry(mesh.vsrc.data, mesh.vsrc.bytes, mesh.vsrc.stride, mesh.isrc.data, mesh.isrc.count, geometry)) {
+		vbuf = drawPool->vertexBuffer();
+		ibuf = drawPool->indexBuffer();
 		indexCount = (uint32_t)mesh.isrc.count;
+	} else {
+		// --- Vertex buffer: DEVICE_LOCAL + TRANSFER_DST ---
+		if (mesh.vsrc.bytes) {
+			pipeline->createBuffer(mesh.vsrc.bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vbuf, vmem);
+			stageCopy(mesh.vsrc.data, mesh.vsrc.bytes, vbuf);
+		}
+
+		// --- Index buffer: DEVICE_LOCAL + TRANSFER_DST ---
+		if (mesh.isrc.count) {
+			VkDeviceSize ibytes = sizeof(uint32_t) * mesh.isrc.count;
+			pipeline->createBuffer(ibytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ibuf, imem);
+			stageCopy(mesh.isrc.data, ibytes, ibuf);
+			indexCount = (uint32_t)mesh.isrc.count;
+		}
 	}
 
 	// --- UBO (view/proj) ---
@@ -263,9 +319,6 @@ void Model::init() {
 		cpu.resize(maxInstances * iStride, 0);
 	}
 
-	uint32_t setCount = createDescriptorPool();
-	pipeline->createDescriptorPool(setCount);
-
 	createDescriptors();
 	pipeline->createDescriptors();
 
@@ -273,12 +326,6 @@ void Model::init() {
 	pipeline->createGraphicsPipeline();
 }
 
-uint32_t Model::createDescriptorPool() {
-	pipeline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
-	pipeline->descriptorPoolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1});
-	return 2;
-}
-
 void Model::createDescriptors() {
 	// set=0, binding 0: UBO (VS|FS)
 	pipeline->createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -316,11 +363,18 @@ void Model::createGraphicsPipeline() {
 }
 
 void Model::destroy() {
+	culling.reset();
 	const auto &dev = pipeline->device;
 	if (mappedSSBO && smem) {
 		vkUnmapMemory(dev, smem);
 		mappedSSBO = nullptr;
 	}
+	if (geometry.valid()) {
+		if (DrawPool *drawPool = DrawPool::current())
+			drawPool->releaseGeometry(geometry);
+		geometry = DrawPool::Geometry{};
+		vbuf = ibuf = VK_NULL_HANDLE; // the pool's
+	}
 	if (vbuf) {
 		vkDestroyBuffer(dev, vbuf, nullptr);
 		vbuf = VK_NULL_HANDLE;
@@ -392,7 +446,7 @@ void Model::erase(int id) {
 	pickingInstancesDirty = true;
 }
 
-void Model::record(VkCommandBuffer cmd) {
+void Model::resolvePicking() {
 	if (picking && pickingDispatched_) {
 		picking->readback(picking->hitInfo);
 
@@ -410,25 +464,29 @@ void Model::record(VkCommandBuffer cmd) {
 			}
 		}
 	}
+}
+
+void Model::syncUniforms() {
+	if (uboDirty) {
+		void *up;
+		vkMapMemory(pipeline->device, umem, 0, VK_WHOLE_SIZE, 0, &up);
+		std::memcpy(up, &vp, sizeof(VPMatrix));
+		vkUnmapMemory(pipeline->device, umem);
+		uboDirty = false;
+	}
+}
+
+void Model::record(VkCommandBuffer cmd) {
+	resolvePicking();
 
-	const auto &dev = pipeline->device;
 	const auto &pipe = pipeline->pipeline;
 	const auto &pipeLayout = pipeline->pipelineLayout;
 	const auto &dsets = pipeline->descriptorSets.descriptorSets;
 	const auto &dynOffsets = pipeline->descriptorSets.dynamicOffsets;
 
 	// sync uploads
-	if (uboDirty) {
-		void *up;
-		vkMapMemory(dev, umem, 0, VK_WHOLE_SIZE, 0, &up);
-		std::memcpy(up, &vp, sizeof(VPMatrix));
-		vkUnmapMemory(dev, umem);
-		uboDirty = false;
-	}
-	if (ssboDirty) {
-		std::memcpy(mappedSSBO, cpu.data(), count * iStride);
-		ssboDirty = false;
-	}
+	syncUniforms();
+	flushInstances();
 
 	// If we don't have geometry yet, bail out safely (prevents VUID 04001)
 	// You can relax the indexCount requirement if you support non-indexed draws.
@@ -436,16 +494,26 @@ void Model::record(VkCommandBuffer cmd) {
 		return;
 	}
 
-	vkCmdSetViewport(cmd, 0, 1, &viewport);
-	vkCmdSetScissor(cmd, 0, 1, &scissor);
-
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
-	if (!dsets.empty()) {
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout, 0, static_cast<uint32_t>(dsets.size()), dsets.data(), static_cast<uint32_t>(dynOffsets.size()), dynOffsets.empty() ? nullptr : dynOffsets.data());
-	}
+	// only what differs from the previous draw in this command buffer is re-issued
+	BindCache &binds = scene->getScenes().bindCache();
+	binds.viewport(cmd, viewport);
+	binds.scissor(cmd, scissor);
+	binds.pipeline(cmd, pipe);
+	binds.descriptorSets(cmd, pipeLayout, dsets, dynOffsets);
 
 	pushConstants(cmd, pipeLayout);
 
+	drawInstances(cmd);
+}
+
+void Model::flushInstances() {
+	if (ssboDirty) {
+		std::memcpy(mappedSSBO, cpu.data(), count * iStride);
+		ssboDirty = false;
+	}
+}
+
+void Model::drawInstances(VkCommandBuffer cmd) {
 	// Build the VB list dynamically to avoid passing VK_NULL_HANDLE
 	VkBuffer vbs[2];
 	VkDeviceSize offs[2] = {0, 0};
@@ -454,21 +522,78 @@ void Model::record(VkCommandBuffer cmd) {
 		vbs[vbCount++] = vbuf;
 	}
 	if (iStride > 0 && ssbo != VK_NULL_HANDLE) {
-		vbs[vbCount++] = ssbo;
+		vbs[vbCount++] = cullDispatched_ ? culling->instanceBuffer() : ssbo;
 	}
 
 	// If binding 0 (vertex stream) is missing, skip (pipeline expects it)
 	if (vbCount == 0)
 		return;
 
-	vkCmdBindVertexBuffers(cmd, 0, vbCount, vbs, offs);
+	BindCache &binds = scene->getScenes().bindCache();
+	binds.vertexBuffers(cmd, std::span<const VkBuffer>(vbs, vbCount), std::span<const VkDeviceSize>(offs, vbCount));
 
 	if (indexCount)
-		vkCmdBindIndexBuffer(cmd, ibuf, 0, VK_INDEX_TYPE_UINT32);
+		binds.indexBuffer(cmd, ibuf, 0);
 
-	if (count && indexCount) {
-		vkCmdDrawIndexed(cmd, indexCount, count, 0, 0, 0);
+	if (cullDispatched_) {
+		culling->draw(cmd); // instance count (and index count) come from compute()
+	} else if (count && indexCount) {
+		vkCmdDrawIndexed(cmd, indexCount, count, geometry.firstIndex, geometry.vertexOffset, 0);
 	}
 }
 
+bool Model::canMergeDraw() const {
+	const DrawPool *drawPool = DrawPool::current();
+	return mergeDraws && geometry.valid() && !culling && iStride > 0 && hasDrawWork() && drawPool && drawPool->canMerge();
+}
+
+bool Model::mergesWith(const Model &o) const {
+	return pipeline->pipeline == o.pipeline->pipeline && iStride == o.iStride && vp.view == o.vp.view && vp.proj == o.vp.proj && vp.billboard == o.vp.billboard &&
+		   std::memcmp(&viewport, &o.viewport, sizeof(VkViewport)) == 0 && std::memcmp(&scissor, &o.scissor, sizeof(VkRect2D)) == 0;
+}
+
+void Model::recordMerged(VkCommandBuffer cmd, std::span<Model *const> run) {
+	VkDeviceSize bytes = 0;
+	for (const Model *m : run)
+		bytes += VkDeviceSize(m->count) * m->iStride;
+
+	DrawPool *drawPool = DrawPool::current();
+	DrawPool::Slice inst, args;
+	if (!drawPool || !drawPool->allocInstances(bytes, inst) || !drawPool->allocCommands(uint32_t(run.size()), args)) {
+		for (Model *m : run)
+			m->record(cmd);
+		return;
+	}
+
+	// instances back to back; command k draws model k's mesh over its own instances
+	auto *cmds = reinterpret_cast<VkDrawIndexedIndirectCommand *>(args.data);
+	uint8_t *dst = inst.data;
+	uint32_t firstInstance = 0;
+	for (size_t k = 0; k < run.size(); ++k) {
+		Model *m = run[k];
+		m->resolvePicking();
+		const size_t n = size_t(m->count) * m->iStride;
+		std::memcpy(dst, m->cpu.data(), n);
+		dst += n;
+		cmds[k] = VkDrawIndexedIndirectCommand{m->indexCount, m->count, m->geometry.firstIndex, m->geometry.vertexOffset, firstInstance};
+		firstInstance += m->count;
+	}
+
+	// the run shares pipeline, view/projection, viewport and scissor, and merged shaders read nothing else from
+	// set 0: the first model's UBO and descriptor sets stand in for all of them
+	Model &lead = *run.front();
+	lead.syncUniforms();
+	BindCache &binds = lead.scene->getScenes().bindCache();
+	binds.viewport(cmd, lead.viewport);
+	binds.scissor(cmd, lead.scissor);
+	binds.pipeline(cmd, lead.pipeline->pipeline);
+	binds.descriptorSets(cmd, lead.pipeline->pipelineLayout, lead.pipeline->descriptorSets.descriptorSets, lead.pipeline->descriptorSets.dynamicOffsets);
+
+	const VkBuffer vbs[2] = {drawPool->vertexBuffer(), inst.buffer};
+	const VkDeviceSize offs[2] = {0, inst.offset};
+	binds.vertexBuffers(cmd, vbs, offs);
+	binds.indexBuffer(cmd, drawPool->indexBuffer(), 0);
+	drawPool->drawIndirect(cmd, args, uint32_t(run.size()));
+}
+
 void Model::recordUI(VkCommandBuffer cmd, uint32_t) { record(cmd); }
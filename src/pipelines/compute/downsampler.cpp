@@ -0,0 +1,361 @@
+#include "downsampler.hpp"
+#include "assets.hpp"
+#include "debug.hpp"
+#include "graphicsbuffers.hpp"
+#include "pipelineregistry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "rendering.hpp"
+
+using namespace Rendering;
+
+Downsampler::~Downsampler() { destroy(); }
+
+// -------------------------------------
+// Lifecycle
+// -------------------------------------
+
+void Downsampler::create(VkDevice dev, VkPhysicalDevice phys) {
+	if (!dev || !phys)
+		throw std::runtime_error("Downsampler::create: device/physicalDevice not set");
+
+	device = dev;
+	physicalDevice = phys;
+
+	VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sci.magFilter = VK_FILTER_LINEAR;
+	sci.minFilter = VK_FILTER_LINEAR;
+	sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.maxLod = 0.0f;
+	VK_CHECK(vkCreateSampler(device, &sci, nullptr, &linearSampler));
+
+	createSpdPipeline();
+	createKawasePipeline();
+}
+
+void Downsampler::destroy() {
+	if (device == VK_NULL_HANDLE)
+		return;
+
+	releaseTargets();
+	targets.clear();
+
+	spd.reset();
+	kawase.reset();
+
+	if (linearSampler) {
+		vkDestroySampler(device, linearSampler, nullptr);
+		linearSampler = VK_NULL_HANDLE;
+	}
+
+	device = VK_NULL_HANDLE;
+	physicalDevice = VK_NULL_HANDLE;
+}
+
+// -------------------------------------
+// Pipelines
+// -------------------------------------
+
+VkDescriptorSetLayout Downsampler::createSetLayout(VkDescriptorType srcType, uint32_t dstCount) {
+	VkDescriptorSetLayoutBinding b[2]{};
+	b[0].binding = 0;
+	b[0].descriptorType = srcType;
+	b[0].descriptorCount = 1;
+	b[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	b[1].binding = 1;
+	b[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	b[1].descriptorCount = dstCount;
+	b[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo lci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+	lci.bindingCount = 2;
+	lci.pBindings = b;
+
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateDescriptorSetLayout(device, &lci, nullptr, &layout));
+	return layout;
+}
+
+void Downsampler::createSpdPipeline() {
+	spd = std::make_unique<Pipeline>();
+	spd->device = device;
+	spd->physicalDevice = physicalDevice;
+	spd->shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/spd", device);
+
+	// Pipeline owns (and destroys) the layout
+	spd->descriptorSets.descriptorSetsLayout.push_back(createSetLayout(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, kMipsPerDispatch));
+
+	spdRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SpdPC)};
+	spd->computePipeline.pipelineLayoutCI.pushConstantRangeCount = 1;
+	spd->computePipeline.pipelineLayoutCI.pPushConstantRanges = &spdRange;
+
+	spd->createComputePipeline();
+}
+
+void Downsampler::createKawasePipeline() {
+	kawase = std::make_unique<Pipeline>();
+	kawase->device = device;
+	kawase->physicalDevice = physicalDevice;
+	kawase->shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/kawase", device);
+
+	kawase->descriptorSets.descriptorSetsLayout.push_back(createSetLayout(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1));
+
+	kawaseRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(KawasePC)};
+	kawase->computePipeline.pipelineLayoutCI.pushConstantRangeCount = 1;
+	kawase->computePipeline.pipelineLayoutCI.pPushConstantRanges = &kawaseRange;
+
+	kawase->createComputePipeline();
+}
+
+// -------------------------------------
+// Targets (per GraphicsBuffers generation)
+// -------------------------------------
+
+void Downsampler::bindTargets(const GraphicsBuffers &buffers) {
+	releaseTargets();
+
+	extent = buffers.getExtent();
+	mipLevels = buffers.getMipLevels();
+	storageMips = buffers.supportsStorageMips();
+
+	const uint32_t slots = buffers.getImageCount() * 2;
+	targets.assign(slots, {});
+	for (uint32_t slot = 0; slot < slots; ++slot) {
+		const uint32_t i = slot / 2;
+		targets[slot].image = (slot & 1u) ? buffers.getColorBImage(i) : buffers.getColorAImage(i);
+	}
+
+	if (!storageMips || mipLevels <= 1)
+		return;
+
+	const uint32_t spdPerTarget = (mipLevels - 1 + kMipsPerDispatch - 1) / kMipsPerDispatch;
+	const uint32_t kawasePerTarget = mipLevels - 1;
+
+	VkDescriptorPoolSize sizes[] = {
+		{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, slots * (spdPerTarget * (1 + kMipsPerDispatch) + kawasePerTarget)},
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, slots * kawasePerTarget},
+	};
+	VkDescriptorPoolCreateInfo dpci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+	dpci.maxSets = slots * (spdPerTarget + kawasePerTarget);
+	dpci.poolSizeCount = (uint32_t)std::size(sizes);
+	dpci.pPoolSizes = sizes;
+	VK_CHECK(vkCreateDescriptorPool(device, &dpci, nullptr, &targetPool));
+
+	auto allocate = [&](VkDescriptorSetLayout layout, uint32_t count, std::vector<VkDescriptorSet> &out) {
+		std::vector<VkDescriptorSetLayout> layouts(count, layout);
+		VkDescriptorSetAllocateInfo dai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+		dai.descriptorPool = targetPool;
+		dai.descriptorSetCount = count;
+		dai.pSetLayouts = layouts.data();
+		out.resize(count);
+		VK_CHECK(vkAllocateDescriptorSets(device, &dai, out.data()));
+	};
+
+	for (uint32_t slot = 0; slot < slots; ++slot) {
+		const uint32_t i = slot / 2;
+		const bool isB = (slot & 1u) != 0;
+		auto mipView = [&](uint32_t m) { return isB ? buffers.getColorBMipView(i, m) : buffers.getColorAMipView(i, m); };
+
+		Target &t = targets[slot];
+		allocate(spd->descriptorSets.descriptorSetsLayout[0], spdPerTarget, t.spdSets);
+		allocate(kawase->descriptorSets.descriptorSetsLayout[0], kawasePerTarget, t.kawaseSets);
+
+		// SPD: src = mip p*5, dst = next 5 mips (tail padded with the last mip; writes are guarded by mipCount)
+		for (uint32_t p = 0; p < spdPerTarget; ++p) {
+			const uint32_t src = p * kMipsPerDispatch;
+			std::array<VkDescriptorImageInfo, 1 + kMipsPerDispatch> infos{};
+			infos[0] = {VK_NULL_HANDLE, mipView(src), VK_IMAGE_LAYOUT_GENERAL};
+			for (uint32_t j = 0; j < kMipsPerDispatch; ++j)
+				infos[1 + j] = {VK_NULL_HANDLE, mipView(std::min(src + 1 + j, mipLevels - 1)), VK_IMAGE_LAYOUT_GENERAL};
+
+			VkWriteDescriptorSet w[2]{{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}, {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}};
+			w[0].dstSet = t.spdSets[p];
+			w[0].dstBinding = 0;
+			w[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			w[0].descriptorCount = 1;
+			w[0].pImageInfo = &infos[0];
+			w[1].dstSet = t.spdSets[p];
+			w[1].dstBinding = 1;
+			w[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			w[1].descriptorCount = kMipsPerDispatch;
+			w[1].pImageInfo = &infos[1];
+			vkUpdateDescriptorSets(device, 2, w, 0, nullptr);
+		}
+
+		// Kawase: sample mip k, write mip k+1
+		for (uint32_t k = 0; k < kawasePerTarget; ++k) {
+			VkDescriptorImageInfo srcInfo{linearSampler, mipView(k), VK_IMAGE_LAYOUT_GENERAL};
+			VkDescriptorImageInfo dstInfo{VK_NULL_HANDLE, mipView(k + 1), VK_IMAGE_LAYOUT_GENERAL};
+
+			VkWriteDescriptorSet w[2]{{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}, {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}};
+			w[0].dstSet = t.kawaseSets[k];
+			w[0].dstBinding = 0;
+			w[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			w[0].descriptorCount = 1;
+			w[0].pImageInfo = &srcInfo;
+			w[1].dstSet = t.kawaseSets[k];
+			w[1].dstBinding = 1;
+			w[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			w[1].descriptorCount = 1;
+			w[1].pImageInfo = &dstInfo;
+			vkUpdateDescriptorSets(device, 2, w, 0, nullptr);
+		}
+	}
+}
+
+void Downsampler::releaseTargets() {
+	for (auto &t : targets) {
+		t.spdSets.clear();
+		t.kawaseSets.clear();
+	}
+	if (targetPool) {
+		vkDestroyDescriptorPool(device, targetPool, nullptr);
+		targetPool = VK_NULL_HANDLE;
+	}
+}
+
+// -------------------------------------
+// Record
+// -------------------------------------
+
+void Downsampler::record(VkCommandBuffer cmd, uint32_t slot, const VkRect2D *region) {
+	if (slot >= targets.size())
+		throw std::runtime_error("Downsampler::record: slot out of range (bindTargets not called?)");
+	if (mipLevels <= 1)
+		return;
+
+	const Target &t = targets[slot];
+	switch (getMode()) {
+	case Mode::SPD:
+		recordSPD(cmd, t, region);
+		break;
+	case Mode::DualKawase:
+		recordKawase(cmd, t, region);
+		break;
+	case Mode::Blit:
+	default:
+		if (region)
+			cmdBuildMipsForImageRegion(cmd, t.image, extent.width, extent.height, mipLevels, *region);
+		else
+			cmdBuildMipsForImageRuntime(cmd, t.image, extent.width, extent.height, mipLevels);
+		break;
+	}
+}
+
+void Downsampler::recordSPD(VkCommandBuffer cmd, const Target &t, const VkRect2D *region) {
+	// mip0: COLOR_ATTACHMENT_OPTIMAL -> GENERAL (storage read), lower mips -> GENERAL (storage write)
+	// full rebuild discards the lower mips (UNDEFINED); a region rebuild keeps them (SHADER_READ_ONLY_OPTIMAL)
+	cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 0, 1, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+	if (region)
+		cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 1, mipLevels - 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+	else
+		cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 1, mipLevels - 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, spd->pipeline);
+
+	for (uint32_t p = 0; p < t.spdSets.size(); ++p) {
+		const uint32_t src = p * kMipsPerDispatch;
+		const uint32_t srcW = std::max(1u, extent.width >> src);
+		const uint32_t srcH = std::max(1u, extent.height >> src);
+		const uint32_t dstW = std::max(1u, srcW >> 1);
+		const uint32_t dstH = std::max(1u, srcH >> 1);
+
+		// one workgroup = 16x16 texels of the first dst mip = (32 << src) mip0 texels
+		uint32_t gx0 = 0, gy0 = 0, gx1 = (dstW + 15) / 16, gy1 = (dstH + 15) / 16;
+		if (region) {
+			const uint32_t tileShift = src + 5;
+			gx0 = uint32_t(region->offset.x) >> tileShift;
+			gy0 = uint32_t(region->offset.y) >> tileShift;
+			gx1 = std::min(gx1, ((uint32_t(region->offset.x) + region->extent.width - 1) >> tileShift) + 1);
+			gy1 = std::min(gy1, ((uint32_t(region->offset.y) + region->extent.height - 1) >> tileShift) + 1);
+		}
+
+		SpdPC pc{};
+		pc.srcW = (int32_t)srcW;
+		pc.srcH = (int32_t)srcH;
+		pc.groupX = (int32_t)gx0;
+		pc.groupY = (int32_t)gy0;
+		pc.mipCount = std::min(kMipsPerDispatch, mipLevels - 1 - src);
+
+		if (gx1 > gx0 && gy1 > gy0) {
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, spd->pipelineLayout, 0, 1, &t.spdSets[p], 0, nullptr);
+			vkCmdPushConstants(cmd, spd->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+			vkCmdDispatch(cmd, gx1 - gx0, gy1 - gy0, 1);
+		}
+
+		// next dispatch reads the last mip this one wrote
+		if (p + 1 < t.spdSets.size()) {
+			const uint32_t last = src + pc.mipCount;
+			cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, last, 1, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+		}
+	}
+
+	// whole chain -> SHADER_READ_ONLY_OPTIMAL for the blur layers
+	cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, mipLevels, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+}
+
+void Downsampler::recordKawase(VkCommandBuffer cmd, const Target &t, const VkRect2D *region) {
+	cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 0, 1, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+	if (region)
+		cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 1, mipLevels - 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+	else
+		cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 1, mipLevels - 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, kawase->pipeline);
+
+	// Dirty texels of the source level, [sx0, sx1) x [sy0, sy1); starts as the region on level 0.
+	// Dst texel p samples around source texel 2p + 1, taps kawaseOffset away plus the bilinear footprint, so
+	// source texels [2p - reach, 2p + 1 + reach] feed it. The rect grows by that reach at every level.
+	const int32_t reach = (int32_t)std::ceil(std::max(0.0f, kawaseOffset)) + 1;
+	int32_t sx0 = 0, sy0 = 0, sx1 = 0, sy1 = 0;
+	if (region) {
+		sx0 = region->offset.x;
+		sy0 = region->offset.y;
+		sx1 = region->offset.x + (int32_t)region->extent.width;
+		sy1 = region->offset.y + (int32_t)region->extent.height;
+	}
+
+	for (uint32_t k = 0; k < t.kawaseSets.size(); ++k) {
+		const uint32_t srcW = std::max(1u, extent.width >> k);
+		const uint32_t srcH = std::max(1u, extent.height >> k);
+		const uint32_t dstW = std::max(1u, srcW >> 1);
+		const uint32_t dstH = std::max(1u, srcH >> 1);
+
+		int32_t x0 = 0, y0 = 0, x1 = (int32_t)dstW, y1 = (int32_t)dstH;
+		if (region) {
+			x0 = std::max(0, sx0 - 1 - reach) >> 1;
+			y0 = std::max(0, sy0 - 1 - reach) >> 1;
+			x1 = std::min((int32_t)dstW, ((sx1 - 1 + reach) >> 1) + 1);
+			y1 = std::min((int32_t)dstH, ((sy1 - 1 + reach) >> 1) + 1);
+			sx0 = x0, sy0 = y0, sx1 = x1, sy1 = y1;
+		}
+
+		KawasePC pc{};
+		pc.dstW = (int32_t)dstW;
+		pc.dstH = (int32_t)dstH;
+		pc.dstX = x0;
+		pc.dstY = y0;
+		pc.texelX = 1.0f / float(srcW);
+		pc.texelY = 1.0f / float(srcH);
+		pc.offset = kawaseOffset;
+
+		if (x1 > x0 && y1 > y0) {
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, kawase->pipelineLayout, 0, 1, &t.kawaseSets[k], 0, nullptr);
+			vkCmdPushConstants(cmd, kawase->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+			vkCmdDispatch(cmd, uint32_t(x1 - x0 + 7) / 8, uint32_t(y1 - y0 + 7) / 8, 1);
+		}
+
+		if (k + 1 < t.kawaseSets.size()) {
+			cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, k + 1, 1, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+		}
+	}
+
+	cmdTransitionImage(cmd, t.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, mipLevels, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+}
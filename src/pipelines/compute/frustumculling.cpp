@@ -0,0 +1,152 @@
+#include "frustumculling.hpp"
+#include "assets.hpp"
+#include "debug.hpp"
+#include "pipelineregistry.hpp"
+#include "profiler.hpp"
+#include <cstddef>
+#include <stdexcept>
+
+static constexpr uint32_t kGroupSize = 64; // local_size_x in culling.comp
+
+FrustumCulling::FrustumCulling() { pipeline = std::make_unique<Pipeline>(); }
+
+FrustumCulling::~FrustumCulling() { destroy(); }
+
+void FrustumCulling::init(VkDevice device, VkPhysicalDevice physicalDevice, VkBuffer sourceInstances) {
+	if (!device || !physicalDevice || sourceInstances == VK_NULL_HANDLE)
+		throw std::runtime_error("FrustumCulling::init: device/physicalDevice/instance buffer not set");
+	if (initInfo.strideBytes == 0 || initInfo.strideBytes % 4 != 0 || initInfo.modelOffsetBytes % 4 != 0)
+		throw std::runtime_error("FrustumCulling::init: instance stride/model offset must be non-zero multiples of 4");
+
+	pipeline->device = device;
+	pipeline->physicalDevice = physicalDevice;
+
+	const uint32_t maxInstances = initInfo.maxInstances ? initInfo.maxInstances : 1;
+	pipeline->createBuffer(VkDeviceSize(maxInstances) * initInfo.strideBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visibleBuf, visibleMem);
+	pipeline->createBuffer(sizeof(ArgsGPU), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, argsBuf, argsMem);
+
+	pipeline->shaders = PipelineRegistry::get().shaderProgram(Assets::shaderRootPath + "/culling", device);
+	createDescriptors(sourceInstances);
+
+	pcRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPC)};
+	pipeline->computePipeline.pipelineLayoutCI.pushConstantRangeCount = 1;
+	pipeline->computePipeline.pipelineLayoutCI.pPushConstantRanges = &pcRange;
+	pipeline->createComputePipeline();
+}
+
+void FrustumCulling::destroy() {
+	if (!pipeline)
+		return;
+	const auto &dev = pipeline->device;
+	if (visibleBuf) {
+		vkDestroyBuffer(dev, visibleBuf, nullptr);
+		visibleBuf = VK_NULL_HANDLE;
+	}
+	if (visibleMem) {
+		vkFreeMemory(dev, visibleMem, nullptr);
+		visibleMem = VK_NULL_HANDLE;
+	}
+	if (argsBuf) {
+		vkDestroyBuffer(dev, argsBuf, nullptr);
+		argsBuf = VK_NULL_HANDLE;
+	}
+	if (argsMem) {
+		vkFreeMemory(dev, argsMem, nullptr);
+		argsMem = VK_NULL_HANDLE;
+	}
+}
+
+void FrustumCulling::createDescriptors(VkBuffer sourceInstances) {
+	const auto CS = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline->createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CS); // source instances (Model::ssbo)
+	pipeline->createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CS); // visible instances
+	pipeline->createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CS); // indirect args + count
+
+	VkDescriptorBufferInfo src{sourceInstances, 0, VK_WHOLE_SIZE};
+	VkDescriptorBufferInfo dst{visibleBuf, 0, VK_WHOLE_SIZE};
+	VkDescriptorBufferInfo args{argsBuf, 0, sizeof(ArgsGPU)};
+	pipeline->createWriteDescriptorSet(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, src);
+	pipeline->createWriteDescriptorSet(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, dst);
+	pipeline->createWriteDescriptorSet(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, args);
+
+	pipeline->createDescriptors();
+}
+
+static void memoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess) {
+	VkMemoryBarrier2 mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+	mb.srcStageMask = srcStage;
+	mb.srcAccessMask = srcAccess;
+	mb.dstStageMask = dstStage;
+	mb.dstAccessMask = dstAccess;
+
+	VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+	dep.memoryBarrierCount = 1;
+	dep.pMemoryBarriers = &mb;
+	vkCmdPipelineBarrier2(cmd, &dep);
+}
+
+void FrustumCulling::record(VkCommandBuffer cmd, const glm::mat4 &view, const glm::mat4 &proj, bool billboard, uint32_t instanceCount, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset) {
+	PROFILE_SCOPE("FrustumCulling::record");
+	if (!pipeline || pipeline->pipeline == VK_NULL_HANDLE)
+		return;
+
+	// Gribb/Hartmann: planes are row3 +/- row0..2 of the clip matrix. Near uses row3 + row2 (z >= -w), which
+	// holds for both [-1,1] and [0,1] depth and is only conservative for the latter.
+	const glm::mat4 m = proj * view;
+	auto row = [&](int r) { return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]); };
+	CullPC pc{};
+	if (billboard) {
+		// the quad's vertices are offset from the projected centre: a world-space sphere says nothing about them
+		const glm::vec4 &sp = initInfo.localSphere;
+		const float reach = glm::length(glm::vec3(sp)) + sp.w; // farthest mesh point from the origin
+		for (int r = 0; r < 4; ++r)
+			pc.planes[r] = row(r);
+		pc.planes[4] = glm::vec4(initInfo.billboardSizeNDC * reach, reach, 0.f, 0.f);
+	} else {
+		pc.planes[0] = row(3) + row(0);
+		pc.planes[1] = row(3) - row(0);
+		pc.planes[2] = row(3) + row(1);
+		pc.planes[3] = row(3) - row(1);
+		pc.planes[4] = row(3) + row(2);
+		pc.planes[5] = row(3) - row(2);
+		for (glm::vec4 &p : pc.planes) {
+			const float len = glm::length(glm::vec3(p));
+			if (len > 0.f)
+				p /= len;
+		}
+	}
+	pc.sphere = initInfo.localSphere;
+	pc.count = instanceCount;
+	pc.strideWords = initInfo.strideBytes / 4;
+	pc.modelWord = initInfo.modelOffsetBytes / 4;
+	pc.billboard = billboard ? 1u : 0u;
+
+	// the previous frame's draw may still read the compacted copy and the args (same queue: a barrier orders it)
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, 0, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, 0);
+
+	ArgsGPU args{};
+	args.cmd.indexCount = indexCount;
+	args.cmd.firstIndex = firstIndex;
+	args.cmd.vertexOffset = vertexOffset;
+	vkCmdUpdateBuffer(cmd, argsBuf, 0, sizeof(ArgsGPU), &args);
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+	if (instanceCount > 0) {
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipelineLayout, 0, (uint32_t)pipeline->descriptorSets.descriptorSets.size(), pipeline->descriptorSets.descriptorSets.data(), 0, nullptr);
+		vkCmdPushConstants(cmd, pipeline->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+		vkCmdDispatch(cmd, (instanceCount + kGroupSize - 1) / kGroupSize, 1, 1);
+	}
+
+	memoryBarrier(cmd, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+void FrustumCulling::draw(VkCommandBuffer cmd) const {
+	if (argsBuf == VK_NULL_HANDLE)
+		return;
+	if (initInfo.indirectCount) {
+		vkCmdDrawIndexedIndirectCount(cmd, argsBuf, 0, argsBuf, offsetof(ArgsGPU, drawCount), 1, sizeof(ArgsGPU));
+	} else {
+		vkCmdDrawIndexedIndirect(cmd, argsBuf, 0, 1, sizeof(ArgsGPU)); // instanceCount 0 when nothing survived
+	}
+}
@@ -1,6 +1,7 @@
 #include "raypicking.hpp"
 #include "assets.hpp"
 #include "debug.hpp"
+#include "profiler.hpp"
 
 #include <algorithm>
 #include <functional>
@@ -22,22 +23,7 @@ void RayPicking::init(VkDevice device, VkPhysicalDevice physicalDevice) {
 	// pipeline core wiring (like Model::init)
 	pipeline->device = device;
 	pipeline->physicalDevice = physicalDevice;
-	pipeline->descriptorPool = initInfo.dpool;
-
-	if (pipeline->descriptorPool == VK_NULL_HANDLE) {
-		VkDescriptorPoolSize sizes[] = {
-			{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6},
-			{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
-		};
-		VkDescriptorPoolCreateInfo dpci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-		dpci.maxSets = 1;
-		dpci.poolSizeCount = (uint32_t)std::size(sizes);
-		dpci.pPoolSizes = sizes;
-		VK_CHECK(vkCreateDescriptorPool(device, &dpci, nullptr, &pipeline->descriptorPool));
-		descriptorPool = pipeline->descriptorPool;
-	} else {
-		descriptorPool = initInfo.dpool;
-	}
+	pipeline->descriptorPool = initInfo.dpool; // null: sets come from the engine's DescriptorAllocator
 
 	// create buffers (HOST_VISIBLE|COHERENT for clarity)
 	pipeline->createBuffer(nz(nodesBytes), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, nodesBuf, nodesMem);
@@ -184,6 +170,7 @@ void RayPicking::createDescriptors() {
 // ---------- uploads ----------
 
 void RayPicking::uploadStatic(std::span<const BVHNodeGPU> nodes, std::span<const TriIndexGPU> tris, std::span<const glm::vec4> positions) {
+	PROFILE_SCOPE("RayPicking::uploadStatic");
 	if (!pipeline)
 		return;
 	const auto &dev = pipeline->device;
@@ -215,6 +202,7 @@ void RayPicking::uploadStatic(std::span<const BVHNodeGPU> nodes, std::span<const
 }
 
 void RayPicking::uploadInstances(std::span<const InstanceXformGPU> instances, std::span<const int> ids) {
+	PROFILE_SCOPE("RayPicking::uploadInstances");
 	if (!pipeline)
 		return;
 	size_t n = std::min(instances.size(), ids.size());
@@ -274,18 +262,7 @@ void RayPicking::resizeInstanceBuffer(uint32_t newMax) {
 	if (newMax == maxInstances)
 		return;
 
-	// ---- Destroy old pipeline layout and set layouts before re-creating ----
-	if (pipeline->pipelineLayout) {
-		vkDestroyPipelineLayout(device, pipeline->pipelineLayout, nullptr);
-		pipeline->pipelineLayout = VK_NULL_HANDLE;
-	}
-	if (!pipeline->descriptorSets.descriptorSetsLayout.empty()) {
-		for (auto &l : pipeline->descriptorSets.descriptorSetsLayout) {
-			if (l)
-				vkDestroyDescriptorSetLayout(device, l, nullptr);
-		}
-		pipeline->descriptorSets.descriptorSetsLayout.clear();
-	}
+	// ---- Bindings don't change: the set layouts and pipeline layout stay, only the sets are rewritten ----
 
 	// Rebuild descriptor write lists for new buffers (you already do this)
 	pipeline->descriptorSets.writeDescriptorSets.clear();
@@ -338,6 +315,8 @@ int RayPicking::buildNode(std::vector<BuildTri> &tris, int begin, int end, int d
 }
 
 void RayPicking::buildBVH(const vector<vec3> &vertices, const vector<uint32_t> &indices) {
+	PROFILE_SCOPE("RayPicking::buildBVH");
+
 	// Gather positions and triangles from current mesh
 	posGPU.clear();
 	triGPU.clear();
@@ -1,44 +1,57 @@
 #include "pipeline.hpp"
 #include "debug.hpp"
+#include "descriptorallocator.hpp"
 #include "memory.hpp"
+#include "pipelineregistry.hpp"
 
 Pipeline::~Pipeline() {
 	if (device == VK_NULL_HANDLE)
 		return;
 
+	// pipeline, layouts and shaders may be shared with other Pipelines: the registry destroys them with the last user
+	auto &registry = PipelineRegistry::get();
 	if (pipeline) {
-		vkDestroyPipeline(device, pipeline, nullptr);
+		registry.releasePipeline(pipeline, device);
 		pipeline = VK_NULL_HANDLE;
 	}
 	if (pipelineLayout) {
-		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		registry.releasePipelineLayout(pipelineLayout, device);
 		pipelineLayout = VK_NULL_HANDLE;
 	}
+	releaseDescriptorSets();
 	if (descriptorSets.descriptorSetsLayout.size() > 0) {
 		for (auto &d : descriptorSets.descriptorSetsLayout) {
 			if (d != VK_NULL_HANDLE) {
-				vkDestroyDescriptorSetLayout(device, d, nullptr);
+				registry.releaseSetLayout(d, device);
 			}
 		}
 		descriptorSets.descriptorSetsLayout.clear();
 	}
-	if (descriptorPool) {
-		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-		descriptorPool = VK_NULL_HANDLE;
-	}
 
-	Assets::destroyShaderProgram(shaders, device);
+	registry.releaseShaderProgram(shaders, device);
 
 	device = VK_NULL_HANDLE;
 }
 
-void Pipeline::createDescriptorPool(uint32_t setCount) {
-	VkDescriptorPoolCreateInfo dpci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-	dpci.maxSets = setCount;
-	;
-	dpci.poolSizeCount = (uint32_t)descriptorPoolSizes.size();
-	dpci.pPoolSizes = descriptorPoolSizes.data();
-	VK_CHECK(vkCreateDescriptorPool(device, &dpci, nullptr, &descriptorPool));
+void Pipeline::releaseDescriptorSets() {
+	if (descriptorSetPool && !descriptorSets.descriptorSets.empty()) {
+		std::vector<VkDescriptorSet> owned;
+		for (uint32_t i = 0; i < descriptorSets.descriptorSets.size(); ++i)
+			if (!isSharedSet(i))
+				owned.push_back(descriptorSets.descriptorSets[i]);
+		// frames in flight may still use them: the allocator frees them once those completed
+		if (auto *allocator = DescriptorAllocator::current())
+			allocator->free(descriptorSetPool, owned);
+	}
+	descriptorSetPool = VK_NULL_HANDLE;
+}
+
+void Pipeline::useSharedSet(uint32_t setIndex, VkDescriptorSetLayout layout, VkDescriptorSet set) {
+	if (descriptorSets.descriptorSetLayoutBindings.size() <= setIndex)
+		descriptorSets.descriptorSetLayoutBindings.resize(setIndex + 1);
+	if (descriptorSets.sharedSets.size() <= setIndex)
+		descriptorSets.sharedSets.resize(setIndex + 1);
+	descriptorSets.sharedSets[setIndex] = {layout, set};
 }
 
 void Pipeline::createDescriptors() {
@@ -46,23 +59,45 @@ void Pipeline::createDescriptors() {
 	if (setCount == 0)
 		return;
 
-	// 1) Create each set layout
-	descriptorSets.descriptorSetsLayout.resize(setCount);
-	for (uint32_t i = 0; i < setCount; ++i) {
-		const auto &bindings = descriptorSets.descriptorSetLayoutBindings[i];
-		descriptorSets.descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		descriptorSets.descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
-		descriptorSets.descriptorSetLayoutCI.pBindings = bindings.empty() ? nullptr : bindings.data();
-		VK_CHECK(vkCreateDescriptorSetLayout(device, &descriptorSets.descriptorSetLayoutCI, nullptr, &descriptorSets.descriptorSetsLayout[i]));
+	// 1) Acquire each set layout (kept when only the sets are rebuilt, e.g. RayPicking::resizeInstanceBuffer)
+	if (descriptorSets.descriptorSetsLayout.size() != setCount) {
+		descriptorSets.descriptorSetsLayout.resize(setCount);
+		for (uint32_t i = 0; i < setCount; ++i) {
+			if (isSharedSet(i)) {
+				descriptorSets.descriptorSetsLayout[i] = PipelineRegistry::get().retainSetLayout(descriptorSets.sharedSets[i].layout);
+				continue;
+			}
+			const auto &bindings = descriptorSets.descriptorSetLayoutBindings[i];
+			descriptorSets.descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			descriptorSets.descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
+			descriptorSets.descriptorSetLayoutCI.pBindings = bindings.empty() ? nullptr : bindings.data();
+			descriptorSets.descriptorSetsLayout[i] = PipelineRegistry::get().acquireSetLayout(device, descriptorSets.descriptorSetLayoutCI);
+		}
 	}
 
-	// 3) Allocate sets
+	// 3) Allocate sets: from the caller's pool if one was given, else from the engine-wide allocator.
+	//    Shared sets are only referenced.
+	releaseDescriptorSets(); // a rebuild replaces the previous sets
+	std::vector<VkDescriptorSetLayout> ownedLayouts;
+	for (uint32_t i = 0; i < setCount; ++i)
+		if (!isSharedSet(i))
+			ownedLayouts.push_back(descriptorSets.descriptorSetsLayout[i]);
+	std::vector<VkDescriptorSet> owned(ownedLayouts.size());
+	if (!owned.empty() && descriptorPool) {
+		descriptorSets.descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptorSets.descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+		descriptorSets.descriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(ownedLayouts.size());
+		descriptorSets.descriptorSetAllocateInfo.pSetLayouts = ownedLayouts.data();
+		VK_CHECK(vkAllocateDescriptorSets(device, &descriptorSets.descriptorSetAllocateInfo, owned.data()));
+	} else if (!owned.empty()) {
+		std::vector<VkDescriptorPoolSize> need;
+		for (const auto &bindings : descriptorSets.descriptorSetLayoutBindings)
+			need = DescriptorAllocator::countDescriptors(bindings, std::move(need));
+		descriptorSetPool = DescriptorAllocator::get().allocate(ownedLayouts, need, owned.data());
+	}
 	descriptorSets.descriptorSets.resize(setCount);
-	descriptorSets.descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptorSets.descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-	descriptorSets.descriptorSetAllocateInfo.descriptorSetCount = setCount;
-	descriptorSets.descriptorSetAllocateInfo.pSetLayouts = descriptorSets.descriptorSetsLayout.data();
-	VK_CHECK(vkAllocateDescriptorSets(device, &descriptorSets.descriptorSetAllocateInfo, descriptorSets.descriptorSets.data()));
+	for (uint32_t i = 0, o = 0; i < setCount; ++i)
+		descriptorSets.descriptorSets[i] = isSharedSet(i) ? descriptorSets.sharedSets[i].set : owned[o++];
 
 	// 4) Patch writes with actual set handles, and collect dynamic order
 	std::vector<VkWriteDescriptorSet> allWrites;
@@ -114,7 +149,7 @@ void Pipeline::createGraphicsPipeline() {
 		pl.pushConstantRangeCount = graphicsPipeline.pushConstantRangeCount;
 		pl.pPushConstantRanges = &graphicsPipeline.pushContantRanges;
 	}
-	VK_CHECK(vkCreatePipelineLayout(device, &pl, nullptr, &pipelineLayout));
+	pipelineLayout = PipelineRegistry::get().acquirePipelineLayout(device, pl);
 
 	auto &vi = graphicsPipeline.vertexInputStateCI;
 	auto &b = graphicsPipeline.vertexInputBindingDescriptions;
@@ -205,7 +240,7 @@ void Pipeline::createGraphicsPipeline() {
 	gp.layout = pipelineLayout;
 	gp.subpass = 0;
 
-	VK_CHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gp, nullptr, &pipeline));
+	pipeline = PipelineRegistry::get().acquireGraphicsPipeline(device, gp);
 }
 
 void Pipeline::createComputePipeline() {
@@ -216,7 +251,7 @@ void Pipeline::createComputePipeline() {
 	computePipeline.pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	computePipeline.pipelineLayoutCI.setLayoutCount = (uint32_t)descriptorSets.descriptorSetsLayout.size();
 	computePipeline.pipelineLayoutCI.pSetLayouts = descriptorSets.descriptorSetsLayout.empty() ? nullptr : descriptorSets.descriptorSetsLayout.data();
-	VK_CHECK(vkCreatePipelineLayout(device, &computePipeline.pipelineLayoutCI, nullptr, &pipelineLayout));
+	pipelineLayout = PipelineRegistry::get().acquirePipelineLayout(device, computePipeline.pipelineLayoutCI);
 
 	VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
 	stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
@@ -227,7 +262,7 @@ void Pipeline::createComputePipeline() {
 	computePipeline.computePipelineCI.stage = stage;
 	computePipeline.computePipelineCI.layout = pipelineLayout;
 
-	VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipeline.computePipelineCI, nullptr, &pipeline));
+	pipeline = PipelineRegistry::get().acquireComputePipeline(device, computePipeline.computePipelineCI);
 }
 
 void Pipeline::createDescriptorSetLayoutBinding(uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags flags, uint32_t descriptorCount, uint32_t setIndex) {
@@ -0,0 +1,426 @@
+#include "pipelineregistry.hpp"
+#include "debug.hpp"
+#include "pipelinecache.hpp"
+
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+uint64_t fnv1a(const void *data, size_t n) {
+	const auto *p = static_cast<const uint8_t *>(data);
+	uint64_t h = 1469598103934665603ull;
+	for (size_t i = 0; i < n; ++i) {
+		h ^= p[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+// Keys are the raw bytes of every field that affects the object; only padding-free PODs go in whole.
+template <typename T> void put(std::string &key, const T &v) {
+	static_assert(std::is_trivially_copyable_v<T>);
+	key.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+template <typename T> void putArray(std::string &key, const T *v, uint32_t n) {
+	put(key, n);
+	for (uint32_t i = 0; i < n; ++i)
+		put(key, v[i]);
+}
+
+// optional create-info sub-state: presence, flags, then its fields; a pNext chain makes it unkeyable
+template <typename S, typename F> void section(std::string &key, bool &shareable, const S *s, F &&fields) {
+	put(key, uint8_t(s != nullptr));
+	if (!s)
+		return;
+	if (s->pNext)
+		shareable = false;
+	put(key, s->flags);
+	fields(*s);
+}
+
+} // namespace
+
+PipelineRegistry &PipelineRegistry::get() {
+	static PipelineRegistry instance;
+	return instance;
+}
+
+PipelineRegistry::Stats PipelineRegistry::stats() const {
+	std::lock_guard lock(mutex);
+	return Stats{modules.size(), setLayouts.entries.size(), pipelineLayouts.entries.size(), pipelines.entries.size(), hits, misses};
+}
+
+// -------------------------------------
+// Shared<Handle>
+// -------------------------------------
+
+template <typename Handle> Handle PipelineRegistry::Shared<Handle>::find(const std::string &key) {
+	auto it = byKey.find(key);
+	if (it == byKey.end())
+		return VK_NULL_HANDLE;
+	++entries[it->second].refs;
+	return it->second;
+}
+
+template <typename Handle> void PipelineRegistry::Shared<Handle>::add(Handle h, std::string key) {
+	byKey.emplace(key, h);
+	entries.emplace(h, Entry{std::move(key), 1});
+}
+
+template <typename Handle> bool PipelineRegistry::Shared<Handle>::release(Handle h, bool &last) {
+	auto it = entries.find(h);
+	if (it == entries.end())
+		return false;
+	last = --it->second.refs == 0;
+	if (last) {
+		byKey.erase(it->second.key);
+		entries.erase(it);
+	}
+	return true;
+}
+
+// -------------------------------------
+// Shader modules
+// -------------------------------------
+
+Assets::ShaderModules PipelineRegistry::shaderProgram(const std::string &shaderRootDir, VkDevice device) {
+	std::lock_guard lock(mutex);
+	auto it = programs.find(shaderRootDir);
+	if (it == programs.end())
+		it = programs.emplace(shaderRootDir, Assets::compileShaderDir(shaderRootDir)).first;
+	const Assets::ShaderBinaries &bins = it->second;
+
+	auto mk = [&](const std::vector<uint32_t> &bin) -> VkShaderModule { return bin.empty() ? VK_NULL_HANDLE : moduleLocked(bin, device); };
+	Assets::ShaderModules out;
+	out.vertexShader = mk(bins.vertexShader);
+	out.tessellationControlShader = mk(bins.tessellationControlShader);
+	out.tessellationEvaluationShader = mk(bins.tessellationEvaluationShader);
+	out.geometryShader = mk(bins.geometryShader);
+	out.fragmentShader = mk(bins.fragmentShader);
+	out.computeShader = mk(bins.computeShader);
+	return out;
+}
+
+VkShaderModule PipelineRegistry::shaderModule(const std::vector<uint32_t> &spirv, VkDevice device) {
+	std::lock_guard lock(mutex);
+	return moduleLocked(spirv, device);
+}
+
+VkShaderModule PipelineRegistry::shaderSource(const std::string &glsl, shaderc_shader_kind kind, VkDevice device) {
+	std::lock_guard lock(mutex);
+	std::string key;
+	put(key, kind);
+	key += glsl;
+	auto it = sources.find(key);
+	if (it == sources.end())
+		it = sources.emplace(std::move(key), Assets::compileShaderSource(glsl, kind)).first;
+	return moduleLocked(it->second, device);
+}
+
+VkShaderModule PipelineRegistry::moduleLocked(const std::vector<uint32_t> &spirv, VkDevice device) {
+	const uint64_t hash = fnv1a(spirv.data(), spirv.size() * sizeof(uint32_t));
+	if (auto it = modulesByHash.find(hash); it != modulesByHash.end()) {
+		Module &m = modules[it->second];
+		if (m.spirv == spirv) {
+			++m.refs;
+			++hits;
+			return it->second;
+		}
+		return Assets::createShaderModule(device, spirv); // hash collision: private module
+	}
+
+	VkShaderModule module = Assets::createShaderModule(device, spirv);
+	modulesByHash.emplace(hash, module);
+	modules.emplace(module, Module{hash, spirv, 1});
+	++misses;
+	return module;
+}
+
+void PipelineRegistry::releaseShaderProgram(Assets::ShaderModules &p, VkDevice device) {
+	std::lock_guard lock(mutex);
+	for (VkShaderModule *m : {&p.vertexShader, &p.tessellationControlShader, &p.tessellationEvaluationShader, &p.geometryShader, &p.fragmentShader, &p.computeShader}) {
+		if (*m)
+			releaseModuleLocked(*m, device);
+		*m = VK_NULL_HANDLE;
+	}
+}
+
+void PipelineRegistry::releaseShaderModule(VkShaderModule module, VkDevice device) {
+	std::lock_guard lock(mutex);
+	releaseModuleLocked(module, device);
+}
+
+void PipelineRegistry::releaseModuleLocked(VkShaderModule module, VkDevice device) {
+	auto it = modules.find(module);
+	if (it != modules.end()) {
+		if (--it->second.refs > 0)
+			return;
+		modulesByHash.erase(it->second.hash);
+		modules.erase(it);
+	}
+	vkDestroyShaderModule(device, module, nullptr);
+}
+
+// -------------------------------------
+// Layouts
+// -------------------------------------
+
+VkDescriptorSetLayout PipelineRegistry::acquireSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo &ci) {
+	std::string key;
+	bool shareable = true;
+	put(key, ci.flags);
+	// binding flags (descriptor indexing) are the one extension keyed; anything else chained stays private
+	const auto *bindingFlags = static_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo *>(ci.pNext);
+	put(key, uint8_t(bindingFlags != nullptr));
+	if (bindingFlags) {
+		if (bindingFlags->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO && !bindingFlags->pNext)
+			putArray(key, bindingFlags->pBindingFlags, bindingFlags->bindingCount);
+		else
+			shareable = false;
+	}
+	for (uint32_t i = 0; i < ci.bindingCount; ++i) {
+		const VkDescriptorSetLayoutBinding &b = ci.pBindings[i];
+		put(key, b.binding);
+		put(key, b.descriptorType);
+		put(key, b.descriptorCount);
+		put(key, b.stageFlags);
+		if (b.pImmutableSamplers)
+			shareable = false;
+	}
+
+	std::lock_guard lock(mutex);
+	if (shareable) {
+		if (VkDescriptorSetLayout hit = setLayouts.find(key)) {
+			++hits;
+			return hit;
+		}
+	}
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateDescriptorSetLayout(device, &ci, nullptr, &layout));
+	if (shareable) {
+		setLayouts.add(layout, std::move(key));
+		++misses;
+	}
+	return layout;
+}
+
+VkDescriptorSetLayout PipelineRegistry::retainSetLayout(VkDescriptorSetLayout layout) {
+	std::lock_guard lock(mutex);
+	auto it = setLayouts.entries.find(layout);
+	if (it == setLayouts.entries.end())
+		throw std::runtime_error("PipelineRegistry::retainSetLayout: layout was not acquired from the registry");
+	++it->second.refs;
+	return layout;
+}
+
+void PipelineRegistry::releaseSetLayout(VkDescriptorSetLayout layout, VkDevice device) {
+	std::lock_guard lock(mutex);
+	releaseSetLayoutLocked(layout, device);
+}
+
+void PipelineRegistry::releaseSetLayoutLocked(VkDescriptorSetLayout layout, VkDevice device) {
+	bool last = true;
+	if (setLayouts.release(layout, last) && !last)
+		return;
+	vkDestroyDescriptorSetLayout(device, layout, nullptr);
+}
+
+VkPipelineLayout PipelineRegistry::acquirePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo &ci) {
+	std::lock_guard lock(mutex);
+	std::string key;
+	bool shareable = ci.pNext == nullptr;
+	put(key, ci.flags);
+	put(key, ci.setLayoutCount);
+	for (uint32_t i = 0; i < ci.setLayoutCount; ++i) {
+		// shared set layouts are unique per content, so their handles stand in for it
+		shareable = shareable && setLayouts.owns(ci.pSetLayouts[i]);
+		put(key, ci.pSetLayouts[i]);
+	}
+	putArray(key, ci.pPushConstantRanges, ci.pushConstantRangeCount);
+
+	if (shareable) {
+		if (VkPipelineLayout hit = pipelineLayouts.find(key)) {
+			++hits;
+			return hit;
+		}
+	}
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	VK_CHECK(vkCreatePipelineLayout(device, &ci, nullptr, &layout));
+	if (shareable) {
+		pipelineLayouts.add(layout, std::move(key));
+		auto &sets = layoutSets[layout];
+		sets.assign(ci.pSetLayouts, ci.pSetLayouts + ci.setLayoutCount);
+		for (VkDescriptorSetLayout s : sets)
+			++setLayouts.entries[s].refs;
+		++misses;
+	}
+	return layout;
+}
+
+void PipelineRegistry::releasePipelineLayout(VkPipelineLayout layout, VkDevice device) {
+	std::lock_guard lock(mutex);
+	releasePipelineLayoutLocked(layout, device);
+}
+
+void PipelineRegistry::releasePipelineLayoutLocked(VkPipelineLayout layout, VkDevice device) {
+	bool last = true;
+	const bool shared = pipelineLayouts.release(layout, last);
+	if (shared && !last)
+		return;
+	vkDestroyPipelineLayout(device, layout, nullptr);
+	if (!shared)
+		return;
+	auto it = layoutSets.find(layout);
+	for (VkDescriptorSetLayout s : it->second)
+		releaseSetLayoutLocked(s, device);
+	layoutSets.erase(it);
+}
+
+// -------------------------------------
+// Pipelines
+// -------------------------------------
+
+bool PipelineRegistry::stageKey(std::string &key, const VkPipelineShaderStageCreateInfo &stage) const {
+	put(key, stage.stage);
+	put(key, stage.flags);
+	auto it = modules.find(stage.module);
+	if (it == modules.end() || stage.pNext || stage.pSpecializationInfo)
+		return false;
+	put(key, it->second.hash);
+	put(key, it->second.spirv.size());
+	key.append(stage.pName ? stage.pName : "");
+	key.push_back('\0');
+	return true;
+}
+
+template <typename Create> VkPipeline PipelineRegistry::pipelineLocked(std::string key, VkPipelineLayout layout, bool shareable, Create &&create) {
+	shareable = shareable && pipelineLayouts.owns(layout);
+	if (shareable) {
+		if (VkPipeline hit = pipelines.find(key)) {
+			++hits;
+			return hit;
+		}
+	}
+	VkPipeline pipeline = create();
+	if (shareable) {
+		pipelines.add(pipeline, std::move(key));
+		pipelineLayoutOf[pipeline] = layout;
+		++pipelineLayouts.entries[layout].refs;
+		++misses;
+	}
+	return pipeline;
+}
+
+VkPipeline PipelineRegistry::acquireGraphicsPipeline(VkDevice device, const VkGraphicsPipelineCreateInfo &ci) {
+	std::lock_guard lock(mutex);
+	std::string key;
+	bool shareable = ci.renderPass == VK_NULL_HANDLE && ci.basePipelineHandle == VK_NULL_HANDLE;
+	put(key, ci.flags);
+	put(key, ci.layout);
+	put(key, ci.stageCount);
+	for (uint32_t i = 0; i < ci.stageCount; ++i)
+		shareable = stageKey(key, ci.pStages[i]) && shareable;
+
+	// dynamic rendering is the only extension struct the engine chains
+	const auto *rendering = static_cast<const VkPipelineRenderingCreateInfo *>(ci.pNext);
+	put(key, uint8_t(rendering != nullptr));
+	if (rendering) {
+		if (rendering->sType != VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO || rendering->pNext)
+			shareable = false;
+		put(key, rendering->viewMask);
+		putArray(key, rendering->pColorAttachmentFormats, rendering->colorAttachmentCount);
+		put(key, rendering->depthAttachmentFormat);
+		put(key, rendering->stencilAttachmentFormat);
+	}
+
+	section(key, shareable, ci.pVertexInputState, [&](const VkPipelineVertexInputStateCreateInfo &s) {
+		putArray(key, s.pVertexBindingDescriptions, s.vertexBindingDescriptionCount);
+		putArray(key, s.pVertexAttributeDescriptions, s.vertexAttributeDescriptionCount);
+	});
+	section(key, shareable, ci.pInputAssemblyState, [&](const VkPipelineInputAssemblyStateCreateInfo &s) {
+		put(key, s.topology);
+		put(key, s.primitiveRestartEnable);
+	});
+	section(key, shareable, ci.pTessellationState, [&](const VkPipelineTessellationStateCreateInfo &s) { put(key, s.patchControlPoints); });
+	section(key, shareable, ci.pViewportState, [&](const VkPipelineViewportStateCreateInfo &s) {
+		putArray(key, s.pViewports, s.pViewports ? s.viewportCount : 0);
+		putArray(key, s.pScissors, s.pScissors ? s.scissorCount : 0);
+		put(key, s.viewportCount);
+		put(key, s.scissorCount);
+	});
+	section(key, shareable, ci.pRasterizationState, [&](const VkPipelineRasterizationStateCreateInfo &s) {
+		put(key, s.depthClampEnable);
+		put(key, s.rasterizerDiscardEnable);
+		put(key, s.polygonMode);
+		put(key, s.cullMode);
+		put(key, s.frontFace);
+		put(key, s.depthBiasEnable);
+		put(key, s.depthBiasConstantFactor);
+		put(key, s.depthBiasClamp);
+		put(key, s.depthBiasSlopeFactor);
+		put(key, s.lineWidth);
+	});
+	section(key, shareable, ci.pMultisampleState, [&](const VkPipelineMultisampleStateCreateInfo &s) {
+		put(key, s.rasterizationSamples);
+		put(key, s.sampleShadingEnable);
+		put(key, s.minSampleShading);
+		put(key, s.alphaToCoverageEnable);
+		put(key, s.alphaToOneEnable);
+		if (s.pSampleMask)
+			shareable = false;
+	});
+	section(key, shareable, ci.pDepthStencilState, [&](const VkPipelineDepthStencilStateCreateInfo &s) {
+		put(key, s.depthTestEnable);
+		put(key, s.depthWriteEnable);
+		put(key, s.depthCompareOp);
+		put(key, s.depthBoundsTestEnable);
+		put(key, s.stencilTestEnable);
+		put(key, s.front);
+		put(key, s.back);
+		put(key, s.minDepthBounds);
+		put(key, s.maxDepthBounds);
+	});
+	section(key, shareable, ci.pColorBlendState, [&](const VkPipelineColorBlendStateCreateInfo &s) {
+		put(key, s.logicOpEnable);
+		put(key, s.logicOp);
+		putArray(key, s.pAttachments, s.attachmentCount);
+		put(key, s.blendConstants);
+	});
+	section(key, shareable, ci.pDynamicState, [&](const VkPipelineDynamicStateCreateInfo &s) { putArray(key, s.pDynamicStates, s.dynamicStateCount); });
+
+	return pipelineLocked(std::move(key), ci.layout, shareable, [&] {
+		VkPipeline p = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateGraphicsPipelines(device, PipelineCache::get(), 1, &ci, nullptr, &p));
+		return p;
+	});
+}
+
+VkPipeline PipelineRegistry::acquireComputePipeline(VkDevice device, const VkComputePipelineCreateInfo &ci) {
+	std::lock_guard lock(mutex);
+	std::string key;
+	put(key, ci.flags);
+	put(key, ci.layout);
+	const bool shareable = stageKey(key, ci.stage) && ci.pNext == nullptr && ci.basePipelineHandle == VK_NULL_HANDLE;
+
+	return pipelineLocked(std::move(key), ci.layout, shareable, [&] {
+		VkPipeline p = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateComputePipelines(device, PipelineCache::get(), 1, &ci, nullptr, &p));
+		return p;
+	});
+}
+
+void PipelineRegistry::releasePipeline(VkPipeline pipeline, VkDevice device) {
+	std::lock_guard lock(mutex);
+	bool last = true;
+	const bool shared = pipelines.release(pipeline, last);
+	if (shared && !last)
+		return;
+	vkDestroyPipeline(device, pipeline, nullptr);
+	if (!shared)
+		return;
+	auto it = pipelineLayoutOf.find(pipeline);
+	releasePipelineLayoutLocked(it->second, device);
+	pipelineLayoutOf.erase(it);
+}
@@ -1,11 +1,44 @@
 #include "scenes.hpp"
+#include "profiler.hpp"
+#include "rendering.hpp"
+#include <algorithm>
 #include <boost/graph/graph_traits.hpp>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <queue>
 #include <stdexcept>
+#include <typeinfo>
 
 Model *Scenes::rayPicked = nullptr;
 
+// "Text #3": dynamic type + index in its layer, for profiler scopes
+static void modelLabel(const Model *m, size_t idx, char (&out)[48]) {
+	const char *n = typeid(*m).name();
+#if defined(_MSC_VER)
+	if (std::strncmp(n, "class ", 6) == 0)
+		n += 6;
+#else
+	while (*n >= '0' && *n <= '9') // Itanium: length prefix
+		++n;
+#endif
+	std::snprintf(out, sizeof(out), "%s #%zu", n, idx);
+}
+
+// Model::record wrapped in a GPU timestamp pair while profiling
+template <typename Fn> static void recordProfiled(VkCommandBuffer cmd, const Model *m, size_t idx, Fn &&fn) {
+	Profiler &prof = Profiler::get();
+	if (!prof.isEnabled()) {
+		fn();
+		return;
+	}
+	char label[48];
+	modelLabel(m, idx, label);
+	const int32_t scope = prof.gpuBegin(cmd, label);
+	fn();
+	prof.gpuEnd(cmd, scope);
+}
+
 Scenes::Scenes(std::shared_ptr<Engine> engine) : engine(engine) {
 	ensureRootExists();
 	initializeRenderingOrder();
@@ -199,6 +232,7 @@ void Scenes::swapChainUpdate(float vw, float vh, float fbw, float fbh) {
 }
 
 void Scenes::tick(float dt, float t) {
+	PROFILE_SCOPE("Scenes::tick");
 	for (const auto v : renderingOrder) {
 		for (const auto &m : v) {
 			if (m->isVisible()) {
@@ -218,17 +252,84 @@ void Scenes::compute(VkCommandBuffer ccmd) {
 	}
 }
 
+// How many batches back a model may move to join one with its pipeline.
+static constexpr size_t kBatchLookback = 32;
+
+// Draw order for one layer: each visible model joins the latest earlier batch with the same pipeline, unless
+// its scissor overlaps something drawn in between (then it starts a new batch). Only non-overlapping draws
+// change order, so blending and depth ties come out the same, and consecutive draws share pipeline state
+// for the BindCache to skip, or one indirect draw when their models merge (mergeRun).
+void Scenes::batchLayer(const vector<Model *> &layer) {
+	drawOrder.clear();
+	batches.clear();
+	for (size_t j = 0; j < layer.size(); ++j) {
+		Model *m = layer[j];
+		if (!m->isVisible())
+			continue;
+		const VkPipeline p = m->getPipeline()->pipeline;
+		const VkRect2D r = m->hasDrawWork() ? m->getScissor() : VkRect2D{};
+
+		uint32_t target = UINT32_MAX;
+		for (size_t k = batches.size(), scanned = 0; k-- > 0 && scanned < kBatchLookback; ++scanned) {
+			if (batches[k].pipeline == p) {
+				target = uint32_t(k);
+				break;
+			}
+			if (Rendering::rectOverlaps(batches[k].bounds, r))
+				break;
+		}
+		if (target == UINT32_MAX) {
+			target = uint32_t(batches.size());
+			batches.push_back(Batch{p, r});
+		} else {
+			batches[target].bounds = Rendering::rectUnion(batches[target].bounds, r);
+		}
+		drawOrder.push_back(Draw{m, j, target});
+	}
+	std::stable_sort(drawOrder.begin(), drawOrder.end(), [](const Draw &a, const Draw &b) { return a.batch < b.batch; });
+}
+
+// Length of the run starting at drawOrder[first] that shares one draw: consecutive models of the same batch whose
+// meshes are in the DrawPool and whose pipeline, view/projection, viewport and scissor match (1 = draws alone).
+size_t Scenes::mergeRun(size_t first) const {
+	const Model *lead = drawOrder[first].model;
+	if (!lead->canMergeDraw())
+		return 1;
+	size_t n = 1;
+	for (; first + n < drawOrder.size(); ++n) {
+		const Draw &d = drawOrder[first + n];
+		if (d.batch != drawOrder[first].batch || !d.model->canMergeDraw() || !lead->mergesWith(*d.model))
+			break;
+	}
+	return n;
+}
+
+// drawOrder through `draw`, except runs of mergeable models: one Model::recordMerged (profiled as the first model)
+template <typename Fn> void Scenes::recordDraws(VkCommandBuffer cmd, Fn &&draw) {
+	for (size_t i = 0; i < drawOrder.size();) {
+		const Draw &d = drawOrder[i];
+		const size_t n = mergeRun(i);
+		if (n > 1) {
+			run.clear();
+			for (size_t k = i; k < i + n; ++k)
+				run.push_back(drawOrder[k].model);
+			recordProfiled(cmd, d.model, d.index, [&] { Model::recordMerged(cmd, run); });
+		} else {
+			recordProfiled(cmd, d.model, d.index, [&] { draw(d.model); });
+		}
+		i += n;
+	}
+}
+
 void Scenes::record(VkCommandBuffer cmd) {
 	if (renderingOrder.empty()) {
 		std::cerr << "[Warning!] Empty render graph!" << std::endl;
 		return;
 	}
 
-	for (const auto &m : renderingOrder[0]) {
-		if (m->isVisible()) {
-			m->record(cmd);
-		}
-	}
+	binds.invalidate();
+	batchLayer(renderingOrder[0]);
+	recordDraws(cmd, [&](Model *m) { m->record(cmd); });
 }
 
 void Scenes::recordUI(VkCommandBuffer cmd, uint32_t blurLayer) {
@@ -237,11 +338,29 @@ void Scenes::recordUI(VkCommandBuffer cmd, uint32_t blurLayer) {
 		return;
 	}
 
-	for (uint32_t i = 1; i < renderingOrder.size(); i++) {
-		for (size_t j = 0; j < renderingOrder[i].size(); j++) {
-			if (i - 1 == blurLayer && renderingOrder[i][j]->isVisible()) {
-				renderingOrder[i][j]->recordUI(cmd, blurLayer);
-			}
-		}
+	const size_t i = size_t(blurLayer) + 1; // 0 = opaque
+	if (i >= renderingOrder.size())
+		return;
+
+	binds.invalidate();
+	batchLayer(renderingOrder[i]);
+	recordDraws(cmd, [&](Model *m) { m->recordUI(cmd, blurLayer); }); // merged models have no recordUI of their own
+}
+
+Scenes::BlurLayerInfo Scenes::blurLayerInfo(uint32_t blurLayer, VkExtent2D extent) const {
+	BlurLayerInfo info{};
+	const size_t i = size_t(blurLayer) + 1; // 0 = opaque
+	if (i >= renderingOrder.size())
+		return info;
+
+	for (Model *m : renderingOrder[i]) {
+		if (!m->isVisible() || !m->hasDrawWork())
+			continue;
+		const VkRect2D r = Rendering::rectClamp(m->getScissor(), extent);
+		if (Rendering::rectEmpty(r))
+			continue;
+		info.bounds = Rendering::rectUnion(info.bounds, r);
+		info.populated = true;
 	}
+	return info;
 }
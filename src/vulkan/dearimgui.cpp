@@ -2,6 +2,7 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_vulkan.h"
+#include "pipelinecache.hpp"
 #include <stdexcept>
 
 DearImGui::~DearImGui() { shutdown(); }
@@ -10,17 +11,15 @@ void DearImGui::createDescriptorPool() {
 	if (imguiDescriptorPool != VK_NULL_HANDLE)
 		return;
 
-	// Big general-purpose pool like you had before
-	VkDescriptorPoolSize pool_sizes[] = {
-		{VK_DESCRIPTOR_TYPE_SAMPLER, 1000},		   {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000}, {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000},			 {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000},			{VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000}, {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000},
-		{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000}, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000},		  {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000}, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000}, {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000},
-	};
+	// ImGui only allocates combined image samplers (the font atlas, plus any AddTexture), freeing them one by one
+	constexpr uint32_t kMaxTextures = 16;
+	VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kMaxTextures};
 
 	VkDescriptorPoolCreateInfo pool_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
 	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-	pool_info.maxSets = 1000u * (uint32_t)(sizeof(pool_sizes) / sizeof(pool_sizes[0]));
-	pool_info.poolSizeCount = (uint32_t)(sizeof(pool_sizes) / sizeof(pool_sizes[0]));
-	pool_info.pPoolSizes = pool_sizes;
+	pool_info.maxSets = kMaxTextures;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes = &pool_size;
 
 	if (vkCreateDescriptorPool(sDevice, &pool_info, nullptr, &imguiDescriptorPool) != VK_SUCCESS) {
 		throw std::runtime_error("ImGui: failed to create descriptor pool");
@@ -61,7 +60,7 @@ void DearImGui::init(GLFWwindow *window, VkInstance instance, VkPhysicalDevice p
 	init.Device = sDevice;
 	init.QueueFamily = sGraphicsQueueFamily;
 	init.Queue = sGraphicsQueue;
-	init.PipelineCache = VK_NULL_HANDLE;
+	init.PipelineCache = PipelineCache::get();
 	init.DescriptorPool = imguiDescriptorPool;
 	init.Subpass = 0;
 	init.MinImageCount = sMinImageCount;
@@ -104,7 +103,7 @@ void DearImGui::onSwapchainRecreated(VkFormat newSwapchainFormat, uint32_t newIm
 	init.Device = sDevice;
 	init.QueueFamily = sGraphicsQueueFamily;
 	init.Queue = sGraphicsQueue;
-	init.PipelineCache = VK_NULL_HANDLE;
+	init.PipelineCache = PipelineCache::get();
 	init.DescriptorPool = imguiDescriptorPool; // reuse
 	init.Subpass = 0;
 	init.MinImageCount = sMinImageCount;
@@ -4,7 +4,7 @@
 #include <cstring>
 #include <stdexcept>
 
-Debug::Debug() {
+Debug::Debug(bool headless) : headless(headless) {
 	validationEnabled = enableValidationLayers;
 	createInstance();
 	setupDebugMessenger();
@@ -43,7 +43,14 @@ bool Debug::checkValidationLayerSupport() const {
 
 std::vector<const char *> Debug::getRequiredExtensions() const {
     std::vector<const char *> exts;
-    
+
+    if (headless) {
+        if (validationEnabled) {
+            exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+        return exts;
+    }
+
     uint32_t glfwCount = 0;
     const char **glfwExts = glfwGetRequiredInstanceExtensions(&glfwCount);
 
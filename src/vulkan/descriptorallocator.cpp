@@ -0,0 +1,176 @@
+#include "descriptorallocator.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// descriptors per set in a new pool, by type: roughly what a Model's sets hold on average
+struct Ratio {
+	VkDescriptorType type;
+	float perSet;
+};
+constexpr Ratio kRatios[] = {
+	{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},		   {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},		  {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+	{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0.5f},		   {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.5f},		  {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.5f},
+	{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f},
+};
+
+bool poolFull(VkResult r) { return r == VK_ERROR_OUT_OF_POOL_MEMORY || r == VK_ERROR_FRAGMENTED_POOL; }
+
+} // namespace
+
+DescriptorAllocator::~DescriptorAllocator() { destroy(); }
+
+DescriptorAllocator &DescriptorAllocator::get() {
+	if (!active)
+		throw std::runtime_error("DescriptorAllocator::get: no allocator (engine not initialized)");
+	return *active;
+}
+
+void DescriptorAllocator::create(VkDevice dev, uint32_t frameOverlap) {
+	destroy();
+	device = dev;
+	frames.resize(frameOverlap);
+	frame = 0;
+	nextSetsPerPool = kFirstSetsPerPool;
+	active = this;
+}
+
+void DescriptorAllocator::destroy() {
+	if (device == VK_NULL_HANDLE)
+		return;
+	// the device is idle by now, and destroying the pools frees whatever is still queued
+	retired.clear();
+	for (const Pool &p : pools)
+		vkDestroyDescriptorPool(device, p.pool, nullptr);
+	for (const FramePools &f : frames)
+		for (VkDescriptorPool p : f.pools)
+			vkDestroyDescriptorPool(device, p, nullptr);
+	pools.clear();
+	frames.clear();
+	if (active == this)
+		active = nullptr;
+	device = VK_NULL_HANDLE;
+}
+
+std::vector<VkDescriptorPoolSize> DescriptorAllocator::countDescriptors(std::span<const VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorPoolSize> into) {
+	for (const VkDescriptorSetLayoutBinding &b : bindings) {
+		auto it = std::find_if(into.begin(), into.end(), [&](const VkDescriptorPoolSize &s) { return s.type == b.descriptorType; });
+		if (it == into.end())
+			into.push_back({b.descriptorType, b.descriptorCount});
+		else
+			it->descriptorCount += b.descriptorCount;
+	}
+	return into;
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets, std::span<const VkDescriptorPoolSize> need, VkDescriptorPoolCreateFlags flags) {
+	std::vector<VkDescriptorPoolSize> sizes;
+	for (const Ratio &r : kRatios)
+		sizes.push_back({r.type, std::max(1u, uint32_t(r.perSet * float(maxSets)))});
+	for (const VkDescriptorPoolSize &n : need) {
+		auto it = std::find_if(sizes.begin(), sizes.end(), [&](const VkDescriptorPoolSize &s) { return s.type == n.type; });
+		if (it == sizes.end())
+			sizes.push_back(n);
+		else
+			it->descriptorCount = std::max(it->descriptorCount, n.descriptorCount);
+	}
+
+	VkDescriptorPoolCreateInfo ci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+	ci.flags = flags;
+	ci.maxSets = maxSets;
+	ci.poolSizeCount = uint32_t(sizes.size());
+	ci.pPoolSizes = sizes.data();
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateDescriptorPool(device, &ci, nullptr, &pool));
+	return pool;
+}
+
+VkResult DescriptorAllocator::tryAllocate(VkDescriptorPool pool, std::span<const VkDescriptorSetLayout> layouts, VkDescriptorSet *out) const {
+	VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+	ai.descriptorPool = pool;
+	ai.descriptorSetCount = uint32_t(layouts.size());
+	ai.pSetLayouts = layouts.data();
+	return vkAllocateDescriptorSets(device, &ai, out);
+}
+
+// -------------------------------------
+// Long-lived sets
+// -------------------------------------
+
+VkDescriptorPool DescriptorAllocator::allocate(std::span<const VkDescriptorSetLayout> layouts, std::span<const VkDescriptorPoolSize> need, VkDescriptorSet *out) {
+	if (layouts.empty())
+		return VK_NULL_HANDLE;
+	const uint32_t count = uint32_t(layouts.size());
+
+	// newest first: older pools only have room where sets were freed
+	for (size_t i = pools.size(); i-- > 0;) {
+		Pool &p = pools[i];
+		if (p.exhausted)
+			continue;
+		const VkResult r = tryAllocate(p.pool, layouts, out);
+		if (r == VK_SUCCESS)
+			return p.pool;
+		if (!poolFull(r))
+			VK_CHECK(r);
+		p.exhausted = true;
+	}
+
+	const uint32_t maxSets = std::max(nextSetsPerPool, count);
+	nextSetsPerPool = std::min(nextSetsPerPool * 2, kMaxSetsPerPool);
+	pools.push_back({createPool(maxSets, need, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT), false});
+
+	VK_CHECK(tryAllocate(pools.back().pool, layouts, out));
+	return pools.back().pool;
+}
+
+void DescriptorAllocator::free(VkDescriptorPool pool, std::span<const VkDescriptorSet> sets) {
+	if (device == VK_NULL_HANDLE || pool == VK_NULL_HANDLE || sets.empty())
+		return;
+	if (std::none_of(pools.begin(), pools.end(), [&](const Pool &p) { return p.pool == pool; }))
+		return;
+	retired.push_back({pool, std::vector<VkDescriptorSet>(sets.begin(), sets.end()), frame});
+}
+
+// -------------------------------------
+// Per-frame sets
+// -------------------------------------
+
+VkDescriptorSet DescriptorAllocator::allocateTransient(uint32_t frame, VkDescriptorSetLayout layout, std::span<const VkDescriptorPoolSize> need) {
+	FramePools &f = frames.at(frame);
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	for (; f.current < f.pools.size(); ++f.current) {
+		const VkResult r = tryAllocate(f.pools[f.current], {&layout, 1}, &set);
+		if (r == VK_SUCCESS)
+			return set;
+		if (!poolFull(r))
+			VK_CHECK(r);
+	}
+
+	f.pools.push_back(createPool(kTransientSetsPerPool, need, 0));
+	f.current = f.pools.size() - 1;
+	VK_CHECK(tryAllocate(f.pools.back(), {&layout, 1}, &set));
+	return set;
+}
+
+void DescriptorAllocator::resetFrame(uint32_t frameIndex) {
+	if (frameIndex >= frames.size())
+		return;
+	FramePools &f = frames[frameIndex];
+	for (VkDescriptorPool p : f.pools)
+		vkResetDescriptorPool(device, p, 0);
+	f.current = 0;
+
+	++frame;
+	// freed during frame N: frame N's submission has completed once the fence of frame N + frameOverlap was waited on
+	while (!retired.empty() && retired.front().frame + frames.size() <= frame) {
+		const Retired &r = retired.front();
+		vkFreeDescriptorSets(device, r.pool, uint32_t(r.sets.size()), r.sets.data());
+		auto it = std::find_if(pools.begin(), pools.end(), [&](const Pool &p) { return p.pool == r.pool; });
+		if (it != pools.end())
+			it->exhausted = false;
+		retired.pop_front();
+	}
+}
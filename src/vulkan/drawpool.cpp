@@ -0,0 +1,334 @@
+#include "drawpool.hpp"
+#include "debug.hpp"
+#include "logicaldevice.hpp"
+#include "memory.hpp"
+#include "textureheap.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+uint64_t fnv1a(const void *data, size_t n, uint64_t h = 1469598103934665603ull) {
+	const auto *p = static_cast<const uint8_t *>(data);
+	for (size_t i = 0; i < n; ++i) {
+		h ^= p[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+uint64_t contentHash(const void *vertices, size_t vertexBytes, uint32_t stride, const uint32_t *indices, size_t indexCount) {
+	uint64_t h = fnv1a(&stride, sizeof(stride));
+	h = fnv1a(vertices, vertexBytes, h);
+	return fnv1a(indices, indexCount * sizeof(uint32_t), h);
+}
+
+} // namespace
+
+// -------------------------------------
+// FreeList
+// -------------------------------------
+
+void DrawPool::FreeList::reset(VkDeviceSize capacity) {
+	ranges.clear();
+	if (capacity > 0)
+		ranges.push_back({0, capacity});
+}
+
+bool DrawPool::FreeList::take(VkDeviceSize size, VkDeviceSize align, VkDeviceSize &offset) {
+	if (size == 0 || align == 0)
+		return false;
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		const Range r = ranges[i];
+		const VkDeviceSize at = (r.offset + align - 1) / align * align;
+		if (at + size > r.offset + r.size)
+			continue;
+
+		// keep what is left on either side
+		const Range front{r.offset, at - r.offset};
+		const Range back{at + size, r.offset + r.size - (at + size)};
+		if (front.size > 0 && back.size > 0) {
+			ranges[i] = front;
+			ranges.insert(ranges.begin() + std::ptrdiff_t(i) + 1, back);
+		} else if (front.size > 0) {
+			ranges[i] = front;
+		} else if (back.size > 0) {
+			ranges[i] = back;
+		} else {
+			ranges.erase(ranges.begin() + std::ptrdiff_t(i));
+		}
+		offset = at;
+		return true;
+	}
+	return false;
+}
+
+void DrawPool::FreeList::give(VkDeviceSize offset, VkDeviceSize size) {
+	if (size == 0)
+		return;
+	auto next = std::lower_bound(ranges.begin(), ranges.end(), offset, [](const Range &r, VkDeviceSize o) { return r.offset < o; });
+	auto it = ranges.insert(next, Range{offset, size});
+	if (auto after = it + 1; after != ranges.end() && it->offset + it->size == after->offset) {
+		it->size += after->size;
+		ranges.erase(after);
+	}
+	if (it != ranges.begin()) {
+		auto before = it - 1;
+		if (before->offset + before->size == it->offset) {
+			before->size += it->size;
+			ranges.erase(it);
+		}
+	}
+}
+
+VkDeviceSize DrawPool::FreeList::freeTotal() const {
+	VkDeviceSize total = 0;
+	for (const Range &r : ranges)
+		total += r.size;
+	return total;
+}
+
+// -------------------------------------
+// DrawPool
+// -------------------------------------
+
+DrawPool::~DrawPool() { destroy(); }
+
+DrawPool &DrawPool::get() {
+	if (!active)
+		throw std::runtime_error("DrawPool::get: no draw pool (engine not initialized)");
+	return *active;
+}
+
+void DrawPool::create(const LogicalDevice &ld, VkPhysicalDevice phys, uint32_t frameOverlap) {
+	destroy();
+	logical = &ld;
+	device = ld.getDevice();
+	physicalDevice = phys;
+
+	multiDraw = ld.supportsMultiDrawIndirect();
+	VkPhysicalDeviceProperties props{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &props);
+	maxDrawCount = std::max(1u, props.limits.maxDrawIndirectCount);
+
+	createBuffer(kVertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuf, vertexMem);
+	createBuffer(VkDeviceSize(kIndexCount) * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuf, indexMem);
+	vertexFree.reset(kVertexBytes);
+	indexFree.reset(kIndexCount);
+
+	frames.resize(frameOverlap);
+	for (Frame &f : frames) {
+		createBuffer(kInstanceBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, f.instances, f.instanceMemory);
+		VK_CHECK(vkMapMemory(device, f.instanceMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&f.instanceData)));
+		createBuffer(VkDeviceSize(kMaxCommands) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, f.args, f.argsMemory);
+		VK_CHECK(vkMapMemory(device, f.argsMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&f.argsData)));
+	}
+	frame = 0;
+	warnedFull = false;
+
+	active = this;
+}
+
+void DrawPool::destroy() {
+	if (device == VK_NULL_HANDLE)
+		return;
+	// the device is idle by now; models still holding geometry just drop their Geometry handles
+	for (Frame &f : frames) {
+		vkDestroyBuffer(device, f.instances, nullptr);
+		vkFreeMemory(device, f.instanceMemory, nullptr); // unmaps
+		vkDestroyBuffer(device, f.args, nullptr);
+		vkFreeMemory(device, f.argsMemory, nullptr);
+	}
+	frames.clear();
+	vkDestroyBuffer(device, vertexBuf, nullptr);
+	vkFreeMemory(device, vertexMem, nullptr);
+	vkDestroyBuffer(device, indexBuf, nullptr);
+	vkFreeMemory(device, indexMem, nullptr);
+	vertexBuf = indexBuf = VK_NULL_HANDLE;
+	vertexMem = indexMem = VK_NULL_HANDLE;
+
+	entries.clear();
+	freeEntries.clear();
+	byContent.clear();
+	vertexFree.reset(0);
+	indexFree.reset(0);
+	if (active == this)
+		active = nullptr;
+	logical = nullptr;
+	device = VK_NULL_HANDLE;
+}
+
+void DrawPool::createBuffer(VkDeviceSize bytes, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer &buf, VkDeviceMemory &mem) const {
+	VkBufferCreateInfo bi{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+	bi.size = bytes;
+	bi.usage = usage;
+	bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VK_CHECK(vkCreateBuffer(device, &bi, nullptr, &buf));
+
+	VkMemoryRequirements req{};
+	vkGetBufferMemoryRequirements(device, buf, &req);
+	VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+	ai.allocationSize = req.size;
+	ai.memoryTypeIndex = Memory::findMemoryType(physicalDevice, req.memoryTypeBits, props);
+	VK_CHECK(vkAllocateMemory(device, &ai, nullptr, &mem));
+	VK_CHECK(vkBindBufferMemory(device, buf, mem, 0));
+}
+
+void DrawPool::upload(const void *vertices, VkDeviceSize vertexBytes, VkDeviceSize vertexOffset, const uint32_t *indices, VkDeviceSize indexCount, VkDeviceSize firstIndex) const {
+	const VkDeviceSize indexBytes = indexCount * sizeof(uint32_t);
+	VkBuffer staging = VK_NULL_HANDLE;
+	VkDeviceMemory stagingMem = VK_NULL_HANDLE;
+	createBuffer(vertexBytes + indexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
+
+	uint8_t *p = nullptr;
+	VK_CHECK(vkMapMemory(device, stagingMem, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&p)));
+	std::memcpy(p, vertices, size_t(vertexBytes));
+	std::memcpy(p + vertexBytes, indices, size_t(indexBytes));
+	vkUnmapMemory(device, stagingMem);
+
+	// only ranges no frame in flight reads are written (freed ones are retired first)
+	VkCommandBuffer cmd = logical->beginSingleUseCmd();
+	const VkBufferCopy vreg{0, vertexOffset, vertexBytes};
+	vkCmdCopyBuffer(cmd, staging, vertexBuf, 1, &vreg);
+	const VkBufferCopy ireg{vertexBytes, firstIndex * sizeof(uint32_t), indexBytes};
+	vkCmdCopyBuffer(cmd, staging, indexBuf, 1, &ireg);
+	logical->endSingleUseCmdGraphics(cmd);
+
+	vkDestroyBuffer(device, staging, nullptr);
+	vkFreeMemory(device, stagingMem, nullptr);
+}
+
+bool DrawPool::acquireGeometry(const void *vertices, size_t vertexBytes, uint32_t stride, const uint32_t *indices, size_t indexCount, Geometry &out) {
+	if (device == VK_NULL_HANDLE || !vertices || !indices || vertexBytes == 0 || indexCount == 0 || stride == 0)
+		return false;
+
+	const uint64_t key = contentHash(vertices, vertexBytes, stride, indices, indexCount);
+	auto [first, last] = byContent.equal_range(key);
+	for (auto it = first; it != last; ++it) {
+		Entry &e = entries[it->second];
+		if (e.stride != stride || e.vertices.size() != vertexBytes || e.indices.size() != indexCount)
+			continue;
+		if (std::memcmp(e.vertices.data(), vertices, vertexBytes) != 0 || !std::equal(e.indices.begin(), e.indices.end(), indices))
+			continue;
+		++e.refs;
+		out = Geometry{e.firstIndex, int32_t(e.vertexByteOffset / stride), it->second};
+		return true;
+	}
+
+	VkDeviceSize vertexOffset = 0, firstIndex = 0;
+	if (!vertexFree.take(vertexBytes, stride, vertexOffset)) {
+		std::fprintf(stderr, "[DrawPool] vertex pool full (%zu bytes requested); the model keeps its own buffers\n", vertexBytes);
+		return false;
+	}
+	if (!indexFree.take(indexCount, 1, firstIndex)) {
+		vertexFree.give(vertexOffset, vertexBytes);
+		std::fprintf(stderr, "[DrawPool] index pool full (%zu indices requested); the model keeps its own buffers\n", indexCount);
+		return false;
+	}
+	upload(vertices, vertexBytes, vertexOffset, indices, indexCount, firstIndex);
+
+	uint32_t id;
+	if (!freeEntries.empty()) {
+		id = freeEntries.back();
+		freeEntries.pop_back();
+	} else {
+		id = uint32_t(entries.size());
+		entries.emplace_back();
+	}
+	Entry &e = entries[id];
+	const auto *vbytes = static_cast<const uint8_t *>(vertices);
+	e.vertices.assign(vbytes, vbytes + vertexBytes);
+	e.indices.assign(indices, indices + indexCount);
+	e.stride = stride;
+	e.vertexByteOffset = vertexOffset;
+	e.firstIndex = uint32_t(firstIndex);
+	e.refs = 1;
+	byContent.emplace(key, id);
+
+	out = Geometry{e.firstIndex, int32_t(vertexOffset / stride), id};
+	return true;
+}
+
+void DrawPool::releaseGeometry(Geometry &geometry) {
+	const uint32_t id = geometry.entry;
+	geometry = Geometry{};
+	if (id >= entries.size() || entries[id].refs == 0 || --entries[id].refs > 0)
+		return;
+
+	// no new user finds it from here on; its ranges are reused once no frame in flight can still read them
+	const Entry &e = entries[id];
+	auto [first, last] = byContent.equal_range(contentHash(e.vertices.data(), e.vertices.size(), e.stride, e.indices.data(), e.indices.size()));
+	for (auto it = first; it != last; ++it) {
+		if (it->second == id) {
+			byContent.erase(it);
+			break;
+		}
+	}
+
+	auto retire = [this, id] {
+		if (id >= entries.size())
+			return; // destroyed meanwhile
+		Entry &r = entries[id];
+		vertexFree.give(r.vertexByteOffset, r.vertices.size());
+		indexFree.give(r.firstIndex, r.indices.size());
+		r = Entry{};
+		freeEntries.push_back(id);
+	};
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(TextureHeap::kInvalid, retire);
+	else
+		retire();
+}
+
+void DrawPool::beginFrame(uint32_t frameIndex) {
+	if (frames.empty())
+		return;
+	frame = frameIndex % uint32_t(frames.size());
+	frames[frame].instanceUsed = 0;
+	frames[frame].commandsUsed = 0;
+}
+
+bool DrawPool::streamsFull() {
+	if (!warnedFull) {
+		std::fprintf(stderr, "[DrawPool] this frame's instance/indirect streams are full; the remaining runs draw per model\n");
+		warnedFull = true;
+	}
+	return false;
+}
+
+bool DrawPool::allocInstances(VkDeviceSize bytes, Slice &out) {
+	if (frames.empty())
+		return false;
+	Frame &f = frames[frame];
+	const VkDeviceSize at = (f.instanceUsed + 15) & ~VkDeviceSize(15);
+	if (at + bytes > kInstanceBytes)
+		return streamsFull();
+	f.instanceUsed = at + bytes;
+	out = Slice{f.instances, at, f.instanceData + at};
+	return true;
+}
+
+bool DrawPool::allocCommands(uint32_t count, Slice &out) {
+	if (frames.empty())
+		return false;
+	Frame &f = frames[frame];
+	if (count > kMaxCommands - f.commandsUsed)
+		return streamsFull();
+	const VkDeviceSize at = VkDeviceSize(f.commandsUsed) * sizeof(VkDrawIndexedIndirectCommand);
+	f.commandsUsed += count;
+	out = Slice{f.args, at, f.argsData + at};
+	return true;
+}
+
+void DrawPool::drawIndirect(VkCommandBuffer cmd, const Slice &args, uint32_t count) const {
+	constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	for (uint32_t done = 0; done < count;) {
+		const uint32_t n = std::min(count - done, maxDrawCount);
+		vkCmdDrawIndexedIndirect(cmd, args.buffer, args.offset + VkDeviceSize(done) * stride, n, stride);
+		done += n;
+	}
+}
@@ -1,7 +1,15 @@
 #include "engine.hpp"
+#include "assets.hpp"
+#include "memory.hpp"
+#include "profiler.hpp"
 #include "rendering.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
 
 using namespace Rendering;
@@ -17,16 +25,32 @@ void Engine::init(GLFWwindow *w) {
 		surface = std::make_unique<Surface>(debug->getInstance(), window);
 		physicalDevice = std::make_unique<PhysicalDevice>(debug->getInstance(), surface->getSurface());
 		logicalDevice = std::make_unique<LogicalDevice>(physicalDevice->getPhysicalDevice(), physicalDevice->getQueueFamilies(), requiredDeviceExtensions, enableValidationLayers);
+		pipelineCache = std::make_unique<PipelineCache>();
+		pipelineCache->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), Assets::joinPath(Assets::appdataPath, "pipeline_cache.bin"));
+		descriptorAllocator = std::make_unique<DescriptorAllocator>();
+		descriptorAllocator->create(logicalDevice->getDevice(), 2);
+		textureHeap = std::make_unique<TextureHeap>();
+		textureHeap->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), 2);
+		textureAtlas = std::make_unique<TextureAtlas>();
+		textureAtlas->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice());
+		drawPool = std::make_unique<DrawPool>();
+		drawPool->create(*logicalDevice, physicalDevice->getPhysicalDevice(), 2);
 		swapchain = std::make_unique<Swapchain>(physicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), surface->getSurface(), physicalDevice->getQueueFamilies(), window);
 		graphicsBuffers = std::make_unique<GraphicsBuffers>();
 		graphicsBuffers->create(physicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), swapchain->getExtent(), VK_FORMAT_R16G16B16A16_SFLOAT, static_cast<uint32_t>(swapchain->getImages().size()));
 
+		downsampler = std::make_unique<Downsampler>();
+		downsampler->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice());
+		downsampler->bindTargets(*graphicsBuffers);
+
 		commandBuffers = std::make_unique<CommandBuffers>();
 		commandBuffers->create(logicalDevice->getDevice(), logicalDevice->getGraphicsQueueFamily(), 2);
 
 		synchronization = std::make_unique<Synchronization>();
 		synchronization->create(logicalDevice->getDevice(), 2, static_cast<uint32_t>(swapchain->getImages().size()));
 
+		Profiler::get().create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), logicalDevice->getGraphicsQueueFamily(), 2);
+
 		imgui = std::make_unique<DearImGui>();
 		imgui->init(w, debug->getInstance(), logicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), logicalDevice->getGraphicsQueueFamily(), logicalDevice->getGraphicsQueue(), swapchain->getImageFormat(), static_cast<uint32_t>(swapchain->getImages().size()), 2);
 
@@ -37,13 +61,75 @@ void Engine::init(GLFWwindow *w) {
 	}
 }
 
-void Engine::beginImGuiFrame() { imgui->newFrame(); }
+void Engine::initHeadless(uint32_t width, uint32_t height) {
+	headless = true;
+	headlessExtent = {width, height};
+
+	try {
+		debug = std::make_unique<Debug>(true);
+		physicalDevice = std::make_unique<PhysicalDevice>(debug->getInstance(), VK_NULL_HANDLE);
+		logicalDevice = std::make_unique<LogicalDevice>(physicalDevice->getPhysicalDevice(), physicalDevice->getQueueFamilies(), std::vector<const char *>{}, enableValidationLayers);
+
+		pipelineCache = std::make_unique<PipelineCache>();
+		pipelineCache->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), Assets::joinPath(Assets::appdataPath, "pipeline_cache.bin"));
+		descriptorAllocator = std::make_unique<DescriptorAllocator>();
+		descriptorAllocator->create(logicalDevice->getDevice(), 2);
+		textureHeap = std::make_unique<TextureHeap>();
+		textureHeap->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), 2);
+		textureAtlas = std::make_unique<TextureAtlas>();
+		textureAtlas->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice());
+		drawPool = std::make_unique<DrawPool>();
+		drawPool->create(*logicalDevice, physicalDevice->getPhysicalDevice(), 2);
+
+		VkPhysicalDeviceProperties props{};
+		vkGetPhysicalDeviceProperties(physicalDevice->getPhysicalDevice(), &props);
+		std::fprintf(stderr, "[Engine] headless %ux%u on %s\n", width, height, props.deviceName);
+
+		graphicsBuffers = std::make_unique<GraphicsBuffers>();
+		graphicsBuffers->create(physicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), headlessExtent, VK_FORMAT_R16G16B16A16_SFLOAT, swapImageCount);
+
+		downsampler = std::make_unique<Downsampler>();
+		downsampler->create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice());
+		downsampler->bindTargets(*graphicsBuffers);
+
+		commandBuffers = std::make_unique<CommandBuffers>();
+		commandBuffers->create(logicalDevice->getDevice(), logicalDevice->getGraphicsQueueFamily(), 2);
+
+		synchronization = std::make_unique<Synchronization>();
+		synchronization->create(logicalDevice->getDevice(), 2, swapImageCount);
+
+		createReadbacks();
+		Profiler::get().create(logicalDevice->getDevice(), physicalDevice->getPhysicalDevice(), logicalDevice->getGraphicsQueueFamily(), 2);
+
+		currentFrameIndex = 0;
+		headlessImageIndex = 0;
+		lastReadbackFrame = -1;
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "Engine headless init failed: %s\n", e.what());
+		throw;
+	}
+}
+
+Engine::~Engine() {
+	if (logicalDevice)
+		vkDeviceWaitIdle(logicalDevice->getDevice());
+	destroyReadbacks();
+	Profiler::get().destroy();
+}
+
+void Engine::beginImGuiFrame() {
+	if (imgui)
+		imgui->newFrame();
+}
 
 // -------------------------------------
 // Swapchain recreation / resize
 // -------------------------------------
 
 void Engine::recreateSwapchain(Scenes &scenes) {
+	if (headless)
+		return;
+
 	// Wait until not minimized (we just use this to block, not to size scenes)
 	int w_fb = 0, h_fb = 0;
 	do {
@@ -58,8 +144,10 @@ void Engine::recreateSwapchain(Scenes &scenes) {
 	swapchain->recreate(physicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), surface->getSurface(), physicalDevice->getQueueFamilies(), window);
 
 	// Recreate offscreen/color/depth buffers for the *new* extent
+	downsampler->releaseTargets();
 	graphicsBuffers->destroy();
 	graphicsBuffers->create(physicalDevice->getPhysicalDevice(), logicalDevice->getDevice(), swapchain->getExtent(), VK_FORMAT_R16G16B16A16_SFLOAT, (uint32_t)swapchain->getImages().size());
+	downsampler->bindTargets(*graphicsBuffers);
 
 	// Recreate sync in case counts changed
 	synchronization->destroy();
@@ -78,68 +166,51 @@ void Engine::recreateSwapchain(Scenes &scenes) {
 // drawFrame(): multipass blur compositing
 // -------------------------------------
 
-void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
+// GENERAL COMPUTE (pre-graphics): culling, picking, etc. Blocks until done.
+void Engine::submitCompute(Scenes &scenes) {
 	VkDevice dev = logicalDevice->getDevice();
-	VkQueue gfxQ = logicalDevice->getGraphicsQueue();
-	VkQueue presQ = logicalDevice->getPresentQueue();
-
-	// --- CPU-GPU sync for this overlapping frame ---
-	VkFence frameFence = synchronization->inFlightFence(currentFrameIndex);
-	vkWaitForFences(dev, 1, &frameFence, VK_TRUE, UINT64_MAX);
-
-	// Also ensure last compute using this frame index is finished  // NEW
 	VkFence compFence = synchronization->computeFence(currentFrameIndex);
-	vkWaitForFences(dev, 1, &compFence, VK_TRUE, UINT64_MAX);
 
-	// --- Acquire swapchain image ---
-	uint32_t imageIndex = 0;
-	VkSemaphore imageAvail = synchronization->imageAvailable(currentFrameIndex);
+	// Reuse per-frame compute cmd
+	VkCommandBuffer ccmd = commandBuffers->getComputeCmd(currentFrameIndex);
+	vkResetFences(dev, 1, &compFence);
+	vkResetCommandBuffer(ccmd, 0);
 
-	VkResult acq = vkAcquireNextImageKHR(dev, swapchain->getHandle(), UINT64_MAX, imageAvail, VK_NULL_HANDLE, &imageIndex);
+	VkCommandBufferBeginInfo cbi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	VK_CHECK(vkBeginCommandBuffer(ccmd, &cbi));
 
-	if (acq == VK_ERROR_OUT_OF_DATE_KHR || framebufferResizedFlag) {
-		recreateSwapchain(scenes);
-		return;
-	} else if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR) {
-		throw std::runtime_error("Engine::drawFrame: failed to acquire swapchain image");
-	}
+	// this slot's fences were waited on: read back its timestamps and reset the queries
+	Profiler::get().beginGpuFrame(ccmd, currentFrameIndex);
 
-	// -----------------------------
-	// GENERAL COMPUTE (pre-graphics)
-	// -----------------------------
+	// Let scenes encode anything: culling, particles, light lists, prefix sums, etc.
 	{
-		// Reuse per-frame compute cmd
-		VkCommandBuffer ccmd = commandBuffers->getComputeCmd(currentFrameIndex);
-		vkResetFences(dev, 1, &compFence);
-		vkResetCommandBuffer(ccmd, 0);
-
-		VkCommandBufferBeginInfo cbi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-		VK_CHECK(vkBeginCommandBuffer(ccmd, &cbi));
-
-		// Let scenes encode anything: culling, particles, light lists, prefix sums, etc.
+		PROFILE_SCOPE("Scenes::compute");
+		PROFILE_GPU_SCOPE(ccmd, "compute");
 		scenes.compute(ccmd);
+	}
 
-		VK_CHECK(vkEndCommandBuffer(ccmd));
+	VK_CHECK(vkEndCommandBuffer(ccmd));
 
-		// Submit to compute queue, signal compute-finished semaphore & fence
-		VkSemaphore compDone = synchronization->computeFinished(currentFrameIndex);
+	// Submit to compute queue, signal compute-finished semaphore & fence
+	VkSemaphore compDone = synchronization->computeFinished(currentFrameIndex);
 
-		VkSubmitInfo csubmit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-		csubmit.commandBufferCount = 1;
-		csubmit.pCommandBuffers = &ccmd;
-		csubmit.signalSemaphoreCount = 1;
-		csubmit.pSignalSemaphores = &compDone;
+	VkSubmitInfo csubmit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	csubmit.commandBufferCount = 1;
+	csubmit.pCommandBuffers = &ccmd;
+	csubmit.signalSemaphoreCount = 1;
+	csubmit.pSignalSemaphores = &compDone;
 
-		VK_CHECK(vkQueueSubmit(logicalDevice->getComputeQueue(), 1, &csubmit, compFence));
-	}
+	VK_CHECK(vkQueueSubmit(logicalDevice->getComputeQueue(), 1, &csubmit, compFence));
 
 	vkWaitForFences(dev, 1, &compFence, VK_TRUE, UINT64_MAX);
+}
 
-	// We'll re-record this frame's command buffer
-	VkCommandBuffer cmd = commandBuffers->getGraphicsCmd(currentFrameIndex);
-
-	vkResetFences(dev, 1, &frameFence);
-	vkResetCommandBuffer(cmd, 0);
+// Records the opaque bootstrap + blur layers for this image's accumulation targets.
+// Returns the image holding the final composite (mip chain in SHADER_READ_ONLY_OPTIMAL).
+VkImage Engine::recordLayers(VkCommandBuffer cmd, Scenes &scenes, uint32_t imageIndex) {
+	PROFILE_SCOPE("Engine::recordLayers");
+	Profiler &prof = Profiler::get();
+	char label[48];
 
 	// We describe state of "src" and "dst" accumulation targets.
 	// We'll ping-pong them as we go through blur layers.
@@ -148,9 +219,10 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 		VkImageView attView;	 // mip0 attachment view
 		VkImageView sampleView;	 // full-mip SRV view
 		VkDescriptorSet descSet; // already bound to sampleView+sampler
+		uint32_t mipSlot;		 // Downsampler slot (idx * 2 + B)
 	};
-	auto makeA = [&](uint32_t idx) -> AccumState { return AccumState{graphicsBuffers->getColorAImage(idx), graphicsBuffers->getColorAAttView(idx), graphicsBuffers->getColorASampleView(idx), graphicsBuffers->getSceneSetA(idx)}; };
-	auto makeB = [&](uint32_t idx) -> AccumState { return AccumState{graphicsBuffers->getColorBImage(idx), graphicsBuffers->getColorBAttView(idx), graphicsBuffers->getColorBSampleView(idx), graphicsBuffers->getSceneSetB(idx)}; };
+	auto makeA = [&](uint32_t idx) -> AccumState { return AccumState{graphicsBuffers->getColorAImage(idx), graphicsBuffers->getColorAAttView(idx), graphicsBuffers->getColorASampleView(idx), graphicsBuffers->getSceneSetA(idx), idx * 2 + 0}; };
+	auto makeB = [&](uint32_t idx) -> AccumState { return AccumState{graphicsBuffers->getColorBImage(idx), graphicsBuffers->getColorBAttView(idx), graphicsBuffers->getColorBSampleView(idx), graphicsBuffers->getSceneSetB(idx), idx * 2 + 1}; };
 
 	AccumState accumA = makeA(imageIndex);
 	AccumState accumB = makeB(imageIndex);
@@ -164,8 +236,7 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 	VkImage depthImg = graphicsBuffers->getDepthImage();
 	VkImageView depthView = graphicsBuffers->getDepthView();
 
-	const VkExtent2D extent = swapchain->getExtent();
-	const uint32_t mipLevels = graphicsBuffers->getMipLevels();
+	const VkExtent2D extent = getExtent();
 
 	// convenience lambdas for swapping and for depth layout ensure
 
@@ -175,120 +246,220 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 		accumDst = tmp;
 	};
 
-	// record command buffer
+	//-----------------------------------------
+	// 0) Prep depth to DEPTH_ATTACHMENT_OPTIMAL
+	//-----------------------------------------
+	cmdTransitionImage(cmd, depthImg, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+	//-----------------------------------------
+	// 1) OPAQUE / BACKGROUND BOOTSTRAP
+	//    We render opaque world into accumDst.mip0, clearing color+depth.
+	//-----------------------------------------
+	// accumDst.mip0: UNDEFINED -> COLOR_ATTACHMENT_OPTIMAL
+	cmdTransitionImage(cmd, accumDst.img, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+
+	// Begin rendering opaque world.
 	{
-		VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-		bi.flags = 0;
-		VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+		VkClearColorValue clrBlack{};
+		clrBlack.float32[0] = 0.f;
+		clrBlack.float32[1] = 0.f;
+		clrBlack.float32[2] = 0.f;
+		clrBlack.float32[3] = 0.f;
+
+		VkClearDepthStencilValue clrDepth{};
+		clrDepth.depth = 1.0f;
+		clrDepth.stencil = 0;
+
+		cmdBeginRenderingColorDepth(cmd, accumDst.attView, depthView, extent, clrBlack, clrDepth,
+									/*colorLoad*/ VK_ATTACHMENT_LOAD_OP_CLEAR,
+									/*colorStore*/ VK_ATTACHMENT_STORE_OP_STORE,
+									/*depthLoad*/ VK_ATTACHMENT_LOAD_OP_CLEAR,
+									/*depthStore*/ VK_ATTACHMENT_STORE_OP_STORE);
+
+		// opaque scene draw call(s)
+		const int32_t opaqueScope = prof.gpuBegin(cmd, "opaque");
+		scenes.record(cmd);
+		prof.gpuEnd(cmd, opaqueScope);
+		vkCmdEndRendering(cmd);
+	}
 
-		//-----------------------------------------
-		// 0) Prep depth to DEPTH_ATTACHMENT_OPTIMAL
-		//-----------------------------------------
-		cmdTransitionImage(cmd, depthImg, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	// Now accumDst.mip0 has opaque+depth. We want accumDst to become "src" for next steps.
+	// For mipgen we expect level0 in COLOR_ATTACHMENT_OPTIMAL.
+	// We'll build mips (compute downsampler, blit fallback) and leave accumDst in SHADER_READ_ONLY_OPTIMAL.
+	{
+		PROFILE_GPU_SCOPE(cmd, "opaque mips");
+		downsampler->record(cmd, accumDst.mipSlot);
+	}
 
-		//-----------------------------------------
-		// 1) OPAQUE / BACKGROUND BOOTSTRAP
-		//    We render opaque world into accumDst.mip0, clearing color+depth.
-		//-----------------------------------------
-		// accumDst.mip0: UNDEFINED -> COLOR_ATTACHMENT_OPTIMAL
-		cmdTransitionImage(cmd, accumDst.img, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+	// After mip build, accumDst is SHADER_READ_ONLY_OPTIMAL.
+	// For future blits we may have to TRANSFER_SRC_OPTIMAL again, but see below.
+
+	// So after opaque stage, the fully composited scene so far is in accumDst.
+	// Make that the "src".
+	swapAccum(); // accumSrc now has opaque scene in SHADER_READ_ONLY_OPTIMAL
+
+	//-----------------------------------------
+	// 2) TRANSLUCENT / BLUR LAYERS
+	// We'll render each blur layer back-to-front.
+	//-----------------------------------------
+
+	// Dirty-rect bookkeeping:
+	// - layers Scenes reports as empty are skipped outright (no copy / pass / mips).
+	// - accumDst starts out holding last frame's data, so the first populated layer copies + re-mips everything.
+	// - after that, the two targets only differ inside the previous layer's bounds, so we copy just that rect,
+	//   render inside the layer's bounds, and re-mip their union.
+	const VkRect2D fullRect{{0, 0}, extent};
+	bool dstStale = true;
+	VkRect2D dstDiff = fullRect; // where accumDst differs from accumSrc
+
+	for (uint32_t layerIdx = 0; layerIdx < blurLayerCount; ++layerIdx) {
+		const Scenes::BlurLayerInfo layer = scenes.blurLayerInfo(layerIdx, extent);
+		if (!layer.populated)
+			continue;
+
+		std::snprintf(label, sizeof(label), "blur layer %u", layerIdx);
+		const int32_t layerScope = prof.gpuBegin(cmd, label);
+		std::snprintf(label, sizeof(label), "layer %u copy", layerIdx);
+		const int32_t copyScope = prof.gpuBegin(cmd, label);
+
+		// Before we can copy accumSrc.mip0 into accumDst.mip0, we need accumSrc.mip0 usable as TRANSFER_SRC.
+		// Right now after mip build accumSrc was SHADER_READ_ONLY_OPTIMAL.
+		// We'll do:
+		//   SHADER_READ_ONLY_OPTIMAL -> TRANSFER_SRC_OPTIMAL (only mip0 is needed for blit)
+		cmdTransitionImage(cmd, accumSrc.img, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+		// Copy src.mip0 -> dst.mip0, then dst goes COLOR_ATTACHMENT_OPTIMAL
+		// (dst.mip0 was left TRANSFER_SRC_OPTIMAL when it was the previous layer's src)
+		if (dstStale)
+			cmdCopyBaseMipToDstAndMakeColorAttachment(cmd, accumSrc.img, accumDst.img, extent.width, extent.height);
+		else
+			cmdCopyBaseMipRegionToDstAndMakeColorAttachment(cmd, accumSrc.img, accumDst.img, dstDiff, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		prof.gpuEnd(cmd, copyScope);
 
-		// Begin rendering opaque world.
+		// Make sure depth is already DEPTH_ATTACHMENT_OPTIMAL (it is).
+		// We are doing a LOAD on color (because dst already has copy of background),
+		// and LOAD on depth (keep same depth buffer, no clear).
 		{
-			VkClearColorValue clrBlack{};
-			clrBlack.float32[0] = 0.f;
-			clrBlack.float32[1] = 0.f;
-			clrBlack.float32[2] = 0.f;
-			clrBlack.float32[3] = 0.f;
-
-			VkClearDepthStencilValue clrDepth{};
-			clrDepth.depth = 1.0f;
-			clrDepth.stencil = 0;
-
-			cmdBeginRenderingColorDepth(cmd, accumDst.attView, depthView, extent, clrBlack, clrDepth,
-										/*colorLoad*/ VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VkClearColorValue dummyClr{};
+			dummyClr.float32[0] = 0.f;
+			dummyClr.float32[1] = 0.f;
+			dummyClr.float32[2] = 0.f;
+			dummyClr.float32[3] = 0.f;
+
+			VkClearDepthStencilValue dummyDepth{};
+			dummyDepth.depth = 1.0f;
+			dummyDepth.stencil = 0;
+
+			cmdBeginRenderingColorDepth(cmd, accumDst.attView, depthView, extent, dummyClr, dummyDepth,
+										/*colorLoad*/ VK_ATTACHMENT_LOAD_OP_LOAD,
 										/*colorStore*/ VK_ATTACHMENT_STORE_OP_STORE,
-										/*depthLoad*/ VK_ATTACHMENT_LOAD_OP_CLEAR,
-										/*depthStore*/ VK_ATTACHMENT_STORE_OP_STORE);
-
-			// opaque scene draw call(s)
-			scenes.record(cmd);
+										/*depthLoad*/ VK_ATTACHMENT_LOAD_OP_LOAD,
+										/*depthStore*/ VK_ATTACHMENT_STORE_OP_STORE, &layer.bounds);
+
+			// Draw all objects in this blur layer.
+			// They sample accumSrc via descriptor set (accumSrc.descSet),
+			// depth test ON, depthWrite OFF, alpha blend ON in the bound pipeline.
+			std::snprintf(label, sizeof(label), "layer %u draw", layerIdx);
+			const int32_t drawScope = prof.gpuBegin(cmd, label);
+			scenes.recordUI(cmd, layerIdx);
+			prof.gpuEnd(cmd, drawScope);
 			vkCmdEndRendering(cmd);
 		}
 
-		// Now accumDst.mip0 has opaque+depth. We want accumDst to become "src" for next steps.
-		// For mipgen we expect level0 in COLOR_ATTACHMENT_OPTIMAL.
-		// We'll build mips and leave accumDst in SHADER_READ_ONLY_OPTIMAL.
-		cmdBuildMipsForImageRuntime(cmd, accumDst.img, extent.width, extent.height, mipLevels);
+		// After we're done drawing into accumDst, accumDst.mip0 is in COLOR_ATTACHMENT_OPTIMAL.
+		// Build its mip chain so future layers can blur it.
+		std::snprintf(label, sizeof(label), "layer %u mips", layerIdx);
+		const int32_t mipScope = prof.gpuBegin(cmd, label);
+		if (dstStale) {
+			downsampler->record(cmd, accumDst.mipSlot);
+		} else {
+			const VkRect2D mipRect = rectUnion(dstDiff, layer.bounds);
+			downsampler->record(cmd, accumDst.mipSlot, &mipRect);
+		}
+		prof.gpuEnd(cmd, mipScope);
+		prof.gpuEnd(cmd, layerScope);
 
-		// After mip build, accumDst is SHADER_READ_ONLY_OPTIMAL.
-		// For future blits we may have to TRANSFER_SRC_OPTIMAL again, but see below.
+		// Swap roles so next layer sees new composite as src.
+		swapAccum();
+		dstStale = false;
+		dstDiff = layer.bounds;
+	}
 
-		// So after opaque stage, the fully composited scene so far is in accumDst.
-		// Make that the "src".
-		swapAccum(); // accumSrc now has opaque scene in SHADER_READ_ONLY_OPTIMAL
+	return accumSrc.img;
+}
 
-		//-----------------------------------------
-		// 2) TRANSLUCENT / BLUR LAYERS
-		// We'll render each blur layer back-to-front.
-		//-----------------------------------------
+void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
+	PROFILE_SCOPE("Engine::drawFrame");
+	VkDevice dev = logicalDevice->getDevice();
+	VkQueue gfxQ = logicalDevice->getGraphicsQueue();
+	VkQueue presQ = logicalDevice->getPresentQueue();
 
-		for (uint32_t layerIdx = 0; layerIdx < blurLayerCount; ++layerIdx) {
-			// Before we can copy accumSrc.mip0 into accumDst.mip0, we need accumSrc.mip0 usable as TRANSFER_SRC.
-			// Right now after mip build accumSrc was SHADER_READ_ONLY_OPTIMAL.
-			// We'll do:
-			//   SHADER_READ_ONLY_OPTIMAL -> TRANSFER_SRC_OPTIMAL (only mip0 is needed for blit)
-			cmdTransitionImage(cmd, accumSrc.img, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+	// --- CPU-GPU sync for this overlapping frame ---
+	VkFence frameFence = synchronization->inFlightFence(currentFrameIndex);
+	vkWaitForFences(dev, 1, &frameFence, VK_TRUE, UINT64_MAX);
 
-			// Copy src.mip0 -> dst.mip0, then dst goes COLOR_ATTACHMENT_OPTIMAL
-			cmdCopyBaseMipToDstAndMakeColorAttachment(cmd, accumSrc.img, accumDst.img, extent.width, extent.height);
+	// Also ensure last compute using this frame index is finished  // NEW
+	VkFence compFence = synchronization->computeFence(currentFrameIndex);
+	vkWaitForFences(dev, 1, &compFence, VK_TRUE, UINT64_MAX);
 
-			// Make sure depth is already DEPTH_ATTACHMENT_OPTIMAL (it is).
-			// We are doing a LOAD on color (because dst already has copy of background),
-			// and LOAD on depth (keep same depth buffer, no clear).
-			{
-				VkClearColorValue dummyClr{};
-				dummyClr.float32[0] = 0.f;
-				dummyClr.float32[1] = 0.f;
-				dummyClr.float32[2] = 0.f;
-				dummyClr.float32[3] = 0.f;
-
-				VkClearDepthStencilValue dummyDepth{};
-				dummyDepth.depth = 1.0f;
-				dummyDepth.stencil = 0;
-
-				cmdBeginRenderingColorDepth(cmd, accumDst.attView, depthView, extent, dummyClr, dummyDepth,
-											/*colorLoad*/ VK_ATTACHMENT_LOAD_OP_LOAD,
-											/*colorStore*/ VK_ATTACHMENT_STORE_OP_STORE,
-											/*depthLoad*/ VK_ATTACHMENT_LOAD_OP_LOAD,
-											/*depthStore*/ VK_ATTACHMENT_STORE_OP_STORE);
-
-				// Draw all objects in this blur layer.
-				// They sample accumSrc via descriptor set (accumSrc.descSet),
-				// depth test ON, depthWrite OFF, alpha blend ON in the bound pipeline.
-				scenes.recordUI(cmd, layerIdx);
-				vkCmdEndRendering(cmd);
-			}
+	// --- Acquire swapchain image ---
+	uint32_t imageIndex = 0;
+	VkSemaphore imageAvail = synchronization->imageAvailable(currentFrameIndex);
 
-			// After we're done drawing into accumDst, accumDst.mip0 is in COLOR_ATTACHMENT_OPTIMAL.
-			// Build its mip chain so future layers can blur it.
-			cmdBuildMipsForImageRuntime(cmd, accumDst.img, extent.width, extent.height, mipLevels);
+	VkResult acq = vkAcquireNextImageKHR(dev, swapchain->getHandle(), UINT64_MAX, imageAvail, VK_NULL_HANDLE, &imageIndex);
 
-			// Swap roles so next layer sees new composite as src.
-			swapAccum();
-		}
+	if (acq == VK_ERROR_OUT_OF_DATE_KHR || framebufferResizedFlag) {
+		recreateSwapchain(scenes);
+		return;
+	} else if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR) {
+		throw std::runtime_error("Engine::drawFrame: failed to acquire swapchain image");
+	}
+
+	// Only once this frame is sure to be submitted: each call counts a frame, and a skipped one (swapchain
+	// recreated above) must not age the deferred frees. Nothing in flight uses this frame's transient descriptor
+	// sets and DrawPool streams, or textures released two frames ago, anymore.
+	descriptorAllocator->resetFrame(currentFrameIndex);
+	textureHeap->beginFrame();
+	drawPool->beginFrame(currentFrameIndex);
+
+	// general compute (pre-graphics), waits for it to finish
+	submitCompute(scenes);
+
+	// We'll re-record this frame's command buffer
+	VkCommandBuffer cmd = commandBuffers->getGraphicsCmd(currentFrameIndex);
+
+	vkResetFences(dev, 1, &frameFence);
+	vkResetCommandBuffer(cmd, 0);
+
+	const VkExtent2D extent = getExtent();
+
+	// ImGui is only drawn while the profiler panel is up
+	const bool drawPanel = imgui && Profiler::get().isPanelVisible();
+	if (drawPanel) {
+		imgui->newFrame();
+		Profiler::get().drawPanel();
+	}
+
+	// record command buffer
+	{
+		VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+		bi.flags = 0;
+		VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+
+		const VkImage finalImg = recordLayers(cmd, scenes, imageIndex);
+		const int32_t blitScope = Profiler::get().gpuBegin(cmd, "final blit");
 
 		//-----------------------------------------
 		// 3) FINAL COMPOSITE + IMGUI to swapchain image
 		//-----------------------------------------
-		// We assume accumSrc currently holds final composited scene in
+		// We assume finalImg currently holds final composited scene in
 		// SHADER_READ_ONLY_OPTIMAL (after its last mip build).
 		// We'll render fullscreen quad + imgui into swapchain img.
 
 		VkImage swapImg = swapchain->getImages()[imageIndex];
 
-		// accumSrc.img: SHADER_READ_ONLY_OPTIMAL -> TRANSFER_SRC_OPTIMAL (only mip0)
-		cmdTransitionImage(cmd, accumSrc.img, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+		// finalImg: SHADER_READ_ONLY_OPTIMAL -> TRANSFER_SRC_OPTIMAL (only mip0)
+		cmdTransitionImage(cmd, finalImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
 
 		// swapImg: UNDEFINED -> TRANSFER_DST_OPTIMAL
 		cmdTransitionImage(cmd, swapImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
@@ -310,7 +481,7 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 		blit.dstOffsets[1] = {int(extent.width), int(extent.height), 1};
 
 		VkBlitImageInfo2 bi2{VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2};
-		bi2.srcImage = accumSrc.img;
+		bi2.srcImage = finalImg;
 		bi2.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 		bi2.dstImage = swapImg;
 		bi2.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -319,16 +490,32 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 		bi2.pRegions = &blit;
 
 		vkCmdBlitImage2(cmd, &bi2);
+		Profiler::get().gpuEnd(cmd, blitScope);
+
+		if (drawPanel) {
+			// profiler panel on top of the composite, straight into the swapchain image
+			PROFILE_GPU_SCOPE(cmd, "imgui");
+			cmdTransitionImage(cmd, swapImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
 
-		// swapImg: TRANSFER_DST_OPTIMAL -> PRESENT_SRC_KHR
-		cmdTransitionImage(cmd, swapImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_NONE, 0);
+			VkClearColorValue noClear{};
+			cmdBeginRenderingColorOnly(cmd, swapchain->getImageViews()[imageIndex], extent, noClear, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE);
+			imgui->recordDraw(cmd);
+			vkCmdEndRendering(cmd);
+
+			// swapImg: COLOR_ATTACHMENT_OPTIMAL -> PRESENT_SRC_KHR
+			cmdTransitionImage(cmd, swapImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 1, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_NONE, 0);
+		} else {
+			// swapImg: TRANSFER_DST_OPTIMAL -> PRESENT_SRC_KHR
+			cmdTransitionImage(cmd, swapImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 1, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_NONE, 0);
+		}
 
 		VK_CHECK(vkEndCommandBuffer(cmd));
 	}
 
 	// --- Submit graphics queue work ---
 	VkSemaphore waitSems[] = {synchronization->imageAvailable(currentFrameIndex), synchronization->computeFinished(currentFrameIndex)};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+	// compute output is consumed as indirect args / instance vertices (GPU culling) and sampled in fragment shaders
+	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
 
 	VkSemaphore signalSems[] = {synchronization->renderFinishedForImage(imageIndex)};
 
@@ -365,3 +552,309 @@ void Engine::drawFrame(Scenes &scenes, bool framebufferResizedFlag) {
 	// advance frame overlap index
 	currentFrameIndex = (currentFrameIndex + 1) % 2; // frameOverlap == 2
 }
+
+// -------------------------------------
+// Headless: render + readback, no present
+// -------------------------------------
+
+void Engine::createReadbacks() {
+	VkDevice dev = logicalDevice->getDevice();
+	VkPhysicalDevice phys = physicalDevice->getPhysicalDevice();
+	const VkDeviceSize bytes = VkDeviceSize(headlessExtent.width) * headlessExtent.height * 8; // RGBA16F
+
+	readbacks.resize(2);
+	for (Readback &rb : readbacks) {
+		VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+		bci.size = bytes;
+		bci.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VK_CHECK(vkCreateBuffer(dev, &bci, nullptr, &rb.buffer));
+
+		VkMemoryRequirements req{};
+		vkGetBufferMemoryRequirements(dev, rb.buffer, &req);
+
+		// cached reads are much faster on the CPU side; coherent is all we strictly need
+		uint32_t typeIndex = 0;
+		try {
+			typeIndex = Memory::findMemoryType(phys, req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		} catch (const std::runtime_error &) {
+			typeIndex = Memory::findMemoryType(phys, req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		}
+
+		VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+		mai.allocationSize = req.size;
+		mai.memoryTypeIndex = typeIndex;
+		VK_CHECK(vkAllocateMemory(dev, &mai, nullptr, &rb.memory));
+		VK_CHECK(vkBindBufferMemory(dev, rb.buffer, rb.memory, 0));
+		VK_CHECK(vkMapMemory(dev, rb.memory, 0, VK_WHOLE_SIZE, 0, &rb.mapped));
+	}
+}
+
+void Engine::destroyReadbacks() {
+	if (!logicalDevice)
+		return;
+	VkDevice dev = logicalDevice->getDevice();
+	for (Readback &rb : readbacks) {
+		if (rb.mapped)
+			vkUnmapMemory(dev, rb.memory);
+		if (rb.buffer)
+			vkDestroyBuffer(dev, rb.buffer, nullptr);
+		if (rb.memory)
+			vkFreeMemory(dev, rb.memory, nullptr);
+	}
+	readbacks.clear();
+}
+
+void Engine::drawFrameHeadless(Scenes &scenes) {
+	PROFILE_SCOPE("Engine::drawFrameHeadless");
+	if (!headless)
+		throw std::runtime_error("Engine::drawFrameHeadless: engine was not initialized headless");
+
+	VkDevice dev = logicalDevice->getDevice();
+
+	VkFence frameFence = synchronization->inFlightFence(currentFrameIndex);
+	vkWaitForFences(dev, 1, &frameFence, VK_TRUE, UINT64_MAX);
+	// no swapchain image to acquire: every frame that gets here is submitted
+	descriptorAllocator->resetFrame(currentFrameIndex);
+	textureHeap->beginFrame();
+	drawPool->beginFrame(currentFrameIndex);
+
+	submitCompute(scenes);
+
+	VkCommandBuffer cmd = commandBuffers->getGraphicsCmd(currentFrameIndex);
+	vkResetFences(dev, 1, &frameFence);
+	vkResetCommandBuffer(cmd, 0);
+
+	const VkExtent2D extent = headlessExtent;
+	const Readback &rb = readbacks[currentFrameIndex];
+
+	{
+		VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+		VK_CHECK(vkBeginCommandBuffer(cmd, &bi));
+
+		const VkImage finalImg = recordLayers(cmd, scenes, headlessImageIndex);
+
+		// finalImg: SHADER_READ_ONLY_OPTIMAL -> TRANSFER_SRC_OPTIMAL (only mip0)
+		cmdTransitionImage(cmd, finalImg, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0; // tightly packed
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {extent.width, extent.height, 1};
+		{
+			PROFILE_GPU_SCOPE(cmd, "readback copy");
+			vkCmdCopyImageToBuffer(cmd, finalImg, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, rb.buffer, 1, &region);
+		}
+
+		// make the copy visible to the host once the fence signals
+		VkBufferMemoryBarrier2 bb{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2};
+		bb.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		bb.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		bb.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+		bb.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+		bb.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bb.buffer = rb.buffer;
+		bb.offset = 0;
+		bb.size = VK_WHOLE_SIZE;
+
+		VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+		dep.bufferMemoryBarrierCount = 1;
+		dep.pBufferMemoryBarriers = &bb;
+		vkCmdPipelineBarrier2(cmd, &dep);
+
+		VK_CHECK(vkEndCommandBuffer(cmd));
+	}
+
+	// only the compute semaphore to wait on, nothing to signal for present
+	VkSemaphore waitSem = synchronization->computeFinished(currentFrameIndex);
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	VkSubmitInfo submit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit.waitSemaphoreCount = 1;
+	submit.pWaitSemaphores = &waitSem;
+	submit.pWaitDstStageMask = &waitStage;
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &cmd;
+
+	VK_CHECK(vkQueueSubmit(logicalDevice->getGraphicsQueue(), 1, &submit, frameFence));
+
+	lastReadbackFrame = int32_t(currentFrameIndex);
+	headlessImageIndex = (headlessImageIndex + 1) % swapImageCount;
+	currentFrameIndex = (currentFrameIndex + 1) % 2; // frameOverlap == 2
+}
+
+namespace {
+
+float halfToFloat(uint16_t h) {
+	const uint32_t sign = uint32_t(h & 0x8000u) << 16;
+	uint32_t exp = (h >> 10) & 0x1Fu;
+	uint32_t mant = h & 0x3FFu;
+
+	uint32_t bits = 0;
+	if (exp == 0) {
+		if (mant == 0) {
+			bits = sign;
+		} else {
+			// subnormal -> normalize
+			exp = 127 - 15 + 1;
+			while ((mant & 0x400u) == 0) {
+				mant <<= 1;
+				--exp;
+			}
+			mant &= 0x3FFu;
+			bits = sign | (exp << 23) | (mant << 13);
+		}
+	} else if (exp == 0x1F) {
+		bits = sign | 0x7F800000u | (mant << 13); // inf / nan
+	} else {
+		bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+	}
+
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+uint8_t linearToSrgb8(float c) {
+	if (!(c > 0.0f))
+		return 0; // also catches NaN
+	if (c >= 1.0f)
+		return 255;
+	const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return uint8_t(s * 255.0f + 0.5f);
+}
+
+uint32_t crc32(const uint8_t *data, size_t n, uint32_t crc = 0) {
+	static const std::array<uint32_t, 256> table = [] {
+		std::array<uint32_t, 256> t{};
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[i] = c;
+		}
+		return t;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < n; ++i)
+		crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+	return ~crc;
+}
+
+void putBE32(std::vector<uint8_t> &out, uint32_t v) {
+	out.push_back(uint8_t(v >> 24));
+	out.push_back(uint8_t(v >> 16));
+	out.push_back(uint8_t(v >> 8));
+	out.push_back(uint8_t(v));
+}
+
+void putChunk(std::vector<uint8_t> &out, const char type[4], const std::vector<uint8_t> &data) {
+	putBE32(out, uint32_t(data.size()));
+	const size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	putBE32(out, crc32(out.data() + start, out.size() - start));
+}
+
+} // namespace
+
+bool Engine::readbackFrame(std::vector<uint8_t> &rgba, uint32_t &width, uint32_t &height) {
+	if (!headless || lastReadbackFrame < 0)
+		return false;
+
+	VkFence fence = synchronization->inFlightFence(uint32_t(lastReadbackFrame));
+	vkWaitForFences(logicalDevice->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+
+	width = headlessExtent.width;
+	height = headlessExtent.height;
+	const size_t texels = size_t(width) * height;
+	rgba.resize(texels * 4);
+
+	const uint16_t *src = static_cast<const uint16_t *>(readbacks[uint32_t(lastReadbackFrame)].mapped);
+	for (size_t i = 0; i < texels; ++i) {
+		rgba[i * 4 + 0] = linearToSrgb8(halfToFloat(src[i * 4 + 0]));
+		rgba[i * 4 + 1] = linearToSrgb8(halfToFloat(src[i * 4 + 1]));
+		rgba[i * 4 + 2] = linearToSrgb8(halfToFloat(src[i * 4 + 2]));
+		rgba[i * 4 + 3] = 255; // the window is opaque, keep goldens that way too
+	}
+	return true;
+}
+
+bool Engine::writeFramePNG(const std::string &path) {
+	std::vector<uint8_t> rgba;
+	uint32_t w = 0, h = 0;
+	if (!readbackFrame(rgba, w, h))
+		return false;
+	return writePNG(path, rgba.data(), w, h);
+}
+
+// Minimal PNG encoder: RGBA8, filter 0, zlib "stored" blocks (no compression, no deps).
+// Plenty for goldens/bench captures; re-encode with a real tool if size matters.
+bool Engine::writePNG(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height) {
+	if (!rgba || width == 0 || height == 0)
+		return false;
+
+	// raw scanlines, each prefixed with filter type 0
+	const size_t rowBytes = size_t(width) * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((rowBytes + 1) * height);
+	for (uint32_t y = 0; y < height; ++y) {
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba + y * rowBytes, rgba + (y + 1) * rowBytes);
+	}
+
+	// zlib stream of stored deflate blocks (max 65535 bytes each)
+	std::vector<uint8_t> z;
+	z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	z.push_back(0x78);
+	z.push_back(0x01);
+	size_t pos = 0;
+	do {
+		const size_t len = std::min<size_t>(65535, raw.size() - pos);
+		const bool last = pos + len == raw.size();
+		z.push_back(last ? 1 : 0);
+		z.push_back(uint8_t(len & 0xFF));
+		z.push_back(uint8_t(len >> 8));
+		z.push_back(uint8_t(~len & 0xFF));
+		z.push_back(uint8_t((~len >> 8) & 0xFF));
+		z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+	} while (pos < raw.size());
+
+	uint32_t a = 1, b = 0; // adler32
+	for (uint8_t v : raw) {
+		a = (a + v) % 65521u;
+		b = (b + a) % 65521u;
+	}
+	putBE32(z, (b << 16) | a);
+
+	std::vector<uint8_t> ihdr;
+	putBE32(ihdr, width);
+	putBE32(ihdr, height);
+	ihdr.push_back(8); // bit depth
+	ihdr.push_back(6); // RGBA
+	ihdr.push_back(0); // deflate
+	ihdr.push_back(0); // filter method
+	ihdr.push_back(0); // no interlace
+
+	std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	putChunk(png, "IHDR", ihdr);
+	putChunk(png, "IDAT", z);
+	putChunk(png, "IEND", {});
+
+	std::ofstream f(path, std::ios::binary);
+	if (!f) {
+		std::fprintf(stderr, "[Engine] cannot open %s for writing\n", path.c_str());
+		return false;
+	}
+	f.write(reinterpret_cast<const char *>(png.data()), std::streamsize(png.size()));
+	return bool(f);
+}
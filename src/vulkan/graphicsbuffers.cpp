@@ -121,7 +121,17 @@ void GraphicsBuffers::createSceneColorTargets() {
 	sceneColorBAttViews.resize(swapCount);
 	sceneColorBSampleViews.resize(swapCount);
 
-	const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	sceneColorAMipViews.assign(swapCount, {});
+	sceneColorBMipViews.assign(swapCount, {});
+
+	// storage writes are needed by the compute downsampler; RGBA16F storage is mandatory, but stay defensive
+	VkFormatProperties fp{};
+	vkGetPhysicalDeviceFormatProperties(phys, sceneColorFmt, &fp);
+	storageMips = (fp.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	if (storageMips)
+		usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 
 	for (uint32_t i = 0; i < swapCount; ++i) {
 		// A
@@ -139,10 +149,28 @@ void GraphicsBuffers::createSceneColorTargets() {
 
 		sceneColorBAttViews[i] = createImageView(sceneColorBImages[i], sceneColorFmt, VK_IMAGE_ASPECT_COLOR_BIT, 0,
 												 1); // mip0 only
+
+		if (storageMips) {
+			for (uint32_t m = 0; m < mipLevels; ++m) {
+				sceneColorAMipViews[i].push_back(createImageView(sceneColorAImages[i], sceneColorFmt, VK_IMAGE_ASPECT_COLOR_BIT, m, 1));
+				sceneColorBMipViews[i].push_back(createImageView(sceneColorBImages[i], sceneColorFmt, VK_IMAGE_ASPECT_COLOR_BIT, m, 1));
+			}
+		}
 	}
 }
 
 void GraphicsBuffers::destroySceneColorTargets() {
+	for (auto &views : sceneColorAMipViews)
+		for (VkImageView v : views)
+			if (v)
+				vkDestroyImageView(dev, v, nullptr);
+	for (auto &views : sceneColorBMipViews)
+		for (VkImageView v : views)
+			if (v)
+				vkDestroyImageView(dev, v, nullptr);
+	sceneColorAMipViews.clear();
+	sceneColorBMipViews.clear();
+
 	for (size_t i = 0; i < sceneColorAImages.size(); ++i) {
 		if (sceneColorAAttViews[i]) {
 			vkDestroyImageView(dev, sceneColorAAttViews[i], nullptr);
@@ -49,9 +49,6 @@ void LogicalDevice::createLogicalDevice(const QueueFamilyIndices &fam, const std
 		qinfos.push_back(qi);
 	}
 
-	VkPhysicalDeviceFeatures feats{};
-	feats.samplerAnisotropy = VK_TRUE;
-
 	// Dynamic rendering
 	VkPhysicalDeviceDynamicRenderingFeatures dynFeat{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES};
 	dynFeat.dynamicRendering = VK_TRUE;
@@ -60,29 +57,45 @@ void LogicalDevice::createLogicalDevice(const QueueFamilyIndices &fam, const std
 	VkPhysicalDeviceSynchronization2Features sync2Feat{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES};
 	sync2Feat.synchronization2 = VK_TRUE;
 
-	// Descriptor Indexing (use the EXT struct; valid on 1.2/1.3)
-	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeat{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+	// Vulkan 1.2 features: descriptor indexing + drawIndirectCount (GPU culling).
+	// The 1.2 struct replaces VkPhysicalDeviceDescriptorIndexingFeatures (the two can't be chained together).
+	VkPhysicalDeviceVulkan12Features supported12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+	VkPhysicalDeviceFeatures2 supported{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+	supported.pNext = &supported12;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+	drawIndirectCount = supported12.drawIndirectCount == VK_TRUE;
+	textureCompressionBC = supported.features.textureCompressionBC == VK_TRUE;
+	multiDrawIndirect = supported.features.multiDrawIndirect == VK_TRUE && supported.features.drawIndirectFirstInstance == VK_TRUE;
+
+	VkPhysicalDeviceFeatures feats{};
+	feats.samplerAnisotropy = VK_TRUE;
+	feats.textureCompressionBC = textureCompressionBC ? VK_TRUE : VK_FALSE; // BC1/BC7 textures (TextureCodec)
+	feats.multiDrawIndirect = multiDrawIndirect ? VK_TRUE : VK_FALSE;		  // merged draws (DrawPool)
+	feats.drawIndirectFirstInstance = multiDrawIndirect ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceVulkan12Features vk12Feat{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+	vk12Feat.drawIndirectCount = drawIndirectCount ? VK_TRUE : VK_FALSE;
 	// Enable the bits you plan to use; the “safe defaults” below cover runtime arrays + UAB:
-	indexingFeat.runtimeDescriptorArray = VK_TRUE;
-	indexingFeat.descriptorBindingPartiallyBound = VK_TRUE;
-	indexingFeat.descriptorBindingVariableDescriptorCount = VK_TRUE;
-	indexingFeat.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
-	indexingFeat.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
-	indexingFeat.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
-	indexingFeat.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
-	indexingFeat.descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE;
-	indexingFeat.descriptorBindingUniformTexelBufferUpdateAfterBind = VK_TRUE;
-	indexingFeat.descriptorBindingStorageTexelBufferUpdateAfterBind = VK_TRUE;
+	vk12Feat.runtimeDescriptorArray = VK_TRUE;
+	vk12Feat.descriptorBindingPartiallyBound = VK_TRUE;
+	vk12Feat.descriptorBindingVariableDescriptorCount = VK_TRUE;
+	vk12Feat.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	vk12Feat.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	vk12Feat.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+	vk12Feat.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+	vk12Feat.descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE;
+	vk12Feat.descriptorBindingUniformTexelBufferUpdateAfterBind = VK_TRUE;
+	vk12Feat.descriptorBindingStorageTexelBufferUpdateAfterBind = VK_TRUE;
 	// non-uniform indexing support in shaders:
-	indexingFeat.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
-	indexingFeat.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
-	indexingFeat.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
-	indexingFeat.shaderUniformBufferArrayNonUniformIndexing = VK_TRUE;
-	indexingFeat.shaderUniformTexelBufferArrayNonUniformIndexing = VK_TRUE;
-	indexingFeat.shaderStorageTexelBufferArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderUniformBufferArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderUniformTexelBufferArrayNonUniformIndexing = VK_TRUE;
+	vk12Feat.shaderStorageTexelBufferArrayNonUniformIndexing = VK_TRUE;
 
 	dynFeat.pNext = &sync2Feat;
-	sync2Feat.pNext = &indexingFeat;
+	sync2Feat.pNext = &vk12Feat;
 
 	VkDeviceCreateInfo ci{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
 	ci.queueCreateInfoCount = (uint32_t)qinfos.size();
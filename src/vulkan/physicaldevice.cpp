@@ -78,6 +78,15 @@ QueueFamilyIndices PhysicalDevice::findQueueFamilies(VkPhysicalDevice dev) const
 			out.graphicsAndComputeFamily = i;
 		}
 
+		if (isHeadless()) {
+			// nothing to present to, the graphics queue stands in
+			if (out.graphicsAndComputeFamily.has_value())
+				out.presentFamily = out.graphicsAndComputeFamily;
+			if (out.isComplete())
+				break;
+			continue;
+		}
+
 		VkBool32 presentSupport = VK_FALSE;
 		vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
 		if (presentSupport) {
@@ -118,14 +127,16 @@ bool PhysicalDevice::isDeviceSuitable(VkPhysicalDevice dev) const {
 	if (!f.isComplete())
 		return false;
 
-	bool extOK = checkDeviceExtensionSupport(dev);
-	if (!extOK)
-		return false;
+	if (!isHeadless()) {
+		bool extOK = checkDeviceExtensionSupport(dev);
+		if (!extOK)
+			return false;
 
-	auto sup = querySwapchainSupport(dev);
-	bool swapOK = !sup.formats.empty() && !sup.presentModes.empty();
-	if (!swapOK)
-		return false;
+		auto sup = querySwapchainSupport(dev);
+		bool swapOK = !sup.formats.empty() && !sup.presentModes.empty();
+		if (!swapOK)
+			return false;
+	}
 
 	VkPhysicalDeviceFeatures feats{};
 	vkGetPhysicalDeviceFeatures(dev, &feats);
@@ -0,0 +1,150 @@
+#include "pipelinecache.hpp"
+#include "debug.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x31435045; // "EPC1"
+
+// prepended to the driver's blob; the driver header only carries the UUID, not the driver version
+struct FileHeader {
+	uint32_t magic;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint8_t uuid[VK_UUID_SIZE];
+	uint64_t dataSize;
+	uint64_t checksum;
+};
+
+uint64_t fnv1a(const uint8_t *p, size_t n) {
+	uint64_t h = 1469598103934665603ull;
+	for (size_t i = 0; i < n; ++i) {
+		h ^= p[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+FileHeader headerFor(const VkPhysicalDeviceProperties &props) {
+	FileHeader h{};
+	h.magic = kMagic;
+	h.vendorID = props.vendorID;
+	h.deviceID = props.deviceID;
+	h.driverVersion = props.driverVersion;
+	std::memcpy(h.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+	return h;
+}
+
+// Returns the driver blob if the file belongs to this device/driver and is intact, empty otherwise.
+std::vector<uint8_t> loadBlob(const std::string &path, const VkPhysicalDeviceProperties &props) {
+	std::ifstream f(path, std::ios::binary);
+	if (!f)
+		return {};
+
+	FileHeader h{};
+	if (!f.read(reinterpret_cast<char *>(&h), sizeof(h)))
+		return {};
+
+	const FileHeader want = headerFor(props);
+	if (h.magic != want.magic || h.vendorID != want.vendorID || h.deviceID != want.deviceID || h.driverVersion != want.driverVersion || std::memcmp(h.uuid, want.uuid, VK_UUID_SIZE) != 0) {
+		std::fprintf(stderr, "[PipelineCache] %s was written by another device/driver, starting empty\n", path.c_str());
+		return {};
+	}
+	if (h.dataSize < sizeof(VkPipelineCacheHeaderVersionOne) || h.dataSize > (uint64_t(1) << 30))
+		return {};
+
+	std::vector<uint8_t> blob(h.dataSize);
+	if (!f.read(reinterpret_cast<char *>(blob.data()), std::streamsize(blob.size())) || fnv1a(blob.data(), blob.size()) != h.checksum) {
+		std::fprintf(stderr, "[PipelineCache] %s is truncated or corrupt, starting empty\n", path.c_str());
+		return {};
+	}
+
+	// the driver's own header must agree too (it rejects mismatches itself, but not every driver does so gracefully)
+	VkPipelineCacheHeaderVersionOne vh{};
+	std::memcpy(&vh, blob.data(), sizeof(vh));
+	if (vh.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || vh.vendorID != props.vendorID || vh.deviceID != props.deviceID || std::memcmp(vh.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return {};
+
+	return blob;
+}
+
+} // namespace
+
+PipelineCache::~PipelineCache() { destroy(); }
+
+void PipelineCache::create(VkDevice dev, VkPhysicalDevice physicalDevice, const std::string &filePath) {
+	destroy();
+	device = dev;
+	path = filePath;
+	vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+	const std::vector<uint8_t> blob = loadBlob(path, props);
+
+	VkPipelineCacheCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	ci.initialDataSize = blob.size();
+	ci.pInitialData = blob.empty() ? nullptr : blob.data();
+	if (vkCreatePipelineCache(device, &ci, nullptr, &cache) != VK_SUCCESS) {
+		// a blob the driver still refuses is not worth failing startup over
+		ci.initialDataSize = 0;
+		ci.pInitialData = nullptr;
+		VK_CHECK(vkCreatePipelineCache(device, &ci, nullptr, &cache));
+	}
+	active = cache;
+}
+
+void PipelineCache::save() const {
+	if (cache == VK_NULL_HANDLE || path.empty())
+		return;
+
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+		return;
+	std::vector<uint8_t> blob(size);
+	if (vkGetPipelineCacheData(device, cache, &size, blob.data()) != VK_SUCCESS)
+		return;
+	blob.resize(size);
+
+	FileHeader h = headerFor(props);
+	h.dataSize = blob.size();
+	h.checksum = fnv1a(blob.data(), blob.size());
+
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+
+	// a crash mid-write must not leave a half file behind for the next run to feed the driver
+	const std::string tmp = path + ".tmp";
+	{
+		std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+		if (!f) {
+			std::fprintf(stderr, "[PipelineCache] cannot write %s\n", tmp.c_str());
+			return;
+		}
+		f.write(reinterpret_cast<const char *>(&h), sizeof(h));
+		f.write(reinterpret_cast<const char *>(blob.data()), std::streamsize(blob.size()));
+		if (!f) {
+			std::fprintf(stderr, "[PipelineCache] failed writing %s\n", tmp.c_str());
+			return;
+		}
+	}
+	fs::rename(tmp, path, ec);
+	if (ec)
+		std::fprintf(stderr, "[PipelineCache] cannot replace %s: %s\n", path.c_str(), ec.message().c_str());
+}
+
+void PipelineCache::destroy() {
+	if (cache == VK_NULL_HANDLE)
+		return;
+	save();
+	vkDestroyPipelineCache(device, cache, nullptr);
+	if (active == cache)
+		active = VK_NULL_HANDLE;
+	cache = VK_NULL_HANDLE;
+	device = VK_NULL_HANDLE;
+}
@@ -0,0 +1,361 @@
+#include "profiler.hpp"
+#include "debug.hpp"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+Profiler &Profiler::get() {
+	static Profiler instance;
+	return instance;
+}
+
+Profiler::Profiler() {
+	building = std::make_unique<FrameRecord>();
+	ring = std::make_unique<RingSlot[]>(kRingFrames);
+	startNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+	if (const char *env = std::getenv("ENGINE_PROFILE"); env && env[0] == '1') {
+		enabledRequested = true;
+		panelVisible = true;
+	}
+}
+
+uint64_t Profiler::nowNs() const {
+	const auto t = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return uint64_t(t) - startNs;
+}
+
+// -------------------------------------
+// GPU query pools
+// -------------------------------------
+
+void Profiler::create(VkDevice dev, VkPhysicalDevice phys, uint32_t queueFamily, uint32_t frameOverlap) {
+	destroy();
+	device = dev;
+
+	VkPhysicalDeviceProperties props{};
+	vkGetPhysicalDeviceProperties(phys, &props);
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(phys, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(phys, &familyCount, families.data());
+
+	const uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+	if (validBits == 0 || props.limits.timestampPeriod <= 0.0f) {
+		std::fprintf(stderr, "[Profiler] no timestamp support on this queue, GPU scopes disabled\n");
+		return;
+	}
+
+	timestampPeriodNs = double(props.limits.timestampPeriod);
+	timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+	gpuSlots.resize(frameOverlap);
+	for (GpuSlot &s : gpuSlots) {
+		VkQueryPoolCreateInfo ci{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		ci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		ci.queryCount = kMaxQueries;
+		VK_CHECK(vkCreateQueryPool(device, &ci, nullptr, &s.pool));
+	}
+}
+
+void Profiler::destroy() {
+	for (GpuSlot &s : gpuSlots) {
+		if (s.pool)
+			vkDestroyQueryPool(device, s.pool, nullptr);
+	}
+	gpuSlots.clear();
+	activeSlot = nullptr;
+	device = VK_NULL_HANDLE;
+}
+
+// -------------------------------------
+// Frame boundaries
+// -------------------------------------
+
+void Profiler::newFrame() {
+	if (owner == std::thread::id())
+		owner = std::this_thread::get_id();
+
+	if (frameEnabled)
+		publish();
+
+	frameEnabled = enabledRequested.load(std::memory_order_relaxed);
+
+	building->frame = ++frameCounter;
+	building->gpuFrame = 0;
+	building->cpuBeginNs = nowNs();
+	building->cpuEndNs = building->cpuBeginNs;
+	building->cpuCount = 0;
+	building->gpuCount = 0;
+	cpuDepth = 0;
+}
+
+void Profiler::beginGpuFrame(VkCommandBuffer firstCmd, uint32_t frameSlot) {
+	activeSlot = nullptr;
+	if (frameSlot >= gpuSlots.size())
+		return;
+
+	GpuSlot &s = gpuSlots[frameSlot];
+	if (s.queries > 0)
+		collect(s);
+	s.queries = 0;
+	s.scopeCount = 0;
+
+	if (!frameEnabled)
+		return;
+
+	vkCmdResetQueryPool(firstCmd, s.pool, 0, kMaxQueries);
+	s.frame = frameCounter;
+	activeSlot = &s;
+	gpuDepth = 0;
+}
+
+void Profiler::collect(GpuSlot &s) {
+	std::vector<uint64_t> data(s.queries);
+	VkResult r = vkGetQueryPoolResults(device, s.pool, 0, s.queries, data.size() * sizeof(uint64_t), data.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (r != VK_SUCCESS || s.scopeCount == 0)
+		return;
+
+	uint64_t base = ~0ull;
+	for (uint32_t i = 0; i < s.scopeCount; ++i)
+		base = std::min(base, data[s.scopes[i].queryBegin] & timestampMask);
+
+	building->gpuFrame = s.frame;
+	building->gpuCount = 0;
+	for (uint32_t i = 0; i < s.scopeCount && building->gpuCount < kMaxEvents; ++i) {
+		const GpuScopeInfo &sc = s.scopes[i];
+		const uint64_t b = data[sc.queryBegin] & timestampMask;
+		const uint64_t e = data[sc.queryEnd] & timestampMask;
+
+		Event &ev = building->gpu[building->gpuCount++];
+		std::memcpy(ev.name, sc.name, sizeof(ev.name));
+		ev.beginNs = uint64_t(double(b - base) * timestampPeriodNs);
+		ev.endNs = e >= b ? uint64_t(double(e - base) * timestampPeriodNs) : ev.beginNs;
+		ev.depth = sc.depth;
+	}
+}
+
+// seqlock write: readers retry if the sequence moved or is odd
+void Profiler::publish() {
+	building->cpuEndNs = nowNs();
+
+	const uint64_t n = published.load(std::memory_order_relaxed);
+	RingSlot &slot = ring[n % kRingFrames];
+	slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.rec = *building;
+	slot.seq.store(2 * n + 2, std::memory_order_release);
+	published.store(n + 1, std::memory_order_release);
+}
+
+// -------------------------------------
+// Scopes
+// -------------------------------------
+
+int32_t Profiler::cpuBegin(const char *name) {
+	if (!frameEnabled || building->cpuCount >= kMaxEvents || !onOwnerThread())
+		return -1;
+
+	const int32_t idx = int32_t(building->cpuCount++);
+	Event &ev = building->cpu[idx];
+	std::snprintf(ev.name, sizeof(ev.name), "%s", name);
+	ev.beginNs = ev.endNs = nowNs();
+	ev.depth = cpuDepth++;
+	return idx;
+}
+
+void Profiler::cpuEnd(int32_t scope) {
+	if (scope < 0 || uint32_t(scope) >= building->cpuCount)
+		return;
+	building->cpu[scope].endNs = nowNs();
+	if (cpuDepth > 0)
+		--cpuDepth;
+}
+
+int32_t Profiler::gpuBegin(VkCommandBuffer cmd, const char *name) {
+	if (!activeSlot || !frameEnabled)
+		return -1;
+	GpuSlot &s = *activeSlot;
+	if (s.scopeCount >= kMaxEvents || s.queries + 2 > kMaxQueries)
+		return -1;
+
+	const int32_t idx = int32_t(s.scopeCount++);
+	GpuScopeInfo &sc = s.scopes[idx];
+	std::snprintf(sc.name, sizeof(sc.name), "%s", name);
+	sc.queryBegin = s.queries++;
+	sc.queryEnd = s.queries++;
+	sc.depth = gpuDepth++;
+
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, s.pool, sc.queryBegin);
+	return idx;
+}
+
+void Profiler::gpuEnd(VkCommandBuffer cmd, int32_t scope) {
+	if (scope < 0 || !activeSlot || uint32_t(scope) >= activeSlot->scopeCount)
+		return;
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, activeSlot->pool, activeSlot->scopes[scope].queryEnd);
+	if (gpuDepth > 0)
+		--gpuDepth;
+}
+
+// -------------------------------------
+// Readers
+// -------------------------------------
+
+static bool readSlot(const std::atomic<uint64_t> &seq, const Profiler::FrameRecord &src, Profiler::FrameRecord &out) {
+	for (int attempt = 0; attempt < 4; ++attempt) {
+		const uint64_t s1 = seq.load(std::memory_order_acquire);
+		if (s1 & 1)
+			continue;
+		out = src;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq.load(std::memory_order_relaxed) == s1)
+			return s1 != 0;
+	}
+	return false;
+}
+
+bool Profiler::latest(FrameRecord &out) const {
+	const uint64_t n = published.load(std::memory_order_acquire);
+	if (n == 0)
+		return false;
+	const RingSlot &slot = ring[(n - 1) % kRingFrames];
+	return readSlot(slot.seq, slot.rec, out);
+}
+
+size_t Profiler::snapshot(std::vector<FrameRecord> &out, size_t maxFrames) const {
+	const uint64_t n = published.load(std::memory_order_acquire);
+	const uint64_t count = std::min<uint64_t>({n, maxFrames, kRingFrames});
+
+	out.resize(count);
+	size_t written = 0;
+	for (uint64_t i = n - count; i < n; ++i) {
+		const RingSlot &slot = ring[i % kRingFrames];
+		if (readSlot(slot.seq, slot.rec, out[written]))
+			++written;
+	}
+	out.resize(written);
+	return written;
+}
+
+static void appendJsonEscaped(std::string &out, const char *s) {
+	for (; *s; ++s) {
+		const char c = *s;
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (uint8_t(c) < 0x20) {
+			out += ' ';
+		} else {
+			out += c;
+		}
+	}
+}
+
+// Chrome trace (chrome://tracing, Perfetto): CPU scopes on tid 1, GPU scopes on tid 2.
+// GPU timestamps are in their own time base; they're placed at the start of the frame record they were
+// collected in, which is close enough to read the per-pass costs.
+bool Profiler::exportChromeTrace(const std::string &path) const {
+	std::vector<FrameRecord> frames;
+	snapshot(frames);
+
+	std::string json = "{\"traceEvents\":[\n";
+	bool first = true;
+	char buf[160];
+
+	auto emit = [&](const Event &ev, uint64_t offsetNs, int tid, uint64_t frame) {
+		if (!first)
+			json += ",\n";
+		first = false;
+		json += "{\"name\":\"";
+		appendJsonEscaped(json, ev.name);
+		std::snprintf(buf, sizeof(buf), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}", tid, double(offsetNs + ev.beginNs) / 1000.0, double(ev.endNs - ev.beginNs) / 1000.0, (unsigned long long)frame);
+		json += buf;
+	};
+
+	for (const FrameRecord &f : frames) {
+		for (uint32_t i = 0; i < f.cpuCount; ++i)
+			emit(f.cpu[i], 0, 1, f.frame);
+		for (uint32_t i = 0; i < f.gpuCount; ++i)
+			emit(f.gpu[i], f.cpuBeginNs, 2, f.gpuFrame);
+	}
+
+	json += "\n],\n\"displayTimeUnit\":\"ms\",\n\"metadata\":{\"thread_name\":{\"1\":\"CPU\",\"2\":\"GPU\"}}}\n";
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		std::fprintf(stderr, "[Profiler] cannot open %s for writing\n", path.c_str());
+		return false;
+	}
+	file << json;
+	return bool(file);
+}
+
+// -------------------------------------
+// ImGui panel
+// -------------------------------------
+
+void Profiler::drawPanel() {
+	if (!panelVisible)
+		return;
+
+	ImGui::SetNextWindowSize(ImVec2(480, 560), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler", &panelVisible)) {
+		ImGui::End();
+		return;
+	}
+
+	bool enabled = enabledRequested.load(std::memory_order_relaxed);
+	if (ImGui::Checkbox("Enabled", &enabled))
+		setEnabled(enabled);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace"))
+		exportChromeTrace("profile_trace.json");
+
+	static std::vector<FrameRecord> frames;
+	snapshot(frames);
+
+	std::vector<float> cpuMs, gpuMs;
+	cpuMs.reserve(frames.size());
+	gpuMs.reserve(frames.size());
+	for (const FrameRecord &f : frames) {
+		cpuMs.push_back(float(double(f.cpuEndNs - f.cpuBeginNs) / 1e6));
+		uint64_t gpuNs = 0;
+		for (uint32_t i = 0; i < f.gpuCount; ++i)
+			if (f.gpu[i].depth == 0)
+				gpuNs += f.gpu[i].endNs - f.gpu[i].beginNs;
+		gpuMs.push_back(float(double(gpuNs) / 1e6));
+	}
+
+	if (!cpuMs.empty()) {
+		ImGui::PlotLines("CPU ms", cpuMs.data(), int(cpuMs.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+		ImGui::PlotLines("GPU ms", gpuMs.data(), int(gpuMs.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+	}
+
+	if (!frames.empty()) {
+		const FrameRecord &f = frames.back();
+		ImGui::Text("frame %llu  cpu %.3f ms  gpu %.3f ms (frame %llu)", (unsigned long long)f.frame, cpuMs.back(), gpuMs.back(), (unsigned long long)f.gpuFrame);
+
+		if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen)) {
+			for (uint32_t i = 0; i < f.gpuCount; ++i) {
+				const Event &ev = f.gpu[i];
+				ImGui::Text("%*s%-36s %8.3f ms", int(ev.depth * 2), "", ev.name, double(ev.endNs - ev.beginNs) / 1e6);
+			}
+		}
+		if (ImGui::CollapsingHeader("CPU", ImGuiTreeNodeFlags_DefaultOpen)) {
+			for (uint32_t i = 0; i < f.cpuCount; ++i) {
+				const Event &ev = f.cpu[i];
+				ImGui::Text("%*s%-36s %8.3f ms", int(ev.depth * 2), "", ev.name, double(ev.endNs - ev.beginNs) / 1e6);
+			}
+		}
+	}
+
+	ImGui::End();
+}
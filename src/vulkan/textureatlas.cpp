@@ -0,0 +1,322 @@
+#include "textureatlas.hpp"
+#include "debug.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+TextureAtlas::~TextureAtlas() { destroy(); }
+
+TextureAtlas &TextureAtlas::get() {
+	if (!active)
+		throw std::runtime_error("TextureAtlas::get: no texture atlas (engine not initialized)");
+	return *active;
+}
+
+void TextureAtlas::create(VkDevice dev, VkPhysicalDevice physical) {
+	destroy();
+	device = dev;
+	physicalDevice = physical;
+	nextPage = 1;
+	active = this;
+}
+
+void TextureAtlas::destroy() {
+	if (device == VK_NULL_HANDLE)
+		return;
+	// the device is idle by now; the heap may already be gone, its slots with it
+	for (auto &kv : pages)
+		destroyPage(kv.second);
+	pages.clear();
+	for (auto &kv : samplers)
+		vkDestroySampler(device, kv.second, nullptr);
+	samplers.clear();
+	if (active == this)
+		active = nullptr;
+	device = VK_NULL_HANDLE;
+}
+
+bool TextureAtlas::fits(VkFormat format, uint32_t w, uint32_t h) {
+	switch (format) {
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+		return w > 0 && h > 0 && w <= kMaxEntryPx && h <= kMaxEntryPx;
+	default:
+		return false;
+	}
+}
+
+void TextureAtlas::stage(const uint8_t *texels, uint32_t w, uint32_t h, uint8_t *dst) {
+	const uint32_t pw = w + 2 * kPadding;
+	const uint32_t ph = h + 2 * kPadding;
+	for (uint32_t y = 0; y < ph; ++y) {
+		const uint32_t sy = std::min(std::max(y, kPadding) - kPadding, h - 1);
+		const uint8_t *src = texels + size_t(sy) * w * 4;
+		uint8_t *row = dst + size_t(y) * pw * 4;
+		for (uint32_t x = 0; x < kPadding; ++x) {
+			std::memcpy(row + size_t(x) * 4, src, 4);
+			std::memcpy(row + size_t(kPadding + w + x) * 4, src + size_t(w - 1) * 4, 4);
+		}
+		std::memcpy(row + size_t(kPadding) * 4, src, size_t(w) * 4);
+	}
+}
+
+TextureAtlas::Region TextureAtlas::allocate(VkFormat format, Filter filter, uint32_t w, uint32_t h) {
+	if (!fits(format, w, h))
+		throw std::runtime_error("TextureAtlas::allocate: " + std::to_string(w) + "x" + std::to_string(h) + " texture does not go in the atlas");
+	const uint32_t cw = w + 2 * kPadding;
+	const uint32_t ch = h + 2 * kPadding;
+
+	auto take = [&](uint32_t id, Page &page, const Cell &cell) {
+		++page.live;
+		Region r;
+		r.page = id;
+		r.heapIndex = page.heapIndex;
+		r.x = cell.x + kPadding;
+		r.y = cell.y + kPadding;
+		r.w = w;
+		r.h = h;
+		r.cellW = cell.w;
+		r.cellH = cell.h;
+		return r;
+	};
+
+	for (auto &[id, page] : pages) {
+		if (page.format != format || page.filter != filter)
+			continue;
+		// a freed cell first (best area fit): re-rasters and icon churn come back at the same sizes
+		auto best = page.freed.end();
+		for (auto it = page.freed.begin(); it != page.freed.end(); ++it)
+			if (it->w >= cw && it->h >= ch && (best == page.freed.end() || it->w * it->h < best->w * best->h))
+				best = it;
+		if (best != page.freed.end()) {
+			const Cell cell = *best;
+			page.freed.erase(best);
+			splitFreed(page, cell, cw, ch);
+			return take(id, page, {cell.x, cell.y, cw, ch});
+		}
+		Cell cell;
+		if (place(page, cw, ch, cell))
+			return take(id, page, cell);
+	}
+
+	const uint32_t id = createPage(format, filter);
+	Page &page = pages.at(id);
+	Cell cell;
+	place(page, cw, ch, cell); // an empty page fits any cell up to kMaxEntryPx + 2 * kPadding
+	return take(id, page, cell);
+}
+
+// Guillotine split of a reused cell: the request takes its top-left corner, the rest goes back to `freed` as two
+// strips. Of the two ways to cut, the one whose full-length strip is larger wins; strips too thin for a 1×1
+// texture and its padding are dropped (the page gets them back when it empties).
+void TextureAtlas::splitFreed(Page &page, const Cell &cell, uint32_t w, uint32_t h) {
+	const uint32_t restW = cell.w - w, restH = cell.h - h;
+	Cell right, below;
+	if (restW * cell.h >= restH * cell.w) { // right strip spans the full height
+		right = {cell.x + w, cell.y, restW, cell.h};
+		below = {cell.x, cell.y + h, w, restH};
+	} else { // bottom strip spans the full width
+		right = {cell.x + w, cell.y, restW, h};
+		below = {cell.x, cell.y + h, cell.w, restH};
+	}
+	constexpr uint32_t kMinCell = 1 + 2 * kPadding;
+	for (const Cell &c : {right, below})
+		if (c.w >= kMinCell && c.h >= kMinCell)
+			page.freed.push_back(c);
+}
+
+// Skyline bottom-left: the lowest position (then the leftmost) where the cell rests on the skyline
+bool TextureAtlas::place(Page &page, uint32_t w, uint32_t h, Cell &out) {
+	std::vector<Node> &sky = page.skyline;
+	size_t bestIndex = sky.size();
+	uint32_t bestY = UINT32_MAX;
+	for (size_t i = 0; i < sky.size(); ++i) {
+		const uint32_t x = sky[i].x;
+		if (x + w > kPageSize)
+			break;
+		uint32_t y = 0;
+		for (size_t j = i; j < sky.size() && sky[j].x < x + w; ++j)
+			y = std::max(y, sky[j].y);
+		if (y + h <= kPageSize && y < bestY) {
+			bestY = y;
+			bestIndex = i;
+		}
+	}
+	if (bestIndex == sky.size())
+		return false;
+
+	out = {sky[bestIndex].x, bestY, w, h};
+
+	// raise [x, x + w) to y + h: trim or drop the segments it covers, then merge equal neighbours
+	const Node raised{out.x, bestY + h, w};
+	sky.insert(sky.begin() + bestIndex, raised);
+	for (size_t i = bestIndex + 1; i < sky.size();) {
+		const uint32_t end = raised.x + raised.w;
+		if (sky[i].x >= end)
+			break;
+		const uint32_t shrink = end - sky[i].x;
+		if (sky[i].w <= shrink) {
+			sky.erase(sky.begin() + i);
+			continue;
+		}
+		sky[i].x += shrink;
+		sky[i].w -= shrink;
+		break;
+	}
+	for (size_t i = 0; i + 1 < sky.size();) {
+		if (sky[i].y == sky[i + 1].y) {
+			sky[i].w += sky[i + 1].w;
+			sky.erase(sky.begin() + i + 1);
+		} else {
+			++i;
+		}
+	}
+	return true;
+}
+
+void TextureAtlas::record(VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize offset, const Region &region) {
+	Page &page = pages.at(region.page);
+
+	VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	b.oldLayout = page.layout;
+	b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	b.srcAccessMask = page.layout == VK_IMAGE_LAYOUT_UNDEFINED ? 0 : VK_ACCESS_SHADER_READ_BIT;
+	b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	b.image = page.image;
+	b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	vkCmdPipelineBarrier(cmd, page.layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &b);
+
+	if (page.layout == VK_IMAGE_LAYOUT_UNDEFINED) { // a new page: what is not packed yet reads transparent
+		const VkClearColorValue clear{};
+		vkCmdClearColorImage(cmd, page.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &b.subresourceRange);
+		VkImageMemoryBarrier w = b;
+		w.oldLayout = w.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		w.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &w);
+	}
+
+	VkBufferImageCopy reg{};
+	reg.bufferOffset = offset;
+	reg.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	reg.imageOffset = {int32_t(region.x - kPadding), int32_t(region.y - kPadding), 0};
+	reg.imageExtent = {region.w + 2 * kPadding, region.h + 2 * kPadding, 1};
+	vkCmdCopyBufferToImage(cmd, staging, page.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &reg);
+
+	b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	b.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &b);
+	page.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void TextureAtlas::release(const Region &region) {
+	if (!region.valid())
+		return;
+	const Cell cell{region.x - kPadding, region.y - kPadding, region.cellW, region.cellH};
+	// frames in flight may still sample the cell: it is reused once they completed
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(TextureHeap::kInvalid, [this, page = region.page, cell] { freeCell(page, cell); });
+	else
+		freeCell(region.page, cell);
+}
+
+void TextureAtlas::freeCell(uint32_t pageId, const Cell &cell) {
+	auto it = pages.find(pageId);
+	if (it == pages.end())
+		return;
+	Page &page = it->second;
+	page.freed.push_back(cell);
+	if (--page.live > 0)
+		return;
+
+	// an empty page is dropped, unless it is the last one of its kind (which starts over instead)
+	const bool last = std::none_of(pages.begin(), pages.end(), [&](const auto &kv) { return kv.first != pageId && kv.second.format == page.format && kv.second.filter == page.filter; });
+	if (last) {
+		page.skyline = {{0, 0, kPageSize}};
+		page.freed.clear();
+		return;
+	}
+	destroyPage(page);
+	pages.erase(it);
+}
+
+uint32_t TextureAtlas::createPage(VkFormat format, Filter filter) {
+	Page page;
+	page.format = format;
+	page.filter = filter;
+	page.skyline.push_back({0, 0, kPageSize});
+
+	VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	ici.imageType = VK_IMAGE_TYPE_2D;
+	ici.format = format;
+	ici.extent = {kPageSize, kPageSize, 1};
+	ici.mipLevels = 1;
+	ici.arrayLayers = 1;
+	ici.samples = VK_SAMPLE_COUNT_1_BIT;
+	ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+	ici.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VK_CHECK(vkCreateImage(device, &ici, nullptr, &page.image));
+
+	VkMemoryRequirements req{};
+	vkGetImageMemoryRequirements(device, page.image, &req);
+	VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+	ai.allocationSize = req.size;
+	ai.memoryTypeIndex = Memory::findMemoryType(physicalDevice, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK(vkAllocateMemory(device, &ai, nullptr, &page.memory));
+	VK_CHECK(vkBindImageMemory(device, page.image, page.memory, 0));
+
+	VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+	vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	vci.image = page.image;
+	vci.format = format;
+	vci.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	VK_CHECK(vkCreateImageView(device, &vci, nullptr, &page.view));
+
+	page.heapIndex = TextureHeap::get().add(page.view, sampler(filter));
+
+	const uint32_t id = nextPage++;
+	pages.emplace(id, std::move(page));
+	return id;
+}
+
+void TextureAtlas::destroyPage(Page &page) {
+	auto destroy = [dev = device, image = page.image, memory = page.memory, view = page.view] {
+		if (view)
+			vkDestroyImageView(dev, view, nullptr);
+		if (image)
+			vkDestroyImage(dev, image, nullptr);
+		if (memory)
+			vkFreeMemory(dev, memory, nullptr);
+	};
+	if (TextureHeap *heap = TextureHeap::current())
+		heap->release(page.heapIndex, destroy);
+	else
+		destroy();
+	page = Page{};
+}
+
+VkSampler TextureAtlas::sampler(Filter filter) {
+	auto it = samplers.find(filter);
+	if (it != samplers.end())
+		return it->second;
+
+	VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sci.magFilter = filter == Filter::Linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	sci.minFilter = filter == Filter::Nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+	sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sci.maxLod = 0.0f;
+	VkSampler s = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateSampler(device, &sci, nullptr, &s));
+	samplers.emplace(filter, s);
+	return s;
+}
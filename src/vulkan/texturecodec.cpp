@@ -0,0 +1,554 @@
+#include "texturecodec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// -------------------------------------
+// Mip filtering
+// -------------------------------------
+
+const std::array<float, 256> &srgbToLinear() {
+	static const std::array<float, 256> lut = [] {
+		std::array<float, 256> t{};
+		for (int i = 0; i < 256; ++i) {
+			const float c = float(i) / 255.0f;
+			t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return t;
+	}();
+	return lut;
+}
+
+uint8_t linearToSrgb(float c) {
+	c = std::clamp(c, 0.0f, 1.0f);
+	const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return uint8_t(std::lround(s * 255.0f));
+}
+
+// 2×2 box filter, averaged in linear space (alpha as is); odd edges repeat the last texel
+void downsample(const uint8_t *src, uint32_t w, uint32_t h, uint8_t *dst, uint32_t nw, uint32_t nh) {
+	const auto &lin = srgbToLinear();
+	for (uint32_t y = 0; y < nh; ++y) {
+		const uint32_t y0 = std::min(2 * y, h - 1), y1 = std::min(2 * y + 1, h - 1);
+		for (uint32_t x = 0; x < nw; ++x) {
+			const uint32_t x0 = std::min(2 * x, w - 1), x1 = std::min(2 * x + 1, w - 1);
+			const uint8_t *p[4] = {src + (size_t(y0) * w + x0) * 4, src + (size_t(y0) * w + x1) * 4, src + (size_t(y1) * w + x0) * 4, src + (size_t(y1) * w + x1) * 4};
+			uint8_t *o = dst + (size_t(y) * nw + x) * 4;
+			for (int c = 0; c < 3; ++c)
+				o[c] = linearToSrgb((lin[p[0][c]] + lin[p[1][c]] + lin[p[2][c]] + lin[p[3][c]]) * 0.25f);
+			o[3] = uint8_t((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+		}
+	}
+}
+
+// -------------------------------------
+// Block compression
+// -------------------------------------
+
+// 4×4 texels at block (bx, by); edges repeat the last row/column
+void fetchBlock(const uint8_t *rgba, uint32_t w, uint32_t h, uint32_t bx, uint32_t by, uint8_t out[64]) {
+	for (uint32_t y = 0; y < 4; ++y)
+		for (uint32_t x = 0; x < 4; ++x) {
+			const uint32_t sx = std::min(bx * 4 + x, w - 1), sy = std::min(by * 4 + y, h - 1);
+			std::memcpy(out + (y * 4 + x) * 4, rgba + (size_t(sy) * w + sx) * 4, 4);
+		}
+}
+
+// Extremes of the block along its principal axis (power iteration on the covariance) over channels [0, N)
+template <int N> void principalEndpoints(const uint8_t px[64], float lo[N], float hi[N]) {
+	float mean[N] = {};
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < N; ++c)
+			mean[c] += px[i * 4 + c];
+	for (int c = 0; c < N; ++c)
+		mean[c] /= 16.0f;
+
+	float cov[N][N] = {};
+	for (int i = 0; i < 16; ++i)
+		for (int a = 0; a < N; ++a)
+			for (int b = 0; b < N; ++b)
+				cov[a][b] += (px[i * 4 + a] - mean[a]) * (px[i * 4 + b] - mean[b]);
+
+	float axis[N];
+	for (int c = 0; c < N; ++c)
+		axis[c] = 1.0f;
+	for (int it = 0; it < 8; ++it) {
+		float next[N] = {};
+		float len = 0.0f;
+		for (int a = 0; a < N; ++a) {
+			for (int b = 0; b < N; ++b)
+				next[a] += cov[a][b] * axis[b];
+			len += next[a] * next[a];
+		}
+		if (len < 1e-12f)
+			break; // flat block: any axis works
+		len = 1.0f / std::sqrt(len);
+		for (int c = 0; c < N; ++c)
+			axis[c] = next[c] * len;
+	}
+
+	float tMin = std::numeric_limits<float>::max(), tMax = -tMin;
+	for (int i = 0; i < 16; ++i) {
+		float t = 0.0f;
+		for (int c = 0; c < N; ++c)
+			t += (px[i * 4 + c] - mean[c]) * axis[c];
+		tMin = std::min(tMin, t);
+		tMax = std::max(tMax, t);
+	}
+	for (int c = 0; c < N; ++c) {
+		lo[c] = std::clamp(mean[c] + tMin * axis[c], 0.0f, 255.0f);
+		hi[c] = std::clamp(mean[c] + tMax * axis[c], 0.0f, 255.0f);
+	}
+}
+
+template <int N> int nearest(const uint8_t *px, const int (*palette)[4], int count) {
+	int best = 0, bestErr = std::numeric_limits<int>::max();
+	for (int p = 0; p < count; ++p) {
+		int err = 0;
+		for (int c = 0; c < N; ++c) {
+			const int d = int(px[c]) - palette[p][c];
+			err += d * d;
+		}
+		if (err < bestErr) {
+			bestErr = err;
+			best = p;
+		}
+	}
+	return best;
+}
+
+uint16_t pack565(const float c[3]) { return uint16_t((std::lround(c[0] * 31.0f / 255.0f) << 11) | (std::lround(c[1] * 63.0f / 255.0f) << 5) | std::lround(c[2] * 31.0f / 255.0f)); }
+
+void unpack565(uint16_t v, int out[4]) {
+	const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+	out[3] = 255;
+}
+
+// LSB-first bit packer for one 128-bit BC7 block
+struct BitWriter {
+	uint8_t *out;
+	uint32_t pos = 0;
+	void put(uint32_t v, uint32_t bits) {
+		for (uint32_t i = 0; i < bits; ++i, ++pos)
+			if ((v >> i) & 1u)
+				out[pos >> 3] |= uint8_t(1u << (pos & 7));
+	}
+};
+
+// 7-bit endpoint + p-bit (the shared lsb) closest to `v`
+void quantizeBC7Endpoint(const float v[4], uint8_t q[4], uint8_t &pbit) {
+	float bestErr = std::numeric_limits<float>::max();
+	for (uint8_t p = 0; p < 2; ++p) {
+		uint8_t cand[4];
+		float err = 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			cand[c] = uint8_t(std::clamp<long>(std::lround((v[c] - p) * 0.5f), 0, 127));
+			const float d = float((cand[c] << 1) | p) - v[c];
+			err += d * d;
+		}
+		if (err < bestErr) {
+			bestErr = err;
+			pbit = p;
+			std::memcpy(q, cand, 4);
+		}
+	}
+}
+
+// -------------------------------------
+// KTX2
+// -------------------------------------
+
+constexpr uint8_t kKtx2Id[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr size_t kKtx2HeaderBytes = 80; // identifier + header + index
+
+uint32_t rd32(const uint8_t *p) {
+	uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+uint64_t rd64(const uint8_t *p) {
+	uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+void put32(std::vector<uint8_t> &b, size_t at, uint32_t v) { std::memcpy(b.data() + at, &v, 4); }
+void put64(std::vector<uint8_t> &b, size_t at, uint64_t v) { std::memcpy(b.data() + at, &v, 8); }
+
+bool isSrgb(VkFormat f) {
+	switch (f) {
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Basic data format descriptor (Khronos Data Format spec) for the formats formatInfo() knows
+std::vector<uint8_t> makeDfd(VkFormat f, const TextureCodec::FormatInfo &fi) {
+	struct Sample {
+		uint16_t bitOffset;
+		uint8_t bitLength;
+		uint8_t channel;
+		uint32_t upper;
+	};
+	constexpr uint8_t kLinear = 0x10; // sample qualifier: alpha of an sRGB format
+	const uint8_t alpha = uint8_t(15 | (isSrgb(f) ? kLinear : 0));
+
+	uint8_t model = 1; // RGBSDA
+	std::vector<Sample> samples;
+	switch (f) {
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		samples = {{0, 8, 2, 255}, {8, 8, 1, 255}, {16, 8, 0, 255}, {24, 8, alpha, 255}};
+		break;
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		model = 128; // BC1A
+		samples = {{0, 64, 0, UINT32_MAX}};
+		break;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+		model = 130; // BC3
+		samples = {{0, 64, alpha, UINT32_MAX}, {64, 64, 0, UINT32_MAX}};
+		break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		model = 134; // BC7
+		samples = {{0, 128, 0, UINT32_MAX}};
+		break;
+	default: // R8G8B8A8
+		samples = {{0, 8, 0, 255}, {8, 8, 1, 255}, {16, 8, 2, 255}, {24, 8, alpha, 255}};
+		break;
+	}
+
+	const uint32_t blockSize = 24 + 16 * uint32_t(samples.size());
+	std::vector<uint8_t> d(4 + blockSize, 0);
+	put32(d, 0, 4 + blockSize);
+	put32(d, 4, 0);							// vendorId / descriptorType: Khronos basic
+	put32(d, 8, 2u | (blockSize << 16));	// versionNumber 2 / descriptorBlockSize
+	d[12] = model;
+	d[13] = 1; // BT.709 primaries
+	d[14] = isSrgb(f) ? 2 : 1;
+	d[16] = d[17] = uint8_t(fi.blockDim - 1);
+	d[20] = uint8_t(fi.blockBytes);
+	for (size_t i = 0; i < samples.size(); ++i) {
+		const size_t at = 28 + 16 * i;
+		std::memcpy(d.data() + at, &samples[i].bitOffset, 2);
+		d[at + 2] = uint8_t(samples[i].bitLength - 1);
+		d[at + 3] = samples[i].channel;
+		put32(d, at + 12, samples[i].upper); // sampleLower stays 0
+	}
+	return d;
+}
+
+size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+} // namespace
+
+// -------------------------------------
+// Formats
+// -------------------------------------
+
+bool TextureCodec::formatInfo(VkFormat format, FormatInfo &out) {
+	switch (format) {
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		out = {1, 4};
+		return true;
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		out = {4, 8};
+		return true;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		out = {4, 16};
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool TextureCodec::isBlockCompressed(VkFormat format) {
+	FormatInfo fi{};
+	return formatInfo(format, fi) && fi.blockDim > 1;
+}
+
+uint32_t TextureCodec::mipCount(uint32_t w, uint32_t h) {
+	uint32_t n = 1;
+	for (uint32_t m = std::max(w, h); m > 1; m >>= 1)
+		++n;
+	return n;
+}
+
+// -------------------------------------
+// Encoding
+// -------------------------------------
+
+TextureCodec::Texture TextureCodec::solid(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	Texture t;
+	t.data = {r, g, b, a};
+	t.levels = {{1, 1, 0, 4}};
+	return t;
+}
+
+TextureCodec::Texture TextureCodec::fromRGBA8(const uint8_t *rgba, uint32_t w, uint32_t h, bool mipmaps, Compression compression) {
+	if (compression == Compression::Auto) {
+		bool opaque = true;
+		for (size_t i = 0, n = size_t(w) * h; i < n && opaque; ++i)
+			opaque = rgba[i * 4 + 3] == 255;
+		compression = opaque ? Compression::BC1 : Compression::BC7;
+	}
+
+	// RGBA8 chain first; each level is filtered from the previous one
+	const uint32_t count = mipmaps ? mipCount(w, h) : 1u;
+	std::vector<std::vector<uint8_t>> chain(count);
+	std::vector<Level> dims(count);
+	chain[0].assign(rgba, rgba + size_t(w) * h * 4);
+	dims[0].w = w;
+	dims[0].h = h;
+	for (uint32_t l = 1; l < count; ++l) {
+		dims[l].w = std::max(1u, dims[l - 1].w / 2);
+		dims[l].h = std::max(1u, dims[l - 1].h / 2);
+		chain[l].resize(size_t(dims[l].w) * dims[l].h * 4);
+		downsample(chain[l - 1].data(), dims[l - 1].w, dims[l - 1].h, chain[l].data(), dims[l].w, dims[l].h);
+	}
+
+	Texture t;
+	t.format = compression == Compression::BC1 ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : compression == Compression::BC7 ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+	FormatInfo fi{};
+	formatInfo(t.format, fi);
+
+	for (uint32_t l = 0; l < count; ++l) {
+		Level lv = dims[l];
+		lv.offset = t.data.size(); // level sizes are whole blocks, so every offset stays block aligned
+		lv.size = size_t((lv.w + fi.blockDim - 1) / fi.blockDim) * ((lv.h + fi.blockDim - 1) / fi.blockDim) * fi.blockBytes;
+		t.data.resize(lv.offset + lv.size);
+
+		uint8_t *dst = t.data.data() + lv.offset;
+		if (compression == Compression::BC1)
+			encodeBC1(chain[l].data(), lv.w, lv.h, dst);
+		else if (compression == Compression::BC7)
+			encodeBC7(chain[l].data(), lv.w, lv.h, dst);
+		else
+			std::memcpy(dst, chain[l].data(), lv.size);
+		t.levels.push_back(lv);
+	}
+	return t;
+}
+
+void TextureCodec::encodeBC1(const uint8_t *rgba, uint32_t w, uint32_t h, uint8_t *out) {
+	const uint32_t bw = (w + 3) / 4, bh = (h + 3) / 4;
+	for (uint32_t by = 0; by < bh; ++by)
+		for (uint32_t bx = 0; bx < bw; ++bx) {
+			uint8_t px[64];
+			fetchBlock(rgba, w, h, bx, by, px);
+
+			float lo[3], hi[3];
+			principalEndpoints<3>(px, lo, hi);
+			uint16_t c0 = pack565(hi), c1 = pack565(lo);
+			if (c0 < c1)
+				std::swap(c0, c1); // c0 > c1 selects the opaque 4-color mode
+
+			uint32_t indices = 0;
+			if (c0 != c1) {
+				int pal[4][4];
+				unpack565(c0, pal[0]);
+				unpack565(c1, pal[1]);
+				for (int c = 0; c < 3; ++c) {
+					pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+					pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+				}
+				for (int i = 0; i < 16; ++i)
+					indices |= uint32_t(nearest<3>(px + i * 4, pal, 4)) << (2 * i);
+			}
+
+			uint8_t *blk = out + (size_t(by) * bw + bx) * 8;
+			std::memcpy(blk, &c0, 2);
+			std::memcpy(blk + 2, &c1, 2);
+			std::memcpy(blk + 4, &indices, 4);
+		}
+}
+
+// Mode 6 only: one subset, RGBA endpoints at 7 bits + p-bit, 4-bit indices. Good enough for photos and UI art.
+void TextureCodec::encodeBC7(const uint8_t *rgba, uint32_t w, uint32_t h, uint8_t *out) {
+	static constexpr int kWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+	const uint32_t bw = (w + 3) / 4, bh = (h + 3) / 4;
+	for (uint32_t by = 0; by < bh; ++by)
+		for (uint32_t bx = 0; bx < bw; ++bx) {
+			uint8_t px[64];
+			fetchBlock(rgba, w, h, bx, by, px);
+
+			float lo[4], hi[4];
+			principalEndpoints<4>(px, lo, hi);
+			uint8_t e[2][4], p[2];
+			quantizeBC7Endpoint(lo, e[0], p[0]);
+			quantizeBC7Endpoint(hi, e[1], p[1]);
+
+			int pal[16][4];
+			for (int i = 0; i < 16; ++i)
+				for (int c = 0; c < 4; ++c) {
+					const int a = (e[0][c] << 1) | p[0], b = (e[1][c] << 1) | p[1];
+					pal[i][c] = ((64 - kWeights[i]) * a + kWeights[i] * b + 32) >> 6;
+				}
+
+			uint8_t idx[16];
+			for (int i = 0; i < 16; ++i)
+				idx[i] = uint8_t(nearest<4>(px + i * 4, pal, 16));
+
+			// texel 0's index is stored with its msb implied 0: swap the endpoints (the weights are symmetric)
+			if (idx[0] & 8) {
+				std::swap(e[0], e[1]);
+				std::swap(p[0], p[1]);
+				for (uint8_t &i : idx)
+					i = uint8_t(15 - i);
+			}
+
+			uint8_t *blk = out + (size_t(by) * bw + bx) * 16;
+			std::memset(blk, 0, 16);
+			BitWriter bits{blk};
+			bits.put(1u << 6, 7); // mode 6
+			for (int c = 0; c < 4; ++c) {
+				bits.put(e[0][c], 7);
+				bits.put(e[1][c], 7);
+			}
+			bits.put(p[0], 1);
+			bits.put(p[1], 1);
+			bits.put(idx[0], 3);
+			for (int i = 1; i < 16; ++i)
+				bits.put(idx[i], 4);
+		}
+}
+
+// -------------------------------------
+// KTX2
+// -------------------------------------
+
+bool TextureCodec::readKTX2(const std::string &path, Texture &out, std::string *error) {
+	auto fail = [&](const std::string &why) {
+		if (error)
+			*error = why;
+		return false;
+	};
+
+	std::ifstream f(path, std::ios::binary);
+	if (!f)
+		return fail("cannot open");
+	const std::vector<uint8_t> b((std::istreambuf_iterator<char>(f)), {});
+	if (b.size() < kKtx2HeaderBytes || std::memcmp(b.data(), kKtx2Id, sizeof(kKtx2Id)) != 0)
+		return fail("not a KTX2 file");
+
+	const VkFormat format = VkFormat(rd32(&b[12]));
+	const uint32_t width = rd32(&b[20]), height = rd32(&b[24]), depth = rd32(&b[28]);
+	const uint32_t layers = rd32(&b[32]), faces = rd32(&b[36]), levelCount = std::max(1u, rd32(&b[40]));
+	if (rd32(&b[44]) != 0)
+		return fail("supercompressed KTX2 is not supported");
+	if (width == 0 || height == 0 || depth > 1 || layers > 1 || faces != 1)
+		return fail("only single 2D textures are supported");
+	FormatInfo fi{};
+	if (!formatInfo(format, fi))
+		return fail("unsupported vkFormat " + std::to_string(uint32_t(format)));
+	if (kKtx2HeaderBytes + size_t(levelCount) * 24 > b.size())
+		return fail("truncated level index");
+
+	Texture t;
+	t.format = format;
+	for (uint32_t l = 0; l < levelCount; ++l) {
+		const uint8_t *entry = &b[kKtx2HeaderBytes + size_t(l) * 24];
+		const uint64_t offset = rd64(entry), length = rd64(entry + 8);
+
+		Level lv;
+		lv.w = std::max(1u, width >> l);
+		lv.h = std::max(1u, height >> l);
+		lv.size = size_t((lv.w + fi.blockDim - 1) / fi.blockDim) * ((lv.h + fi.blockDim - 1) / fi.blockDim) * fi.blockBytes;
+		if (length < lv.size || offset > b.size() || b.size() - offset < lv.size)
+			return fail("truncated level " + std::to_string(l));
+
+		lv.offset = t.data.size();
+		t.data.insert(t.data.end(), b.begin() + ptrdiff_t(offset), b.begin() + ptrdiff_t(offset + lv.size));
+		t.levels.push_back(lv);
+	}
+	out = std::move(t);
+	return true;
+}
+
+bool TextureCodec::writeKTX2(const std::string &path, const Texture &tex) {
+	FormatInfo fi{};
+	if (tex.levels.empty() || !formatInfo(tex.format, fi))
+		return false;
+
+	const uint32_t levelCount = uint32_t(tex.levels.size());
+	const std::vector<uint8_t> dfd = makeDfd(tex.format, fi);
+	const size_t dfdOffset = kKtx2HeaderBytes + size_t(levelCount) * 24;
+
+	// level data goes smallest first, each aligned to lcm(block bytes, 4) (= block bytes here)
+	std::vector<uint8_t> b(dfdOffset + dfd.size(), 0);
+	std::memcpy(b.data(), kKtx2Id, sizeof(kKtx2Id));
+	put32(b, 12, uint32_t(tex.format));
+	put32(b, 16, 1); // typeSize
+	put32(b, 20, tex.width());
+	put32(b, 24, tex.height());
+	put32(b, 36, 1); // faceCount
+	put32(b, 40, levelCount);
+	put32(b, 48, uint32_t(dfdOffset));
+	put32(b, 52, uint32_t(dfd.size()));
+	std::memcpy(b.data() + dfdOffset, dfd.data(), dfd.size());
+
+	for (uint32_t l = levelCount; l-- > 0;) {
+		const Level &lv = tex.levels[l];
+		const size_t at = alignUp(b.size(), fi.blockBytes);
+		b.resize(at + lv.size, 0);
+		std::memcpy(b.data() + at, tex.data.data() + lv.offset, lv.size);
+
+		const size_t entry = kKtx2HeaderBytes + size_t(l) * 24;
+		put64(b, entry, at);
+		put64(b, entry + 8, lv.size);
+		put64(b, entry + 16, lv.size);
+	}
+
+	// several workers may write the same entry: each writes its own temp file and the last rename wins
+	std::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+	const std::string tmp = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+		if (!f || !f.write(reinterpret_cast<const char *>(b.data()), std::streamsize(b.size()))) {
+			std::fprintf(stderr, "[TextureCodec] cannot write %s\n", tmp.c_str());
+			return false;
+		}
+	}
+	fs::rename(tmp, path, ec);
+	if (ec) {
+		std::fprintf(stderr, "[TextureCodec] cannot replace %s: %s\n", path.c_str(), ec.message().c_str());
+		fs::remove(tmp, ec);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,133 @@
+#include "textureheap.hpp"
+#include "debug.hpp"
+#include "pipelineregistry.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TextureHeap::~TextureHeap() { destroy(); }
+
+TextureHeap &TextureHeap::get() {
+	if (!active)
+		throw std::runtime_error("TextureHeap::get: no texture heap (engine not initialized)");
+	return *active;
+}
+
+void TextureHeap::create(VkDevice dev, VkPhysicalDevice physicalDevice, uint32_t overlap) {
+	destroy();
+	device = dev;
+	frameOverlap = overlap;
+	frame = 0;
+
+	VkPhysicalDeviceVulkan12Properties props12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES};
+	VkPhysicalDeviceProperties2 props{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+	props.pNext = &props12;
+	vkGetPhysicalDeviceProperties2(physicalDevice, &props);
+	slotCount = std::min({kMaxTextures, props12.maxPerStageDescriptorUpdateAfterBindSamplers, props12.maxPerStageDescriptorUpdateAfterBindSampledImages, props12.maxDescriptorSetUpdateAfterBindSamplers, props12.maxDescriptorSetUpdateAfterBindSampledImages});
+
+	// acquired through the registry so every pipeline using the heap shares its pipeline layout / VkPipeline
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = slotCount;
+	binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	const VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsCI{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+	flagsCI.bindingCount = 1;
+	flagsCI.pBindingFlags = &flags;
+
+	VkDescriptorSetLayoutCreateInfo lci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+	lci.pNext = &flagsCI;
+	lci.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	lci.bindingCount = 1;
+	lci.pBindings = &binding;
+	setLayout = PipelineRegistry::get().acquireSetLayout(device, lci);
+
+	VkDescriptorPoolSize size{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, slotCount};
+	VkDescriptorPoolCreateInfo pci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+	pci.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	pci.maxSets = 1;
+	pci.poolSizeCount = 1;
+	pci.pPoolSizes = &size;
+	VK_CHECK(vkCreateDescriptorPool(device, &pci, nullptr, &pool));
+
+	VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+	ai.descriptorPool = pool;
+	ai.descriptorSetCount = 1;
+	ai.pSetLayouts = &setLayout;
+	VK_CHECK(vkAllocateDescriptorSets(device, &ai, &descriptorSet));
+
+	freeSlots.resize(slotCount);
+	for (uint32_t i = 0; i < slotCount; ++i)
+		freeSlots[i] = slotCount - 1 - i;
+
+	active = this;
+}
+
+void TextureHeap::destroy() {
+	// the device is idle by now: nothing can still sample what is waiting to retire. A callback may release more
+	// (TextureAtlas drops a page once its last cell goes), so drain until nothing is queued.
+	while (!retired.empty()) {
+		Retired r = std::move(retired.front());
+		retired.pop_front();
+		if (r.destroy)
+			r.destroy();
+	}
+	if (device == VK_NULL_HANDLE)
+		return;
+	freeSlots.clear();
+
+	vkDestroyDescriptorPool(device, pool, nullptr);
+	PipelineRegistry::get().releaseSetLayout(setLayout, device);
+	pool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
+	slotCount = 0;
+	if (active == this)
+		active = nullptr;
+	device = VK_NULL_HANDLE;
+}
+
+uint32_t TextureHeap::add(VkImageView view, VkSampler sampler, VkImageLayout imageLayout) {
+	if (freeSlots.empty())
+		throw std::runtime_error("TextureHeap::add: all " + std::to_string(slotCount) + " texture slots are in use");
+	const uint32_t index = freeSlots.back();
+	freeSlots.pop_back();
+
+	VkDescriptorImageInfo ii{};
+	ii.sampler = sampler;
+	ii.imageView = view;
+	ii.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+	w.dstSet = descriptorSet;
+	w.dstBinding = 0;
+	w.dstArrayElement = index;
+	w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	w.descriptorCount = 1;
+	w.pImageInfo = &ii;
+	vkUpdateDescriptorSets(device, 1, &w, 0, nullptr);
+
+	return index;
+}
+
+void TextureHeap::release(uint32_t index, std::function<void()> onRetired) {
+	if (index != kInvalid && index >= slotCount)
+		throw std::runtime_error("TextureHeap::release: slot " + std::to_string(index) + " out of range");
+	retired.push_back({index, frame, std::move(onRetired)});
+}
+
+void TextureHeap::beginFrame() {
+	++frame;
+	// released during frame N: frame N's submission has completed once the fence of frame N + frameOverlap was waited on
+	while (!retired.empty() && retired.front().frame + frameOverlap <= frame) {
+		Retired r = std::move(retired.front());
+		retired.pop_front();
+		if (r.destroy)
+			r.destroy();
+		if (r.index != kInvalid)
+			freeSlots.push_back(r.index);
+	}
+}